@@ -1,23 +1,40 @@
 package xrpc
 
 import (
+	"bufio"
+	"errors"
 	"net"
+	"sync"
 	"time"
-	"bufio"
 )
 
 const (
 	defaultConnectTimeout = 100 * time.Millisecond
 	defaultReadTimeout    = 500 * time.Millisecond
 	defaultWriteTimeout   = 500 * time.Millisecond
+	// 要小于xrtcserver的connection_timeout，避免使用一个服务端正要关闭的连接
+	defaultIdleTimeout = 3000 * time.Millisecond
+	// 超时之后还没有收到响应的请求超过这个数，认为服务端已经不可用，关闭连接
+	maxTimedOutRequests = 1024
+)
+
+var (
+	ErrConnClosed      = errors.New("xrpc connection closed")
+	ErrReadTimeout     = errors.New("xrpc read response timeout")
+	ErrTooManyTimedOut = errors.New("xrpc too many timed out requests")
 )
 
 type Client struct {
 	ConnectTimeout time.Duration
 	ReadTimeout    time.Duration
 	WriteTimeout   time.Duration
+	IdleTimeout    time.Duration
 
 	selector ServerSelector
+
+	// 每个服务端地址一个长连接，多个请求同时在一个连接上发送，按Header.Id匹配响应
+	mu    sync.Mutex
+	conns map[string]*clientConn
 }
 
 func NewClient(servers []string) *Client {
@@ -25,6 +42,7 @@ func NewClient(servers []string) *Client {
 	ss.SetServers(servers)
 	return &Client{
 		selector: ss,
+		conns:    make(map[string]*clientConn),
 	}
 }
 
@@ -49,39 +67,221 @@ func (c *Client) writeTimeout() time.Duration {
 	return c.WriteTimeout
 }
 
+func (c *Client) idleTimeout() time.Duration {
+	if c.IdleTimeout == 0 {
+		return defaultIdleTimeout
+	}
+	return c.IdleTimeout
+}
+
 func (c *Client) Do(req *Request) (*Response, error) {
 	addr, err := c.selector.PickServer()
 	if err != nil {
 		return nil, err
 	}
 
-	// 建立连接
-	nc, err := net.DialTimeout(addr.Network(), addr.String(), c.connectTimeout())
+	cc, err := c.getConn(addr)
 	if err != nil {
 		return nil, err
 	}
 
-	// 设置超时
-	nc.SetReadDeadline(time.Now().Add(c.readTimeout()))
-	nc.SetWriteDeadline(time.Now().Add(c.writeTimeout()))
-
 	// 发起请求
-	rw := bufio.NewReadWriter(bufio.NewReader(nc), bufio.NewWriter(nc))
-	if _, err := req.Write(rw); err != nil {
+	ch, err := cc.send(req, c.writeTimeout())
+	if err != nil {
 		return nil, err
 	}
 
-	if err = rw.Flush(); err != nil {
+	// 等待响应，响应可能和请求的顺序不一致
+	timer := time.NewTimer(c.readTimeout())
+	defer timer.Stop()
+
+	select {
+	case resp, ok := <-ch:
+		if !ok {
+			return nil, ErrConnClosed
+		}
+		return resp, nil
+	case <-timer.C:
+		cc.cancel(req.Header.Id)
+		return nil, ErrReadTimeout
+	}
+}
+
+func (c *Client) getConn(addr net.Addr) (*clientConn, error) {
+	key := addr.String()
+
+	c.mu.Lock()
+	cc, ok := c.conns[key]
+	c.mu.Unlock()
+
+	if ok && cc.usable(c.idleTimeout()) {
+		return cc, nil
+	}
+
+	if ok {
+		cc.close(nil)
+	}
+
+	// 建立连接
+	nc, err := net.DialTimeout(addr.Network(), key, c.connectTimeout())
+	if err != nil {
 		return nil, err
 	}
 
-	// 读取响应结果
-	resp, err := ReadResponse(rw);
+	cc = newClientConn(nc)
+
+	c.mu.Lock()
+	if old, ok := c.conns[key]; ok && old != cc && old.usable(c.idleTimeout()) {
+		// 其它请求已经建好了连接
+		c.mu.Unlock()
+		cc.close(nil)
+		return old, nil
+	}
+	c.conns[key] = cc
+	c.mu.Unlock()
+
+	go cc.readLoop()
+
+	return cc, nil
+}
+
+type clientConn struct {
+	nc net.Conn
+
+	// 写请求需要串行
+	wmu sync.Mutex
+	w   *bufio.Writer
+
+	mu sync.Mutex
+	// 超时的请求保留id，值为nil，直到迟到的响应到达或者连接关闭，
+	// 否则nextId回绕之后新请求会复用这个id，收到旧请求的响应
+	pending  map[uint16]chan *Response
+	timedOut int
+	nextId   uint16
+	closed   bool
+	lastUsed time.Time
+}
+
+func newClientConn(nc net.Conn) *clientConn {
+	return &clientConn{
+		nc:       nc,
+		w:        bufio.NewWriter(nc),
+		pending:  make(map[uint16]chan *Response),
+		lastUsed: time.Now(),
+	}
+}
+
+func (cc *clientConn) usable(idleTimeout time.Duration) bool {
+	cc.mu.Lock()
+	defer cc.mu.Unlock()
+
+	if cc.closed {
+		return false
+	}
+
+	// 有请求在等待时连接不会被服务端判定为空闲
+	return len(cc.pending) > cc.timedOut || time.Since(cc.lastUsed) < idleTimeout
+}
+
+func (cc *clientConn) send(req *Request, writeTimeout time.Duration) (chan *Response, error) {
+	ch := make(chan *Response, 1)
+
+	cc.mu.Lock()
+	if cc.closed {
+		cc.mu.Unlock()
+		return nil, ErrConnClosed
+	}
+
+	// 跳过还在等待响应的id
+	for {
+		cc.nextId++
+		if _, ok := cc.pending[cc.nextId]; !ok {
+			break
+		}
+	}
+	req.Header.Id = cc.nextId
+	cc.pending[req.Header.Id] = ch
+	cc.lastUsed = time.Now()
+	cc.mu.Unlock()
+
+	cc.wmu.Lock()
+	cc.nc.SetWriteDeadline(time.Now().Add(writeTimeout))
+	_, err := req.Write(cc.w)
+	if err == nil {
+		err = cc.w.Flush()
+	}
+	cc.wmu.Unlock()
+
 	if err != nil {
+		// 写了一半的请求会破坏后续的数据流，直接关闭连接
+		cc.close(err)
 		return nil, err
 	}
 
-	nc.Close()
+	return ch, nil
+}
+
+func (cc *clientConn) cancel(id uint16) {
+	cc.mu.Lock()
+	if ch, ok := cc.pending[id]; !ok || ch == nil {
+		cc.mu.Unlock()
+		return
+	}
+	cc.pending[id] = nil
+	cc.timedOut++
+	timedOut := cc.timedOut
+	cc.mu.Unlock()
+
+	if timedOut > maxTimedOutRequests {
+		cc.close(ErrTooManyTimedOut)
+	}
+}
+
+func (cc *clientConn) readLoop() {
+	r := bufio.NewReader(cc.nc)
+	for {
+		resp, err := ReadResponse(r)
+		if err != nil {
+			cc.close(err)
+			return
+		}
+
+		cc.mu.Lock()
+		ch, ok := cc.pending[resp.Header.Id]
+		if ok {
+			delete(cc.pending, resp.Header.Id)
+			if ch == nil {
+				cc.timedOut--
+			}
+		}
+		cc.lastUsed = time.Now()
+		cc.mu.Unlock()
 
-	return resp, nil
+		// 已经超时的请求，丢弃响应，id从此可以复用
+		if ch != nil {
+			ch <- resp
+		}
+	}
+}
+
+func (cc *clientConn) close(err error) {
+	cc.mu.Lock()
+	if cc.closed {
+		cc.mu.Unlock()
+		return
+	}
+	cc.closed = true
+	pending := cc.pending
+	cc.pending = make(map[uint16]chan *Response)
+	cc.timedOut = 0
+	cc.mu.Unlock()
+
+	cc.nc.Close()
+
+	// 通知所有等待中的请求，超时的请求已经没有人等待
+	for _, ch := range pending {
+		if ch != nil {
+			close(ch)
+		}
+	}
 }
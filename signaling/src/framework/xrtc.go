@@ -59,6 +59,12 @@ func loadXrpc() error {
 			}
 		}
 
+		if value, ok := mSection["idleTimeout"]; ok {
+			if idleTimeout, err := strconv.Atoi(value); err == nil {
+				client.IdleTimeout = time.Duration(idleTimeout) * time.Millisecond
+			}
+		}
+
 		//fmt.Println(client)
 		xrpcClients[section] = client
 	}
@@ -53,14 +53,21 @@ namespace xrtc {
         rtp_rtcp_->OnSendingRtpFrame(rtp_timestamp, capture_time_ms, false);
     }
 
+    void AudioReceiveStream::DetachEventLoop() {
+        rtp_rtcp_->DetachEventLoop();
+    }
+
+    void AudioReceiveStream::AttachEventLoop(EventLoop* el) {
+        el_ = el;
+        rtp_rtcp_->AttachEventLoop(el);
+    }
+
      void AudioReceiveStream::DeliverRtcp(const uint8_t* packet, size_t length) {
         rtp_rtcp_->IncomingRtcpPacket(packet, length);
     }
 
-    void AudioReceiveStream::DeliverRtp(const uint8_t* packet, size_t length) {
-        RtpPacketReceived rtp_packet_received;
-        rtp_packet_received.Parse(packet, length);
-        rtp_receive_statistics_->OnRtpPacket(rtp_packet_received);
+    void AudioReceiveStream::DeliverRtp(const RtpPacketView& rtp_packet) {
+        rtp_receive_statistics_->OnRtpPacket(rtp_packet);
     }
 
 } // namespace xrtc
\ No newline at end of file
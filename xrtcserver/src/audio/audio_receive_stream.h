@@ -8,6 +8,7 @@
 #include "modules/rtp_rtcp/rtp_rtcp_impl.h"
 #include "modules/rtp_rtcp/include/receive_statistics.h"
 #include "modules/rtp_rtcp/include/rtp_packet_received.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
 
 namespace xrtc {
 
@@ -19,7 +20,13 @@ public:
     void UpdateRtpStats(std::shared_ptr<RtpPacketToSend> packet, bool is_retransmit);
     void OnSendingRtpFrame(uint32_t rtp_timestamp, int64_t capture_time_ms);
     void DeliverRtcp(const uint8_t* packet, size_t length);
-    void DeliverRtp(const uint8_t* packet, size_t length);
+    void DeliverRtp(const RtpPacketView& rtp_packet);
+
+    // 收到的包按这个映射查找扩展
+    const RtpHeaderExtensionMap& extensions() const { return config_.rtp.extensions; }
+
+    void DetachEventLoop();
+    void AttachEventLoop(EventLoop* el);
 
 private:
     EventLoop* el_;
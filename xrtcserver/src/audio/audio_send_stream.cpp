@@ -25,7 +25,7 @@ namespace xrtc {
     {
         // 设置RTCP包为复合包模式，同时启动定时器
         rtp_rtcp_->SetRTCPStatus(webrtc::RtcpMode::kCompound);
-        rtp_rtcp_->SetSendingStatus(false);
+        rtp_rtcp_->SetSendingStatus(true);
     }
 
     AudioSendStream::~AudioSendStream() {
@@ -43,4 +43,32 @@ namespace xrtc {
         rtp_rtcp_->OnSendingRtpFrame(rtp_timestamp, capture_time_ms, false);
     }
 
+    void AudioSendStream::DeliverRtcp(const uint8_t* packet, size_t length) {
+        rtp_rtcp_->IncomingRtcpPacket(packet, length);
+    }
+
+    void AudioSendStream::OnSendingRtpPacket(uint32_t ssrc, const RtpPacketCounter& counter) {
+        if (ssrc != config_.rtp.ssrc) {
+            return;
+        }
+
+        rtp_rtcp_->UpdateRtpStats(counter, false, false);
+    }
+
+    void AudioSendStream::OnRemoteSenderReport(uint32_t ssrc, uint32_t rtp_timestamp) {
+        if (ssrc != config_.rtp.ssrc) {
+            return;
+        }
+
+        rtp_rtcp_->OnSendingRtpFrame(rtp_timestamp, -1, false);
+    }
+
+    void AudioSendStream::DetachEventLoop() {
+        rtp_rtcp_->DetachEventLoop();
+    }
+
+    void AudioSendStream::AttachEventLoop(EventLoop* el) {
+        rtp_rtcp_->AttachEventLoop(el);
+    }
+
 } // namespace xrtc
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "base/event_loop.h"
 #include "audio/audio_stream_config.h"
 #include "modules/rtp_rtcp/rtp_rtcp_impl.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
 
 namespace xrtc {
 
@@ -16,6 +17,18 @@ public:
 
     void UpdateRtpStats(std::shared_ptr<RtpPacketToSend> packet, bool is_retransmit);
     void OnSendingRtpFrame(uint32_t rtp_timestamp, int64_t capture_time_ms);
+    void DeliverRtcp(const uint8_t* packet, size_t length);
+
+    // 转发给订阅者的包，更新SR中的发送统计，大小由转发路径解析一次之后传入
+    void OnSendingRtpPacket(uint32_t ssrc, const RtpPacketCounter& counter);
+    // 订阅者按这个映射解析转发给它的包中的扩展
+    const RtpHeaderExtensionMap& extensions() const { return config_.rtp.extensions; }
+    // 推流者的SR，SR中的RTP时间戳对应收到SR的本地时间，和VideoSendStream相同
+    void OnRemoteSenderReport(uint32_t ssrc, uint32_t rtp_timestamp);
+
+    // 会话迁移到其它worker时，RTCP定时器跟随转移
+    void DetachEventLoop();
+    void AttachEventLoop(EventLoop* el);
     
 private:
     AudioSendStreamConfig config_;
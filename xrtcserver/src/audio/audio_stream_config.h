@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
+
 namespace xrtc {
 
 class RtpRtcpModuleObserver;
@@ -12,6 +14,8 @@ struct AudioSendStreamConfig {
         uint32_t ssrc = 0;
         int payload_type = -1;
         int clock_rate = 48000;
+        // 对端offer中协商的RTP头扩展id
+        RtpHeaderExtensionMap extensions;
     } rtp;
 
     // 音频的rtcp包发送间隔
@@ -25,6 +29,8 @@ struct AudioReceiveStreamConfig {
         uint32_t local_ssrc = 0;
         int payload_type = -1;
         int clock_rate = 48000;
+        // 对端offer中协商的RTP头扩展id
+        RtpHeaderExtensionMap extensions;
     } rtp;
 
     // 音频的rtcp包发送间隔
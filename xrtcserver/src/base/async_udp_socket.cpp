@@ -1,11 +1,537 @@
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include <algorithm>
+#include <vector>
+
 #include <rtc_base/logging.h>
 
 #include "base/socket.h"
+#include "base/io_uring.h"
 #include "base/async_udp_socket.h"
 
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
 namespace xrtc {
 
 const size_t MAX_BUF_SIZE = 1500;
+const size_t k_recv_batch_size = 32;
+const size_t k_gro_recv_batch_size = 8;
+const size_t k_gro_buf_size = 65536;
+const size_t k_recv_ctrl_size = CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(int));
+const size_t k_send_slab_size = 512 * 1024;
+const size_t k_send_max_entries = 1024;
+const size_t k_gso_max_segments = 64;
+const size_t k_gso_max_size = 65000;
+const size_t k_send_ctrl_size = CMSG_SPACE(sizeof(uint16_t));
+// io_uring的provided buffer，每个缓冲区放io_uring_recvmsg_out、地址、控制消息和数据
+const uint16_t k_uring_bgid = 0;
+const unsigned int k_uring_buf_num = 1024;
+const size_t k_uring_buf_size = 2048;
+const uint16_t k_uring_gro_bgid = 1;
+const unsigned int k_uring_gro_buf_num = 32;
+const size_t k_uring_gro_buf_size = k_gro_buf_size + 256;
+const size_t k_uring_send_max_slots = 4096;
+const size_t k_uring_send_buf_size = 2048;
+
+// recvmmsg使用的缓冲区，同一个线程上的socket依次处理，共享一份即可
+class RecvBatch {
+public:
+    RecvBatch(size_t batch_size, size_t buf_size) :
+        batch_size(batch_size),
+        buf_size(buf_size),
+        bufs(batch_size * buf_size),
+        msgs(batch_size),
+        iovs(batch_size),
+        addrs(batch_size),
+        ctrls(batch_size * k_recv_ctrl_size)
+    {
+    }
+
+    void prepare() {
+        for (size_t i = 0; i < batch_size; ++i) {
+            iovs[i].iov_base = buf(i);
+            iovs[i].iov_len = buf_size;
+
+            struct msghdr& hdr = msgs[i].msg_hdr;
+            hdr.msg_name = &addrs[i];
+            hdr.msg_namelen = sizeof(struct sockaddr_in);
+            hdr.msg_iov = &iovs[i];
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = &ctrls[i * k_recv_ctrl_size];
+            hdr.msg_controllen = k_recv_ctrl_size;
+            hdr.msg_flags = 0;
+            msgs[i].msg_len = 0;
+        }
+    }
+
+    char* buf(size_t i) { return &bufs[i * buf_size]; }
+
+    const size_t batch_size;
+    const size_t buf_size;
+    std::vector<char> bufs;
+    std::vector<struct mmsghdr> msgs;
+    std::vector<struct iovec> iovs;
+    std::vector<struct sockaddr_in> addrs;
+    std::vector<char> ctrls;
+};
+
+static RecvBatch* get_recv_batch(bool gro) {
+    if (gro) {
+        static thread_local RecvBatch gro_batch(k_gro_recv_batch_size, k_gro_buf_size);
+        return &gro_batch;
+    }
+
+    static thread_local RecvBatch batch(k_recv_batch_size, MAX_BUF_SIZE);
+    return &batch;
+}
+
+struct UdpSendEntry {
+    AsyncUdpSocket* socket;
+    size_t offset;
+    size_t len;
+    struct sockaddr_in addr;
+};
+
+// 同一个线程上所有socket共享的发送缓存，在ev_prepare中统一flush
+class UdpSendBatcher {
+public:
+    explicit UdpSendBatcher(EventLoop* el);
+    ~UdpSendBatcher();
+
+    void add(AsyncUdpSocket* socket, const char* data, size_t size, const struct sockaddr_in& addr);
+    void remove_socket(AsyncUdpSocket* socket);
+    void flush();
+
+private:
+    void _flush_socket(AsyncUdpSocket* socket, size_t begin, size_t end);
+    void _queue_entries(AsyncUdpSocket* socket, size_t begin, size_t end);
+
+private:
+    EventLoop* el_;
+    PrepareWatcher* prepare_watcher_ = nullptr;
+    bool gso_disabled_ = false;
+
+    std::vector<char> slab_;
+    size_t used_ = 0;
+    std::vector<UdpSendEntry> entries_;
+    std::vector<size_t> order_;
+
+    std::vector<struct mmsghdr> msgs_;
+    std::vector<struct iovec> iovs_;
+    std::vector<char> ctrls_;
+    // 每个mmsghdr对应order_中的[msg_begin_, msg_begin_ + msg_count_)
+    std::vector<size_t> msg_begin_;
+    std::vector<size_t> msg_count_;
+};
+
+static void udp_send_batch_prepare_cb(EventLoop* /*el*/, PrepareWatcher* /*w*/, void* data) {
+    UdpSendBatcher* batcher = (UdpSendBatcher*)data;
+    batcher->flush();
+}
+
+UdpSendBatcher::UdpSendBatcher(EventLoop* el) :
+    el_(el),
+    slab_(k_send_slab_size)
+{
+    entries_.reserve(k_send_max_entries);
+    prepare_watcher_ = el_->create_prepare_event(udp_send_batch_prepare_cb, this);
+}
+
+UdpSendBatcher::~UdpSendBatcher() {
+    if (prepare_watcher_) {
+        el_->delete_prepare_event(prepare_watcher_);
+        prepare_watcher_ = nullptr;
+    }
+}
+
+// 指针本身不需要析构，线程退出时holder先释放batcher并清空指针，
+// 之后析构的socket通过find_send_batcher拿到nullptr，不会再创建新的batcher
+static thread_local UdpSendBatcher* t_send_batcher = nullptr;
+
+struct UdpSendBatcherHolder {
+    ~UdpSendBatcherHolder() {
+        delete t_send_batcher;
+        t_send_batcher = nullptr;
+    }
+};
+
+static UdpSendBatcher* get_send_batcher(EventLoop* el) {
+    static thread_local UdpSendBatcherHolder holder;
+    if (!t_send_batcher) {
+        t_send_batcher = new UdpSendBatcher(el);
+    }
+    return t_send_batcher;
+}
+
+// 只查找当前线程已有的batcher，用于销毁和迁移等不应该创建batcher的地方
+static UdpSendBatcher* find_send_batcher() {
+    return t_send_batcher;
+}
+
+void UdpSendBatcher::add(AsyncUdpSocket* socket, const char* data, size_t size,
+        const struct sockaddr_in& addr)
+{
+    if (used_ + size > slab_.size() || entries_.size() >= k_send_max_entries) {
+        flush();
+    }
+
+    if (entries_.empty()) {
+        el_->start_prepare_event(prepare_watcher_);
+    }
+
+    memcpy(&slab_[used_], data, size);
+    entries_.push_back({socket, used_, size, addr});
+    used_ += size;
+}
+
+void UdpSendBatcher::remove_socket(AsyncUdpSocket* socket) {
+    for (auto& entry : entries_) {
+        if (entry.socket == socket) {
+            entry.socket = nullptr;
+        }
+    }
+}
+
+void UdpSendBatcher::flush() {
+    el_->stop_prepare_event(prepare_watcher_);
+    if (entries_.empty()) {
+        return;
+    }
+
+    // 按socket分组，同一个socket内保持发送顺序
+    order_.resize(entries_.size());
+    for (size_t i = 0; i < order_.size(); ++i) {
+        order_[i] = i;
+    }
+    std::stable_sort(order_.begin(), order_.end(), [this](size_t a, size_t b) {
+        return entries_[a].socket < entries_[b].socket;
+    });
+
+    size_t begin = 0;
+    while (begin < order_.size()) {
+        AsyncUdpSocket* socket = entries_[order_[begin]].socket;
+        size_t end = begin + 1;
+        while (end < order_.size() && entries_[order_[end]].socket == socket) {
+            ++end;
+        }
+
+        if (socket) {
+            _flush_socket(socket, begin, end);
+        }
+        begin = end;
+    }
+
+    entries_.clear();
+    used_ = 0;
+}
+
+static bool same_address(const struct sockaddr_in& a, const struct sockaddr_in& b) {
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+void UdpSendBatcher::_queue_entries(AsyncUdpSocket* socket, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        UdpSendEntry& entry = entries_[order_[i]];
+        rtc::SocketAddress addr;
+        addr.FromSockAddr(entry.addr);
+        socket->_queue_udp_packet(&slab_[entry.offset], entry.len, addr);
+    }
+}
+
+void UdpSendBatcher::_flush_socket(AsyncUdpSocket* socket, size_t begin, size_t end) {
+    // socket已经阻塞，追加到等待队列保证顺序
+    if (!socket->udp_packet_list_.empty()) {
+        _queue_entries(socket, begin, end);
+        return;
+    }
+
+    size_t count = end - begin;
+    msgs_.resize(count);
+    iovs_.resize(count);
+    ctrls_.resize(count * k_send_ctrl_size);
+    msg_begin_.clear();
+    msg_count_.clear();
+
+    bool gso = socket->gso_ && !gso_disabled_;
+    size_t i = begin;
+    while (i < end) {
+        UdpSendEntry& first = entries_[order_[i]];
+        size_t segments = 1;
+        size_t total = first.len;
+
+        // 发往同一地址、长度相同的连续包合并，只有最后一个分段可以更短
+        if (gso) {
+            while (i + segments < end && segments < k_gso_max_segments) {
+                UdpSendEntry& next = entries_[order_[i + segments]];
+                if (!same_address(next.addr, first.addr) || next.len > first.len
+                        || total + next.len > k_gso_max_size)
+                {
+                    break;
+                }
+
+                total += next.len;
+                ++segments;
+                if (next.len < first.len) {
+                    break;
+                }
+            }
+        }
+
+        size_t m = msg_begin_.size();
+        for (size_t k = 0; k < segments; ++k) {
+            UdpSendEntry& entry = entries_[order_[i + k]];
+            iovs_[i - begin + k].iov_base = &slab_[entry.offset];
+            iovs_[i - begin + k].iov_len = entry.len;
+        }
+
+        struct msghdr& hdr = msgs_[m].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = &first.addr;
+        hdr.msg_namelen = sizeof(first.addr);
+        hdr.msg_iov = &iovs_[i - begin];
+        hdr.msg_iovlen = segments;
+        msgs_[m].msg_len = 0;
+
+        if (segments > 1) {
+            hdr.msg_control = &ctrls_[m * k_send_ctrl_size];
+            hdr.msg_controllen = k_send_ctrl_size;
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t gso_size = first.len;
+            memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+        }
+
+        msg_begin_.push_back(i);
+        msg_count_.push_back(segments);
+        i += segments;
+    }
+
+    size_t msg_num = msg_begin_.size();
+    size_t done = 0;
+    while (done < msg_num) {
+        int sent = sock_send_mmsg(socket->socket_, &msgs_[done], msg_num - done);
+        ++socket->send_syscalls_;
+        if (sent > 0) {
+            for (size_t k = done; k < done + sent; ++k) {
+                socket->send_packets_ += msg_count_[k];
+            }
+            done += sent;
+        } else if (0 == sent) {
+            // 缓冲区满，剩余的包放到等待队列，可写时再发送
+            _queue_entries(socket, msg_begin_[done], end);
+            el_->start_io_event(socket->socket_watcher_, socket->socket_, EventLoop::WRITE);
+            return;
+        } else if (msg_count_[done] > 1) {
+            // 网卡或内核不支持GSO，关闭GSO后逐个发送剩余的包
+            RTC_LOG(LS_WARNING) << "udp gso send failed, disable gso";
+            gso_disabled_ = true;
+            for (size_t k = msg_begin_[done]; k < end; ++k) {
+                UdpSendEntry& entry = entries_[order_[k]];
+                rtc::SocketAddress addr;
+                addr.FromSockAddr(entry.addr);
+                socket->_add_udp_packet(&slab_[entry.offset], entry.len, addr);
+            }
+            return;
+        } else {
+            // 和sendto一样，出错的包直接丢弃
+            ++done;
+        }
+    }
+}
+
+// multishot recvmsg请求，一次提交持续接收，直到被取消或者出错
+// socket销毁时只是解除关联并取消请求，接收请求的最后一个完成事件和取消请求的完成事件
+// 都收到之后再释放
+struct UringRecvRequest {
+    IoUringOp op;
+    IoUringOp cancel_op;
+    AsyncUdpSocket* socket = nullptr;
+    int fd = -1;
+    uint16_t bgid = k_uring_bgid;
+    // 已经提交了取消请求，还没有收到它的完成事件
+    bool cancel_pending = false;
+    // 接收请求已经结束，内核不再使用hdr
+    bool finished = false;
+    struct msghdr hdr;
+};
+
+static int uring_submit_recv(IoUring* ring, UringRecvRequest* req) {
+    struct io_uring_sqe* sqe = ring->get_sqe(&req->op);
+    if (!sqe) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = req->fd;
+    sqe->addr = (uint64_t)(uintptr_t)&req->hdr;
+    sqe->len = 1;
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = req->bgid;
+    sqe->ioprio |= IORING_RECV_MULTISHOT;
+    return 0;
+}
+
+static void uring_cancel_recv_cb(IoUring* /*ring*/, const struct io_uring_cqe* /*cqe*/, void* data) {
+    UringRecvRequest* req = (UringRecvRequest*)data;
+    req->cancel_pending = false;
+    // 没有找到要取消的请求(例如它正好结束)时，接收请求的最后一个完成事件也会到达，
+    // 之后还在接收的话由接收回调重新取消
+    if (req->finished) {
+        delete req;
+    }
+}
+
+static int uring_cancel_recv(IoUring* ring, UringRecvRequest* req) {
+    struct io_uring_sqe* sqe = ring->get_sqe(&req->cancel_op);
+    if (!sqe) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)&req->op;
+    req->cancel_pending = true;
+    return 0;
+}
+
+void async_udp_uring_recv_cb(IoUring* ring, const struct io_uring_cqe* cqe, void* data) {
+    UringRecvRequest* req = (UringRecvRequest*)data;
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        if (req->socket && cqe->res > 0) {
+            req->socket->_on_uring_recv(ring->buffer(req->bgid, bid), cqe->res, req->hdr);
+        }
+        ring->recycle_buffer(req->bgid, bid);
+    }
+
+    if (cqe->flags & IORING_CQE_F_MORE) {
+        // socket已经销毁但是取消请求没有提交成功或者没有找到请求，重新取消
+        if (!req->socket && !req->cancel_pending) {
+            uring_cancel_recv(ring, req);
+        }
+        return;
+    }
+
+    if (!req->socket) {
+        req->finished = true;
+        if (!req->cancel_pending) {
+            delete req;
+        }
+        return;
+    }
+
+    // 缓冲区用完(ENOBUFS)或者其它原因结束，重新提交
+    if (uring_submit_recv(ring, req) != 0) {
+        AsyncUdpSocket* socket = req->socket;
+        RTC_LOG(LS_WARNING) << "io_uring resubmit recv failed, fallback to libev, fd: " << req->fd;
+        socket->uring_recv_ = nullptr;
+        delete req;
+        socket->el_->start_io_event(socket->socket_watcher_, socket->socket_, EventLoop::READ);
+    }
+}
+
+// 发送请求使用的内存，从提交到完成期间必须有效
+struct UringSendSlot {
+    IoUringOp op;
+    UringSendSlot* next_free = nullptr;
+    // 发送失败时放回socket的等待队列，socket销毁或者迁移走之后为nullptr
+    AsyncUdpSocket* socket = nullptr;
+    struct msghdr hdr;
+    struct iovec iov;
+    struct sockaddr_in addr;
+    char buf[k_uring_send_buf_size];
+};
+
+// 同一个线程上所有socket共享的发送内存池
+class UringSendPool {
+public:
+    ~UringSendPool() {
+        for (auto slot : slots_) {
+            delete slot;
+        }
+    }
+
+    UringSendSlot* alloc();
+    void free(UringSendSlot* slot) {
+        slot->socket = nullptr;
+        slot->next_free = free_list_;
+        free_list_ = slot;
+    }
+
+    // socket还有发送请求没有完成时，解除这些请求和socket的关联
+    void remove_socket(AsyncUdpSocket* socket) {
+        for (auto slot : slots_) {
+            if (slot->socket == socket) {
+                slot->socket = nullptr;
+            }
+        }
+    }
+
+    uint64_t send_errors = 0;
+
+private:
+    std::vector<UringSendSlot*> slots_;
+    UringSendSlot* free_list_ = nullptr;
+};
+
+void async_udp_uring_send_cb(IoUring* ring, const struct io_uring_cqe* cqe, void* data);
+
+UringSendSlot* UringSendPool::alloc() {
+    if (free_list_) {
+        UringSendSlot* slot = free_list_;
+        free_list_ = slot->next_free;
+        return slot;
+    }
+
+    if (slots_.size() >= k_uring_send_max_slots) {
+        return nullptr;
+    }
+
+    UringSendSlot* slot = new UringSendSlot();
+    slot->op.cb = async_udp_uring_send_cb;
+    slot->op.data = slot;
+    slots_.push_back(slot);
+    return slot;
+}
+
+static UringSendPool* get_uring_send_pool() {
+    static thread_local UringSendPool pool;
+    return &pool;
+}
+
+void async_udp_uring_send_cb(IoUring* /*ring*/, const struct io_uring_cqe* cqe, void* data) {
+    UringSendPool* pool = get_uring_send_pool();
+    UringSendSlot* slot = (UringSendSlot*)data;
+    AsyncUdpSocket* socket = slot->socket;
+    if (socket) {
+        --socket->uring_sending_;
+    }
+
+    if (cqe->res < 0) {
+        if (pool->send_errors++ % 1000 == 0) {
+            RTC_LOG(LS_WARNING) << "io_uring send udp packet error: " << strerror(-cqe->res)
+                << ", send_errors: " << pool->send_errors;
+        }
+
+        if (socket) {
+            socket->_on_uring_send_error(slot->buf, slot->iov.iov_len, slot->addr, -cqe->res);
+        }
+    }
+    pool->free(slot);
+}
 
 void async_udpsocket_io_cb(EventLoop* /*el*/, IOWatcher* /*w*/, 
         int /*fd*/, int event, void* data) 
@@ -22,44 +548,294 @@ void async_udpsocket_io_cb(EventLoop* /*el*/, IOWatcher* /*w*/,
 
 AsyncUdpSocket::AsyncUdpSocket(EventLoop *el, int socket) :
     el_(el),
-    socket_(socket),
-    buf_(new char[MAX_BUF_SIZE]),
-    size_(MAX_BUF_SIZE)
+    socket_(socket)
 {
+    sock_set_recv_timestamp(socket_);
+
     socket_watcher_ = el_->create_io_event(async_udpsocket_io_cb, this);
-    el_->start_io_event(socket_watcher_, socket_, EventLoop::READ);
+    uring_send_ = el_->io_uring() != nullptr;
+    if (!el_->io_uring() || _uring_start_recv() != 0) {
+        el_->start_io_event(socket_watcher_, socket_, EventLoop::READ);
+    }
 }
 
 AsyncUdpSocket::~AsyncUdpSocket() {
+    _uring_stop_recv();
+
+    if (uring_sending_ > 0) {
+        get_uring_send_pool()->remove_socket(this);
+        uring_sending_ = 0;
+    }
+
+    UdpSendBatcher* batcher = send_batch_ ? find_send_batcher() : nullptr;
+    if (batcher) {
+        batcher->remove_socket(this);
+    }
+
+    for (auto packet : udp_packet_list_) {
+        delete packet;
+    }
+    udp_packet_list_.clear();
+
     if (socket_watcher_) {
         el_->delete_io_event(socket_watcher_);
         socket_watcher_ = nullptr;
     }
 
-    if (buf_) {
-        delete []buf_;
-        buf_ = nullptr;
+    RTC_LOG(LS_VERBOSE) << "async udp socket destroy, fd: " << socket_
+        << ", recv_packets: " << recv_packets_
+        << ", recv_syscalls: " << recv_syscalls_
+        << ", send_packets: " << send_packets_
+        << ", send_syscalls: " << send_syscalls_;
+}
+
+void AsyncUdpSocket::enable_send_batch(bool gso) {
+    send_batch_ = true;
+    gso_ = gso;
+}
+
+int AsyncUdpSocket::enable_gro() {
+    if (sock_set_udp_gro(socket_) != 0) {
+        return -1;
+    }
+
+    gro_ = true;
+
+    // 换成大缓冲区的buffer group重新提交接收请求
+    if (uring_recv_) {
+        _uring_stop_recv();
+        if (_uring_start_recv() != 0) {
+            el_->start_io_event(socket_watcher_, socket_, EventLoop::READ);
+        }
+    }
+
+    return 0;
+}
+
+void AsyncUdpSocket::detach_event_loop() {
+    // 当前线程的发送缓存和io_uring只能在当前线程使用，先把已有的数据发出去
+    UdpSendBatcher* batcher = send_batch_ ? find_send_batcher() : nullptr;
+    if (batcher) {
+        batcher->flush();
+    }
+
+    if (el_->io_uring()) {
+        _uring_stop_recv();
+        el_->io_uring()->submit();
+    }
+
+    // 还没有完成的发送请求在当前线程完成，失败时不再放回等待队列
+    if (uring_sending_ > 0) {
+        get_uring_send_pool()->remove_socket(this);
+        uring_sending_ = 0;
+    }
+    uring_send_ = false;
+
+    el_->detach_io_event(socket_watcher_);
+}
+
+void AsyncUdpSocket::attach_event_loop(EventLoop* el) {
+    el_ = el;
+    el_->attach_io_event(socket_watcher_);
+    uring_send_ = el_->io_uring() != nullptr;
+
+    // 目标worker的IO方式可能不同，按目标EventLoop重新开始接收
+    if (el_->io_uring() && _uring_start_recv() == 0) {
+        el_->stop_io_event(socket_watcher_, socket_, EventLoop::READ);
+    } else {
+        el_->start_io_event(socket_watcher_, socket_, EventLoop::READ);
+    }
+}
+
+int AsyncUdpSocket::_uring_start_recv() {
+    IoUring* ring = el_->io_uring();
+    uint16_t bgid = gro_ ? k_uring_gro_bgid : k_uring_bgid;
+    if (!ring->has_buffer_group(bgid)) {
+        int ret = gro_ ? ring->register_buffer_group(bgid, k_uring_gro_buf_num, k_uring_gro_buf_size)
+            : ring->register_buffer_group(bgid, k_uring_buf_num, k_uring_buf_size);
+        if (ret != 0) {
+            return -1;
+        }
+    }
+
+    UringRecvRequest* req = new UringRecvRequest();
+    req->op.cb = async_udp_uring_recv_cb;
+    req->op.data = req;
+    req->cancel_op.cb = uring_cancel_recv_cb;
+    req->cancel_op.data = req;
+    req->socket = this;
+    req->fd = socket_;
+    req->bgid = bgid;
+    memset(&req->hdr, 0, sizeof(req->hdr));
+    req->hdr.msg_namelen = sizeof(struct sockaddr_in);
+    req->hdr.msg_controllen = k_recv_ctrl_size;
+
+    if (uring_submit_recv(ring, req) != 0) {
+        delete req;
+        return -1;
+    }
+
+    uring_recv_ = req;
+    return 0;
+}
+
+void AsyncUdpSocket::_uring_stop_recv() {
+    if (!uring_recv_) {
+        return;
+    }
+
+    IoUring* ring = el_->io_uring();
+    uring_recv_->socket = nullptr;
+
+    // 立即提交取消请求，保证socket关闭之后内核不再持有它，
+    // 提交失败时在下一个接收完成事件中重新取消
+    if (uring_cancel_recv(ring, uring_recv_) == 0) {
+        ring->submit();
+    } else {
+        RTC_LOG(LS_WARNING) << "io_uring cancel recv failed, fd: " << socket_;
+    }
+
+    uring_recv_ = nullptr;
+}
+
+void AsyncUdpSocket::_on_uring_recv(char* buf, size_t len, const struct msghdr& tmpl) {
+    // 缓冲区布局: io_uring_recvmsg_out | 地址 | 控制消息 | 数据
+    struct io_uring_recvmsg_out* out = (struct io_uring_recvmsg_out*)buf;
+    size_t payload_offset = sizeof(*out) + tmpl.msg_namelen + tmpl.msg_controllen;
+    if (len < payload_offset || (out->flags & MSG_TRUNC)
+            || out->namelen < sizeof(struct sockaddr_in))
+    {
+        return;
     }
+
+    struct sockaddr_in addr;
+    memcpy(&addr, buf + sizeof(*out), sizeof(addr));
+
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_control = buf + sizeof(*out) + tmpl.msg_namelen;
+    hdr.msg_controllen = out->controllen;
+
+    size_t payload_len = std::min((size_t)out->payloadlen, len - payload_offset);
+    _on_recv_message(hdr, buf + payload_offset, payload_len, addr);
+}
+
+int AsyncUdpSocket::_uring_send(const char* data, size_t size, const rtc::SocketAddress& addr) {
+    if (size > k_uring_send_buf_size) {
+        return -1;
+    }
+
+    UringSendPool* pool = get_uring_send_pool();
+    UringSendSlot* slot = pool->alloc();
+    if (!slot) {
+        return -1;
+    }
+
+    struct io_uring_sqe* sqe = el_->io_uring()->get_sqe(&slot->op);
+    if (!sqe) {
+        pool->free(slot);
+        return -1;
+    }
+
+    memcpy(slot->buf, data, size);
+    slot->socket = this;
+    addr.ToSockAddr(&slot->addr);
+    slot->iov.iov_base = slot->buf;
+    slot->iov.iov_len = size;
+    memset(&slot->hdr, 0, sizeof(slot->hdr));
+    slot->hdr.msg_name = &slot->addr;
+    slot->hdr.msg_namelen = sizeof(slot->addr);
+    slot->hdr.msg_iov = &slot->iov;
+    slot->hdr.msg_iovlen = 1;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = socket_;
+    sqe->addr = (uint64_t)(uintptr_t)&slot->hdr;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    ++uring_sending_;
+    return 0;
+}
+
+void AsyncUdpSocket::_on_uring_send_error(const char* data, size_t size,
+        const struct sockaddr_in& addr, int err)
+{
+    // 发送缓冲区满，和sendto一样放到等待队列，可写时再发送，后续的包也排在后面，
+    // 其它错误和sendto一样直接丢弃
+    if (err != EAGAIN && err != EWOULDBLOCK && err != ENOBUFS && err != ENOMEM) {
+        return;
+    }
+
+    rtc::SocketAddress remote_addr;
+    remote_addr.FromSockAddr(addr);
+    _queue_udp_packet(data, size, remote_addr);
+    el_->start_io_event(socket_watcher_, socket_, EventLoop::WRITE);
 }
 
 void AsyncUdpSocket::recv_data() {
+    RecvBatch* batch = get_recv_batch(gro_);
+
     while (true) {
-        struct sockaddr_in addr;
-        socklen_t addr_len = sizeof(addr);
-        int len = sock_recv_from(socket_, buf_, size_, (struct sockaddr*)&addr, addr_len);
-        if (len <= 0) {
+        batch->prepare();
+        int count = sock_recv_mmsg(socket_, batch->msgs.data(), batch->batch_size);
+        ++recv_syscalls_;
+        if (count <= 0) {
+            return;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            struct msghdr& hdr = batch->msgs[i].msg_hdr;
+            size_t len = batch->msgs[i].msg_len;
+            if (0 == len || (hdr.msg_flags & MSG_TRUNC)) {
+                continue;
+            }
+
+            _on_recv_message(hdr, batch->buf(i), len, batch->addrs[i]);
+        }
+
+        // 没有读满说明socket里的数据已经取完
+        if ((size_t)count < batch->batch_size) {
             return;
         }
-        
-        // 拿到数据包到达服务器的时间
-        int64_t timestamp = sock_get_recv_timestamp(socket_);
-        
-        int port = ntohs(addr.sin_port);
-        char ip[64] = {0};
-        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
-        rtc::SocketAddress remote_addr(ip, port);
-        
-        signal_read_packet(this, buf_, len, remote_addr, timestamp);
+    }
+}
+
+void AsyncUdpSocket::_on_recv_message(struct msghdr& hdr, char* buf, size_t len,
+        const struct sockaddr_in& addr)
+{
+    // 从控制消息中拿到数据包到达服务器的时间和GRO分段大小
+    int64_t timestamp = -1;
+    size_t segment_size = 0;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (SOL_SOCKET == cmsg->cmsg_level && SCM_TIMESTAMPNS == cmsg->cmsg_type) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            timestamp = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        } else if (SOL_UDP == cmsg->cmsg_level && UDP_GRO == cmsg->cmsg_type) {
+            int gso_size = 0;
+            memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+            segment_size = gso_size;
+        }
+    }
+
+    if (timestamp < 0) {
+        timestamp = sock_get_recv_timestamp(socket_);
+    }
+
+    // 地址保持二进制形式，不经过inet_ntop和字符串
+    rtc::SocketAddress remote_addr;
+    remote_addr.FromSockAddr(addr);
+
+    if (0 == segment_size || segment_size >= len) {
+        ++recv_packets_;
+        signal_read_packet(this, buf, len, remote_addr, timestamp);
+        return;
+    }
+
+    for (size_t offset = 0; offset < len; offset += segment_size) {
+        size_t segment_len = std::min(segment_size, len - offset);
+        ++recv_packets_;
+        signal_read_packet(this, buf + offset, segment_len, remote_addr, timestamp);
     }
 }
 
@@ -94,7 +870,25 @@ void AsyncUdpSocket::send_data() {
 }
 
 int AsyncUdpSocket::send_to(const char* data, size_t size, const rtc::SocketAddress& addr) {
-    return _add_udp_packet(data, size, addr);
+    // io_uring的发送请求在本轮事件循环结束前统一提交
+    if (uring_send_ && udp_packet_list_.empty() && _uring_send(data, size, addr) == 0) {
+        ++send_packets_;
+        return size;
+    }
+
+    if (!send_batch_ || !udp_packet_list_.empty()) {
+        return _add_udp_packet(data, size, addr);
+    }
+
+    struct sockaddr_in saddr;
+    addr.ToSockAddr(&saddr);
+    get_send_batcher(el_)->add(this, data, size, saddr);
+    return size;
+}
+
+void AsyncUdpSocket::_queue_udp_packet(const char* data, size_t size, const rtc::SocketAddress& addr) {
+    UdpPacketData* packet_data = new UdpPacketData(data, size, addr);
+    udp_packet_list_.push_back(packet_data);
 }
 
 int AsyncUdpSocket::_add_udp_packet(const char* data, size_t size, const rtc::SocketAddress& addr) {
@@ -127,6 +921,7 @@ int AsyncUdpSocket::_add_udp_packet(const char* data, size_t size, const rtc::So
     sockaddr_storage saddr;
     len = addr.ToSockAddrStorage(&saddr);
     sent = sock_send_to(socket_, data, size, MSG_NOSIGNAL, (struct sockaddr*)&saddr, len);
+    ++send_syscalls_;
     if (sent < 0) {
         RTC_LOG(LS_WARNING) << "send udp packet error, remote_addr: " << addr.ToString();
         return -1;
@@ -135,11 +930,11 @@ int AsyncUdpSocket::_add_udp_packet(const char* data, size_t size, const rtc::So
         goto SEND_AGAIN;
     }
 
+    ++send_packets_;
     return sent;
 
 SEND_AGAIN:
-    UdpPacketData* packet_data = new UdpPacketData(data, size, addr);
-    udp_packet_list_.push_back(packet_data);
+    _queue_udp_packet(data, size, addr);
     el_->start_io_event(socket_watcher_, socket_, EventLoop::WRITE);
 
     return size;   
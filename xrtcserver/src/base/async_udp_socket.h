@@ -7,6 +7,10 @@
 #ifndef  __ASYNC_UDP_SOCKET_H_
 #define  __ASYNC_UDP_SOCKET_H_
 
+#include <stdint.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
 #include <list>
 
 #include <rtc_base/third_party/sigslot/sigslot.h>
@@ -14,6 +18,8 @@
 
 #include "base/event_loop.h"
 
+struct io_uring_cqe;
+
 namespace xrtc {
 
 class UdpPacketData {
@@ -43,6 +49,10 @@ private:
     rtc::SocketAddress addr_;
 };
 
+class UdpSendBatcher;
+class IoUring;
+struct UringRecvRequest;
+
 class AsyncUdpSocket {
 public:
     AsyncUdpSocket(EventLoop *el, int socket);
@@ -53,20 +63,65 @@ public:
     
     int send_to(const char* data, size_t size, const rtc::SocketAddress& addr);
 
+    // 开启UDP_GRO，内核把同一个流的多个包合并后一次交给用户态
+    int enable_gro();
+
+    // 发送的包先缓存，本轮事件循环阻塞之前用sendmmsg批量发送，
+    // gso为true时发往同一地址的连续包合并为一个UDP_SEGMENT消息
+    void enable_send_batch(bool gso);
+
+    // EventLoop开启了io_uring时，收发通过io_uring进行，接收请求失败回退到libev时
+    // 发送仍然可以使用io_uring
+    bool use_io_uring() const { return uring_send_ || uring_recv_ != nullptr; }
+
+    // 迁移到另一个worker，detach在当前线程调用，attach在目标线程调用，
+    // 两者之间socket不收发数据，未发送的包保留在socket的等待队列中
+    void detach_event_loop();
+    void attach_event_loop(EventLoop* el);
+
+    uint64_t recv_syscalls() const { return recv_syscalls_; }
+    uint64_t recv_packets() const { return recv_packets_; }
+    uint64_t send_syscalls() const { return send_syscalls_; }
+    uint64_t send_packets() const { return send_packets_; }
+
     sigslot::signal5<AsyncUdpSocket*, char*, size_t, const rtc::SocketAddress&, int64_t>
         signal_read_packet;
 
 private:
     int _add_udp_packet(const char* data, size_t size, const rtc::SocketAddress& addr);
+    void _queue_udp_packet(const char* data, size_t size, const rtc::SocketAddress& addr);
+    void _on_recv_message(struct msghdr& hdr, char* buf, size_t len,
+            const struct sockaddr_in& addr);
+
+    int _uring_start_recv();
+    void _uring_stop_recv();
+    void _on_uring_recv(char* buf, size_t len, const struct msghdr& tmpl);
+    int _uring_send(const char* data, size_t size, const rtc::SocketAddress& addr);
+    void _on_uring_send_error(const char* data, size_t size, const struct sockaddr_in& addr,
+            int err);
+
+    friend class UdpSendBatcher;
+    friend void async_udp_uring_recv_cb(IoUring* ring, const struct io_uring_cqe* cqe, void* data);
+    friend void async_udp_uring_send_cb(IoUring* ring, const struct io_uring_cqe* cqe, void* data);
 
 private:
     EventLoop *el_ = nullptr;
     int socket_ = 0;
     IOWatcher *socket_watcher_ = nullptr;
-    char *buf_ = nullptr;
-    size_t size_ = 0;
+    bool gro_ = false;
+    bool send_batch_ = false;
+    bool gso_ = false;
+    uint64_t recv_syscalls_ = 0;
+    uint64_t recv_packets_ = 0;
+    uint64_t send_syscalls_ = 0;
+    uint64_t send_packets_ = 0;
 
     std::list<UdpPacketData*> udp_packet_list_;
+
+    UringRecvRequest* uring_recv_ = nullptr;
+    bool uring_send_ = false;
+    // 已经提交还没有完成的io_uring发送请求个数
+    size_t uring_sending_ = 0;
 };
 
 } // end namespace xrtc
@@ -0,0 +1,95 @@
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <rtc_base/logging.h>
+
+#include "base/cpu_affinity.h"
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+namespace xrtc {
+
+int select_worker_cpu(const std::vector<int>& cpus, int worker_id) {
+    if (cpus.empty() || worker_id < 0) {
+        return -1;
+    }
+
+    return cpus[worker_id % cpus.size()];
+}
+
+int bind_thread_to_cpu(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return -1;
+    }
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+
+    // pthread_*系列函数直接返回错误码，不设置errno
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (ret != 0) {
+        RTC_LOG(LS_WARNING) << "pthread_setaffinity_np error: " << strerror(ret)
+            << ", cpu: " << cpu;
+        return -1;
+    }
+
+    return 0;
+}
+
+int get_cpu_numa_node(int cpu) {
+    if (cpu < 0) {
+        return -1;
+    }
+
+    // /sys/devices/system/cpu/cpuN/目录下有一个nodeX的链接
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    if (!dir) {
+        return -1;
+    }
+
+    int node = -1;
+    struct dirent* entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0'
+                && entry->d_name[4] <= '9')
+        {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+
+    closedir(dir);
+    return node;
+}
+
+int set_preferred_numa_node(int node) {
+    if (node < 0 || node >= (int)(sizeof(unsigned long) * 8)) {
+        return -1;
+    }
+
+    // 不依赖libnuma，直接调用set_mempolicy，内核会把maxnode减1，所以多传一位
+    unsigned long nodemask = 1UL << node;
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &nodemask,
+                sizeof(nodemask) * 8 + 1) != 0)
+    {
+        RTC_LOG(LS_WARNING) << "set_mempolicy error: " << strerror(errno)
+            << ", errno: " << errno << ", node: " << node;
+        return -1;
+    }
+
+    return 0;
+}
+
+} // namespace xrtc
@@ -0,0 +1,30 @@
+/**
+ * @file cpu_affinity.h
+ * @author charles
+ * @brief 线程绑核和NUMA内存策略
+ *         绑核后线程申请的内存优先放在该核所在的NUMA节点上，
+ *         之后在该线程中创建的对象(包缓存池、会话等)都是本地内存
+*/
+
+#ifndef __BASE_CPU_AFFINITY_H_
+#define __BASE_CPU_AFFINITY_H_
+
+#include <vector>
+
+namespace xrtc {
+
+// 按worker_id在核列表中轮流选择，列表为空返回-1
+int select_worker_cpu(const std::vector<int>& cpus, int worker_id);
+
+// 把当前线程绑定到指定的核
+int bind_thread_to_cpu(int cpu);
+
+// 返回cpu所在的NUMA节点，非NUMA系统或者获取失败返回-1
+int get_cpu_numa_node(int cpu);
+
+// 当前线程之后申请的内存优先从node分配，node内存不足时回退到其他节点
+int set_preferred_numa_node(int node);
+
+} // namespace xrtc
+
+#endif // __BASE_CPU_AFFINITY_H_
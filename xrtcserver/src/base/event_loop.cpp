@@ -1,5 +1,7 @@
+#include <time.h>
 
 #include "base/event_loop.h"
+#include "base/io_uring.h"
 
 #define TRANS_TO_EV_MASK(mask) \
     (((mask) & EventLoop::READ ? EV_READ : 0) | ((mask) & EventLoop::WRITE ? EV_WRITE : 0))
@@ -9,16 +11,51 @@
 
 namespace xrtc {
 
+// 时间轮每个tick 5ms，1024个slot，一圈约5s，更长的定时器用圈数表示
+const unsigned int k_wheel_tick_usec = 5000;
+const size_t k_wheel_slot_num = 1024;
+
+static uint64_t monotonic_usec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// libev在阻塞等待之前调用release，返回之后调用acquire，两者之间的时间是空闲时间
+void loop_release_cb(struct ev_loop *loop) {
+    EventLoop *el = (EventLoop*)ev_userdata(loop);
+    uint64_t busy = monotonic_usec() - el->busy_start_usec_;
+    el->busy_usec_ += busy;
+    el->iteration_histogram_.add(busy);
+}
+
+void loop_acquire_cb(struct ev_loop *loop) {
+    EventLoop *el = (EventLoop*)ev_userdata(loop);
+    el->busy_start_usec_ = monotonic_usec();
+}
+
 EventLoop::EventLoop(void *owner) :
     owner_(owner),
     loop_(ev_loop_new(EVFLAG_AUTO))
 {
+    ev_set_userdata(loop_, this);
+    ev_set_loop_release_cb(loop_, loop_release_cb, loop_acquire_cb);
 }
 
 EventLoop::~EventLoop() {
+    if (io_uring_) {
+        delete io_uring_;
+        io_uring_ = nullptr;
+    }
+
+    if (wheel_driver_) {
+        delete_timer(wheel_driver_);
+        wheel_driver_ = nullptr;
+    }
 }
 
 void EventLoop::start() {
+    busy_start_usec_ = monotonic_usec();
     ev_run(loop_);
 }
 
@@ -98,6 +135,19 @@ TimerWatcher* EventLoop::create_timer(time_cb_t cb, void *data, bool need_repeat
 }
 
 void EventLoop::start_timer(TimerWatcher *w, unsigned int usec) {
+    if (w->in_wheel) {
+        // 向上取整，保证不会提前触发
+        uint32_t ticks = (usec + k_wheel_tick_usec - 1) / k_wheel_tick_usec;
+        if (ticks == 0) {
+            ticks = 1;
+        }
+
+        _wheel_remove(w);
+        w->interval_ticks = ticks;
+        _wheel_insert(w, ticks);
+        return;
+    }
+
     struct ev_timer* timer = &(w->timer);
     float sec = float(usec) / 1000000;
 
@@ -112,6 +162,11 @@ void EventLoop::start_timer(TimerWatcher *w, unsigned int usec) {
 }
 
 void EventLoop::stop_timer(TimerWatcher *w) {
+    if (w->in_wheel) {
+        _wheel_remove(w);
+        return;
+    }
+
     struct ev_timer* timer = &(w->timer);
     ev_timer_stop(loop_, timer);
 }
@@ -122,6 +177,217 @@ void EventLoop::delete_timer(TimerWatcher *w) {
     w = nullptr;
 }
 
+void EventLoop::detach_io_event(IOWatcher *w) {
+    struct ev_io *io = &(w->io);
+    w->detached_mask = ev_is_active(io) ? TRANS_FROM_EV_MASK(io->events) : 0;
+    ev_io_stop(loop_, io);
+}
+
+void EventLoop::attach_io_event(IOWatcher *w) {
+    w->el = this;
+    if (w->detached_mask) {
+        start_io_event(w, w->io.fd, w->detached_mask);
+        w->detached_mask = 0;
+    }
+}
+
+void EventLoop::detach_timer(TimerWatcher *w) {
+    w->detached_usec = 0;
+
+    if (w->in_wheel) {
+        if (!w->wheel_active) {
+            return;
+        }
+
+        // 距离到期的tick数，wheel_tick_可能落后于当前时间，需要减去落后的部分
+        uint64_t ticks = (w->slot - wheel_tick_) & (k_wheel_slot_num - 1);
+        if (0 == ticks) {
+            ticks = k_wheel_slot_num;
+        }
+        ticks += (uint64_t)w->rounds * k_wheel_slot_num;
+
+        uint64_t now_tick = _wheel_now_tick();
+        uint64_t lag = now_tick > wheel_tick_ ? now_tick - wheel_tick_ : 0;
+        ticks = ticks > lag + 1 ? ticks - lag : 1;
+
+        w->detached_usec = ticks * k_wheel_tick_usec;
+        _wheel_remove(w);
+        return;
+    }
+
+    struct ev_timer* timer = &(w->timer);
+    if (!ev_is_active(timer)) {
+        return;
+    }
+
+    ev_tstamp remaining = ev_timer_remaining(loop_, timer);
+    w->detached_usec = remaining > 0 ? (uint64_t)(remaining * 1000000) : 0;
+    if (0 == w->detached_usec) {
+        w->detached_usec = 1;
+    }
+    ev_timer_stop(loop_, timer);
+}
+
+void EventLoop::attach_timer(TimerWatcher *w) {
+    w->el = this;
+    if (0 == w->detached_usec) {
+        return;
+    }
+
+    uint64_t usec = w->detached_usec;
+    w->detached_usec = 0;
+
+    if (w->in_wheel) {
+        // 保留原来的周期，只有第一次按剩余时间触发
+        uint64_t ticks = (usec + k_wheel_tick_usec - 1) / k_wheel_tick_usec;
+        _wheel_insert(w, ticks > 0 ? (uint32_t)ticks : 1);
+        return;
+    }
+
+    struct ev_timer* timer = &(w->timer);
+    ev_timer_set(timer, float(usec) / 1000000, w->need_repeat ? timer->repeat : 0);
+    ev_timer_start(loop_, timer);
+}
+
+TimerWatcher* EventLoop::create_wheel_timer(time_cb_t cb, void *data, bool need_repeat) {
+    TimerWatcher *watcher = new TimerWatcher(this, cb, data, need_repeat);
+    watcher->in_wheel = true;
+    return watcher;
+}
+
+uint64_t EventLoop::_wheel_now_tick() {
+    return now() / k_wheel_tick_usec;
+}
+
+void wheel_tick_cb(EventLoop *el, TimerWatcher * /*w*/, void * /*data*/) {
+    el->_wheel_advance();
+}
+
+void EventLoop::_wheel_insert(TimerWatcher *w, uint32_t ticks) {
+    if (wheel_slots_.empty()) {
+        wheel_slots_.resize(k_wheel_slot_num, nullptr);
+    }
+
+    if (0 == wheel_timer_count_) {
+        // 时间轮从空闲状态恢复，从当前时间开始计tick
+        wheel_tick_ = _wheel_now_tick();
+        if (!wheel_driver_) {
+            wheel_driver_ = create_timer(wheel_tick_cb, nullptr, true);
+        }
+        start_timer(wheel_driver_, k_wheel_tick_usec);
+    }
+
+    // 插入到链表头部，正在处理的slot中新插入的定时器本轮不会被遍历到
+    w->slot = (wheel_tick_ + ticks) & (k_wheel_slot_num - 1);
+    w->rounds = (ticks - 1) / k_wheel_slot_num;
+    w->wheel_prev = nullptr;
+    w->wheel_next = wheel_slots_[w->slot];
+    if (w->wheel_next) {
+        w->wheel_next->wheel_prev = w;
+    }
+    wheel_slots_[w->slot] = w;
+    w->wheel_active = true;
+    ++wheel_timer_count_;
+}
+
+void EventLoop::_wheel_remove(TimerWatcher *w) {
+    if (!w->wheel_active) {
+        return;
+    }
+
+    if (wheel_cursor_ == w) {
+        wheel_cursor_ = w->wheel_next;
+    }
+
+    if (w->wheel_prev) {
+        w->wheel_prev->wheel_next = w->wheel_next;
+    } else {
+        wheel_slots_[w->slot] = w->wheel_next;
+    }
+
+    if (w->wheel_next) {
+        w->wheel_next->wheel_prev = w->wheel_prev;
+    }
+
+    w->wheel_prev = nullptr;
+    w->wheel_next = nullptr;
+    w->wheel_active = false;
+
+    if (--wheel_timer_count_ == 0 && wheel_driver_) {
+        stop_timer(wheel_driver_);
+    }
+}
+
+void EventLoop::_wheel_advance() {
+    // 事件循环有延迟时补齐落后的tick
+    uint64_t now_tick = _wheel_now_tick();
+    while (wheel_tick_ < now_tick && wheel_timer_count_ > 0) {
+        ++wheel_tick_;
+        size_t slot = wheel_tick_ & (k_wheel_slot_num - 1);
+
+        TimerWatcher *w = wheel_slots_[slot];
+        while (w) {
+            wheel_cursor_ = w->wheel_next;
+            if (w->rounds > 0) {
+                --w->rounds;
+            } else {
+                // 重复定时器在回调之前重新插入，回调中可以安全地stop/delete/restart
+                _wheel_remove(w);
+                if (w->need_repeat) {
+                    _wheel_insert(w, w->interval_ticks);
+                }
+                w->cb(this, w, w->data);
+            }
+            w = wheel_cursor_;
+        }
+        wheel_cursor_ = nullptr;
+    }
+
+    if (wheel_tick_ < now_tick) {
+        wheel_tick_ = now_tick;
+    }
+}
+
+static void generic_prepare_cb(struct ev_loop * /*loop*/, struct ev_prepare *prepare, int /*events*/) {
+    PrepareWatcher *watcher = (PrepareWatcher*)(prepare->data);
+    watcher->cb(watcher->el, watcher, watcher->data);
+}
+
+PrepareWatcher* EventLoop::create_prepare_event(prepare_cb_t cb, void *data) {
+    PrepareWatcher *watcher = new PrepareWatcher(this, cb, data);
+    ev_init(&(watcher->prepare), generic_prepare_cb);
+    return watcher;
+}
+
+void EventLoop::start_prepare_event(PrepareWatcher *w) {
+    ev_prepare_start(loop_, &(w->prepare));
+}
+
+void EventLoop::stop_prepare_event(PrepareWatcher *w) {
+    ev_prepare_stop(loop_, &(w->prepare));
+}
+
+void EventLoop::delete_prepare_event(PrepareWatcher *w) {
+    stop_prepare_event(w);
+    delete w;
+    w = nullptr;
+}
+
+int EventLoop::enable_io_uring(unsigned int entries) {
+    if (io_uring_) {
+        return 0;
+    }
+
+    IoUring *ring = new IoUring(this);
+    if (ring->init(entries) != 0) {
+        delete ring;
+        return -1;
+    }
+
+    io_uring_ = ring;
+    return 0;
+}
+
 unsigned long EventLoop::now() {
     return static_cast<unsigned long>(ev_now(loop_) * 1000000);
 }
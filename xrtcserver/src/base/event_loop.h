@@ -7,16 +7,25 @@
 #ifndef __BASE_EVENT_LOOP_H_
 #define __BASE_EVENT_LOOP_H_
 
+#include <stdint.h>
+
+#include <vector>
+
 #include <libev/ev.h>
 
+#include "base/latency_histogram.h"
+
 namespace xrtc {
 
 class EventLoop;
 class IOWatcher;
 class TimerWatcher;
+class PrepareWatcher;
+class IoUring;
 
 typedef void(*io_cb_t)(EventLoop *el, IOWatcher *w, int fd, int event, void *data);
 typedef void(*time_cb_t)(EventLoop *el, TimerWatcher *w, void *data);
+typedef void(*prepare_cb_t)(EventLoop *el, PrepareWatcher *w, void *data);
 
 class EventLoop {
 public:
@@ -44,10 +53,66 @@ public:
     void stop_timer(TimerWatcher *w);
     void delete_timer(TimerWatcher *w);
 
+    // 时间轮定时器，精度为一个tick(k_wheel_tick_usec)
+    // 会话级别的大量定时器使用时间轮，整个worker只占用一个libev定时器，
+    // 同一个tick到期的定时器在一次回调中批量处理，start/stop/delete和普通定时器一样使用
+    TimerWatcher* create_wheel_timer(time_cb_t cb, void *data, bool need_repeat = true);
+    size_t wheel_timer_count() { return wheel_timer_count_; }
+
+    // 每轮事件循环阻塞等待之前回调，用于批量提交本轮产生的数据
+    PrepareWatcher* create_prepare_event(prepare_cb_t cb, void *data);
+    void start_prepare_event(PrepareWatcher *w);
+    void stop_prepare_event(PrepareWatcher *w);
+    void delete_prepare_event(PrepareWatcher *w);
+
+    // 开启io_uring，UDP收发改为通过io_uring提交，失败时返回-1，继续使用libev
+    // 必须在创建socket之前调用
+    int enable_io_uring(unsigned int entries);
+    IoUring* io_uring() { return io_uring_; }
+
+    // 把watcher从当前EventLoop摘下，之后在另一个线程的EventLoop上attach恢复，
+    // 用于会话在worker之间迁移。detach在当前EventLoop线程调用，attach在目标EventLoop线程调用，
+    // 定时器保留剩余时间，IO事件保留监听的事件
+    void detach_io_event(IOWatcher *w);
+    void attach_io_event(IOWatcher *w);
+    void detach_timer(TimerWatcher *w);
+    void attach_timer(TimerWatcher *w);
+
+    // 事件循环处理事件的累计时间(不包括阻塞等待)，只能在EventLoop线程读取
+    uint64_t busy_usec() { return busy_usec_; }
+
+    // 事件循环已经执行的轮数，同一轮中的回调得到相同的值
+    unsigned int iteration() { return ev_iteration(loop_); }
+
+    // 每轮事件循环处理时间(不包括阻塞等待)的累计分布，只能在EventLoop线程读取
+    const LatencyHistogram& iteration_histogram() { return iteration_histogram_; }
+
+private:
+    friend void wheel_tick_cb(EventLoop *el, TimerWatcher *w, void *data);
+    friend void loop_release_cb(struct ev_loop *loop);
+    friend void loop_acquire_cb(struct ev_loop *loop);
+
+    void _wheel_insert(TimerWatcher *w, uint32_t ticks);
+    void _wheel_remove(TimerWatcher *w);
+    void _wheel_advance();
+    uint64_t _wheel_now_tick();
+
 private:
     void *owner_;
     struct ev_loop *loop_;
-    
+
+    std::vector<TimerWatcher*> wheel_slots_;
+    uint64_t wheel_tick_ = 0;
+    size_t wheel_timer_count_ = 0;
+    // 正在处理的slot中下一个要处理的定时器，回调中删除定时器时需要修正
+    TimerWatcher *wheel_cursor_ = nullptr;
+    TimerWatcher *wheel_driver_ = nullptr;
+
+    IoUring *io_uring_ = nullptr;
+
+    uint64_t busy_usec_ = 0;
+    uint64_t busy_start_usec_ = 0;
+    LatencyHistogram iteration_histogram_;
 };
 
 class IOWatcher {
@@ -64,6 +129,8 @@ public:
     ev_io io;
     io_cb_t cb;
     void *data;
+    // detach时正在监听的事件
+    int detached_mask = 0;
 };
 
 class TimerWatcher {
@@ -82,6 +149,33 @@ public:
     time_cb_t cb;
     void *data;
     bool need_repeat = false;
+    // detach时的剩余时间，0表示没有启动
+    uint64_t detached_usec = 0;
+
+    // 时间轮定时器使用
+    bool in_wheel = false;
+    bool wheel_active = false;
+    uint32_t interval_ticks = 0;
+    uint32_t rounds = 0;
+    uint32_t slot = 0;
+    TimerWatcher *wheel_prev = nullptr;
+    TimerWatcher *wheel_next = nullptr;
+};
+
+class PrepareWatcher {
+public:
+    PrepareWatcher(EventLoop *el, prepare_cb_t cb, void *data) :
+        el(el),
+        cb(cb),
+        data(data) {
+        prepare.data = this;
+    }
+
+public:
+    EventLoop *el;
+    struct ev_prepare prepare;
+    prepare_cb_t cb;
+    void *data;
 };
 
 } // namespace xrtc
@@ -0,0 +1,92 @@
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/eventfd.h>
+
+#include <rtc_base/logging.h>
+
+#include "base/event_loop.h"
+#include "base/event_notifier.h"
+
+namespace xrtc {
+
+void event_notifier_recv_cb(EventLoop * /*el*/, IOWatcher * /*w*/, int fd, int /*event*/,
+        void *data)
+{
+    uint64_t value = 0;
+    if (read(fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        RTC_LOG(LS_WARNING) << "read from eventfd error: " << strerror(errno) << ", errno: " << errno;
+    }
+
+    EventNotifier *notifier = (EventNotifier*)data;
+    notifier->_process();
+}
+
+EventNotifier::EventNotifier(EventLoop *el, notify_cb_t cb, void *data) :
+    el_(el), cb_(cb), data_(data)
+{
+}
+
+EventNotifier::~EventNotifier() {
+    if (io_watcher_) {
+        el_->delete_io_event(io_watcher_);
+        io_watcher_ = nullptr;
+    }
+
+    if (event_fd_ >= 0) {
+        close(event_fd_);
+        event_fd_ = -1;
+    }
+}
+
+int EventNotifier::init() {
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0) {
+        RTC_LOG(LS_ERROR) << "create eventfd error: " << strerror(errno) << ", errno: " << errno;
+        return -1;
+    }
+
+    io_watcher_ = el_->create_io_event(event_notifier_recv_cb, this);
+    el_->start_io_event(io_watcher_, event_fd_, EventLoop::READ);
+
+    return 0;
+}
+
+int EventNotifier::notify(int msg) {
+    if (msg < 0 || msg > k_max_msg) {
+        return -1;
+    }
+
+    // 调用方先写队列再通知，bit之前已经置位说明还没有被处理，不需要再唤醒
+    uint32_t prev = pending_.fetch_or(1u << msg, std::memory_order_acq_rel);
+    if (prev != 0) {
+        return 0;
+    }
+
+    uint64_t value = 1;
+    if (write(event_fd_, &value, sizeof(value)) != sizeof(value)) {
+        RTC_LOG(LS_WARNING) << "write to eventfd error: " << strerror(errno) << ", errno: " << errno;
+        return -1;
+    }
+
+    return 0;
+}
+
+void EventNotifier::_process() {
+    // 先清除再处理，处理过程中新来的通知会再次唤醒
+    uint32_t msgs = pending_.exchange(0, std::memory_order_acq_rel);
+    if (0 == msgs) {
+        return;
+    }
+
+    ++wakeups_;
+
+    // 从大到小处理，QUIT(0)放在最后
+    for (int msg = k_max_msg; msg >= 0; --msg) {
+        if (msgs & (1u << msg)) {
+            cb_(el_, msg, data_);
+        }
+    }
+}
+
+} // namespace xrtc
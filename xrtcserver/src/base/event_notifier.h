@@ -0,0 +1,56 @@
+/**
+ * @file event_notifier.h
+ * @author charles
+ * @brief 基于eventfd的线程间通知
+ *         每种消息对应一个bit，多次通知在被处理之前只唤醒一次，
+ *         唤醒后把所有置位的消息一起交给回调，回调需要处理完对应队列中的全部数据
+*/
+
+#ifndef __BASE_EVENT_NOTIFIER_H_
+#define __BASE_EVENT_NOTIFIER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+namespace xrtc {
+
+class EventLoop;
+class IOWatcher;
+class EventNotifier;
+
+typedef void(*notify_cb_t)(EventLoop *el, int msg, void *data);
+
+class EventNotifier {
+public:
+    // 消息的取值范围是[0, k_max_msg]
+    static const int k_max_msg = 31;
+
+    EventNotifier(EventLoop *el, notify_cb_t cb, void *data);
+    ~EventNotifier();
+
+    int init();
+    // 可以在任意线程调用
+    int notify(int msg);
+
+    uint64_t wakeups() const { return wakeups_; }
+
+private:
+    friend void event_notifier_recv_cb(EventLoop *el, IOWatcher *w, int fd, int event, void *data);
+
+    void _process();
+
+private:
+    EventLoop *el_;
+    notify_cb_t cb_;
+    void *data_;
+
+    int event_fd_ = -1;
+    IOWatcher *io_watcher_ = nullptr;
+    std::atomic<uint32_t> pending_{0};
+    uint64_t wakeups_ = 0;
+};
+
+} // namespace xrtc
+
+#endif // __BASE_EVENT_NOTIFIER_H_
@@ -0,0 +1,343 @@
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+
+#include <algorithm>
+
+#include <rtc_base/logging.h>
+
+#include "base/event_loop.h"
+#include "base/io_uring.h"
+
+namespace xrtc {
+
+static int sys_io_uring_setup(unsigned int entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete,
+        unsigned int flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned int opcode, const void *arg, unsigned int nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+template <typename T>
+static T* ring_offset(void *base, uint32_t offset) {
+    return (T*)((char*)base + offset);
+}
+
+// 内核头文件中bufs是__DECLARE_FLEX_ARRAY声明的，C++下前面的空结构体占位会让bufs偏移8字节，
+// 这里直接按照io_uring_buf数组访问，tail和bufs[0]的resv字段重叠
+static struct io_uring_buf* ring_buf(struct io_uring_buf_ring *ring, unsigned int index) {
+    return (struct io_uring_buf*)ring + index;
+}
+
+void uring_event_cb(EventLoop * /*el*/, IOWatcher * /*w*/, int fd, int /*event*/, void *data) {
+    uint64_t value = 0;
+    while (read(fd, &value, sizeof(value)) > 0) {
+    }
+
+    IoUring *ring = (IoUring*)data;
+    ring->_reap();
+}
+
+void uring_prepare_cb(EventLoop *el, PrepareWatcher *w, void *data) {
+    IoUring *ring = (IoUring*)data;
+    ring->submit();
+
+    // 回调过程中可能产生新的完成事件(例如内联完成的发送)，阻塞前处理掉
+    ring->_reap();
+    if (ring->sqe_tail_ == __atomic_load_n(ring->sq_head_, __ATOMIC_ACQUIRE)) {
+        el->stop_prepare_event(w);
+        ring->prepare_started_ = false;
+    }
+}
+
+IoUring::IoUring(EventLoop *el) :
+    el_(el)
+{
+}
+
+IoUring::~IoUring() {
+    if (event_watcher_) {
+        el_->delete_io_event(event_watcher_);
+        event_watcher_ = nullptr;
+    }
+
+    if (prepare_watcher_) {
+        el_->delete_prepare_event(prepare_watcher_);
+        prepare_watcher_ = nullptr;
+    }
+
+    for (auto& group : buffer_groups_) {
+        if (group.ring) {
+            munmap(group.ring, group.ring_size);
+        }
+        delete[] group.bufs;
+    }
+    buffer_groups_.clear();
+
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+    }
+
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_size_);
+    }
+
+    if (sq_ptr_) {
+        munmap(sq_ptr_, sq_size_);
+    }
+
+    if (event_fd_ >= 0) {
+        close(event_fd_);
+        event_fd_ = -1;
+    }
+
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+}
+
+int IoUring::init(unsigned int entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // multishot接收会产生大量完成事件，CQ比SQ大
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    ring_fd_ = sys_io_uring_setup(entries, &params);
+    if (ring_fd_ < 0) {
+        RTC_LOG(LS_WARNING) << "io_uring setup failed, err: " << strerror(errno);
+        return -1;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == sq_ptr_) {
+        sq_ptr_ = nullptr;
+        RTC_LOG(LS_WARNING) << "io_uring mmap sq ring failed, err: " << strerror(errno);
+        return -1;
+    }
+
+    if (single_mmap) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ring_fd_, IORING_OFF_CQ_RING);
+        if (MAP_FAILED == cq_ptr_) {
+            cq_ptr_ = nullptr;
+            RTC_LOG(LS_WARNING) << "io_uring mmap cq ring failed, err: " << strerror(errno);
+            return -1;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_SQES);
+    if (MAP_FAILED == sqes) {
+        RTC_LOG(LS_WARNING) << "io_uring mmap sqes failed, err: " << strerror(errno);
+        return -1;
+    }
+    sqes_ = (struct io_uring_sqe*)sqes;
+
+    sq_head_ = ring_offset<unsigned int>(sq_ptr_, params.sq_off.head);
+    sq_tail_ = ring_offset<unsigned int>(sq_ptr_, params.sq_off.tail);
+    sq_mask_ = *ring_offset<unsigned int>(sq_ptr_, params.sq_off.ring_mask);
+    sq_entries_ = *ring_offset<unsigned int>(sq_ptr_, params.sq_off.ring_entries);
+    sq_array_ = ring_offset<unsigned int>(sq_ptr_, params.sq_off.array);
+    sq_flags_ = ring_offset<unsigned int>(sq_ptr_, params.sq_off.flags);
+    sqe_tail_ = *sq_tail_;
+
+    cq_head_ = ring_offset<unsigned int>(cq_ptr_, params.cq_off.head);
+    cq_tail_ = ring_offset<unsigned int>(cq_ptr_, params.cq_off.tail);
+    cq_mask_ = *ring_offset<unsigned int>(cq_ptr_, params.cq_off.ring_mask);
+    cqes_ = ring_offset<struct io_uring_cqe>(cq_ptr_, params.cq_off.cqes);
+
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0) {
+        RTC_LOG(LS_WARNING) << "create eventfd failed, err: " << strerror(errno);
+        return -1;
+    }
+
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_EVENTFD, &event_fd_, 1) < 0) {
+        RTC_LOG(LS_WARNING) << "io_uring register eventfd failed, err: " << strerror(errno);
+        return -1;
+    }
+
+    event_watcher_ = el_->create_io_event(uring_event_cb, this);
+    el_->start_io_event(event_watcher_, event_fd_, EventLoop::READ);
+    prepare_watcher_ = el_->create_prepare_event(uring_prepare_cb, this);
+
+    RTC_LOG(LS_INFO) << "io_uring init ok, sq_entries: " << params.sq_entries
+        << ", cq_entries: " << params.cq_entries;
+
+    return 0;
+}
+
+struct io_uring_sqe* IoUring::get_sqe(IoUringOp *op) {
+    unsigned int head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sqe_tail_ - head >= sq_entries_) {
+        submit();
+        head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sqe_tail_ - head >= sq_entries_) {
+            return nullptr;
+        }
+    }
+
+    unsigned int index = sqe_tail_ & sq_mask_;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    sq_array_[index] = index;
+    ++sqe_tail_;
+
+    // 本轮事件循环阻塞之前统一提交
+    if (!prepare_started_) {
+        el_->start_prepare_event(prepare_watcher_);
+        prepare_started_ = true;
+    }
+
+    return sqe;
+}
+
+int IoUring::submit() {
+    if (sqe_tail_ != *sq_tail_) {
+        __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+    }
+
+    unsigned int to_submit = sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (0 == to_submit) {
+        return 0;
+    }
+
+    int ret = sys_io_uring_enter(ring_fd_, to_submit, 0, 0);
+    ++submit_syscalls_;
+    if (ret < 0) {
+        // EAGAIN/EBUSY时SQE仍在队列中，下一轮再提交
+        if (errno != EAGAIN && errno != EBUSY && errno != EINTR) {
+            RTC_LOG(LS_WARNING) << "io_uring enter failed, err: " << strerror(errno);
+        }
+        return -1;
+    }
+
+    return ret;
+}
+
+void IoUring::_reap() {
+    unsigned int head = *cq_head_;
+    while (true) {
+        unsigned int tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            // CQ溢出时内核把完成事件暂存起来，需要主动取回
+            if (!(__atomic_load_n(sq_flags_, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW)) {
+                break;
+            }
+            sys_io_uring_enter(ring_fd_, 0, 0, IORING_ENTER_GETEVENTS);
+            if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            continue;
+        }
+
+        // 先拷贝出来再释放CQ的位置，回调里可以继续提交请求
+        struct io_uring_cqe cqe = cqes_[head & cq_mask_];
+        ++head;
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        ++completions_;
+
+        IoUringOp *op = (IoUringOp*)(uintptr_t)cqe.user_data;
+        if (op && op->cb) {
+            op->cb(this, &cqe, op->data);
+        }
+    }
+}
+
+int IoUring::register_buffer_group(uint16_t bgid, unsigned int buf_num, size_t buf_size) {
+    if (has_buffer_group(bgid)) {
+        return 0;
+    }
+
+    if (0 == buf_num || (buf_num & (buf_num - 1)) != 0 || buf_num > 32768) {
+        return -1;
+    }
+
+    BufferGroup group;
+    group.buf_num = buf_num;
+    group.buf_size = buf_size;
+    group.ring_size = buf_num * sizeof(struct io_uring_buf);
+    void *ring = mmap(nullptr, group.ring_size, PROT_READ | PROT_WRITE,
+            MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (MAP_FAILED == ring) {
+        return -1;
+    }
+    group.ring = (struct io_uring_buf_ring*)ring;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring;
+    reg.ring_entries = buf_num;
+    reg.bgid = bgid;
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        RTC_LOG(LS_WARNING) << "io_uring register buffer ring failed, bgid: " << bgid
+            << ", err: " << strerror(errno);
+        munmap(ring, group.ring_size);
+        return -1;
+    }
+
+    group.bufs = new char[buf_num * buf_size];
+    for (unsigned int i = 0; i < buf_num; ++i) {
+        struct io_uring_buf *buf = ring_buf(group.ring, i);
+        buf->addr = (uint64_t)(uintptr_t)(group.bufs + i * buf_size);
+        buf->len = buf_size;
+        buf->bid = i;
+    }
+    __atomic_store_n(&group.ring->tail, (uint16_t)buf_num, __ATOMIC_RELEASE);
+
+    if (buffer_groups_.size() <= bgid) {
+        buffer_groups_.resize(bgid + 1);
+    }
+    buffer_groups_[bgid] = group;
+
+    return 0;
+}
+
+bool IoUring::has_buffer_group(uint16_t bgid) const {
+    return bgid < buffer_groups_.size() && buffer_groups_[bgid].ring != nullptr;
+}
+
+char* IoUring::buffer(uint16_t bgid, uint16_t bid) {
+    const BufferGroup& group = buffer_groups_[bgid];
+    return group.bufs + (size_t)bid * group.buf_size;
+}
+
+size_t IoUring::buffer_size(uint16_t bgid) const {
+    return buffer_groups_[bgid].buf_size;
+}
+
+void IoUring::recycle_buffer(uint16_t bgid, uint16_t bid) {
+    BufferGroup& group = buffer_groups_[bgid];
+    uint16_t tail = group.ring->tail;
+    struct io_uring_buf *buf = ring_buf(group.ring, tail & (group.buf_num - 1));
+    buf->addr = (uint64_t)(uintptr_t)buffer(bgid, bid);
+    buf->len = group.buf_size;
+    buf->bid = bid;
+    __atomic_store_n(&group.ring->tail, (uint16_t)(tail + 1), __ATOMIC_RELEASE);
+}
+
+} // namespace xrtc
@@ -0,0 +1,108 @@
+/**
+ * @file io_uring.h
+ * @author charles
+ * @brief 基于系统调用的io_uring封装，不依赖liburing
+ *         完成事件通过注册的eventfd接入EventLoop，提交在每轮事件循环阻塞之前批量进行，
+ *         只能在EventLoop所在的线程中使用
+*/
+
+#ifndef __BASE_IO_URING_H_
+#define __BASE_IO_URING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include <linux/io_uring.h>
+
+namespace xrtc {
+
+class EventLoop;
+class IOWatcher;
+class PrepareWatcher;
+class IoUring;
+
+typedef void(*uring_cb_t)(IoUring *ring, const struct io_uring_cqe *cqe, void *data);
+
+// 提交的每个请求的user_data指向一个IoUringOp，完成时回调cb
+struct IoUringOp {
+    uring_cb_t cb = nullptr;
+    void *data = nullptr;
+};
+
+class IoUring {
+public:
+    explicit IoUring(EventLoop *el);
+    ~IoUring();
+
+    // 内核不支持或者被禁用时返回-1，调用方回退到libev
+    int init(unsigned int entries);
+
+    // 返回一个清零的SQE，SQ满时先提交再获取，仍然失败返回nullptr
+    struct io_uring_sqe* get_sqe(IoUringOp *op);
+    // 立即提交所有未提交的SQE，返回提交的个数
+    int submit();
+
+    // 注册provided buffer ring，buf_num必须是2的幂
+    int register_buffer_group(uint16_t bgid, unsigned int buf_num, size_t buf_size);
+    bool has_buffer_group(uint16_t bgid) const;
+    char* buffer(uint16_t bgid, uint16_t bid);
+    size_t buffer_size(uint16_t bgid) const;
+    // 数据处理完之后把缓冲区还给内核
+    void recycle_buffer(uint16_t bgid, uint16_t bid);
+
+    uint64_t submit_syscalls() const { return submit_syscalls_; }
+    uint64_t completions() const { return completions_; }
+
+private:
+    friend void uring_event_cb(EventLoop *el, IOWatcher *w, int fd, int event, void *data);
+    friend void uring_prepare_cb(EventLoop *el, PrepareWatcher *w, void *data);
+
+    void _reap();
+
+    struct BufferGroup {
+        struct io_uring_buf_ring *ring = nullptr;
+        size_t ring_size = 0;
+        unsigned int buf_num = 0;
+        size_t buf_size = 0;
+        char *bufs = nullptr;
+    };
+
+private:
+    EventLoop *el_;
+    int ring_fd_ = -1;
+    int event_fd_ = -1;
+    IOWatcher *event_watcher_ = nullptr;
+    PrepareWatcher *prepare_watcher_ = nullptr;
+    bool prepare_started_ = false;
+
+    void *sq_ptr_ = nullptr;
+    size_t sq_size_ = 0;
+    void *cq_ptr_ = nullptr;
+    size_t cq_size_ = 0;
+    struct io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned int *sq_head_ = nullptr;
+    unsigned int *sq_tail_ = nullptr;
+    unsigned int sq_mask_ = 0;
+    unsigned int sq_entries_ = 0;
+    unsigned int *sq_array_ = nullptr;
+    unsigned int *sq_flags_ = nullptr;
+    unsigned int sqe_tail_ = 0;
+
+    unsigned int *cq_head_ = nullptr;
+    unsigned int *cq_tail_ = nullptr;
+    unsigned int cq_mask_ = 0;
+    struct io_uring_cqe *cqes_ = nullptr;
+
+    std::vector<BufferGroup> buffer_groups_;
+
+    uint64_t submit_syscalls_ = 0;
+    uint64_t completions_ = 0;
+};
+
+} // namespace xrtc
+
+#endif // __BASE_IO_URING_H_
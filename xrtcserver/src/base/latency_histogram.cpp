@@ -0,0 +1,61 @@
+#include <sstream>
+
+#include "base/latency_histogram.h"
+
+namespace xrtc {
+
+// 桶的范围，最后一个桶没有上限
+static std::string bucket_range(size_t bucket) {
+    if (bucket + 1 == LatencyHistogram::k_bucket_num) {
+        return ">=" + std::to_string((uint64_t)1 << (bucket - 1)) + "us";
+    }
+    return "<" + std::to_string((uint64_t)1 << bucket) + "us";
+}
+
+void LatencyHistogram::add(uint64_t usec) {
+    size_t bucket = 0;
+    while (usec > 0 && bucket + 1 < k_bucket_num) {
+        usec >>= 1;
+        ++bucket;
+    }
+    ++buckets_[bucket];
+}
+
+std::string LatencyHistogram::report_since(LatencyHistogram* last) const {
+    uint64_t delta[k_bucket_num];
+    uint64_t total = 0;
+    for (size_t i = 0; i < k_bucket_num; ++i) {
+        delta[i] = buckets_[i] - last->buckets_[i];
+        last->buckets_[i] = buckets_[i];
+        total += delta[i];
+    }
+
+    if (0 == total) {
+        return "";
+    }
+
+    const double percentiles[] = {0.5, 0.99, 0.999};
+    const char* names[] = {"p50", "p99", "p999"};
+    std::stringstream ss;
+    ss << "count: " << total;
+    size_t p = 0;
+    uint64_t count = 0;
+    for (size_t i = 0; i < k_bucket_num && p < 3; ++i) {
+        count += delta[i];
+        while (p < 3 && count >= total * percentiles[p]) {
+            ss << ", " << names[p] << bucket_range(i);
+            ++p;
+        }
+    }
+
+    ss << ", histogram:";
+    for (size_t i = 0; i < k_bucket_num; ++i) {
+        if (delta[i] > 0) {
+            ss << " " << bucket_range(i) << "=" << delta[i];
+        }
+    }
+
+    return ss.str();
+}
+
+} // namespace xrtc
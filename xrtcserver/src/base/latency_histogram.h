@@ -0,0 +1,35 @@
+/**
+ * @file latency_histogram.h
+ * @author charles
+ * @brief 按2的幂分桶的耗时分布，只计数不加锁，只能在一个线程中使用
+*/
+
+#ifndef __BASE_LATENCY_HISTOGRAM_H_
+#define __BASE_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+namespace xrtc {
+
+class LatencyHistogram {
+public:
+    // 第0个桶是小于1us，第i个桶是[2^(i-1), 2^i)us，最后一个桶包括所有更长的时间
+    static const size_t k_bucket_num = 20;
+
+    void add(uint64_t usec);
+    uint64_t bucket(size_t i) const { return buckets_[i]; }
+
+    // 输出和last之间新增部分的个数、p50/p99/p999和分布，分位数用所在桶的范围表示，
+    // 之后把当前值保存到last，没有新增时返回空串
+    std::string report_since(LatencyHistogram* last) const;
+
+private:
+    uint64_t buckets_[k_bucket_num] = {0};
+};
+
+} // namespace xrtc
+
+#endif // __BASE_LATENCY_HISTOGRAM_H_
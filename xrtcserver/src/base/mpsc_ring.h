@@ -0,0 +1,103 @@
+/**
+ * @file mpsc_ring.h
+ * @author charles
+ * @brief 多个生产者，一个消费者的有界无锁环形队列
+ *         每个槽位带一个序号，生产者通过CAS抢占tail，不需要加锁，也不会为每个元素分配内存；
+ *         容量向上取整为2的幂，队列满时push返回false
+*/
+
+#ifndef __BASE_MPSC_RING_H_
+#define __BASE_MPSC_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace xrtc {
+
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+        mask_ = size - 1;
+    }
+
+    ~MpscRing() = default;
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // 可以在任意线程调用
+    bool push(const T& t) {
+        Cell* cell = nullptr;
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (0 == diff) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // 消费者还没有取走上一圈的数据，队列已满
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = t;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 只能在消费者线程调用
+    bool pop(T* result) {
+        Cell* cell = &cells_[head_ & mask_];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(head_ + 1) < 0) {
+            // 空队列，或者生产者抢到了位置还没有写完
+            return false;
+        }
+
+        *result = std::move(cell->value);
+        cell->value = T();
+        cell->seq.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+
+    // 生产者和消费者的索引放在不同的cache line，避免伪共享
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0;
+};
+
+} // namespace xrtc
+
+#endif // __BASE_MPSC_RING_H_
@@ -0,0 +1,100 @@
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "base/packet_buffer.h"
+
+namespace xrtc {
+
+const size_t k_max_free_packet_buffers = 4096;
+
+uint8_t* PacketBuffer::prepend(size_t len) {
+    if (len > offset_) {
+        return nullptr;
+    }
+
+    offset_ -= len;
+    size_ += len;
+    return storage_ + offset_;
+}
+
+void PacketBuffer::Release() const {
+    if (--ref_count_ == 0) {
+        pool_->_recycle(const_cast<PacketBuffer*>(this));
+    }
+}
+
+void PacketBuffer::_reset() {
+    ref_count_ = 0;
+    offset_ = k_packet_headroom;
+    size_ = 0;
+}
+
+PacketBufferPool::PacketBufferPool(size_t max_free_count) :
+    max_free_count_(max_free_count)
+{
+    free_list_.reserve(max_free_count_);
+}
+
+PacketBufferPool::~PacketBufferPool() {
+    for (auto buffer : free_list_) {
+        delete buffer;
+    }
+    free_list_.clear();
+}
+
+PacketBufferPool* PacketBufferPool::current() {
+    static thread_local std::unique_ptr<PacketBufferPool> pool;
+    if (!pool) {
+        pool = std::make_unique<PacketBufferPool>(k_max_free_packet_buffers);
+    }
+    return pool.get();
+}
+
+PacketBufferPtr PacketBufferPool::alloc() {
+    PacketBuffer* buffer = nullptr;
+    if (!free_list_.empty()) {
+        buffer = free_list_.back();
+        free_list_.pop_back();
+    } else {
+        buffer = new PacketBuffer(this);
+        ++allocated_count_;
+    }
+
+    buffer->_reset();
+    return PacketBufferPtr(buffer);
+}
+
+PacketBufferPtr PacketBufferPool::alloc(const void* data, size_t len) {
+    if (len > k_packet_buffer_size - k_packet_headroom) {
+        return nullptr;
+    }
+
+    PacketBufferPtr buffer = alloc();
+    memcpy(buffer->data(), data, len);
+    buffer->set_size(len);
+    return buffer;
+}
+
+void PacketBufferPool::prealloc(size_t count) {
+    count = std::min(count, max_free_count_);
+    while (free_list_.size() < count) {
+        PacketBuffer* buffer = new PacketBuffer(this);
+        memset(buffer->storage_, 0, sizeof(buffer->storage_));
+        ++allocated_count_;
+        free_list_.push_back(buffer);
+    }
+}
+
+void PacketBufferPool::_recycle(PacketBuffer* buffer) {
+    if (free_list_.size() >= max_free_count_) {
+        --allocated_count_;
+        delete buffer;
+        return;
+    }
+
+    free_list_.push_back(buffer);
+}
+
+} // namespace xrtc
@@ -0,0 +1,93 @@
+/**
+ * @file packet_buffer.h
+ * @author charles
+ * @brief 媒体包缓冲区和每个worker线程的缓冲池
+ *         缓冲区大小固定，前后预留空间(SRTP认证tag、RTX头等)，
+ *         引用计数不是原子的，只能在创建它的worker线程中使用
+*/
+
+#ifndef __BASE_PACKET_BUFFER_H_
+#define __BASE_PACKET_BUFFER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include <api/scoped_refptr.h>
+
+namespace xrtc {
+
+const size_t k_packet_buffer_size = 2048;
+const size_t k_packet_headroom = 64;
+
+class PacketBufferPool;
+
+class PacketBuffer {
+public:
+    uint8_t* data() { return storage_ + offset_; }
+    const uint8_t* data() const { return storage_ + offset_; }
+    size_t size() const { return size_; }
+    void set_size(size_t size) { size_ = size; }
+
+    // data()之后可以使用的空间，包括tailroom
+    size_t capacity() const { return k_packet_buffer_size - offset_; }
+    size_t headroom() const { return offset_; }
+
+    // 在数据前面预留len字节，返回新的起始地址，空间不够时返回nullptr
+    uint8_t* prepend(size_t len);
+
+    // rtc::scoped_refptr需要的接口，非原子操作
+    void AddRef() const { ++ref_count_; }
+    void Release() const;
+    bool HasOneRef() const { return 1 == ref_count_; }
+
+private:
+    friend class PacketBufferPool;
+
+    PacketBuffer(PacketBufferPool* pool) : pool_(pool) {}
+    ~PacketBuffer() = default;
+
+    void _reset();
+
+private:
+    PacketBufferPool* pool_;
+    mutable int ref_count_ = 0;
+    size_t offset_ = k_packet_headroom;
+    size_t size_ = 0;
+    uint8_t storage_[k_packet_buffer_size];
+};
+
+typedef rtc::scoped_refptr<PacketBuffer> PacketBufferPtr;
+
+class PacketBufferPool {
+public:
+    explicit PacketBufferPool(size_t max_free_count);
+    ~PacketBufferPool();
+
+    // 当前worker线程的缓冲池，第一次使用时在本线程创建
+    static PacketBufferPool* current();
+
+    PacketBufferPtr alloc();
+    PacketBufferPtr alloc(const void* data, size_t len);
+
+    // 在当前线程预先分配并写一遍缓冲区，让内存落在本线程所在的NUMA节点上
+    void prealloc(size_t count);
+
+    size_t allocated_count() const { return allocated_count_; }
+    size_t free_count() const { return free_list_.size(); }
+
+private:
+    friend class PacketBuffer;
+
+    void _recycle(PacketBuffer* buffer);
+
+private:
+    size_t max_free_count_;
+    size_t allocated_count_ = 0;
+    std::vector<PacketBuffer*> free_list_;
+};
+
+} // namespace xrtc
+
+#endif // __BASE_PACKET_BUFFER_H_
@@ -4,15 +4,24 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <sys/ioctl.h>
 
 #include <rtc_base/logging.h>
 
 #include "base/socket.h"
 
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+#ifndef SO_INCOMING_CPU
+#define SO_INCOMING_CPU 49
+#endif
+
 namespace xrtc {
 
-int create_tcp_server(const char* addr, int port) {
+int create_tcp_server(const char* addr, int port, bool reuse_port) {
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (-1 == sock) {
         RTC_LOG(LS_WARNING) << "create socket error, errno: " << errno << ", error: " << strerror(errno);
@@ -27,6 +36,15 @@ int create_tcp_server(const char* addr, int port) {
         return -1;
     }
 
+    if (reuse_port) {
+        ret = setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+        if (-1 == ret) {
+            RTC_LOG(LS_WARNING) << "setsockopt SO_REUSEPORT, errno: " << errno << ", error: " << strerror(errno);
+            close(sock);
+            return -1;
+        }
+    }
+
     struct sockaddr_in sa;
     sa.sin_family = AF_INET;
     sa.sin_port = htons(port);
@@ -63,6 +81,9 @@ int generic_accept(int sock, struct sockaddr *addr, socklen_t *len) {
         if (-1 == fd) {
             if (EINTR == errno) {
                 continue;
+            } else if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                // 非阻塞的监听socket已经没有新连接
+                return -1;
             } else {
                 RTC_LOG(LS_WARNING) << "tcp accept error:" << strerror(errno) << ", errno:" << errno;
                 return -1;
@@ -182,6 +203,19 @@ int sock_write_data(int sock, const char *buf, size_t len) {
     return nwritten;
 }
 
+int sock_writev_data(int sock, const struct iovec *iov, int iovcnt) {
+    int nwritten = writev(sock, iov, iovcnt);
+    if (-1 == nwritten) {
+        if (EAGAIN == errno || EINTR == errno) {
+            nwritten = 0;
+        } else {
+            RTC_LOG(LS_WARNING) << "sock writev failed, error:" << strerror(errno) << ", errno:" << errno << ", fd:" << sock;
+            return -1;
+        }
+    }
+    return nwritten;
+}
+
 int create_udp_socket(int family) {
     int sock = socket(family, SOCK_DGRAM, 0);
     if (-1 == sock) {
@@ -263,6 +297,56 @@ int64_t sock_get_recv_timestamp(int sock) {
     return time.tv_sec * 1000000 + time.tv_usec;
 }
 
+int sock_set_recv_timestamp(int sock) {
+    int on = 1;
+    int ret = setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    if (-1 == ret) {
+        RTC_LOG(LS_WARNING) << "setsockopt SO_TIMESTAMPNS error: " << strerror(errno)
+            << ", errno: " << errno;
+        return -1;
+    }
+
+    return 0;
+}
+
+int sock_set_udp_gro(int sock) {
+    int on = 1;
+    int ret = setsockopt(sock, SOL_UDP, UDP_GRO, &on, sizeof(on));
+    if (-1 == ret) {
+        RTC_LOG(LS_WARNING) << "setsockopt UDP_GRO error: " << strerror(errno)
+            << ", errno: " << errno;
+        return -1;
+    }
+
+    return 0;
+}
+
+int sock_set_incoming_cpu(int sock, int cpu) {
+    int ret = setsockopt(sock, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+    if (-1 == ret) {
+        RTC_LOG(LS_WARNING) << "setsockopt SO_INCOMING_CPU error: " << strerror(errno)
+            << ", errno: " << errno << ", cpu: " << cpu;
+        return -1;
+    }
+
+    return 0;
+}
+
+int sock_recv_mmsg(int sock, struct mmsghdr* msgs, unsigned int vlen) {
+    int received = recvmmsg(sock, msgs, vlen, 0, nullptr);
+    if (received < 0) {
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            received = 0;
+        } else {
+            RTC_LOG(LS_WARNING) << "recvmmsg error: " << strerror(errno)
+                << ", errno: " << errno;
+            return -1;
+        }
+    }
+
+    return received;
+}
+
 int sock_send_to(int sock, const char* buf, size_t len, int flag,
         struct sockaddr* addr, socklen_t addr_len)
 {
@@ -282,4 +366,20 @@ int sock_send_to(int sock, const char* buf, size_t len, int flag,
     return sent;
 }
 
+int sock_send_mmsg(int sock, struct mmsghdr* msgs, unsigned int vlen) {
+    int sent = sendmmsg(sock, msgs, vlen, MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            sent = 0;
+        } else {
+            int err = errno;
+            RTC_LOG(LS_WARNING) << "sendmmsg error: " << strerror(err) << ", errno: " << err;
+            errno = err;
+            return -1;
+        }
+    }
+
+    return sent;
+}
+
 }
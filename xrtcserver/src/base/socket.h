@@ -8,10 +8,12 @@
 #define __BASE_SOCKET_H_
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 namespace xrtc {
 
-int create_tcp_server(const char* addr, int port);
+// reuse_port为true时设置SO_REUSEPORT，多个线程各自监听同一个端口，由内核分发连接
+int create_tcp_server(const char* addr, int port, bool reuse_port = false);
 
 int tcp_accept(int sock, char *host, int *port);
 
@@ -25,6 +27,9 @@ int sock_read_data(int sock, char *buf, size_t len);
 
 int sock_write_data(int sock, const char *buf, size_t len);
 
+// 一次系统调用写入多段数据，缓冲区满时返回0
+int sock_writev_data(int sock, const struct iovec *iov, int iovcnt);
+
 int create_udp_socket(int family);
 
 int sock_bind(int sock, struct sockaddr* addr, socklen_t len, int min_port, int max_port);
@@ -35,8 +40,22 @@ int sock_recv_from(int sock, char* buf, size_t len, struct sockaddr* addr, sockl
 
 int64_t sock_get_recv_timestamp(int sock);
 
+// 通过控制消息(SCM_TIMESTAMPNS)携带内核接收时间，代替每个包一次ioctl
+int sock_set_recv_timestamp(int sock);
+
+int sock_set_udp_gro(int sock);
+
+// SO_INCOMING_CPU，让内核优先把cpu上收到的包交给该socket(对SO_REUSEPORT组内的选择生效)
+int sock_set_incoming_cpu(int sock, int cpu);
+
+// 一次系统调用接收多个数据包，返回接收到的包个数，没有数据时返回0
+int sock_recv_mmsg(int sock, struct mmsghdr* msgs, unsigned int vlen);
+
 int sock_send_to(int sock, const char* buf, size_t len, int flag, struct sockaddr* addr, socklen_t addr_len);
 
+// 一次系统调用发送多个数据包，返回发送成功的包个数，socket缓冲区满时返回0
+int sock_send_mmsg(int sock, struct mmsghdr* msgs, unsigned int vlen);
+
 } // end namespace xrtc
 
 #endif // __BASE_SOCKET_H_
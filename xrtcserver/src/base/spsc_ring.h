@@ -0,0 +1,91 @@
+/**
+ * @file spsc_ring.h
+ * @author charles
+ * @brief 一个生产者，一个消费者的有界无锁环形队列
+ *         容量向上取整为2的幂，队列满时push返回false，由调用方决定丢弃还是重试
+*/
+
+#ifndef __BASE_SPSC_RING_H_
+#define __BASE_SPSC_RING_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace xrtc {
+
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        buf_.resize(size);
+        mask_ = size - 1;
+    }
+
+    ~SpscRing() = default;
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // 只能在生产者线程调用
+    bool push(const T& t) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                return false;
+            }
+        }
+
+        buf_[tail & mask_] = t;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 只能在消费者线程调用
+    bool pop(T* result) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+
+        *result = std::move(buf_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+
+private:
+    std::vector<T> buf_;
+    size_t mask_ = 0;
+
+    // 生产者和消费者各自的索引放在不同的cache line，避免伪共享
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+};
+
+} // namespace xrtc
+
+#endif // __BASE_SPSC_RING_H_
@@ -145,6 +145,29 @@ void IceAgent::gathering_candidate() {
     }     
 }
 
+bool IceAgent::can_migrate() {
+    for (auto channel : channels_) {
+        if (!channel->can_migrate()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IceAgent::detach_event_loop() {
+    for (auto channel : channels_) {
+        channel->detach_event_loop();
+    }
+}
+
+void IceAgent::attach_event_loop(EventLoop* el, PortAllocator* allocator) {
+    el_ = el;
+    port_allocator_ = allocator;
+    for (auto channel : channels_) {
+        channel->attach_event_loop(el, allocator);
+    }
+}
+
 int IceAgent::send_unencrypted_rtcp(const std::string& transport_name, IceCandidateComponent component, const char* buf, size_t size) {
     IceTransportChannel* channel = get_channel(transport_name, component);
     if (channel) {
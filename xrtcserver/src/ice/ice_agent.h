@@ -45,6 +45,10 @@ public:
 
     IceTransportState ice_state() { return ice_state_; }
 
+    bool can_migrate();
+    void detach_event_loop();
+    void attach_event_loop(EventLoop* el, PortAllocator* allocator);
+
     sigslot::signal4<IceAgent*, const std::string&, IceCandidateComponent,
         const std::vector<Candidate>&> signal_candidate_allocate_done;
     sigslot::signal2<IceAgent*, IceTransportState> signal_ice_state;
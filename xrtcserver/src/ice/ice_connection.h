@@ -94,6 +94,8 @@ public:
     void update_state(int64_t now);
     int send_packet(const char* data, size_t len);
     void destroy();
+    // 迁移到另一个worker，没有watcher，只需要更新EventLoop
+    void attach_event_loop(EventLoop *el) { el_ = el; }
 
     sigslot::signal1<IceConnection*> signal_state_change;
     sigslot::signal1<IceConnection*> signal_connection_destroy;
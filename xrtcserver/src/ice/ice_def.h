@@ -12,7 +12,8 @@ namespace xrtc {
 #define LOCAL_PORT_TYPE "host"
 #define PRFLX_PORT_TYPE "prflx"
 
-const int ICE_UFRAG_LENGTH = 4;
+// 共享端口模式下按ufrag分发会话，加长ufrag避免冲突
+const int ICE_UFRAG_LENGTH = 16;
 const int ICE_PWD_LENGTH = 24;
 
 const int STUN_PACKET_SIZE = 60 * 8;
@@ -24,7 +24,7 @@ IceTransportChannel::IceTransportChannel(EventLoop* el, PortAllocator *allocator
 {
     RTC_LOG(LS_INFO) << "ice transport channel created, transport_name:" << transport_name_
         << ", component:" << component_;  
-    ping_watcher_ = el_->create_timer(ice_ping_cb, this, true);
+    ping_watcher_ = el_->create_wheel_timer(ice_ping_cb, this, true);
 }
 
 IceTransportChannel::~IceTransportChannel() {
@@ -48,6 +48,31 @@ IceTransportChannel::~IceTransportChannel() {
     RTC_LOG(LS_INFO) << to_string() << ": IceTransportChannel destroy";
 }
 
+bool IceTransportChannel::can_migrate() {
+    for (auto port : ports_) {
+        if (!port->can_migrate()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IceTransportChannel::detach_event_loop() {
+    el_->detach_timer(ping_watcher_);
+    for (auto port : ports_) {
+        port->detach_event_loop();
+    }
+}
+
+void IceTransportChannel::attach_event_loop(EventLoop* el, PortAllocator* allocator) {
+    el_ = el;
+    port_allocator_ = allocator;
+    el_->attach_timer(ping_watcher_);
+    for (auto port : ports_) {
+        port->attach_event_loop(el_, allocator);
+    }
+}
+
 void IceTransportChannel::set_ice_params(const IceParameters& ice_params) {
     RTC_LOG(LS_INFO) << "set ICE param, transport_name: " << transport_name_
         << ", component: " << component_
@@ -91,12 +116,27 @@ void IceTransportChannel::gathering_candidate() {
         return;
     }
 
+    // 共享端口模式下所有网络接口共用一个socket，只需要一个candidate
+    UdpPortMux* mux = port_allocator_->shared_port_mux();
+    if (mux) {
+        UDPPort* port = new UDPPort(el_, transport_name_, component_, ice_params_);
+        port->signal_unknown_address.connect(this, &IceTransportChannel::_on_unknown_address);
+        ports_.push_back(port);
+        Candidate c;
+        if (port->create_ice_candidate(network_list.front(), mux, c) == 0) {
+            local_candidates_.push_back(c);
+        }
+
+        signal_candidate_allocate_done(this, local_candidates_);
+        return;
+    }
+
     for (auto network : network_list) {
         UDPPort* port = new UDPPort(el_, transport_name_, component_, ice_params_);
         port->signal_unknown_address.connect(this, &IceTransportChannel::_on_unknown_address);     
         ports_.push_back(port); 
         Candidate c;
-        int ret = port->create_ice_candidate(network, port_allocator_->min_port(), port_allocator_->max_port(), c);
+        int ret = port->create_ice_candidate(network, port_allocator_, c);
         if (ret != 0) {
             continue;
         }
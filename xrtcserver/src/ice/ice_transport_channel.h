@@ -60,6 +60,10 @@ public:
     void on_check_and_ping();
     int send_packet(const char* data, size_t len);
 
+    bool can_migrate();
+    void detach_event_loop();
+    void attach_event_loop(EventLoop* el, PortAllocator* allocator);
+
     sigslot::signal2<IceTransportChannel*, const std::vector<Candidate>&>
         signal_candidate_allocate_done;
     sigslot::signal1<IceTransportChannel*> signal_receiving_state;
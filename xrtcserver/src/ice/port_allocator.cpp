@@ -1,12 +1,38 @@
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <netinet/in.h>
 
+#include <rtc_base/logging.h>
+
+#include "base/event_loop.h"
+#include "base/socket.h"
 #include "ice/port_allocator.h"
+#include "ice/udp_port_mux.h"
 
 namespace xrtc {
 
+const int k_pool_refill_interval = 100; // 100ms
+const size_t k_pool_refill_batch = 64;
+
 PortAllocator::PortAllocator() : network_manager_(new NetworkManager()) {
     network_manager_->create_networks();
 }
 
+PortAllocator::~PortAllocator() {
+    if (pool_timer_) {
+        el_->delete_timer(pool_timer_);
+        pool_timer_ = nullptr;
+    }
+
+    for (auto& item : socket_pool_) {
+        for (auto& pooled : item.second) {
+            close(pooled.sock);
+        }
+    }
+    socket_pool_.clear();
+}
+
 const std::vector<Network*>& PortAllocator::get_networks() {
     return network_manager_->get_networks();
 }
@@ -19,6 +45,175 @@ void PortAllocator::set_port_range(int min_port, int max_port) {
     if (max_port > 0) {
         max_port_ = max_port;
     }
+
+    free_ports_inited_ = false;
+    free_ports_.clear();
+}
+
+void PortAllocator::set_port_shard(int shard, int shard_num) {
+    if (shard_num <= 0 || shard < 0 || shard >= shard_num) {
+        return;
+    }
+
+    shard_ = shard;
+    shard_num_ = shard_num;
+    free_ports_inited_ = false;
+    free_ports_.clear();
+}
+
+int PortAllocator::enable_shared_port(EventLoop* el, int port) {
+    std::unique_ptr<UdpPortMux> mux = std::make_unique<UdpPortMux>(el, port);
+    if (mux->start() != 0) {
+        return -1;
+    }
+
+    if (incoming_cpu_ >= 0) {
+        sock_set_incoming_cpu(mux->socket(), incoming_cpu_);
+    }
+
+    mux_ = std::move(mux);
+    return 0;
+}
+
+void PortAllocator::_init_free_ports() {
+    free_ports_inited_ = true;
+    if (0 == min_port_ && 0 == max_port_) {
+        return;
+    }
+
+    for (int port = min_port_; port <= max_port_; ++port) {
+        if ((port - min_port_) % shard_num_ == shard_) {
+            free_ports_.push_back(port);
+        }
+    }
+}
+
+int PortAllocator::_bind_socket(Network* network, int* port) {
+    if (!free_ports_inited_) {
+        _init_free_ports();
+    }
+
+    int sock = create_udp_socket(network->ip().family());
+    if (sock < 0) {
+        return -1;
+    }
+
+    if (sock_setnoblock(sock) != 0) {
+        close(sock);
+        return -1;
+    }
+
+    if (incoming_cpu_ >= 0) {
+        sock_set_incoming_cpu(sock, incoming_cpu_);
+    }
+
+    sockaddr_in addr_in;
+    memset(&addr_in, 0, sizeof(addr_in));
+    addr_in.sin_family = network->ip().family();
+    addr_in.sin_addr = network->ip().ipv4_address();
+
+    if (0 == min_port_ && 0 == max_port_) {
+        // 让操作系统自动选择一个port
+        if (sock_bind(sock, (struct sockaddr*)&addr_in, sizeof(sockaddr), 0, 0) != 0
+                || sock_get_address(sock, nullptr, port) != 0)
+        {
+            close(sock);
+            return -1;
+        }
+        return sock;
+    }
+
+    // 每个端口最多尝试一次，被其他进程占用的端口放到队尾，以后再试
+    size_t tries = free_ports_.size();
+    while (tries-- > 0) {
+        int candidate_port = free_ports_.front();
+        free_ports_.pop_front();
+
+        addr_in.sin_port = htons(candidate_port);
+        if (bind(sock, (struct sockaddr*)&addr_in, sizeof(sockaddr)) == 0) {
+            *port = candidate_port;
+            return sock;
+        }
+
+        free_ports_.push_back(candidate_port);
+        if (errno != EADDRINUSE) {
+            break;
+        }
+    }
+
+    RTC_LOG(LS_WARNING) << "no free udp port, free: " << free_ports_.size()
+        << ", err: " << strerror(errno) << ", errno: " << errno;
+    close(sock);
+    return -1;
+}
+
+int PortAllocator::alloc_socket(Network* network, int* port) {
+    auto iter = socket_pool_.find(network);
+    if (iter != socket_pool_.end() && !iter->second.empty()) {
+        PooledSocket pooled = iter->second.back();
+        iter->second.pop_back();
+        *port = pooled.port;
+        return pooled.sock;
+    }
+
+    return _bind_socket(network, port);
+}
+
+void PortAllocator::release_socket(int sock, int port) {
+    if (sock >= 0) {
+        close(sock);
+    }
+
+    // 从其它worker迁移过来的会话归还的是其它分片的端口，端口的所有权随会话转移，
+    // 原来的worker已经把它从空闲列表中取出，这里放入本worker的空闲列表不会冲突
+    if (port > 0 && min_port_ <= port && port <= max_port_) {
+        free_ports_.push_back(port);
+    }
+}
+
+static void pool_refill_cb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+    PortAllocator* allocator = (PortAllocator*)data;
+    allocator->refill_socket_pool();
+}
+
+void PortAllocator::enable_socket_pool(EventLoop* el, size_t pool_size) {
+    if (0 == pool_size || pool_timer_) {
+        return;
+    }
+
+    el_ = el;
+    pool_size_ = pool_size;
+
+    // 启动时一次填满，之后由定时器在热路径之外补充
+    for (auto network : get_networks()) {
+        auto& pool = socket_pool_[network];
+        while (pool.size() < pool_size_) {
+            PooledSocket pooled;
+            pooled.sock = _bind_socket(network, &pooled.port);
+            if (pooled.sock < 0) {
+                break;
+            }
+            pool.push_back(pooled);
+        }
+    }
+
+    pool_timer_ = el_->create_timer(pool_refill_cb, this, true);
+    el_->start_timer(pool_timer_, k_pool_refill_interval * 1000);
+}
+
+void PortAllocator::refill_socket_pool() {
+    for (auto network : get_networks()) {
+        auto& pool = socket_pool_[network];
+        size_t count = 0;
+        while (pool.size() < pool_size_ && count++ < k_pool_refill_batch) {
+            PooledSocket pooled;
+            pooled.sock = _bind_socket(network, &pooled.port);
+            if (pooled.sock < 0) {
+                break;
+            }
+            pool.push_back(pooled);
+        }
+    }
 }
 
 }
@@ -8,19 +8,28 @@
 #define  __PORT_ALLOCATOR_H_
 
 #include <memory>
+#include <deque>
+#include <vector>
+#include <unordered_map>
 
 #include "base/network.h"
 
 namespace xrtc {
 
+class EventLoop;
+class TimerWatcher;
+class UdpPortMux;
+
 class PortAllocator {
 public:
     PortAllocator();
-    ~PortAllocator() = default;
+    ~PortAllocator();
     
     const std::vector<Network*>& get_networks();
 
     void set_port_range(int min_port, int max_port);
+    // 多个worker共用一个端口范围时，每个worker只分配 (port - min_port) % shard_num == shard 的端口
+    void set_port_shard(int shard, int shard_num);
 
     int min_port() const { 
         return min_port_; 
@@ -30,14 +39,49 @@ public:
         return max_port_;
     }    
 
+    // 之后创建的socket都设置SO_INCOMING_CPU，需要在enable_shared_port和enable_socket_pool之前调用
+    void set_incoming_cpu(int cpu) { incoming_cpu_ = cpu; }
+    int incoming_cpu() const { return incoming_cpu_; }
+
+    // 所有会话共享一个UDP端口，按ufrag和远端地址分发
+    int enable_shared_port(EventLoop* el, int port);
+    UdpPortMux* shared_port_mux() { return mux_.get(); }
+
+    // 为每个网络接口预先创建并绑定一批socket，分配时不需要系统调用
+    void enable_socket_pool(EventLoop* el, size_t pool_size);
+    void refill_socket_pool();
+
+    // 返回已绑定端口的非阻塞socket，失败返回-1
+    int alloc_socket(Network* network, int* port);
+    void release_socket(int sock, int port);
+
+private:
+    void _init_free_ports();
+    int _bind_socket(Network* network, int* port);
+
 private:
     std::unique_ptr<NetworkManager> network_manager_;
+    std::unique_ptr<UdpPortMux> mux_;
     int min_port_ = 0;
     int max_port_ = 0;
+    int shard_ = 0;
+    int shard_num_ = 1;
+    int incoming_cpu_ = -1;
+
+    bool free_ports_inited_ = false;
+    std::deque<int> free_ports_;
+
+    struct PooledSocket {
+        int sock;
+        int port;
+    };
+
+    EventLoop* el_ = nullptr;
+    TimerWatcher* pool_timer_ = nullptr;
+    size_t pool_size_ = 0;
+    std::unordered_map<Network*, std::vector<PooledSocket>> socket_pool_;
 };
 
 } // namespace xrtc
 
 #endif  //__PORT_ALLOCATOR_H_
-
-
@@ -8,6 +8,8 @@
 #include "base/socket.h"
 #include "base/async_udp_socket.h"
 #include "ice/udp_port.h"
+#include "ice/udp_port_mux.h"
+#include "ice/port_allocator.h"
 #include "ice/stun.h"
 #include "ice/ice_connection.h"
 #include "server/settings.h"
@@ -26,6 +28,20 @@ UDPPort::UDPPort(EventLoop* el,
 }
 
 UDPPort::~UDPPort() {
+    if (mux_) {
+        for (auto& item : connections_) {
+            mux_->remove_address(item.first, this);
+        }
+        mux_->remove_port(this);
+        mux_ = nullptr;
+    }
+
+    // 先停止监听，再关闭socket并归还端口
+    async_socket_.reset();
+    if (allocator_ && socket_ >= 0) {
+        allocator_->release_socket(socket_, port_);
+        socket_ = -1;
+    }
 }
 
 std::string compute_foundation(const std::string& type,
@@ -38,37 +54,44 @@ std::string compute_foundation(const std::string& type,
     return std::to_string(rtc::ComputeCrc32(ss.str()));
 }
 
-int UDPPort::create_ice_candidate(Network* network, int min_port, int max_port, Candidate& c) {
-    socket_ = create_udp_socket(network->ip().family());
+int UDPPort::create_ice_candidate(Network* network, PortAllocator* allocator, Candidate& c) {
+    // 从PortAllocator获取已经绑定好端口的socket，不再逐个端口尝试bind
+    socket_ = allocator->alloc_socket(network, &port_);
     if (socket_ < 0) {
         return -1;
     }
+    allocator_ = allocator;
 
-    if (sock_setnoblock(socket_) != 0) {
-        return -1;
+    async_socket_ = std::make_unique<AsyncUdpSocket>(el_, socket_);
+    async_socket_->signal_read_packet.connect(this,  &UDPPort::_on_read_packet);
+    if (Singleton<Settings>::Instance()->UdpGro()) {
+        async_socket_->enable_gro();
     }
-
-    sockaddr_in addr_in;
-    addr_in.sin_family = network->ip().family();
-    addr_in.sin_addr = network->ip().ipv4_address();
-    if (sock_bind(socket_, (struct sockaddr*)&addr_in, sizeof(sockaddr), 
-            min_port, max_port) != 0)
-    {
-        return -1;
+    if (Singleton<Settings>::Instance()->UdpSendBatch()) {
+        async_socket_->enable_send_batch(Singleton<Settings>::Instance()->UdpGso());
     }
 
-    int port = 0;
-    if (sock_get_address(socket_, nullptr, &port) != 0) {
+    _add_candidate(network, port_, c);
+
+    return 0;
+}
+
+int UDPPort::create_ice_candidate(Network* network, UdpPortMux* mux, Candidate& c) {
+    if (!mux || !mux->add_port(this)) {
         return -1;
     }
 
+    mux_ = mux;
+    _add_candidate(network, mux->port(), c);
+
+    return 0;
+}
+
+void UDPPort::_add_candidate(Network* network, int port, Candidate& c) {
     local_addr_.SetIP(network->ip());
     local_addr_.SetIP(Singleton<Settings>::Instance()->CandidateIp().c_str());
     local_addr_.SetPort(port);
 
-    async_socket_ = std::make_unique<AsyncUdpSocket>(el_, socket_);
-    async_socket_->signal_read_packet.connect(this,  &UDPPort::_on_read_packet);
-
     RTC_LOG(LS_INFO) << "prepared socket address: " << local_addr_.ToString();
 
     c.component = component_;
@@ -82,8 +105,31 @@ int UDPPort::create_ice_candidate(Network* network, int min_port, int max_port,
     c.foundation = compute_foundation(c.type, c.protocol, "", c.address);
     
     candidates_.push_back(c);
+}
 
-    return 0;
+void UDPPort::detach_event_loop() {
+    if (async_socket_) {
+        async_socket_->detach_event_loop();
+    }
+}
+
+void UDPPort::attach_event_loop(EventLoop* el, PortAllocator* allocator) {
+    el_ = el;
+    if (allocator_) {
+        allocator_ = allocator;
+        // 跟随会话迁移到新worker绑定的核
+        if (allocator_->incoming_cpu() >= 0 && socket_ >= 0) {
+            sock_set_incoming_cpu(socket_, allocator_->incoming_cpu());
+        }
+    }
+
+    if (async_socket_) {
+        async_socket_->attach_event_loop(el_);
+    }
+
+    for (auto& item : connections_) {
+        item.second->attach_event_loop(el_);
+    }
 }
 
 IceConnection* UDPPort::create_connection(const Candidate& remote_candidate)
@@ -100,10 +146,18 @@ IceConnection* UDPPort::create_connection(const Candidate& remote_candidate)
         //todo 清理以前存在的ice connection
     }
 
+    if (mux_) {
+        mux_->add_address(conn->remote_candidate().address, this);
+    }
+
     return conn;
 }
 
 int UDPPort::send_to(const char* buf, size_t len, const rtc::SocketAddress& addr) {
+    if (mux_) {
+        return mux_->send_to(buf, len, addr);
+    }
+
     if (!async_socket_) {
         return -1;
     }
@@ -118,6 +172,12 @@ IceConnection* UDPPort::get_connection(const rtc::SocketAddress& addr) {
 
 void UDPPort::_on_read_packet(AsyncUdpSocket* /*socket*/, char* buf, size_t size,
         const rtc::SocketAddress& addr, int64_t timestamp)
+{
+    on_read_packet(buf, size, addr, timestamp);
+}
+
+void UDPPort::on_read_packet(char* buf, size_t size,
+        const rtc::SocketAddress& addr, int64_t timestamp)
 {
     if (IceConnection *conn = get_connection(addr)) {
         conn->on_read_packet(buf, size, timestamp);
@@ -241,7 +301,7 @@ void UDPPort::send_binding_error_response(StunMessage* stun_msg,
         int err_code,
         const std::string& reason)
 {
-    if (!async_socket_) {
+    if (!async_socket_ && !mux_) {
         return;
     }
 
@@ -267,7 +327,7 @@ void UDPPort::send_binding_error_response(StunMessage* stun_msg,
     }
 
     // 3、将转换后的buf发送出去
-    int ret = async_socket_->send_to(buf.Data(), buf.Length(), addr);
+    int ret = send_to(buf.Data(), buf.Length(), addr);
     if (ret < 0) {
         RTC_LOG(LS_WARNING) << to_string() << " send "
             << stun_method_to_string(response.type())
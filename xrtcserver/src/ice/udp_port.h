@@ -25,6 +25,8 @@ class EventLoop;
 class AsyncUdpSocket;
 class StunMessage;
 class IceConnection;
+class UdpPortMux;
+class PortAllocator;
 
 typedef std::map<rtc::SocketAddress, IceConnection*> AddressMap;
 
@@ -44,7 +46,9 @@ public:
     const rtc::SocketAddress& local_addr() { return local_addr_; } 
     const std::vector<Candidate> candidates() const { return candidates_; }
 
-    int create_ice_candidate(Network* network, int min_port, int max_port, Candidate& c);
+    int create_ice_candidate(Network* network, PortAllocator* allocator, Candidate& c);
+    // 使用共享端口，不单独创建socket
+    int create_ice_candidate(Network* network, UdpPortMux* mux, Candidate& c);
     bool get_stun_message(const char* data, size_t len,
             const rtc::SocketAddress& addr,
             std::unique_ptr<StunMessage>* out_msg,
@@ -61,6 +65,13 @@ public:
 
     void create_stun_username(const std::string& remote_username, std::string* stun_attr_username);
     int send_to(const char* buf, size_t len, const rtc::SocketAddress& addr);
+    void on_read_packet(char* buf, size_t size, const rtc::SocketAddress& addr, int64_t timestamp);
+
+    // 使用共享端口时远端地址对应的是当前worker的socket，不能迁移
+    bool can_migrate() { return nullptr == mux_; }
+    // 迁移到另一个worker，socket和连接状态保持不变，端口由目标worker的allocator回收
+    void detach_event_loop();
+    void attach_event_loop(EventLoop* el, PortAllocator* allocator);
 
     sigslot::signal4<UDPPort*, const rtc::SocketAddress&, StunMessage*, const std::string&> signal_unknown_address;
 
@@ -68,6 +79,7 @@ private:
     void _on_read_packet(AsyncUdpSocket* socket, char* buf, size_t size,
             const rtc::SocketAddress& addr, int64_t timestamp);
     bool _parse_stun_username(StunMessage *stun_msg, std::string *local_ufrag, std::string *remote_ufrag);
+    void _add_candidate(Network* network, int port, Candidate& c);
 
 private:
     EventLoop* el_;
@@ -75,9 +87,12 @@ private:
     IceCandidateComponent component_;
     IceParameters ice_params_;
     int socket_ = -1;
+    int port_ = 0;
+    PortAllocator* allocator_ = nullptr;
     rtc::SocketAddress local_addr_;
     std::vector<Candidate> candidates_;
     std::unique_ptr<AsyncUdpSocket> async_socket_;
+    UdpPortMux* mux_ = nullptr;
     AddressMap connections_;
 };
 
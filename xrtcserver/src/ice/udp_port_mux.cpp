@@ -0,0 +1,150 @@
+#include <unistd.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include <rtc_base/logging.h>
+#include <rtc_base/string_encode.h>
+
+#include "base/socket.h"
+#include "base/async_udp_socket.h"
+#include "ice/udp_port_mux.h"
+#include "ice/udp_port.h"
+#include "ice/stun.h"
+#include "server/settings.h"
+
+namespace xrtc {
+
+UdpPortMux::UdpPortMux(EventLoop* el, int port) :
+    el_(el),
+    port_(port)
+{
+}
+
+UdpPortMux::~UdpPortMux() {
+    async_socket_.reset();
+
+    if (socket_ >= 0) {
+        close(socket_);
+        socket_ = -1;
+    }
+}
+
+int UdpPortMux::start() {
+    socket_ = create_udp_socket(AF_INET);
+    if (socket_ < 0) {
+        return -1;
+    }
+
+    if (sock_setnoblock(socket_) != 0) {
+        return -1;
+    }
+
+    sockaddr_in addr_in;
+    memset(&addr_in, 0, sizeof(addr_in));
+    addr_in.sin_family = AF_INET;
+    addr_in.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (sock_bind(socket_, (struct sockaddr*)&addr_in, sizeof(sockaddr), port_, port_) != 0) {
+        RTC_LOG(LS_WARNING) << "udp port mux bind failed, port: " << port_;
+        return -1;
+    }
+
+    async_socket_ = std::make_unique<AsyncUdpSocket>(el_, socket_);
+    async_socket_->signal_read_packet.connect(this, &UdpPortMux::_on_read_packet);
+    if (Singleton<Settings>::Instance()->UdpGro()) {
+        async_socket_->enable_gro();
+    }
+    if (Singleton<Settings>::Instance()->UdpSendBatch()) {
+        async_socket_->enable_send_batch(Singleton<Settings>::Instance()->UdpGso());
+    }
+
+    RTC_LOG(LS_INFO) << "udp port mux listen on port: " << port_;
+
+    return 0;
+}
+
+bool UdpPortMux::add_port(UDPPort* port) {
+    auto ret = ufrag_ports_.insert(std::make_pair(port->ice_ufrag(), port));
+    if (!ret.second && ret.first->second != port) {
+        RTC_LOG(LS_WARNING) << "udp port mux ufrag conflict, ufrag: " << port->ice_ufrag();
+        return false;
+    }
+    return true;
+}
+
+void UdpPortMux::remove_port(UDPPort* port) {
+    auto iter = ufrag_ports_.find(port->ice_ufrag());
+    if (iter != ufrag_ports_.end() && iter->second == port) {
+        ufrag_ports_.erase(iter);
+    }
+}
+
+void UdpPortMux::add_address(const rtc::SocketAddress& addr, UDPPort* port) {
+    addr_ports_[addr] = port;
+}
+
+void UdpPortMux::remove_address(const rtc::SocketAddress& addr, UDPPort* port) {
+    auto iter = addr_ports_.find(addr);
+    if (iter != addr_ports_.end() && iter->second == port) {
+        addr_ports_.erase(iter);
+    }
+}
+
+int UdpPortMux::send_to(const char* buf, size_t len, const rtc::SocketAddress& addr) {
+    if (!async_socket_) {
+        return -1;
+    }
+
+    return async_socket_->send_to(buf, len, addr);
+}
+
+void UdpPortMux::_on_read_packet(AsyncUdpSocket* /*socket*/, char* buf, size_t size,
+        const rtc::SocketAddress& addr, int64_t timestamp)
+{
+    // 已经建立连接的远端地址
+    auto iter = addr_ports_.find(addr);
+    if (iter != addr_ports_.end()) {
+        iter->second->on_read_packet(buf, size, addr, timestamp);
+        return;
+    }
+
+    // 未知地址只处理STUN binding request，按ufrag找到对应的会话
+    UDPPort* port = _find_port_by_stun_username(buf, size);
+    if (port) {
+        port->on_read_packet(buf, size, addr, timestamp);
+    }
+}
+
+UDPPort* UdpPortMux::_find_port_by_stun_username(const char* buf, size_t size) {
+    // STUN消息的前两位为0，且header固定20字节
+    if (size < k_stun_header_size || (buf[0] & 0xC0) != 0) {
+        return nullptr;
+    }
+
+    uint16_t type = ((uint8_t)buf[0] << 8) | (uint8_t)buf[1];
+    if (type != STUN_BINDING_REQUEST) {
+        return nullptr;
+    }
+
+    StunMessage stun_msg;
+    rtc::ByteBufferReader reader(buf, size);
+    if (!stun_msg.read(&reader)) {
+        return nullptr;
+    }
+
+    const StunByteStringAttribute* attr = stun_msg.get_byte_string(STUN_ATTR_USERNAME);
+    if (!attr) {
+        return nullptr;
+    }
+
+    //LFRAG:RFRAG
+    std::string username = attr->get_string();
+    size_t pos = username.find(':');
+    if (pos == std::string::npos) {
+        return nullptr;
+    }
+
+    auto iter = ufrag_ports_.find(username.substr(0, pos));
+    return iter == ufrag_ports_.end() ? nullptr : iter->second;
+}
+
+} // namespace xrtc
@@ -0,0 +1,69 @@
+/**
+ * @file udp_port_mux.h
+ * @author charles
+ * @brief 多个会话共享一个UDP端口
+ *         STUN binding request按USERNAME中的本端ufrag找到UDPPort，
+ *         之后的媒体包按远端地址(本端地址固定，即5元组)查找
+*/
+
+#ifndef  __UDP_PORT_MUX_H_
+#define  __UDP_PORT_MUX_H_
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include <rtc_base/socket_address.h>
+#include <rtc_base/third_party/sigslot/sigslot.h>
+
+namespace xrtc {
+
+class EventLoop;
+class AsyncUdpSocket;
+class UDPPort;
+
+// 远端地址的hash，IPv4和IPv6都按完整的ip+port区分
+struct SocketAddressHash {
+    size_t operator()(const rtc::SocketAddress& addr) const {
+        return ((size_t)rtc::HashIP(addr.ipaddr()) << 16) ^ addr.port();
+    }
+};
+
+class UdpPortMux : public sigslot::has_slots<> {
+public:
+    UdpPortMux(EventLoop* el, int port);
+    ~UdpPortMux();
+
+    int start();
+    int port() const { return port_; }
+    int socket() const { return socket_; }
+
+    bool add_port(UDPPort* port);
+    void remove_port(UDPPort* port);
+
+    void add_address(const rtc::SocketAddress& addr, UDPPort* port);
+    void remove_address(const rtc::SocketAddress& addr, UDPPort* port);
+
+    int send_to(const char* buf, size_t len, const rtc::SocketAddress& addr);
+
+private:
+    void _on_read_packet(AsyncUdpSocket* socket, char* buf, size_t size,
+            const rtc::SocketAddress& addr, int64_t timestamp);
+    UDPPort* _find_port_by_stun_username(const char* buf, size_t size);
+
+private:
+    EventLoop* el_;
+    int port_;
+    int socket_ = -1;
+    std::unique_ptr<AsyncUdpSocket> async_socket_;
+
+    // 本端ufrag -> UDPPort
+    std::unordered_map<std::string, UDPPort*> ufrag_ports_;
+    // 远端ip+port -> UDPPort
+    std::unordered_map<rtc::SocketAddress, UDPPort*, SocketAddressHash> addr_ports_;
+};
+
+} // namespace xrtc
+
+#endif  // __UDP_PORT_MUX_H_
@@ -84,8 +84,9 @@ int main() {
     signal(SIGINT, process_signal);
     signal(SIGTERM, process_signal);
 
-    g_signaling_server->start();
+    // 信令开始accept之前RTC服务必须已经就绪
     g_rtc_server->start();
+    g_signaling_server->start();
 
     g_signaling_server->join();
     g_rtc_server->join();
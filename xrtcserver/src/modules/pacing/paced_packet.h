@@ -0,0 +1,26 @@
+#ifndef MODULES_PACING_PACED_PACKET_H_
+#define MODULES_PACING_PACED_PACKET_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "base/packet_buffer.h"
+#include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+
+namespace xrtc {
+
+    // pacer队列中的包，只持有缓冲区的引用，同一个包发给多个订阅者时共享一份数据，
+    // 入队时记下调度和发送统计需要的ssrc、类型和大小，发送时不再解析，不构造RtpPacketToSend
+    struct PacedPacket {
+        PacketBufferPtr buffer;
+        uint32_t ssrc = 0;
+        RtpPacketMediaType type = RtpPacketMediaType::kVideo;
+        // 负载和填充的字节数，按它消耗发送预算
+        size_t payload_size = 0;
+        size_t header_size = 0;
+        size_t padding_size = 0;
+    };
+
+} // namespace xrtc
+
+#endif // MODULES_PACING_PACED_PACKET_H_
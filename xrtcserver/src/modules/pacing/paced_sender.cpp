@@ -0,0 +1,49 @@
+#include "modules/pacing/pacing_scheduler.h"
+#include "modules/pacing/paced_sender.h"
+
+namespace xrtc {
+
+    PacedSender::PacedSender(webrtc::Clock* clock,
+        PacingController::PacketSender* packet_sender) :
+        pacing_controller_(clock, packet_sender)
+    {
+    }
+
+    PacedSender::~PacedSender() {
+        PacingScheduler::current()->RemoveSender(this);
+    }
+
+    void PacedSender::EnqueuePacket(PacedPacket packet) {
+        pacing_controller_.EnqueuePacket(std::move(packet));
+        PacingScheduler::current()->OnPacketEnqueued(this);
+    }
+
+    void PacedSender::SetPacingBitrate(webrtc::DataRate bitrate) {
+        pacing_controller_.SetPacingBitrate(bitrate);
+    }
+
+    void PacedSender::SetQueueTimeLimit(webrtc::TimeDelta limit) {
+        pacing_controller_.SetQueueTimeLimit(limit);
+    }
+
+    size_t PacedSender::QueueSizePackets() const {
+        return pacing_controller_.QueueSizePackets();
+    }
+
+    void PacedSender::DetachEventLoop() {
+        // 队列中的包引用的是本worker缓冲池的缓冲区，迁移之前在本worker上发送完
+        pacing_controller_.Flush();
+        PacingScheduler::current()->RemoveSender(this);
+    }
+
+    void PacedSender::AttachEventLoop() {
+        if (pacing_controller_.QueueSizePackets() > 0) {
+            PacingScheduler::current()->OnPacketEnqueued(this);
+        }
+    }
+
+    size_t PacedSender::ProcessPackets(size_t max_packets) {
+        return pacing_controller_.ProcessPackets(max_packets);
+    }
+
+} // namespace xrtc
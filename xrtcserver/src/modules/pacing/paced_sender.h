@@ -0,0 +1,43 @@
+#ifndef MODULES_PACING_PACED_SENDER_H_
+#define MODULES_PACING_PACED_SENDER_H_
+
+#include <system_wrappers/include/clock.h>
+
+#include "modules/pacing/paced_packet.h"
+#include "modules/pacing/pacing_controller.h"
+
+namespace xrtc {
+
+    class PacingScheduler;
+
+    // 在worker线程上驱动PacingController，不需要单独的线程和跨线程投递，
+    // 发送时机由所在worker的PacingScheduler统一调度，只能在所属worker线程中调用
+    class PacedSender {
+    public:
+        PacedSender(webrtc::Clock* clock, PacingController::PacketSender* packet_sender);
+        ~PacedSender();
+
+        // 本轮事件循环的发送预算还有剩余时立即尝试发送，否则等待调度器的时间片
+        void EnqueuePacket(PacedPacket packet);
+        void SetPacingBitrate(webrtc::DataRate bitrate);
+        void SetQueueTimeLimit(webrtc::TimeDelta limit);
+        size_t QueueSizePackets() const;
+
+        // 会话迁移到其它worker时，在源worker上发送完队列并从调度器中移除，在目标worker上重新加入
+        void DetachEventLoop();
+        void AttachEventLoop();
+
+    private:
+        friend class PacingScheduler;
+        // 最多发送max_packets个包，返回实际发送的包数
+        size_t ProcessPackets(size_t max_packets);
+
+    private:
+        PacingController pacing_controller_;
+        // 是否在调度器的轮转队列中，由PacingScheduler维护
+        bool scheduled_ = false;
+    };
+
+} // namespace xrtc
+
+#endif // MODULES_PACING_PACED_SENDER_H_
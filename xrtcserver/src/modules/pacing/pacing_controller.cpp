@@ -47,14 +47,14 @@ namespace {
 
 	}
 
-    void PacingController::EnqueuePacket(std::unique_ptr<RtpPacketToSend> packet) {
+    void PacingController::EnqueuePacket(PacedPacket packet) {
         // 1. 获得RTP packet的优先级
-        int priority = GetPriorityForType(*packet->packet_type());
+        int priority = GetPriorityForType(packet.type);
         // 2. 插入packet
         EnqueuePacketInternal(priority, std::move(packet));
     }
 
-    void PacingController::ProcessPackets() {
+    size_t PacingController::ProcessPackets(size_t max_packets) {
         webrtc::Timestamp now = clock_->CurrentTime();
         webrtc::Timestamp target_send_time = now;
         // 计算流逝的时间（当前时间距离上一次发送过去了多长时间）
@@ -74,7 +74,7 @@ namespace {
                     webrtc::DataRate min_rate_need = queue_data_size / avg_queue_left;
                     if (min_rate_need > target_rate) {
                         target_rate = min_rate_need;
-                        RTC_LOG(LS_INFO) << "large queue, pacing_rate: " << pacing_bitrate_.kbps()
+                        RTC_LOG(LS_VERBOSE) << "large queue, pacing_rate: " << pacing_bitrate_.kbps()
                             << ", min_rate_need: " << min_rate_need.kbps()
                             << ", queue_data_size: " << queue_data_size.bytes()
                             << ", avg_queue_time: " << avg_queue_time.ms()
@@ -88,26 +88,26 @@ namespace {
             UpdateBudgetWithElapsedTime(elapsed_time);
         }
 
-        while (true) {
+        size_t sent_packets = 0;
+        while (sent_packets < max_packets) {
             // 从队列当中获取rtp数据包进行发送
-            std::unique_ptr<RtpPacketToSend> rtp_packet =
-                GetPendingPacket();
-
-            if (!rtp_packet) {
+            PacedPacket rtp_packet;
+            if (!GetPendingPacket(&rtp_packet)) {
                 // 队列为空或者预算耗尽了，停止发送循环
                 break;
             }
 
-            webrtc::DataSize packet_size = webrtc::DataSize::Bytes(
-                rtp_packet->payload_size() + rtp_packet->padding_size());
+            webrtc::DataSize packet_size = webrtc::DataSize::Bytes(rtp_packet.payload_size);
 
             // 发送rtp_packet到网络
-            packet_sender_->SendPacket(std::move(rtp_packet));
+            packet_sender_->SendPacket(rtp_packet);
 
             // 更新预算
             OnPacketSent(packet_size, target_send_time);
-
+            ++sent_packets;
         }
+
+        return sent_packets;
     }
 
     webrtc::Timestamp PacingController::NextSendTime() {
@@ -120,8 +120,14 @@ namespace {
             << pacing_bitrate_.kbps();
     }
 
+    void PacingController::Flush() {
+        while (!packet_queue_.Empty()) {
+            packet_sender_->SendPacket(packet_queue_.Pop());
+        }
+    }
+
     void PacingController::EnqueuePacketInternal(int priority, 
-        std::unique_ptr<RtpPacketToSend> packet)
+        PacedPacket packet)
     {
         webrtc::Timestamp now = clock_->CurrentTime();
         packet_queue_.Push(priority, now, packet_counter_++, std::move(packet));
@@ -132,8 +138,11 @@ namespace {
             return webrtc::TimeDelta::Zero();
         }
 
-        webrtc::TimeDelta elapsed_time = now - last_process_time_;
-        last_process_time_ = now;
+        // 预算按整毫秒增加，不足1毫秒的部分留到下一次，
+        // 同一个tick内被多次调用时不会丢掉流逝的时间
+        webrtc::TimeDelta elapsed_time = webrtc::TimeDelta::Millis(
+            (now - last_process_time_).us() / 1000);
+        last_process_time_ += elapsed_time;
         if (elapsed_time > kMaxElapsedTime) {
             elapsed_time = kMaxElapsedTime;
             RTC_LOG(LS_WARNING) << "elapsed time " << elapsed_time.ms()
@@ -150,25 +159,25 @@ namespace {
         media_budget_.IncreaseBudget(delta.ms()); 
     }
 
-    std::unique_ptr<RtpPacketToSend> PacingController::GetPendingPacket() {
+    bool PacingController::GetPendingPacket(PacedPacket* packet) {
         // 如果队列为空
         if (packet_queue_.Empty()) {
-            return nullptr;
+            return false;
         }
 
         // 如果本轮预算已经耗尽
         if (media_budget_.BytesRemaining() <= 0) {
-            return nullptr;
+            return false;
         }
 
-        return packet_queue_.Pop();
+        *packet = packet_queue_.Pop();
+        return true;
     }
 
     void PacingController::OnPacketSent(webrtc::DataSize packet_size,
-        webrtc::Timestamp send_time)
+        webrtc::Timestamp /*send_time*/)
     {
         UpdateBudgetWithSendData(packet_size);
-        last_process_time_ = send_time;
     }
 
     void PacingController::UpdateBudgetWithSendData(webrtc::DataSize packet_size) {
@@ -1,10 +1,12 @@
 #ifndef MODULES_PACING_PACING_CONTROLLER_H
 #define MODULES_PACING_PACING_CONTROLLER_H
 
+#include <stdint.h>
+
 #include <system_wrappers/include/clock.h>
 #include <api/units/data_rate.h>
 
-#include "modules/rtp_rtcp/rtp_packet_to_send.h"
+#include "modules/pacing/paced_packet.h"
 #include "modules/pacing/round_robin_packet_queue.h"
 #include "modules/pacing/interval_budget.h"
 
@@ -15,25 +17,30 @@ namespace xrtc {
         class PacketSender {
         public:
             virtual ~PacketSender() = default;
-            virtual void SendPacket(std::unique_ptr<RtpPacketToSend> packet) = 0;
+            virtual void SendPacket(const PacedPacket& packet) = 0;
         };
 
         PacingController(webrtc::Clock* clock, PacketSender* packet_sender);
         ~PacingController();
 
-        void EnqueuePacket(std::unique_ptr<RtpPacketToSend> packet);
-        void ProcessPackets();
+        void EnqueuePacket(PacedPacket packet);
+        // 在预算允许的范围内发送，最多发送max_packets个包，返回实际发送的包数
+        size_t ProcessPackets(size_t max_packets = SIZE_MAX);
+        // 不受预算限制，立即发送队列中剩下的全部包
+        void Flush();
         webrtc::Timestamp NextSendTime();
         void SetPacingBitrate(webrtc::DataRate bitrate);
         void SetQueueTimeLimit(webrtc::TimeDelta limit) {
             queue_time_limit_ = limit;
         }
+        size_t QueueSizePackets() const { return packet_queue_.SizePackets(); }
 
     private:
-        void EnqueuePacketInternal(int priority, std::unique_ptr<RtpPacketToSend> packet);
+        void EnqueuePacketInternal(int priority, PacedPacket packet);
         webrtc::TimeDelta UpdateTimeAndGetElapsed(webrtc::Timestamp now);
         void UpdateBudgetWithElapsedTime(webrtc::TimeDelta elapsed_time);
-        std::unique_ptr<RtpPacketToSend> GetPendingPacket();
+        // 队列为空或者预算耗尽时返回false
+        bool GetPendingPacket(PacedPacket* packet);
         void OnPacketSent(webrtc::DataSize packet_size, webrtc::Timestamp target_send_time);
         void UpdateBudgetWithSendData(webrtc::DataSize packet_size);
 
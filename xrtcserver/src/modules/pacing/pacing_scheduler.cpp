@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <memory>
+
+#include "modules/pacing/paced_sender.h"
+#include "modules/pacing/pacing_scheduler.h"
+
+namespace xrtc {
+
+    // 轮转队列的驱动周期，等于时间轮的一个tick
+    const unsigned int kSchedulerTickUs = 5000;
+    // 轮转时每个发送者一个时间片最多发送的包数
+    const size_t kSlicePackets = 4;
+
+    void pacing_scheduler_tick_cb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+        PacingScheduler* scheduler = (PacingScheduler*)data;
+        scheduler->ProcessSenders();
+    }
+
+    PacingScheduler::PacingScheduler() {
+    }
+
+    PacingScheduler::~PacingScheduler() {
+        for (PacedSender* sender : senders_) {
+            sender->scheduled_ = false;
+        }
+
+        if (tick_timer_) {
+            el_->delete_timer(tick_timer_);
+            tick_timer_ = nullptr;
+        }
+    }
+
+    PacingScheduler* PacingScheduler::current() {
+        static thread_local std::unique_ptr<PacingScheduler> scheduler;
+        if (!scheduler) {
+            scheduler = std::make_unique<PacingScheduler>();
+        }
+        return scheduler.get();
+    }
+
+    void PacingScheduler::Init(EventLoop* el, size_t packets_per_iteration) {
+        if (el_) {
+            return;
+        }
+
+        el_ = el;
+        packets_per_iteration_ = std::max<size_t>(packets_per_iteration, 1);
+        budget_ = packets_per_iteration_;
+        budget_iteration_ = el_->iteration();
+        tick_timer_ = el_->create_wheel_timer(pacing_scheduler_tick_cb, this, true);
+    }
+
+    void PacingScheduler::OnPacketEnqueued(PacedSender* sender) {
+        if (!el_) {
+            sender->ProcessPackets(SIZE_MAX);
+            return;
+        }
+
+        // 已经在轮转队列中的发送者等待自己的时间片，保持队列中的顺序
+        if (sender->scheduled_) {
+            return;
+        }
+
+        RefreshBudget();
+        if (budget_ > 0) {
+            budget_ -= sender->ProcessPackets(budget_);
+        }
+
+        // 本轮预算用完或者受自己的码率限制，剩下的包交给定时器
+        if (sender->QueueSizePackets() > 0) {
+            AddSender(sender);
+        }
+    }
+
+    void PacingScheduler::RemoveSender(PacedSender* sender) {
+        if (!sender->scheduled_) {
+            return;
+        }
+
+        auto iter = std::find(senders_.begin(), senders_.end(), sender);
+        if (iter != senders_.end()) {
+            RemoveSenderAt(iter - senders_.begin());
+        }
+    }
+
+    void PacingScheduler::ProcessSenders() {
+        RefreshBudget();
+        while (budget_ > 0 && !senders_.empty()) {
+            // 一圈中每个发送者最多发送一个时间片，所有发送者都没有发出包时说明
+            // 剩下的都受自己的码率限制，等下一个tick
+            size_t sent_packets = 0;
+            size_t count = senders_.size();
+            for (size_t i = 0; i < count && budget_ > 0 && !senders_.empty(); ++i) {
+                if (cursor_ >= senders_.size()) {
+                    cursor_ = 0;
+                }
+
+                PacedSender* sender = senders_[cursor_];
+                size_t sent = sender->ProcessPackets(std::min(budget_, kSlicePackets));
+                budget_ -= sent;
+                sent_packets += sent;
+
+                if (0 == sender->QueueSizePackets()) {
+                    RemoveSenderAt(cursor_);
+                } else {
+                    ++cursor_;
+                }
+            }
+
+            if (0 == sent_packets) {
+                break;
+            }
+        }
+
+        if (senders_.empty() && timer_started_) {
+            el_->stop_timer(tick_timer_);
+            timer_started_ = false;
+        }
+    }
+
+    void PacingScheduler::RefreshBudget() {
+        unsigned int iteration = el_->iteration();
+        if (iteration != budget_iteration_) {
+            budget_iteration_ = iteration;
+            budget_ = packets_per_iteration_;
+        }
+    }
+
+    void PacingScheduler::AddSender(PacedSender* sender) {
+        sender->scheduled_ = true;
+        senders_.push_back(sender);
+        if (!timer_started_) {
+            el_->start_timer(tick_timer_, kSchedulerTickUs);
+            timer_started_ = true;
+        }
+    }
+
+    void PacingScheduler::RemoveSenderAt(size_t index) {
+        senders_[index]->scheduled_ = false;
+        senders_.erase(senders_.begin() + index);
+        if (index < cursor_) {
+            --cursor_;
+        }
+    }
+
+} // namespace xrtc
@@ -0,0 +1,57 @@
+#ifndef MODULES_PACING_PACING_SCHEDULER_H_
+#define MODULES_PACING_PACING_SCHEDULER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/event_loop.h"
+
+namespace xrtc {
+
+    class PacedSender;
+
+    // 一个worker上所有PacedSender共用的发送调度，线程局部，
+    // 每轮事件循环最多发送packets_per_iteration个包，限制关键帧扇出时一次回调写入内核的包数；
+    // 预算用完之后还有包的发送者进入轮转队列，由一个时间轮定时器每个tick给每个发送者
+    // 一个时间片，下一个tick从上次中断的位置继续
+    class PacingScheduler {
+    public:
+        PacingScheduler();
+        ~PacingScheduler();
+
+        static PacingScheduler* current();
+
+        // 在worker线程开始事件循环之前调用，没有初始化时不限制每轮的发送量
+        void Init(EventLoop* el, size_t packets_per_iteration);
+
+        // 发送者有新的包入队，本轮预算还有剩余时直接发送
+        void OnPacketEnqueued(PacedSender* sender);
+        // 发送者销毁或者迁移走之前调用
+        void RemoveSender(PacedSender* sender);
+
+        size_t PendingSenders() const { return senders_.size(); }
+
+    private:
+        friend void pacing_scheduler_tick_cb(EventLoop* el, TimerWatcher* w, void* data);
+        void ProcessSenders();
+        void RefreshBudget();
+        void AddSender(PacedSender* sender);
+        void RemoveSenderAt(size_t index);
+
+    private:
+        EventLoop* el_ = nullptr;
+        TimerWatcher* tick_timer_ = nullptr;
+        bool timer_started_ = false;
+        size_t packets_per_iteration_ = 0;
+        // 本轮事件循环剩余的预算
+        size_t budget_ = 0;
+        unsigned int budget_iteration_ = 0;
+        // 等待发送的发送者，cursor_是下一个时间片的发送者
+        std::vector<PacedSender*> senders_;
+        size_t cursor_ = 0;
+    };
+
+} // namespace xrtc
+
+#endif // MODULES_PACING_PACING_SCHEDULER_H_
@@ -8,11 +8,11 @@ namespace xrtc {
     RoundRobinPacketQueue::QueuedPacket::QueuedPacket(int priority,
         webrtc::Timestamp enqueue_time,
         uint64_t enqueue_order,
-        std::unique_ptr<RtpPacketToSend> packet) :
+        PacedPacket packet) :
         priority_(priority),
         enqueue_time_(enqueue_time),
         enqueue_order_(enqueue_order),
-        owned_packet_(packet.release())
+        packet_(std::move(packet))
     {
     }
 
@@ -31,12 +31,12 @@ namespace xrtc {
     void RoundRobinPacketQueue::Push(int priority, 
         webrtc::Timestamp enqueue_time, 
         uint64_t enqueue_order, 
-        std::unique_ptr<RtpPacketToSend> packet)
+        PacedPacket packet)
     {
         Push(QueuedPacket(priority, enqueue_time, enqueue_order, std::move(packet)));
     }
 
-    std::unique_ptr<RtpPacketToSend> RoundRobinPacketQueue::Pop() {
+    PacedPacket RoundRobinPacketQueue::Pop() {
         // 获取优先级最高的流
         Stream* stream = GetHighestPriorityStream();        
         const QueuedPacket& queued_packet = stream->packet_queue.top();
@@ -55,7 +55,7 @@ namespace xrtc {
         stream->size = std::max(stream->size + packet_size, max_size_ - kMaxLeadingSize);
         max_size_ = std::max(stream->size, max_size_);
 
-        std::unique_ptr<RtpPacketToSend> rtp_packet(queued_packet.rtp_packet());
+        PacedPacket rtp_packet = queued_packet.packet();
         stream->packet_queue.pop();
         size_packets_ -= 1;
         size_ -= packet_size;
@@ -112,7 +112,7 @@ namespace xrtc {
         // 2.2 如果存在stream，然后新来了一个packet，该packet的priority比stream的要小
         // 则说明需要重新提高stream的优先级了
         else if (packet.Priority() < stream->priority_it->first.priority) {
-            streams_.erase(stream_iter);
+            stream_priorities_.erase(stream->priority_it);
             // 重新插入，更新优先级
             stream->priority_it = stream_priorities_.emplace(StreamPrioKey(packet.Priority(), stream->size),
                 packet.Ssrc());
@@ -134,8 +134,7 @@ namespace xrtc {
         const QueuedPacket& queued_packet)
     {
         // 暂时先不考虑rtp的头部大小
-        return webrtc::DataSize::Bytes(queued_packet.rtp_packet()->payload_size() +
-            queued_packet.rtp_packet()->padding_size());
+        return webrtc::DataSize::Bytes(queued_packet.packet().payload_size);
     }
 
     RoundRobinPacketQueue::Stream::Stream() :
@@ -8,7 +8,7 @@
 #include <api/units/timestamp.h>
 #include <api/units/data_size.h>
 
-#include "modules/rtp_rtcp/rtp_packet_to_send.h"
+#include "modules/pacing/paced_packet.h"
 
 namespace xrtc {
 
@@ -20,9 +20,9 @@ namespace xrtc {
         void Push(int priority,
             webrtc::Timestamp enqueue_time,
             uint64_t enqueue_order,
-            std::unique_ptr<RtpPacketToSend> packet);
+            PacedPacket packet);
 
-        std::unique_ptr<RtpPacketToSend> Pop();
+        PacedPacket Pop();
 
         bool Empty() const { return size_packets_ == 0;}
         webrtc::DataSize Size() const { return size_; }
@@ -36,7 +36,7 @@ namespace xrtc {
             QueuedPacket(int priority,
                 webrtc::Timestamp enqueue_time,
                 uint64_t enqueue_order,
-                std::unique_ptr<RtpPacketToSend> packet);
+                PacedPacket packet);
             ~QueuedPacket();
 
             bool operator<(const QueuedPacket& other) const {
@@ -48,18 +48,18 @@ namespace xrtc {
                 return enqueue_order_ > other.enqueue_order_;
             }
 
-            uint32_t Ssrc() const { return owned_packet_->ssrc(); }
+            uint32_t Ssrc() const { return packet_.ssrc; }
             int Priority() const { return priority_; }
             webrtc::Timestamp EnqueueTime() const { return enqueue_time_; }
-            RtpPacketToSend* rtp_packet() const {
-                return owned_packet_;
+            const PacedPacket& packet() const {
+                return packet_;
             }
 
         private:
             int priority_;                   // RTP包的优先级
             webrtc::Timestamp enqueue_time_; // RTP包入队列时间
             uint64_t enqueue_order_;         // RTP包入队列的顺序
-            RtpPacketToSend* owned_packet_;  // 原始数据包
+            PacedPacket packet_;             // 数据包，复制时只增加缓冲区的引用计数
         };
 
         struct StreamPrioKey {
@@ -29,6 +29,8 @@
 
 namespace xrtc {
 
+class RtpPacketView;
+
 class ReceiveStatisticsProvider {
  public:
   virtual ~ReceiveStatisticsProvider() = default;
@@ -66,6 +68,10 @@ class ReceiveStatistics : public ReceiveStatisticsProvider,
   static std::unique_ptr<ReceiveStatistics> CreateThreadCompatible(
       webrtc::Clock* clock);
 
+  // 已经解析过的包直接使用视图，避免再次拷贝解析
+  virtual void OnRtpPacket(const RtpPacketView& packet) = 0;
+  using RtpPacketSinkInterface::OnRtpPacket;
+
   // Returns a pointer to the statistician of an ssrc.
   virtual StreamStatistician* GetStatistician(uint32_t ssrc) const = 0;
 
@@ -62,7 +62,7 @@ StreamStatisticianImpl::StreamStatisticianImpl(uint32_t ssrc,
 
 StreamStatisticianImpl::~StreamStatisticianImpl() = default;
 
-bool StreamStatisticianImpl::UpdateOutOfOrder(const RtpPacketReceived& packet,
+bool StreamStatisticianImpl::UpdateOutOfOrder(const RtpPacketView& packet,
                                               int64_t sequence_number,
                                               int64_t now_ms) {
   // Check if `packet` is second packet of a stream restart.
@@ -111,7 +111,7 @@ bool StreamStatisticianImpl::UpdateOutOfOrder(const RtpPacketReceived& packet,
   return true;
 }
 
-void StreamStatisticianImpl::UpdateCounters(const RtpPacketReceived& packet) {
+void StreamStatisticianImpl::UpdateCounters(const RtpPacketView& packet) {
     RTC_DCHECK_EQ(ssrc_, packet.ssrc());
     int64_t now_ms = clock_->TimeInMilliseconds();
 
@@ -148,7 +148,7 @@ void StreamStatisticianImpl::UpdateCounters(const RtpPacketReceived& packet) {
     last_receive_time_ms_ = now_ms;
 }
 
-void StreamStatisticianImpl::UpdateJitter(const RtpPacketReceived& packet,
+void StreamStatisticianImpl::UpdateJitter(const RtpPacketView& packet,
                                           int64_t receive_time_ms) {
   int64_t receive_diff_ms = receive_time_ms - last_receive_time_ms_;
   RTC_DCHECK_GE(receive_diff_ms, 0);
@@ -283,7 +283,7 @@ uint32_t StreamStatisticianImpl::BitrateReceived() const {
 }
 
 bool StreamStatisticianImpl::IsRetransmitOfOldPacket(
-    const RtpPacketReceived& packet,
+    const RtpPacketView& packet,
     int64_t now_ms) const {
   uint32_t frequency_khz = packet.payload_type_frequency() / 1000;
   RTC_DCHECK_GT(frequency_khz, 0);
@@ -339,6 +339,16 @@ ReceiveStatisticsImpl::ReceiveStatisticsImpl(
       max_reordering_threshold_(kDefaultMaxReorderingThreshold) {}
 
 void ReceiveStatisticsImpl::OnRtpPacket(const RtpPacketReceived& packet) {
+  RtpPacketView view;
+  if (!view.Parse(packet.data(), packet.size())) {
+    return;
+  }
+  view.set_payload_type_frequency(packet.payload_type_frequency());
+  view.set_recovered(packet.recovered());
+  OnRtpPacket(view);
+}
+
+void ReceiveStatisticsImpl::OnRtpPacket(const RtpPacketView& packet) {
   // StreamStatisticianImpl instance is created once and only destroyed when
   // this whole ReceiveStatisticsImpl is destroyed. StreamStatisticianImpl has
   // it's own locking so don't hold receive_statistics_lock_ (potential
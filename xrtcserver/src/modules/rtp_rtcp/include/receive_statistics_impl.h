@@ -28,6 +28,7 @@
 
 #include "modules/rtp_rtcp/include/receive_statistics.h"
 #include "modules/rtp_rtcp/rtcp_packet/report_block.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
 
 namespace xrtc {
 
@@ -39,7 +40,7 @@ class StreamStatisticianImplInterface : public StreamStatistician {
       std::vector<rtcp::ReportBlock>& report_blocks) = 0;
   virtual void SetMaxReorderingThreshold(int max_reordering_threshold) = 0;
   virtual void EnableRetransmitDetection(bool enable) = 0;
-  virtual void UpdateCounters(const RtpPacketReceived& packet) = 0;
+  virtual void UpdateCounters(const RtpPacketView& packet) = 0;
 };
 
 // Thread-compatible implementation of StreamStatisticianImplInterface.
@@ -62,15 +63,15 @@ class StreamStatisticianImpl : public StreamStatisticianImplInterface {
   void SetMaxReorderingThreshold(int max_reordering_threshold) override;
   void EnableRetransmitDetection(bool enable) override;
   // Updates StreamStatistician for incoming packets.
-  void UpdateCounters(const RtpPacketReceived& packet) override;
+  void UpdateCounters(const RtpPacketView& packet) override;
 
  private:
-  bool IsRetransmitOfOldPacket(const RtpPacketReceived& packet,
+  bool IsRetransmitOfOldPacket(const RtpPacketView& packet,
                                int64_t now_ms) const;
-  void UpdateJitter(const RtpPacketReceived& packet, int64_t receive_time_ms);
+  void UpdateJitter(const RtpPacketView& packet, int64_t receive_time_ms);
   // Updates StreamStatistician for out of order packets.
   // Returns true if packet considered to be out of order.
-  bool UpdateOutOfOrder(const RtpPacketReceived& packet,
+  bool UpdateOutOfOrder(const RtpPacketView& packet,
                         int64_t sequence_number,
                         int64_t now_ms);
   // Checks if this StreamStatistician received any rtp packets.
@@ -151,7 +152,7 @@ class StreamStatisticianLocked : public StreamStatisticianImplInterface {
     webrtc::MutexLock lock(&stream_lock_);
     return impl_.EnableRetransmitDetection(enable);
   }
-  void UpdateCounters(const RtpPacketReceived& packet) override {
+  void UpdateCounters(const RtpPacketView& packet) override {
     webrtc::MutexLock lock(&stream_lock_);
     return impl_.UpdateCounters(packet);
   }
@@ -178,6 +179,9 @@ class ReceiveStatisticsImpl : public ReceiveStatistics {
   // Implements RtpPacketSinkInterface
   void OnRtpPacket(const RtpPacketReceived& packet) override;
 
+  // Implements ReceiveStatistics.
+  void OnRtpPacket(const RtpPacketView& packet) override;
+
   // Implements ReceiveStatistics.
   StreamStatistician* GetStatistician(uint32_t ssrc) const override;
   void SetMaxReorderingThreshold(int max_reordering_threshold) override;
@@ -224,6 +228,10 @@ class ReceiveStatisticsLocked : public ReceiveStatistics {
     return impl_.OnRtpPacket(packet);
   }
 
+  void OnRtpPacket(const RtpPacketView& packet) override {
+    return impl_.OnRtpPacket(packet);
+  }
+
   StreamStatistician* GetStatistician(uint32_t ssrc) const override {
     return impl_.GetStatistician(ssrc);
   }
@@ -1,5 +1,6 @@
 ﻿#include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "modules/rtp_rtcp/rtp_packet.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
 
 namespace xrtc {
 
@@ -32,6 +33,13 @@ namespace xrtc {
         ++packets;
     }
 
+    void RtpPacketCounter::AddPacket(const RtpPacketView& packet) {
+        header_bytes += packet.header_size();
+        payload_bytes += packet.payload_size();
+        padding_bytes += packet.padding_size();
+        ++packets;
+    }
+
     StreamDataCounters::StreamDataCounters() : first_packet_time_ms(-1) {}
 
 
@@ -10,6 +10,7 @@
 namespace xrtc {
 
 class RtpPacket;
+class RtpPacketView;
 
 constexpr int kDefaultMaxReorderingThreshold = 5;  // In sequence numbers.
 constexpr int kRtcpMaxNackFields = 253;
@@ -41,10 +42,13 @@ class RtpPacketCounter {
 public:
     RtpPacketCounter() = default;
     explicit RtpPacketCounter(const RtpPacket& packet);
+    RtpPacketCounter(size_t header, size_t payload, size_t padding) :
+        header_bytes(header), payload_bytes(payload), padding_bytes(padding), packets(1) {}
 
     void Add(const RtpPacketCounter& other);
     void Subtract(const RtpPacketCounter& other);
     void AddPacket(const RtpPacket& packet);
+    void AddPacket(const RtpPacketView& packet);
 
     size_t header_bytes = 0;
     size_t payload_bytes = 0;
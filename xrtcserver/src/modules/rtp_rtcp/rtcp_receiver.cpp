@@ -83,6 +83,9 @@ bool RTCPReceiver::ParseCompoundPacket(rtc::ArrayView<const uint8_t> packet,
 			case rtcp::SenderReport::kPacketType: // SR 200
 				HandleSenderReport(rtcp_block, packet_info);
 				break;
+			case rtcp::ReceiverReport::kPacketType: // RR 201
+				HandleReceiverReport(rtcp_block, packet_info);
+				break;
 			case RTCPPayloadType::kRtpFb: // 205
 				switch (rtcp_block.fmt()) {
 				case rtcp::Nack::kFeedbackMessageType: // 1 NACK
@@ -0,0 +1,172 @@
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+
+#include <rtc_base/logging.h>
+
+#include "modules/rtp_rtcp/source/byte_io.h"
+
+namespace xrtc {
+
+namespace {
+
+const size_t kFixedHeaderSize = 12;
+const uint8_t kRtpVersion = 2;
+
+constexpr uint16_t kOneByteExtensionProfileId = 0xBEDE;
+constexpr uint16_t kTwoByteExtensionProfileId = 0x1000;
+constexpr uint16_t kTwobyteExtensionProfileIdAppBitsFilter = 0xfff0;
+constexpr size_t kOneByteExtensionHeaderLength = 1;
+constexpr size_t kTwoByteExtensionHeaderLength = 2;
+constexpr uint8_t kPaddingByte = 0;
+constexpr uint8_t kPaddingId = 0;
+constexpr uint8_t kOneByteHeaderExtensionReservedId = 15;
+
+} // namespace
+
+// 解析规则和RtpPacket::ParseBuffer一致，只是不拷贝数据，
+// 扩展信息记录在定长数组中，不需要分配内存
+bool RtpPacketView::Parse(const uint8_t* buffer, size_t size) {
+    data_ = buffer;
+    size_ = size;
+    num_extensions_ = 0;
+    payload_type_frequency_ = 0;
+    recovered_ = false;
+
+    if (size < kFixedHeaderSize) {
+        return false;
+    }
+
+    const uint8_t version = buffer[0] >> 6;
+    if (version != kRtpVersion) {
+        return false;
+    }
+
+    const bool has_padding = (buffer[0] & 0x20) != 0;
+    const bool has_extension = (buffer[0] & 0x10) != 0;
+    const uint8_t number_of_crcs = buffer[0] & 0x0f;
+    marker_ = (buffer[1] & 0x80) != 0;
+    payload_type_ = buffer[1] & 0x7f;
+
+    sequence_number_ = webrtc::ByteReader<uint16_t>::ReadBigEndian(&buffer[2]);
+    timestamp_ = webrtc::ByteReader<uint32_t>::ReadBigEndian(&buffer[4]);
+    ssrc_ = webrtc::ByteReader<uint32_t>::ReadBigEndian(&buffer[8]);
+    if (size < kFixedHeaderSize + number_of_crcs * 4) {
+        return false;
+    }
+    payload_offset_ = kFixedHeaderSize + number_of_crcs * 4;
+
+    if (has_extension) {
+        size_t extension_offset = payload_offset_ + 4;
+        if (extension_offset > size) {
+            return false;
+        }
+
+        uint16_t profile =
+            webrtc::ByteReader<uint16_t>::ReadBigEndian(&buffer[payload_offset_]);
+        size_t extensions_capacity =
+            webrtc::ByteReader<uint16_t>::ReadBigEndian(&buffer[payload_offset_ + 2]);
+        extensions_capacity *= 4;
+        if (extension_offset + extensions_capacity > size) {
+            return false;
+        }
+
+        if (profile == kOneByteExtensionProfileId ||
+                (profile & kTwobyteExtensionProfileIdAppBitsFilter) == kTwoByteExtensionProfileId)
+        {
+            size_t extension_header_length = profile == kOneByteExtensionProfileId
+                ? kOneByteExtensionHeaderLength
+                : kTwoByteExtensionHeaderLength;
+            size_t extensions_size = 0;
+            while (extensions_size + extension_header_length < extensions_capacity) {
+                const uint8_t* p = buffer + extension_offset + extensions_size;
+                if (*p == kPaddingByte) {
+                    extensions_size++;
+                    continue;
+                }
+
+                uint8_t id;
+                uint8_t length;
+                if (profile == kOneByteExtensionProfileId) {
+                    id = p[0] >> 4;
+                    length = 1 + (p[0] & 0xf);
+                    if (id == kOneByteHeaderExtensionReservedId ||
+                            (id == kPaddingId && length != 1))
+                    {
+                        break;
+                    }
+                } else {
+                    id = p[0];
+                    length = p[1];
+                }
+
+                if (extensions_size + extension_header_length + length > extensions_capacity) {
+                    RTC_LOG(LS_WARNING) << "Oversized rtp header extension.";
+                    break;
+                }
+
+                size_t offset = extension_offset + extensions_size + extension_header_length;
+                if (offset > 0xFFFF) {
+                    break;
+                }
+
+                AddExtension(id, length, static_cast<uint16_t>(offset));
+                extensions_size += extension_header_length + length;
+            }
+        }
+
+        payload_offset_ = extension_offset + extensions_capacity;
+    }
+
+    if (has_padding && payload_offset_ < size) {
+        padding_size_ = buffer[size - 1];
+        if (padding_size_ == 0) {
+            return false;
+        }
+    } else {
+        padding_size_ = 0;
+    }
+
+    if (payload_offset_ + padding_size_ > size) {
+        return false;
+    }
+    payload_size_ = size - payload_offset_ - padding_size_;
+    return true;
+}
+
+void RtpPacketView::AddExtension(uint8_t id, uint8_t length, uint16_t offset) {
+    // 重复的id以最后一个为准，和RtpPacket一致
+    for (size_t i = 0; i < num_extensions_; ++i) {
+        if (extension_entries_[i].id == id) {
+            extension_entries_[i].length = length;
+            extension_entries_[i].offset = offset;
+            return;
+        }
+    }
+
+    if (num_extensions_ < kMaxExtensions) {
+        extension_entries_[num_extensions_++] = ExtensionInfo{id, length, offset};
+    }
+}
+
+rtc::ArrayView<const uint8_t> RtpPacketView::FindExtensionById(int id) const {
+    for (size_t i = 0; i < num_extensions_; ++i) {
+        if (extension_entries_[i].id == id) {
+            return rtc::MakeArrayView(data_ + extension_entries_[i].offset,
+                    extension_entries_[i].length);
+        }
+    }
+    return nullptr;
+}
+
+rtc::ArrayView<const uint8_t> RtpPacketView::FindExtension(ExtensionType type) const {
+    if (!extensions_) {
+        return nullptr;
+    }
+
+    uint8_t id = extensions_->GetId(type);
+    if (id == ExtensionManager::kInvalidId) {
+        return nullptr;
+    }
+    return FindExtensionById(id);
+}
+
+} // namespace xrtc
@@ -0,0 +1,111 @@
+/**
+ * @file rtp_packet_view.h
+ * @author charles
+ * @brief RTP包的只读视图，不拷贝数据
+ *         收到包时解析一次header和扩展偏移表，之后分发、接收统计、
+ *         NACK、转发都使用同一个视图，数据的生命周期由调用方保证
+*/
+
+#ifndef MODULES_RTP_RTCP_RTP_PACKET_VIEW_H_
+#define MODULES_RTP_RTCP_RTP_PACKET_VIEW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <api/array_view.h>
+
+#include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
+#include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
+
+namespace xrtc {
+
+class RtpPacketView {
+public:
+    using ExtensionType = RTPExtensionType;
+    using ExtensionManager = RtpHeaderExtensionMap;
+
+    // 一个包内最多记录的扩展个数，超过的扩展忽略
+    static const size_t kMaxExtensions = 16;
+
+public:
+    RtpPacketView() = default;
+
+    // 解析失败时视图不可用，header字段的值无意义
+    bool Parse(const uint8_t* buffer, size_t size);
+    bool Parse(rtc::ArrayView<const uint8_t> packet) {
+        return Parse(packet.data(), packet.size());
+    }
+
+    uint32_t ssrc() const { return ssrc_; }
+    uint16_t sequence_number() const { return sequence_number_; }
+    bool marker() const { return marker_; }
+    uint8_t payload_type() const { return payload_type_; }
+    uint32_t timestamp() const { return timestamp_; }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t header_size() const { return payload_offset_; }
+    size_t payload_size() const { return payload_size_; }
+    size_t padding_size() const { return padding_size_; }
+    rtc::ArrayView<const uint8_t> payload() const {
+        return rtc::MakeArrayView(data_ + payload_offset_, payload_size_);
+    }
+
+    // 接收端元数据，不是从包中解析出来的
+    int payload_type_frequency() const { return payload_type_frequency_; }
+    void set_payload_type_frequency(int value) { payload_type_frequency_ = value; }
+    bool recovered() const { return recovered_; }
+    void set_recovered(bool value) { recovered_ = value; }
+
+    // 扩展id和类型的映射，没有设置时所有扩展都查不到
+    void set_extension_map(const ExtensionManager* extensions) { extensions_ = extensions; }
+
+    template <typename Extension>
+    bool HasExtension() const { return !FindExtension(Extension::kId).empty(); }
+
+    template <typename Extension, typename FirstValue, typename... Values>
+    bool GetExtension(FirstValue first, Values... values) const {
+        auto raw = FindExtension(Extension::kId);
+        if (raw.empty()) {
+            return false;
+        }
+        return Extension::Parse(raw, first, values...);
+    }
+
+    // 按id查找扩展的原始数据，没有时返回空
+    rtc::ArrayView<const uint8_t> FindExtensionById(int id) const;
+    rtc::ArrayView<const uint8_t> FindExtension(ExtensionType type) const;
+
+private:
+    struct ExtensionInfo {
+        uint8_t id;
+        uint8_t length;
+        uint16_t offset;
+    };
+
+    void AddExtension(uint8_t id, uint8_t length, uint16_t offset);
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+
+    bool marker_ = false;
+    uint8_t payload_type_ = 0;
+    uint16_t sequence_number_ = 0;
+    uint32_t timestamp_ = 0;
+    uint32_t ssrc_ = 0;
+    size_t payload_offset_ = 0;
+    size_t payload_size_ = 0;
+    size_t padding_size_ = 0;
+
+    int payload_type_frequency_ = 0;
+    bool recovered_ = false;
+
+    const ExtensionManager* extensions_ = nullptr;
+    ExtensionInfo extension_entries_[kMaxExtensions];
+    size_t num_extensions_ = 0;
+};
+
+} // namespace xrtc
+
+#endif // MODULES_RTP_RTCP_RTP_PACKET_VIEW_H_
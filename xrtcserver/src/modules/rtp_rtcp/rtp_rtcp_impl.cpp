@@ -13,7 +13,7 @@ const int kDefaultVideoRtcpIntervalMs = 1000;
 
 void send_rr_rtcp_time_cb(EventLoop*, TimerWatcher*, void* data) {
     ModuleRtpRtcpImpl* impl = (ModuleRtpRtcpImpl*)data;
-    impl->SendRTCPReceiveReport();
+    impl->SendRTCPReport();
 }
 
 ModuleRtpRtcpImpl::ModuleRtpRtcpImpl(
@@ -28,7 +28,7 @@ ModuleRtpRtcpImpl::ModuleRtpRtcpImpl(
     rtcp_receiver_(config)
 {
     int report_interval_ms = config.audio ? kDefaultAudioRtcpIntervalMs : kDefaultVideoRtcpIntervalMs;
-    send_rr_rtcp_timer_ = el_->create_timer(send_rr_rtcp_time_cb, this, true);
+    send_rr_rtcp_timer_ = el_->create_wheel_timer(send_rr_rtcp_time_cb, this, true);
     el_->start_timer(send_rr_rtcp_timer_, report_interval_ms * 1000);  
 }
 
@@ -39,6 +39,15 @@ ModuleRtpRtcpImpl::~ModuleRtpRtcpImpl() {
     }
 }
 
+void ModuleRtpRtcpImpl::DetachEventLoop() {
+    el_->detach_timer(send_rr_rtcp_timer_);
+}
+
+void ModuleRtpRtcpImpl::AttachEventLoop(EventLoop* el) {
+    el_ = el;
+    el_->attach_timer(send_rr_rtcp_timer_);
+}
+
 void ModuleRtpRtcpImpl::UpdateRtpStats(std::shared_ptr<RtpPacketToSend> packet,
          bool is_rtx, bool is_retransmit)
 {
@@ -52,6 +61,17 @@ void ModuleRtpRtcpImpl::UpdateRtpStats(std::shared_ptr<RtpPacketToSend> packet,
     stream_counter->transmitted.Add(counter);
 }
 
+void ModuleRtpRtcpImpl::UpdateRtpStats(const RtpPacketCounter& counter,
+        bool is_rtx, bool is_retransmit)
+{
+    StreamDataCounters* stream_counter = is_rtx ? &rtx_rtp_stats_ : &rtp_stats_;
+    if (is_retransmit) {
+        stream_counter->retransmitted.Add(counter);
+    }
+
+    stream_counter->transmitted.Add(counter);
+}
+
 void ModuleRtpRtcpImpl::SetRTCPStatus(webrtc::RtcpMode mode) {
     rtcp_sender_.SetRTCPStatus(mode);
 }
@@ -146,8 +166,10 @@ RTCPSender::FeedbackState ModuleRtpRtcpImpl::GetFeedbackState() {
     return state;
 }
 
-void ModuleRtpRtcpImpl::SendRTCPReceiveReport() {
-    rtcp_sender_.SendRTCP(GetFeedbackState(), RTCPPacketType::kRtcpRr);
+void ModuleRtpRtcpImpl::SendRTCPReport() {
+    // 还没有发送过RTP包时SR会被跳过
+    rtcp_sender_.SendRTCP(GetFeedbackState(),
+            rtcp_sender_.Sending() ? RTCPPacketType::kRtcpSr : RTCPPacketType::kRtcpRr);
 }
 
 void ModuleRtpRtcpImpl::SendNack(const std::vector<uint16_t>& sequence_numbers) {
@@ -8,6 +8,7 @@
 #include "base/event_loop.h"
 #include "modules/rtp_rtcp/rtp_rtcp_interface.h"
 #include "modules/rtp_rtcp/rtp_packet_to_send.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
 #include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 #include "modules/rtp_rtcp/rtcp_sender.h"
 #include "modules/rtp_rtcp/rtcp_receiver.h"
@@ -21,6 +22,8 @@ namespace xrtc {
 
         void UpdateRtpStats(std::shared_ptr<RtpPacketToSend> packet,
             bool is_rtx, bool is_retransmit);
+        // 转发的包只有转发路径上已经算好的大小，不需要构造RtpPacketToSend
+        void UpdateRtpStats(const RtpPacketCounter& counter, bool is_rtx, bool is_retransmit);
         void SetRTCPStatus(webrtc::RtcpMode mode);
         void SetSendingStatus(bool sending);
         void OnSendingRtpFrame(uint32_t rtp_timestamp,
@@ -31,11 +34,15 @@ namespace xrtc {
         }
         void IncomingRtcpPacket(rtc::ArrayView<const uint8_t> packet);
 
-        // 周期发送RTCP RR包
-        void SendRTCPReceiveReport();
+        // 周期发送RTCP报告，发送端为SR，只接收时为RR
+        void SendRTCPReport();
 
         void SendNack(const std::vector<uint16_t>& sequence_numbers);
 
+        // 会话迁移到其它worker时，RR定时器跟随转移
+        void DetachEventLoop();
+        void AttachEventLoop(EventLoop* el);
+
     private:
         void ScheduleNextRtcpSend(webrtc::TimeDelta duration);
         void MaybeSendRTCP();
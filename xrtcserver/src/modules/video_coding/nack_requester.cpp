@@ -27,7 +27,7 @@ NackRequester::NackRequester(EventLoop* el, webrtc::Clock* clock) :
     rtt_ms_(kDefaultRttMs),
     reordering_histogram_(kNumReorderingBuckets, kMaxReorderingPackets)
 {
-    nack_timer_ = el_->create_timer(nack_time_cb, this, true);
+    nack_timer_ = el_->create_wheel_timer(nack_time_cb, this, true);
     el_->start_timer(nack_timer_, kUpdateIntervalMs * 1000);     
 }
 
@@ -38,6 +38,15 @@ NackRequester::~NackRequester() {
     }
 }
 
+void NackRequester::DetachEventLoop() {
+    el_->detach_timer(nack_timer_);
+}
+
+void NackRequester::AttachEventLoop(EventLoop* el) {
+    el_ = el;
+    el_->attach_timer(nack_timer_);
+}
+
 int NackRequester::OnReceivedPacket(uint16_t seq_num, bool is_keyframe, bool is_retransmitted) {
     // 第一次收到数据包
     if (!initialized_) {
@@ -26,6 +26,9 @@ public:
     void ProcessNacks();
     void UpdateRtt(int64_t rtt_ms) { rtt_ms_ = rtt_ms; }
 
+    void DetachEventLoop();
+    void AttachEventLoop(EventLoop* el);
+
 private:
     enum NackFilterOptions {
         kSeqNumOnly,    // 基于丢包时触发
@@ -40,7 +40,12 @@ void DtlsSrtpTransport::_on_read_packet(DtlsTransport* /*dtls*/,
         return;
     }
 
-    rtc::CopyOnWriteBuffer packet(data, len);
+    // 从本worker的缓冲池取缓冲区，原地解密后由所有消费者共享
+    PacketBufferPtr packet = PacketBufferPool::current()->alloc(data, len);
+    if (!packet) {
+        return;
+    }
+
     if (packet_type == RtpPacketType::k_rtcp) {
         _on_rtcp_packet_received(std::move(packet), ts);
     } else {
@@ -48,38 +53,39 @@ void DtlsSrtpTransport::_on_read_packet(DtlsTransport* /*dtls*/,
     }
 }
 
-void DtlsSrtpTransport::_on_rtp_packet_received(rtc::CopyOnWriteBuffer packet, int64_t ts) {
+void DtlsSrtpTransport::_on_rtp_packet_received(PacketBufferPtr packet, int64_t ts) {
     if (!is_srtp_active()) {
         RTC_LOG(LS_WARNING) << "Inactive SRTP transport received a rtp packet, drop it.";
         return;
     }
 
-    char *data = packet.data<char>();
-    int len = packet.size();
+    char *data = (char*)packet->data();
+    int len = packet->size();
     if (!unprotect_rtp(data, len, &len)) {
         const int k_fail_log = 100; // 失败100次才打印，控制刷屏
         if (unprotect_fail_count_ % k_fail_log == 0) {
+            auto view = rtc::MakeArrayView(packet->data(), packet->size());
             RTC_LOG(LS_WARNING) << "Failed to unprotect rtp packet: "
                 << ", size=" << len
-                << ", seqnum=" << parse_rtp_sequence_number(packet)
-                << ", ssrc=" << parse_rtp_ssrc(packet)
+                << ", seqnum=" << parse_rtp_sequence_number(view)
+                << ", ssrc=" << parse_rtp_ssrc(view)
                 << ", unprotect_fail_count=" << unprotect_fail_count_;
         }
         unprotect_fail_count_++;
         return;
     }
-    packet.SetSize(len);
-    signal_rtp_packet_received(this, &packet, ts);
+    packet->set_size(len);
+    signal_rtp_packet_received(this, packet.get(), ts);
 }
 
-void DtlsSrtpTransport::_on_rtcp_packet_received(rtc::CopyOnWriteBuffer packet, int64_t ts) {
+void DtlsSrtpTransport::_on_rtcp_packet_received(PacketBufferPtr packet, int64_t ts) {
     if (!is_srtp_active()) {
         RTC_LOG(LS_WARNING) << "Inactive SRTP transport received a rtcp packet, drop it.";
         return;
     }
 
-    char* data = packet.data<char>();
-    int len = packet.size();
+    char* data = (char*)packet->data();
+    int len = packet->size();
     if (!unprotect_rtcp(data, len, &len)) {
         int type = 0;
         get_rtcp_type(data, len, &type);
@@ -88,8 +94,8 @@ void DtlsSrtpTransport::_on_rtcp_packet_received(rtc::CopyOnWriteBuffer packet,
             << ", type=" << type;
         return;
     }
-    packet.SetSize(len);
-    signal_rtcp_packet_received(this, &packet, ts);
+    packet->set_size(len);
+    signal_rtcp_packet_received(this, packet.get(), ts);
 }
 
 void DtlsSrtpTransport::_on_dtls_state(DtlsTransport* /*dtls*/, DtlsTransportState state) {
@@ -190,28 +196,30 @@ int DtlsSrtpTransport::send_rtp(const char* buf, size_t size) {
         return -1;
     }
 
-    int rtp_auth_tag_len = 0;
-    get_send_auth_tag_len(&rtp_auth_tag_len, nullptr);
-    // size + rtp_auth_tag_len：加密后的容量
-    rtc::CopyOnWriteBuffer packet(buf, size, size + rtp_auth_tag_len); 
+    // 加密会原地写入并追加认证tag，只在这里拷贝一次，缓冲区的tailroom足够容纳tag
+    PacketBufferPtr packet = PacketBufferPool::current()->alloc(buf, size);
+    if (!packet) {
+        RTC_LOG(LS_WARNING) << "Failed to send rtp packet: packet too large, size=" << size;
+        return -1;
+    }
 
-    char* data = (char*)packet.data();
-    int len = packet.size();
-    uint16_t seq_num = parse_rtp_sequence_number(packet);
+    char* data = (char*)packet->data();
+    int len = packet->size();
+    auto view = rtc::MakeArrayView(packet->data(), packet->size());
+    uint16_t seq_num = parse_rtp_sequence_number(view);
 
-    // rtp加密，packet.capacity()可能会比len大
-    if (!protect_rtp(data, len, packet.capacity(), &len)) {
+    if (!protect_rtp(data, len, packet->capacity(), &len)) {
         RTC_LOG(LS_WARNING) << "Failed to protect rtp packet, size=" << len
             << ", seqnum=" << seq_num
-            << ", ssrc=" << parse_rtp_ssrc(packet)
+            << ", ssrc=" << parse_rtp_ssrc(view)
             << ", last_send_seq_num=" << last_send_seq_num_;
         return -1;
     }
     
     last_send_seq_num_ = seq_num;
 
-    packet.SetSize(len);
-    return rtp_dtls_transport_->send_packet((const char*)packet.cdata(), packet.size());
+    packet->set_size(len);
+    return rtp_dtls_transport_->send_packet((const char*)packet->data(), packet->size());
 }
 
 int DtlsSrtpTransport::send_rtcp(const char* buf, size_t size) {
@@ -220,14 +228,16 @@ int DtlsSrtpTransport::send_rtcp(const char* buf, size_t size) {
         return -1;
     }
 
-    int rtcp_auth_tag_len = 0;
-    get_send_auth_tag_len(&rtcp_auth_tag_len, nullptr);
-    // size + rtcp_auth_tag_len + sizeof(uint32_t)：加密后的容量
-    rtc::CopyOnWriteBuffer packet(buf, size, size + rtcp_auth_tag_len + sizeof(uint32_t)); 
+    // 加密后追加认证tag和SRTCP index，缓冲区的tailroom足够容纳
+    PacketBufferPtr packet = PacketBufferPool::current()->alloc(buf, size);
+    if (!packet) {
+        RTC_LOG(LS_WARNING) << "Failed to send rtcp packet: packet too large, size=" << size;
+        return -1;
+    }
 
-    char* data = (char*)packet.data();
-    int len = packet.size();
-    if (!protect_rtcp(data, len, packet.capacity(), &len)) {
+    char* data = (char*)packet->data();
+    int len = packet->size();
+    if (!protect_rtcp(data, len, packet->capacity(), &len)) {
         int type = 0;
         get_rtcp_type(data, len, &type);
         RTC_LOG(LS_WARNING) << "Failed to protect rtcp packet, size=" << len
@@ -235,8 +245,8 @@ int DtlsSrtpTransport::send_rtcp(const char* buf, size_t size) {
         return -1;
     }
     
-    packet.SetSize(len);
-    return rtp_dtls_transport_->send_packet((const char*)packet.cdata(), packet.size());
+    packet->set_size(len);
+    return rtp_dtls_transport_->send_packet((const char*)packet->data(), packet->size());
 }
 
 } // end namespace xrtc
@@ -12,6 +12,7 @@
 #include <rtc_base/buffer.h>
 #include <rtc_base/copy_on_write_buffer.h>
 
+#include "base/packet_buffer.h"
 #include "pc/srtp_transport.h"
 
 namespace xrtc {
@@ -29,8 +30,8 @@ public:
     int send_rtp(const char* buf, size_t size);
     int send_rtcp(const char* buf, size_t size);
 
-    sigslot::signal3<DtlsSrtpTransport*, rtc::CopyOnWriteBuffer*, int64_t> signal_rtp_packet_received;
-    sigslot::signal3<DtlsSrtpTransport*, rtc::CopyOnWriteBuffer*, int64_t> signal_rtcp_packet_received;
+    sigslot::signal3<DtlsSrtpTransport*, PacketBuffer*, int64_t> signal_rtp_packet_received;
+    sigslot::signal3<DtlsSrtpTransport*, PacketBuffer*, int64_t> signal_rtcp_packet_received;
 
 private:
     bool _extract_params(DtlsTransport* dtls_transport,
@@ -41,8 +42,8 @@ private:
     void _setup_dtls_srtp();
     void _on_dtls_state(DtlsTransport* dtls, DtlsTransportState state);
     void _on_read_packet(DtlsTransport* dtls, const char* data, size_t len, int64_t ts);
-    void _on_rtp_packet_received(rtc::CopyOnWriteBuffer packet, int64_t ts);
-    void _on_rtcp_packet_received(rtc::CopyOnWriteBuffer packet, int64_t ts);
+    void _on_rtp_packet_received(PacketBufferPtr packet, int64_t ts);
+    void _on_rtcp_packet_received(PacketBufferPtr packet, int64_t ts);
 
 private:
     std::string transport_name_;
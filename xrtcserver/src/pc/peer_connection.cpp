@@ -1,5 +1,9 @@
+#include <algorithm>
+
 #include <rtc_base/logging.h>
 #include <absl/algorithm/container.h>
+#include <absl/strings/match.h>
+#include <absl/strings/string_view.h>
 #include <rtc_base/helpers.h>
 #include <api/task_queue/default_task_queue_factory.h>
 
@@ -12,6 +16,17 @@
 
 namespace xrtc {
 
+// pacing速率是带宽估计的2.5倍，和webrtc一致，只平滑突发，不长期积压
+const int k_pacing_factor_percent = 250;
+const int k_min_pacing_bitrate_kbps = 100;
+// 队列中的平均排队时间超过该值时提高发送速率排空队列
+const int k_pacing_queue_time_limit_ms = 500;
+// RR中的丢包率(Q8)，2%和10%
+const uint8_t k_low_loss_threshold = 5;
+const uint8_t k_high_loss_threshold = 26;
+// 速率增加的最小间隔，RR的周期比这短时避免每个RR都上调8%
+const int64_t k_pacing_increase_interval_ms = 1000;
+
 namespace {
 
 struct SsrcInfo {
@@ -66,38 +81,82 @@ PeerConnection::~PeerConnection() {
         audio_recv_stream_ = nullptr;
     }
 
+    // 队列中的包发送时会回调到PeerConnection，先于其它成员释放
+    pacer_.reset();
+
+    if (video_send_stream_) {
+        delete video_send_stream_;
+        video_send_stream_ = nullptr;
+    }
+
+    if (audio_send_stream_) {
+        delete audio_send_stream_;
+        audio_send_stream_ = nullptr;
+    }
+
     RTC_LOG(LS_INFO) << "PeerConnection destroy";   
 }
 
 void PeerConnection::_on_rtp_packet_received(TransportController*,
-        rtc::CopyOnWriteBuffer* packet, int64_t ts)
+        PacketBuffer* packet, int64_t ts)
 {
-    signal_rtp_packet_received(this, packet, ts);
+    // 收到包时解析一次，分发、接收统计、NACK和转发都使用这个视图
+    RtpPacketView rtp_packet;
+    if (!rtp_packet.Parse(packet->data(), packet->size())) {
+        return;
+    }
+
+    // 转发和接收模块都按推流者协商的扩展id解析
+    uint32_t ssrc = rtp_packet.ssrc();
+    if (remote_audio_ssrc_ == ssrc && audio_recv_stream_) {
+        rtp_packet.set_extension_map(&audio_recv_stream_->extensions());
+    } else if ((remote_video_ssrc_ == ssrc || remote_video_rtx_ssrc_ == ssrc)
+            && video_recv_stream_)
+    {
+        rtp_packet.set_extension_map(&video_recv_stream_->extensions());
+    }
 
-    RtpPacket rtp_packet;
-    bool success = rtp_packet.Parse((const uint8_t*)packet->data(), packet->size());
-    if (!success) return;
+    signal_rtp_packet_received(this, packet, rtp_packet, ts);
 
-    if (remote_audio_ssrc_ == rtp_packet.ssrc() ) {
+    if (remote_audio_ssrc_ == ssrc) {
         if (audio_recv_stream_) {
-            audio_recv_stream_->DeliverRtp((const uint8_t*)packet->data(), packet->size());
+            audio_recv_stream_->DeliverRtp(rtp_packet);
         }
-    } else if(remote_video_ssrc_ == rtp_packet.ssrc() || remote_video_rtx_ssrc_ == rtp_packet.ssrc() ) {
+    } else if (remote_video_ssrc_ == ssrc || remote_video_rtx_ssrc_ == ssrc) {
         if (video_recv_stream_) {
-            video_recv_stream_->DeliverRtp((const uint8_t*)packet->data(), packet->size());
+            video_recv_stream_->DeliverRtp(rtp_packet);
         }
     }
 }
 
 void PeerConnection::_on_rtcp_packet_received(TransportController*,
-        rtc::CopyOnWriteBuffer* packet, int64_t ts)
+        PacketBuffer* packet, int64_t ts)
 {
     signal_rtcp_packet_received(this, packet, ts);
 
+    // 复合包中可能同时有音频和视频的报告，每个模块只处理自己ssrc的部分
+    const uint8_t* data = (const uint8_t*)packet->data();
+    size_t len = packet->size();
     if (video_recv_stream_) {
-        video_recv_stream_->DeliverRtcp((const uint8_t*)packet->data(), packet->size());
-    } else if (audio_recv_stream_) {
-        audio_recv_stream_->DeliverRtcp((const uint8_t*)packet->data(), packet->size());
+        video_recv_stream_->DeliverRtcp(data, len);
+    }
+    if (audio_recv_stream_) {
+        audio_recv_stream_->DeliverRtcp(data, len);
+    }
+    if (video_send_stream_) {
+        video_send_stream_->DeliverRtcp(data, len);
+    }
+    if (audio_send_stream_) {
+        audio_send_stream_->DeliverRtcp(data, len);
+    }
+}
+
+void PeerConnection::on_remote_sender_report(uint32_t ssrc, uint32_t rtp_timestamp) {
+    if (video_send_stream_) {
+        video_send_stream_->OnRemoteSenderReport(ssrc, rtp_timestamp);
+    }
+    if (audio_send_stream_) {
+        audio_send_stream_->OnRemoteSenderReport(ssrc, rtp_timestamp);
     }
 }
 
@@ -157,6 +216,10 @@ std::string PeerConnection::create_answer(const RTCOfferAnswerOptions& options)
             for (auto stream : audio_source_) {
                 audio->add_stream(stream);
             }    
+
+            if (options.send_rtcp_report) {
+                _create_audio_send_stream();
+            }
         }
 
     }
@@ -172,6 +235,10 @@ std::string PeerConnection::create_answer(const RTCOfferAnswerOptions& options)
             for (auto stream : video_source_) {
                 video->add_stream(stream);
             }   
+
+            if (options.send_rtcp_report) {
+                _create_video_send_stream();
+            }
         }
     }
 
@@ -196,87 +263,104 @@ std::string PeerConnection::create_answer(const RTCOfferAnswerOptions& options)
     return local_desc_->to_string(options.dtls_on);
 }
 
-// 从 a=ice-ufrag:w/W3\r\n 里面取出w/W3
-static std::string get_attribute(const std::string& line)
-{
-    std::vector<std::string> fields;
-    size_t size = rtc::tokenize(line, ':', &fields);
-    if (size != 2) {
-        RTC_LOG(LS_WARNING) << "get attribute error: " << line;
-        return "";
+// 解析十进制的uint32，不允许有其它字符
+static bool parse_uint32(absl::string_view str, uint32_t* value) {
+    if (str.empty() || str.size() > 10) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (char c : str) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+
+    if (result > 0xFFFFFFFFu) {
+        return false;
     }
 
-    return fields[1];
+    *value = (uint32_t)result;
+    return true;
 }
 
-static int parse_transport_info(TransportDescription* td, const std::string& line) 
+// 以delimiter把str分成两部分，连续的delimiter当作一个
+static bool split_first(absl::string_view str, char delimiter,
+        absl::string_view* left, absl::string_view* right)
 {
-    // a=ice-ufrag:w/W3\r\n
-    if (line.find("a=ice-ufrag") != std::string::npos) {
-        td->ice_ufrag = get_attribute(line);
-        if (td->ice_ufrag.empty()) {
-            return -1;
-        }
+    size_t pos = str.find(delimiter);
+    if (pos == absl::string_view::npos) {
+        return false;
+    }
 
-    // a=ice-pwd:l8PkVNNDw9depfNOxAzZHUzT\r\n     
-    } else if (line.find("a=ice-pwd") != std::string::npos) {
-        td->ice_pwd = get_attribute(line);
-        if (td->ice_pwd.empty()) {
-            return -1;
-        }
+    *left = str.substr(0, pos);
+    size_t next = str.find_first_not_of(delimiter, pos);
+    *right = next == absl::string_view::npos ? absl::string_view() : str.substr(next);
+    return true;
+}
 
-    // a=fingerprint:sha-256 A0:C5:56:20:92:76:F7:3E:5D:E7:80:CA:F3:69:51:53:24:3A:CA:16:89:7E:2D:E0:EA:D3:1B:92:7C:D0:EF:B6\r\n
-    } else if (line.find("a=fingerprint") != std::string::npos) {
-        std::vector<std::string> items;
-        rtc::tokenize(line, ' ', &items);
-        if (items.size() != 2) {
-            RTC_LOG(LS_WARNING) << "parse a=fingerprint error: " << line;
-            return -1;
-        }
+// a=ice-ufrag:w/W3 中的value: w/W3，不能为空也不能再包含':'
+static bool get_attribute_value(absl::string_view line, absl::string_view value,
+        std::string* result)
+{
+    if (value.empty() || value.find(':') != absl::string_view::npos) {
+        RTC_LOG(LS_WARNING) << "get attribute error: " << std::string(line);
+        return false;
+    }
 
-         // 字符串a=fingerprint: 是14字节，还需注意大小写转换
-        std::string alg = items[0].substr(14);
-        absl::c_transform(alg, alg.begin(), ::tolower);
-        std::string content = items[1];
+    result->assign(value.data(), value.size());
+    return true;
+}
 
-        td->identity_fingerprint = rtc::SSLFingerprint::CreateUniqueFromRfc4572(
-                alg, content);
-        if (!(td->identity_fingerprint.get())) {
-            RTC_LOG(LS_WARNING) << "create fingerprint error: " << line;
-            return -1;
-        }            
+// a=fingerprint:sha-256 A0:C5:56:20:92:76:F7:3E:5D:E7:80:CA:F3:69:51:53:24:3A:CA:16:89:7E:2D:E0:EA:D3:1B:92:7C:D0:EF:B6
+static int parse_fingerprint(TransportDescription* td, absl::string_view line,
+        absl::string_view value)
+{
+    absl::string_view alg_view, content;
+    if (!split_first(value, ' ', &alg_view, &content) || alg_view.empty() || content.empty()
+            || content.find(' ') != absl::string_view::npos)
+    {
+        RTC_LOG(LS_WARNING) << "parse a=fingerprint error: " << std::string(line);
+        return -1;
+    }
 
+    // 算法名需要转成小写
+    std::string alg(alg_view.data(), alg_view.size());
+    absl::c_transform(alg, alg.begin(), ::tolower);
+
+    td->identity_fingerprint = rtc::SSLFingerprint::CreateUniqueFromRfc4572(
+            alg, std::string(content.data(), content.size()));
+    if (!(td->identity_fingerprint.get())) {
+        RTC_LOG(LS_WARNING) << "create fingerprint error: " << std::string(line);
+        return -1;
     }
+
     return 0;
 }
 
-static int parse_ssrc_info(std::vector<SsrcInfo>& ssrc_info, const std::string& line) {
-    if (line.find("a=ssrc:") == std::string::npos) {
-        return 0;
-    }
-
-    // rfc5576
-    // a=ssrc:<ssrc-id> <attribute>
-    // a=ssrc:<ssrc-id> <attribute>:<value>
-    std::string field1, field2;
-    if (!rtc::tokenize_first(line.substr(2), ' ', &field1, &field2)) {
-        RTC_LOG(LS_WARNING) << "parse a=ssrc failed, line: " << line;
+// rfc5576
+// a=ssrc:<ssrc-id> <attribute>
+// a=ssrc:<ssrc-id> <attribute>:<value>
+static int parse_ssrc_info(std::vector<SsrcInfo>& ssrc_info, absl::string_view line,
+        absl::string_view value)
+{
+    absl::string_view ssrc_id_s, field2;
+    if (!split_first(value, ' ', &ssrc_id_s, &field2) || field2.empty()) {
+        RTC_LOG(LS_WARNING) << "parse a=ssrc failed, line: " << std::string(line);
         return -1;
     }
 
-    // ssrc:<ssrc-id>
-    std::string ssrc_id_s = field1.substr(5);
     uint32_t ssrc_id = 0;
-    if (!rtc::FromString(ssrc_id_s, &ssrc_id)) {
-        RTC_LOG(LS_WARNING) << "invalid ssrc_id, line: " << line;
+    if (!parse_uint32(ssrc_id_s, &ssrc_id)) {
+        RTC_LOG(LS_WARNING) << "invalid ssrc_id, line: " << std::string(line);
         return -1;
     }
 
-    // <attribute>
-    std::string attribute;
-    std::string value;
-    if (!rtc::tokenize_first(field2, ':', &attribute, &value)) {
-        RTC_LOG(LS_WARNING) << "get ssrc attribute failed, line: " << line;
+    // <attribute>:<value>
+    absl::string_view attribute, attr_value;
+    if (!split_first(field2, ':', &attribute, &attr_value)) {
+        RTC_LOG(LS_WARNING) << "get ssrc attribute failed, line: " << std::string(line);
         return -1;
     }
 
@@ -298,53 +382,61 @@ static int parse_ssrc_info(std::vector<SsrcInfo>& ssrc_info, const std::string&
 
     // a=ssrc:3038623782 cname:9UkMttm/AKBk/3gN
     if ("cname" == attribute) {
-        iter->cname = value;
+        iter->cname.assign(attr_value.data(), attr_value.size());
 
     // a=ssrc:3038623782 msid:Z0HUtsuZwWwocPvLkt8PANm3axsdHekKKIXA 19a75650-d2ad-45d8-b7f4-53398701f7de
     } else if ("msid" == attribute) {
-        std::vector<std::string> fields;
-        rtc::split(value, ' ', &fields);
-        if (fields.size() < 1 || fields.size() > 2) {
-            RTC_LOG(LS_WARNING) << "msid format error, line: " << line;
-            return -1;
+        size_t pos = attr_value.find(' ');
+        absl::string_view stream_id = attr_value.substr(0, pos);
+        absl::string_view track_id;
+        if (pos != absl::string_view::npos) {
+            track_id = attr_value.substr(pos + 1);
+            if (track_id.find(' ') != absl::string_view::npos) {
+                RTC_LOG(LS_WARNING) << "msid format error, line: " << std::string(line);
+                return -1;
+            }
         }
 
-        iter->stream_id = fields[0];
-        if (fields.size() == 2) {
-            iter->track_id = fields[1];
+        iter->stream_id.assign(stream_id.data(), stream_id.size());
+        if (pos != absl::string_view::npos) {
+            iter->track_id.assign(track_id.data(), track_id.size());
         }
     }
 
     return 0;
 }
 
-// 解析 a=ssrc-group:FID 3038623782 2405544162
-static int parse_ssrc_group_info(std::vector<SsrcGroup>& ssrc_groups, const std::string& line) {
-    if (line.find("a=ssrc-group:") == std::string::npos) {
-        return 0;
-    }  
-
-    // rfc5576
-    // a=ssrc-group:<semantics> <ssrc-id> ...
-    std::vector<std::string> fields;
-    rtc::split(line.substr(2), ' ', &fields);
-    if (fields.size() < 2) {
-        RTC_LOG(LS_WARNING) << "ssrc-group field size < 2, line: " << line;
+// rfc5576
+// a=ssrc-group:<semantics> <ssrc-id> ...
+// a=ssrc-group:FID 3038623782 2405544162
+static int parse_ssrc_group_info(std::vector<SsrcGroup>& ssrc_groups, absl::string_view line,
+        absl::string_view value)
+{
+    size_t pos = value.find(' ');
+    if (pos == absl::string_view::npos) {
+        RTC_LOG(LS_WARNING) << "ssrc-group field size < 2, line: " << std::string(line);
         return -1;
     }
 
-    std::string semantics = get_attribute(fields[0]);
-    if (semantics.empty()) {
+    std::string semantics;
+    if (!get_attribute_value(line, value.substr(0, pos), &semantics)) {
         return -1;
     }
 
     std::vector<uint32_t> ssrcs;
-    for (size_t i = 1; i < fields.size(); ++i) {
+    absl::string_view rest = value.substr(pos + 1);
+    while (true) {
+        pos = rest.find(' ');
         uint32_t ssrc_id = 0;
-        if (!rtc::FromString(fields[i], &ssrc_id)) {
+        if (!parse_uint32(rest.substr(0, pos), &ssrc_id)) {
             return -1;
         }
         ssrcs.push_back(ssrc_id);
+
+        if (pos == absl::string_view::npos) {
+            break;
+        }
+        rest = rest.substr(pos + 1);
     }
 
     ssrc_groups.push_back(SsrcGroup(semantics, ssrcs));
@@ -352,67 +444,141 @@ static int parse_ssrc_group_info(std::vector<SsrcGroup>& ssrc_groups, const std:
     return 0;    
 }
 
-// 暂时采用比较粗暴的做法
-// a=fmtp:100 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f
-static int parse_fmtp_info(int &h264_codec_id, const std::string& line) {
-    if (h264_codec_id != 0) {
-        return 0;
+// 取出 a=fmtp:100 xxx 或者 a=rtpmap:101 xxx 中的payload type
+static int parse_payload_type(absl::string_view line, absl::string_view value) {
+    size_t pos = value.find(' ');
+    if (pos == absl::string_view::npos || 0 == pos) {
+        RTC_LOG(LS_WARNING) << "rtpmap field size < 2, line: " << std::string(line);
+        return -1;
     }
 
-    if (line.find("42e01f") == std::string::npos) {
-        return 0;
+    uint32_t codec_id = 0;
+    if (!parse_uint32(value.substr(0, pos), &codec_id)) {
+        RTC_LOG(LS_WARNING) << "invalid payload type, line: " << std::string(line);
+        return -1;
     }
 
-    if (line.find("level-asymmetry-allowed=1") == std::string::npos) {
-        return 0;
-    }  
+    return codec_id;
+}
 
-    if (line.find("packetization-mode=1") == std::string::npos) {
+// 暂时采用比较粗暴的做法
+// a=fmtp:100 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f
+static int parse_fmtp_info(int &h264_codec_id, absl::string_view line, absl::string_view value) {
+    if (h264_codec_id != 0) {
         return 0;
-    }    
+    }
 
-    std::vector<std::string> fields;
-    rtc::split(line.substr(2), ' ', &fields);
-    if (fields.size() < 2) {
-        RTC_LOG(LS_WARNING) << "rtpmap field size < 2, line: " << line;
-        return -1;
+    if (value.find("42e01f") == absl::string_view::npos
+            || value.find("level-asymmetry-allowed=1") == absl::string_view::npos
+            || value.find("packetization-mode=1") == absl::string_view::npos)
+    {
+        return 0;
     }
 
-    std::string code_id = get_attribute(fields[0]);
-    if (code_id.empty()) {
+    int codec_id = parse_payload_type(line, value);
+    if (codec_id < 0) {
         return -1;
     }
 
-    h264_codec_id = atoi(code_id.c_str());
+    h264_codec_id = codec_id;
     RTC_LOG(LS_INFO) << "fmtp h264 code id: " << h264_codec_id;
 
     return 0;
 }
 
 // a=rtpmap:101 rtx/90000
-static int parse_rtpmap_info(int &rtx_codec_id, const std::string& line) {
+static int parse_rtpmap_info(int &rtx_codec_id, absl::string_view line, absl::string_view value) {
     if (rtx_codec_id != 0) {
         return 0;
     }
 
-    if (line.find("rtx/90000") == std::string::npos) {
+    if (value.find("rtx/90000") == absl::string_view::npos) {
         return 0;
-    }  
+    }
 
-    std::vector<std::string> fields;
-    rtc::split(line.substr(2), ' ', &fields);
-    if (fields.size() < 2) {
-        RTC_LOG(LS_WARNING) << "rtpmap field size < 2, line: " << line;
+    int codec_id = parse_payload_type(line, value);
+    if (codec_id < 0) {
         return -1;
     }
 
-    std::string code_id = get_attribute(fields[0]);
-    if (code_id.empty()) {
+    rtx_codec_id = codec_id;
+    RTC_LOG(LS_INFO) << "rtpmap rtx code id: " << rtx_codec_id;
+
+    return 0;
+}
+
+// rfc8285
+// a=extmap:<value>["/"<direction>] <URI> <extensionattributes>
+static int parse_extmap(RtpHeaderExtensionMap* extensions, absl::string_view line,
+        absl::string_view value)
+{
+    absl::string_view id_view, uri;
+    uint32_t id = 0;
+    if (!split_first(value, ' ', &id_view, &uri) || uri.empty()
+            || !parse_uint32(id_view.substr(0, id_view.find('/')), &id))
+    {
+        RTC_LOG(LS_WARNING) << "parse a=extmap error: " << std::string(line);
         return -1;
     }
 
-    rtx_codec_id = atoi(code_id.c_str());
-    RTC_LOG(LS_INFO) << "rtpmap rtx code id: " << rtx_codec_id;
+    // 不认识的扩展不影响会话，只是查不到
+    extensions->RegisterByUri(id, uri.substr(0, uri.find(' ')));
+    return 0;
+}
+
+// 一个m=段中和会话相关的属性
+struct MediaSectionInfo {
+    TransportDescription* td;
+    std::vector<SsrcInfo>* ssrc_info;
+    std::vector<SsrcGroup>* ssrc_groups;
+    RtpHeaderExtensionMap* extensions;
+};
+
+// 解析m=段中的一行a=属性，name是':'之前的部分，value是':'之后的部分
+static int parse_media_attribute(const MediaSectionInfo& section, int* h264_codec_id,
+        int* rtx_codec_id, absl::string_view line, absl::string_view name,
+        absl::string_view value)
+{
+    switch (name[0]) {
+        case 'i':
+            // a=ice-ufrag:w/W3
+            if ("ice-ufrag" == name) {
+                return get_attribute_value(line, value, &section.td->ice_ufrag) ? 0 : -1;
+            }
+            // a=ice-pwd:l8PkVNNDw9depfNOxAzZHUzT
+            if ("ice-pwd" == name) {
+                return get_attribute_value(line, value, &section.td->ice_pwd) ? 0 : -1;
+            }
+            break;
+        case 'e':
+            if ("extmap" == name) {
+                return parse_extmap(section.extensions, line, value);
+            }
+            break;
+        case 'f':
+            if ("fingerprint" == name) {
+                return parse_fingerprint(section.td, line, value);
+            }
+            if (h264_codec_id && "fmtp" == name) {
+                return parse_fmtp_info(*h264_codec_id, line, value);
+            }
+            break;
+        case 's':
+            if ("ssrc" == name) {
+                return parse_ssrc_info(*section.ssrc_info, line, value);
+            }
+            if (section.ssrc_groups && "ssrc-group" == name) {
+                return parse_ssrc_group_info(*section.ssrc_groups, line, value);
+            }
+            break;
+        case 'r':
+            if (h264_codec_id && *h264_codec_id != 0 && "rtpmap" == name) {
+                return parse_rtpmap_info(*rtx_codec_id, line, value);
+            }
+            break;
+        default:
+            break;
+    }
 
     return 0;
 }
@@ -444,21 +610,13 @@ static void create_track_from_ssrc_info(const std::vector<SsrcInfo>& ssrc_infos,
 }
 
 int PeerConnection::set_remote_sdp(const std::string& sdp) {
-    std::vector<std::string> fields;
-    size_t size = rtc::tokenize(sdp, '\n', &fields);
-    if (size <= 0) {
+    if (sdp.find_first_not_of('\n') == std::string::npos) {
         RTC_LOG(LS_WARNING) << "remote sdp invalid";
         return -1;
     }
 
-    bool is_rn = false;
-    if (sdp.find("\r\n") != std::string::npos) {
-        is_rn = true;
-    }
-
     remote_desc_ = std::make_unique<SessionDescription>(SdpType::k_offer);
 
-    std::string media_type;
     std::shared_ptr<AudioContentDescription> audio_content;
     std::shared_ptr<VideoContentDescription> video_content;
     auto audio_td = std::make_shared<TransportDescription>();
@@ -470,72 +628,88 @@ int PeerConnection::set_remote_sdp(const std::string& sdp) {
     std::vector<StreamParams> audio_tracks;
     std::vector<StreamParams> video_tracks;
 
-    for (auto field : fields) {
-        if (is_rn) {
-            field = field.substr(0, field.length() - 1);
+    MediaSectionInfo audio_section = { audio_td.get(), &audio_ssrc_info, nullptr,
+        &audio_extensions_ };
+    MediaSectionInfo video_section = { video_td.get(), &video_ssrc_info, &video_ssrc_groups,
+        &video_extensions_ };
+    // 当前所在的m=段，nullptr表示会话级或者不关心的媒体类型
+    const MediaSectionInfo* section = nullptr;
+    bool is_video = false;
+
+    // 只遍历一次，每一行都是原始sdp上的string_view，不拷贝
+    absl::string_view rest(sdp);
+    while (!rest.empty()) {
+        size_t pos = rest.find('\n');
+        absl::string_view line = rest.substr(0, pos);
+        rest = pos == absl::string_view::npos ? absl::string_view() : rest.substr(pos + 1);
+
+        if (!line.empty() && '\r' == line.back()) {
+            line.remove_suffix(1);
+        }
+
+        if (line.size() < 2 || line[1] != '=') {
+            continue;
         }
 
-        if (field.find("m=group:BUNDLE") != std::string::npos) {
-            std::vector<std::string> items;
-            rtc::split(field, ' ', &items);
-            if (items.size() > 1) {
+        if ('m' == line[0]) {
+            if (absl::StartsWith(line, "m=group:BUNDLE")) {
+                absl::string_view items = line;
                 ContentGroup answer_bundle("BUNDLE");
-                for (size_t i = 1; i < items.size(); ++i) {
-                    answer_bundle.add_content_name(items[i]);
+                while ((pos = items.find(' ')) != absl::string_view::npos) {
+                    items = items.substr(pos + 1);
+                    absl::string_view name = items.substr(0, items.find(' '));
+                    answer_bundle.add_content_name(std::string(name.data(), name.size()));
                 }
-                remote_desc_->add_group(answer_bundle);
+
+                if (!answer_bundle.content_names().empty()) {
+                    remote_desc_->add_group(answer_bundle);
+                }
+                continue;
             }
-        } else if (field.find("m=") != std::string::npos) {
-            std::vector<std::string> items;
-            rtc::split(field, ' ', &items);
-            if (items.size() <= 2) {
-                RTC_LOG(LS_WARNING) << "parse m= error: " << field;
+
+            // m=<media> <port> <proto> <fmt> ...
+            absl::string_view media_type, fields;
+            if (!split_first(line.substr(2), ' ', &media_type, &fields)
+                    || fields.find(' ') == absl::string_view::npos)
+            {
+                RTC_LOG(LS_WARNING) << "parse m= error: " << std::string(line);
                 return -1;
             }
 
             // m=audio/video
-            media_type = items[0].substr(2);
+            section = nullptr;
+            is_video = false;
             if ("audio" == media_type) {
                 audio_td->mid = "audio";
                 exist_push_audio_source_ = true;
-            } else if ("video" == media_type){    
+                section = &audio_section;
+            } else if ("video" == media_type) {
                 video_td->mid = "video";
                 exist_push_video_source_ = true;
-            }    
-        }
-
-        if ("audio" == media_type) {
-            if (parse_transport_info(audio_td.get(), field) != 0) {
-                return -1;
-            }
-
-            if (parse_ssrc_info(audio_ssrc_info, field) != 0) {
-                return -1;
+                section = &video_section;
+                is_video = true;
             }
 
-        } else if ("video" == media_type) {
-            if (parse_transport_info(video_td.get(), field) != 0) {
-                return -1;
-            }
+            continue;
+        }
 
-            if (parse_ssrc_info(video_ssrc_info, field) != 0) {
-                return -1;
-            }      
+        if (!section || line[0] != 'a') {
+            continue;
+        }
 
-            if (parse_ssrc_group_info(video_ssrc_groups, field) != 0) {
-                return -1;
-            }
+        // a=<name>:<value>
+        absl::string_view attr = line.substr(2);
+        pos = attr.find(':');
+        if (pos == absl::string_view::npos || 0 == pos) {
+            continue;
+        }
 
-            if (parse_fmtp_info(h264_codec_id_, field) != 0) {
-                return -1;
-            }
-            if (h264_codec_id_ != 0) {
-                if (parse_rtpmap_info(rtx_codec_id_, field) != 0) {
-                    return -1;
-                }      
-            }        
+        if (parse_media_attribute(*section, is_video ? &h264_codec_id_ : nullptr,
+                    &rtx_codec_id_, line, attr.substr(0, pos), attr.substr(pos + 1)) != 0)
+        {
+            return -1;
         }
-    } 
+    }
 
     if (exist_push_audio_source_) {
         audio_content = std::make_shared<AudioContentDescription>();
@@ -621,11 +795,126 @@ void PeerConnection::destroy() {
         destroy_timer_ = nullptr;
     }
 
-    destroy_timer_ = el_->create_timer(destroy_timer_cb, this, false);
+    destroy_timer_ = el_->create_wheel_timer(destroy_timer_cb, this, false);
     el_->start_timer(destroy_timer_, 10000); // 10ms
 }
 
-int PeerConnection::send_rtp(const char* data, size_t len) {
+bool PeerConnection::can_migrate() {
+    return state_ == PeerConnectionState::k_connected && !destroy_timer_
+        && transport_controller_->can_migrate();
+}
+
+void PeerConnection::detach_event_loop() {
+    // pacer在传输迁移之前把队列发送完
+    if (pacer_) {
+        pacer_->DetachEventLoop();
+    }
+
+    transport_controller_->detach_event_loop();
+
+    if (audio_recv_stream_) {
+        audio_recv_stream_->DetachEventLoop();
+    }
+
+    if (video_recv_stream_) {
+        video_recv_stream_->DetachEventLoop();
+    }
+
+    if (audio_send_stream_) {
+        audio_send_stream_->DetachEventLoop();
+    }
+
+    if (video_send_stream_) {
+        video_send_stream_->DetachEventLoop();
+    }
+}
+
+void PeerConnection::attach_event_loop(EventLoop* el, PortAllocator* allocator) {
+    el_ = el;
+    transport_controller_->attach_event_loop(el, allocator);
+
+    if (audio_recv_stream_) {
+        audio_recv_stream_->AttachEventLoop(el);
+    }
+
+    if (video_recv_stream_) {
+        video_recv_stream_->AttachEventLoop(el);
+    }
+
+    if (audio_send_stream_) {
+        audio_send_stream_->AttachEventLoop(el);
+    }
+
+    if (video_send_stream_) {
+        video_send_stream_->AttachEventLoop(el);
+    }
+
+    if (pacer_) {
+        pacer_->AttachEventLoop();
+    }
+}
+
+int PeerConnection::send_rtp(const char* data, size_t len, bool retransmission) {
+    // 数据不归调用者所有，复制一份到缓冲池
+    PacketBufferPtr packet = PacketBufferPool::current()->alloc(data, len);
+    if (!packet) {
+        return _send_rtp_data(data, len);
+    }
+
+    return send_rtp(packet.get(), retransmission);
+}
+
+int PeerConnection::send_rtp(PacketBuffer* packet, bool retransmission) {
+    // 缓存的关键帧、NACK重传等没有现成视图的包在这里解析
+    RtpPacketView rtp_packet;
+    if (!rtp_packet.Parse(packet->data(), packet->size())) {
+        return _send_rtp_data((const char*)packet->data(), packet->size());
+    }
+
+    return send_rtp(packet, rtp_packet, retransmission);
+}
+
+int PeerConnection::send_rtp(PacketBuffer* packet, const RtpPacketView& rtp_packet,
+        bool retransmission)
+{
+    PacedPacket paced_packet;
+    paced_packet.buffer = packet;
+    paced_packet.ssrc = rtp_packet.ssrc();
+    paced_packet.payload_size = rtp_packet.payload_size() + rtp_packet.padding_size();
+    paced_packet.header_size = rtp_packet.header_size();
+    paced_packet.padding_size = rtp_packet.padding_size();
+    // 音频优先，重传其次，最后是视频
+    if (rtp_packet.ssrc() == send_audio_ssrc_) {
+        paced_packet.type = RtpPacketMediaType::kAudio;
+    } else if (retransmission || (send_video_rtx_ssrc_ && rtp_packet.ssrc() == send_video_rtx_ssrc_)) {
+        paced_packet.type = RtpPacketMediaType::kRetransmission;
+    } else {
+        paced_packet.type = RtpPacketMediaType::kVideo;
+    }
+
+    if (pacer_) {
+        pacer_->EnqueuePacket(std::move(paced_packet));
+        return (int)packet->size();
+    }
+
+    return _send_rtp_packet(paced_packet);
+}
+
+int PeerConnection::_send_rtp_packet(const PacedPacket& packet) {
+    // 发送统计用来生成发给订阅者的SR，每个send stream只统计自己的ssrc
+    RtpPacketCounter counter(packet.header_size, packet.payload_size - packet.padding_size,
+            packet.padding_size);
+    if (video_send_stream_) {
+        video_send_stream_->OnSendingRtpPacket(packet.ssrc, counter);
+    }
+    if (audio_send_stream_) {
+        audio_send_stream_->OnSendingRtpPacket(packet.ssrc, counter);
+    }
+
+    return _send_rtp_data((const char*)packet.buffer->data(), packet.buffer->size());
+}
+
+int PeerConnection::_send_rtp_data(const char* data, size_t len) {
     if (transport_controller_) {
         // todo: 需要根据实际情况完善
         // 因为当前是bundle，视频和音频共用一个通道
@@ -667,6 +956,7 @@ void PeerConnection::_create_audio_receive_stream(AudioContentDescription* audio
             remote_audio_ssrc_ = stream.ssrcs[0];
             config.rtp.local_ssrc = rtc::CreateRandomId(); // 随机32位
             config.rtp.payload_type = audio_payload_type_;
+            config.rtp.extensions = audio_extensions_;
             config.rtp_rtcp_module_observer = this;
 
             if (!audio_recv_stream_) {
@@ -689,6 +979,7 @@ void PeerConnection::_create_video_receive_stream(VideoContentDescription* video
             remote_video_ssrc_ = stream.ssrcs[0];
             config.rtp.local_ssrc = rtc::CreateRandomId(); // 随机32位
             config.rtp.payload_type = video_payload_type_;
+            config.rtp.extensions = video_extensions_;
             config.rtp_rtcp_module_observer = this;
             if (stream.ssrcs.size() > 1) {
                 config.rtp.rtx.ssrc = stream.ssrcs[1];
@@ -704,6 +995,102 @@ void PeerConnection::_create_video_receive_stream(VideoContentDescription* video
     }
 }
 
+// 发送方向第一路流的ssrc，RTX的ssrc来自FID分组
+static bool get_send_ssrc(const std::vector<StreamParams>& source,
+        uint32_t* ssrc, uint32_t* rtx_ssrc)
+{
+    for (auto stream : source) {
+        if (stream.ssrcs.empty()) {
+            return false;
+        }
+
+        *ssrc = stream.ssrcs[0];
+        *rtx_ssrc = 0;
+        for (const SsrcGroup& group : stream.ssrc_groups) {
+            if (group.semantics == "FID" && group.ssrcs.size() >= 2 && group.ssrcs[0] == *ssrc) {
+                *rtx_ssrc = group.ssrcs[1];
+                break;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void PeerConnection::_create_audio_send_stream() {
+    uint32_t ssrc = 0;
+    uint32_t rtx_ssrc = 0;
+    if (audio_send_stream_ || !get_send_ssrc(audio_source_, &ssrc, &rtx_ssrc)) {
+        return;
+    }
+
+    // 转发时不改写ssrc，SR使用推流者的ssrc
+    AudioSendStreamConfig config;
+    config.rtp.ssrc = ssrc;
+    config.rtp.extensions = audio_extensions_;
+    config.rtp_rtcp_module_observer = this;
+    audio_send_stream_ = new AudioSendStream(el_, clock_, config);
+}
+
+void PeerConnection::_create_video_send_stream() {
+    uint32_t ssrc = 0;
+    uint32_t rtx_ssrc = 0;
+    if (video_send_stream_ || !get_send_ssrc(video_source_, &ssrc, &rtx_ssrc)) {
+        return;
+    }
+
+    VideoSendStreamConfig config;
+    config.rtp.ssrc = ssrc;
+    config.rtp.rtx.ssrc = rtx_ssrc;
+    config.rtp.rtx.payload_type = rtx_codec_id_;
+    config.rtp.extensions = video_extensions_;
+    config.rtp_rtcp_module_observer = this;
+    video_send_stream_ = new VideoSendStream(el_, clock_, config);
+}
+
+void PeerConnection::enable_pacing(int start_bitrate_kbps, int max_bitrate_kbps) {
+    if (pacer_) {
+        return;
+    }
+
+    uint32_t ssrc = 0;
+    get_send_ssrc(audio_source_, &send_audio_ssrc_, &ssrc);
+    get_send_ssrc(video_source_, &ssrc, &send_video_rtx_ssrc_);
+
+    pacing_max_bitrate_kbps_ = max_bitrate_kbps;
+    pacing_target_bitrate_kbps_ = std::min(start_bitrate_kbps, max_bitrate_kbps);
+    last_pacing_increase_ms_ = clock_->TimeInMilliseconds();
+    pacer_ = std::make_unique<PacedSender>(clock_, this);
+    pacer_->SetQueueTimeLimit(webrtc::TimeDelta::Millis(k_pacing_queue_time_limit_ms));
+    pacer_->SetPacingBitrate(webrtc::DataRate::KilobitsPerSec(
+            pacing_target_bitrate_kbps_ * k_pacing_factor_percent / 100));
+}
+
+void PeerConnection::_update_pacing_bitrate(uint8_t fraction_lost) {
+    // 和webrtc基于丢包的带宽估计一致：丢包率低于2%时每秒最多增加一次8%，
+    // 高于10%时立即按丢包率降低
+    int bitrate_kbps = pacing_target_bitrate_kbps_;
+    int64_t now_ms = clock_->TimeInMilliseconds();
+    if (fraction_lost < k_low_loss_threshold) {
+        if (now_ms - last_pacing_increase_ms_ < k_pacing_increase_interval_ms) {
+            return;
+        }
+
+        last_pacing_increase_ms_ = now_ms;
+        bitrate_kbps = bitrate_kbps * 108 / 100 + 1;
+    } else if (fraction_lost > k_high_loss_threshold) {
+        bitrate_kbps = bitrate_kbps * (512 - fraction_lost) / 512;
+    }
+
+    bitrate_kbps = std::max(k_min_pacing_bitrate_kbps, std::min(bitrate_kbps, pacing_max_bitrate_kbps_));
+    if (bitrate_kbps != pacing_target_bitrate_kbps_) {
+        pacing_target_bitrate_kbps_ = bitrate_kbps;
+        pacer_->SetPacingBitrate(webrtc::DataRate::KilobitsPerSec(
+                bitrate_kbps * k_pacing_factor_percent / 100));
+    }
+}
+
 void PeerConnection::OnLocalRtcpPacket(webrtc::MediaType /*media_type*/, const uint8_t* data, size_t len) {
     if (state_ != PeerConnectionState::k_connected) {
         return;
@@ -713,8 +1100,11 @@ void PeerConnection::OnLocalRtcpPacket(webrtc::MediaType /*media_type*/, const u
 }
 
 void PeerConnection::OnNetworkInfo(int64_t /*rtt_ms*/, int32_t /*packets_lost*/, 
-    uint8_t /*fraction_lost*/, uint32_t /*jitter*/) 
+    uint8_t fraction_lost, uint32_t /*jitter*/) 
 {
+    if (pacer_) {
+        _update_pacing_bitrate(fraction_lost);
+    }
 }
 
 void PeerConnection::OnNackReceived(webrtc::MediaType /*media_type*/, 
@@ -731,12 +1121,12 @@ std::shared_ptr<RtpPacketToSend> PeerConnection::FindVideoCache(uint16_t /*seq*/
     return nullptr;
 }
 
-void PeerConnection::SendPacket(std::unique_ptr<RtpPacketToSend> packet) {
+void PeerConnection::SendPacket(const PacedPacket& packet) {
     if (state_ != PeerConnectionState::k_connected) {
         return;
     }
 
-    send_rtcp((const char*)packet->data(), packet->size());
+    _send_rtp_packet(packet);
 }
 
 } // namespace xrtc
@@ -19,10 +19,14 @@
 #include "pc/transport_controller.h"
 #include "pc/stream_params.h"
 #include "pc/session_description.h"
-#include "pc/rtp_transport_controller_send.h"
+#include "modules/pacing/paced_sender.h"
 #include "audio/audio_receive_stream.h"
 #include "video/video_receive_stream.h"
+#include "audio/audio_send_stream.h"
+#include "video/video_send_stream.h"
 #include "modules/rtp_rtcp/rtp_rtcp_interface.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+#include "modules/rtp_rtcp/rtp_packet_to_send.h"
 
 namespace xrtc {
 
@@ -39,6 +43,8 @@ struct RTCOfferAnswerOptions {
     bool use_rtp_mux = true;
     bool use_rtcp_mux = true;
     bool dtls_on = true;
+    // 发送方向由服务端按转发的包生成SR，不转发推流者的SR
+    bool send_rtcp_report = false;
 };
 
 class PeerConnection : public sigslot::has_slots<>,
@@ -57,6 +63,9 @@ public:
     SessionDescription* remote_desc() { return remote_desc_.get(); }
     SessionDescription* local_desc() { return local_desc_.get(); }
 
+    // 对端offer中RTX的payload type，没有协商RTX时为0
+    int video_rtx_codec_id() const { return rtx_codec_id_; }
+
     void add_audio_source(const std::vector<StreamParams>& source) {
         audio_source_ = source;
     }
@@ -65,13 +74,32 @@ public:
         video_source_ = source;
     }
 
-    int send_rtp(const char* data, size_t len);
+    // 开启pacing时包先进入发送队列，按订阅者的带宽估计平滑发送
+    int send_rtp(const char* data, size_t len, bool retransmission = false);
+    // 包来自缓冲池时使用，开启pacing时队列只持有packet的引用，不复制数据
+    int send_rtp(PacketBuffer* packet, bool retransmission = false);
+    // 调用者已经解析过的包，发送队列和发送统计直接使用视图中的信息，不再解析
+    int send_rtp(PacketBuffer* packet, const RtpPacketView& rtp_packet,
+            bool retransmission = false);
     int send_rtcp(const char* data, size_t len);
     int send_unencrypted_rtcp(const char* data, size_t len);
 
+    // 转发的ssrc的推流者发送了SR，发给订阅者的SR沿用其中RTP时间戳和时间的对应关系
+    void on_remote_sender_report(uint32_t ssrc, uint32_t rtp_timestamp);
+
+    // 发送方向开启pacing，速率从start_bitrate_kbps开始按订阅者RR的丢包率调整，
+    // 在add_audio_source/add_video_source之后调用
+    void enable_pacing(int start_bitrate_kbps, int max_bitrate_kbps);
+
+    // 迁移到另一个worker，不重新协商，ICE/DTLS/SRTP的状态保持不变
+    bool can_migrate();
+    void detach_event_loop();
+    void attach_event_loop(EventLoop* el, PortAllocator* allocator);
+
     sigslot::signal2<PeerConnection*, PeerConnectionState> signal_connection_state;
-    sigslot::signal3<PeerConnection*, rtc::CopyOnWriteBuffer*, int64_t> signal_rtp_packet_received;
-    sigslot::signal3<PeerConnection*, rtc::CopyOnWriteBuffer*, int64_t> signal_rtcp_packet_received;
+    // 包只解析一次，视图和packet一起向下传递
+    sigslot::signal4<PeerConnection*, PacketBuffer*, const RtpPacketView&, int64_t> signal_rtp_packet_received;
+    sigslot::signal3<PeerConnection*, PacketBuffer*, int64_t> signal_rtcp_packet_received;
 
 private:
     ~PeerConnection();
@@ -81,11 +109,16 @@ private:
             IceCandidateComponent component,
             const std::vector<Candidate>& candidate);
     void _on_connection_state(TransportController* transport_controller, PeerConnectionState state);
-    void _on_rtp_packet_received(TransportController*, rtc::CopyOnWriteBuffer* packet, int64_t ts);
-    void _on_rtcp_packet_received(TransportController*, rtc::CopyOnWriteBuffer* packet, int64_t ts);
+    void _on_rtp_packet_received(TransportController*, PacketBuffer* packet, int64_t ts);
+    void _on_rtcp_packet_received(TransportController*, PacketBuffer* packet, int64_t ts);
 
     void _create_audio_receive_stream(AudioContentDescription* audio_content);
 	void _create_video_receive_stream(VideoContentDescription* video_content);
+    void _create_audio_send_stream();
+    void _create_video_send_stream();
+    int _send_rtp_packet(const PacedPacket& packet);
+    int _send_rtp_data(const char* data, size_t len);
+    void _update_pacing_bitrate(uint8_t fraction_lost);
 
     friend void destroy_timer_cb(EventLoop* el, TimerWatcher* w, void* data);
 
@@ -98,7 +131,7 @@ private:
 	std::shared_ptr<RtpPacketToSend> FindVideoCache(uint16_t seq);
 
 	// PacingController::PacketSender
-	void SendPacket(std::unique_ptr<RtpPacketToSend> packet) override;
+	void SendPacket(const PacedPacket& packet) override;
 
 private:
     EventLoop *el_= nullptr;
@@ -122,6 +155,14 @@ private:
 
     AudioReceiveStream* audio_recv_stream_ = nullptr;
 	VideoReceiveStream* video_recv_stream_ = nullptr;
+    AudioSendStream* audio_send_stream_ = nullptr;
+    VideoSendStream* video_send_stream_ = nullptr;
+    std::unique_ptr<PacedSender> pacer_;
+    uint32_t send_audio_ssrc_ = 0;
+    uint32_t send_video_rtx_ssrc_ = 0;
+    int pacing_target_bitrate_kbps_ = 0;
+    int pacing_max_bitrate_kbps_ = 0;
+    int64_t last_pacing_increase_ms_ = 0;
 	webrtc::Clock* clock_;
     PeerConnectionState state_ = PeerConnectionState::k_new;
 
@@ -129,6 +170,9 @@ private:
     bool exist_push_video_source_ = false;
     int h264_codec_id_ = 0;
     int rtx_codec_id_ = 0;
+    // offer中每个m=段的a=extmap，创建收发流时注册到流的配置中
+    RtpHeaderExtensionMap audio_extensions_;
+    RtpHeaderExtensionMap video_extensions_;
 };
 
 } // namespace xrtc
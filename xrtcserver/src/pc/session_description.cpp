@@ -1,5 +1,4 @@
-
-#include <sstream>
+#include <unordered_map>
 
 #include <rtc_base/logging.h>
 
@@ -10,6 +9,8 @@ namespace xrtc {
 
 const char k_media_protocol_dtls_savpf[] = "UDP/TLS/RTP/SAVPF";
 const char k_meida_protocol_savpf[] = "RTP/SAVPF";
+const size_t k_sdp_reserve_size = 4096;
+const size_t k_max_template_codecs = 6;
 
 AudioContentDescription::AudioContentDescription() {
     auto codec = std::make_shared<AudioCodecInfo>();
@@ -94,65 +95,6 @@ SessionDescription::SessionDescription(SdpType type) :
 SessionDescription::~SessionDescription() {
 }
 
-static void add_fmtp_line(std::shared_ptr<CodecInfo> codec,
-        std::stringstream& ss)
-{
-    if (!codec->codec_param.empty()) {
-        ss << "a=fmtp:" << codec->id << " ";
-        std::string data;
-        for (auto param : codec->codec_param) {
-            data += (";" + param.first + "=" + param.second);
-        }
-        // data = ";key1=value1;key2=value2"
-        data = data.substr(1);
-        ss << data << "\r\n";
-    }
-}
-
-static void add_rtcp_fb_line(std::shared_ptr<CodecInfo> codec,
-        std::stringstream& ss)
-{
-    for (auto param : codec->feedback_param) {
-        ss << "a=rtcp-fb:" << codec->id << " " << param.id();
-        if (!param.param().empty()) {
-            ss << " " << param.param();
-        }
-        ss << "\r\n";
-    }
-}
-
-static void build_rtp_map(std::shared_ptr<MediaContentDescription> content, 
-        std::stringstream& ss) {          
-    for (auto codec : content->get_codecs()) {
-        ss << "a=rtpmap:" << codec->id << " " << codec->name << "/" << codec->samplerate;
-        if (MediaType::MEDIA_TYPE_AUDIO == content->type()) {
-            auto audio_codec = codec->as_audio();
-            ss << "/" << audio_codec->channels;
-        }
-        ss << "\r\n";
-
-        add_rtcp_fb_line(codec, ss);
-        add_fmtp_line(codec, ss);
-    }
-}
-
-static void build_rtp_direction(std::shared_ptr<MediaContentDescription> content, std::stringstream& ss) {
-    switch (content->direction()) {
-        case RtpDirection::k_send_recv:
-            ss << "a=sendrecv\r\n";
-            break;
-        case RtpDirection::k_send_only:
-            ss << "a=sendonly\r\n";
-            break;
-        case RtpDirection::k_recv_only:
-            ss << "a=recvonly\r\n";
-            break;
-        default:
-            ss << "a=inactive\r\n";
-            break;
-    }
-}
-
 void SessionDescription::add_content(std::shared_ptr<MediaContentDescription> content) {
     contents_.push_back(content);
 }
@@ -172,7 +114,7 @@ std::vector<const ContentGroup*> SessionDescription::get_group_by_name(const std
     return content_groups;
 }
 
-static std::string connection_role_to_string(ConnectionRole role) {
+static const char* connection_role_to_string(ConnectionRole role) {
     switch (role) {
         case ConnectionRole::ACTIVE:
             return "active";
@@ -256,142 +198,319 @@ std::string SessionDescription::get_first_bundle_mid() {
     return content_group[0]->content_names()[0];
 }
 
-static void build_candidates(std::shared_ptr<MediaContentDescription> content,
-        std::stringstream& ss)
+static void append_uint(std::string* sdp, uint64_t value) {
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    sdp->append(p, end - p);
+}
+
+static void append_int(std::string* sdp, int value) {
+    if (value < 0) {
+        sdp->push_back('-');
+        append_uint(sdp, -(int64_t)value);
+    } else {
+        append_uint(sdp, value);
+    }
+}
+
+static void add_fmtp_line(const std::shared_ptr<CodecInfo>& codec, std::string* sdp) {
+    if (codec->codec_param.empty()) {
+        return;
+    }
+
+    // a=fmtp:<id> key1=value1;key2=value2
+    sdp->append("a=fmtp:");
+    append_int(sdp, codec->id);
+    sdp->push_back(' ');
+    bool first = true;
+    for (const auto& param : codec->codec_param) {
+        if (!first) {
+            sdp->push_back(';');
+        }
+        first = false;
+        sdp->append(param.first);
+        sdp->push_back('=');
+        sdp->append(param.second);
+    }
+    sdp->append("\r\n");
+}
+
+static void add_rtcp_fb_line(const std::shared_ptr<CodecInfo>& codec, std::string* sdp) {
+    for (auto& param : codec->feedback_param) {
+        sdp->append("a=rtcp-fb:");
+        append_int(sdp, codec->id);
+        sdp->push_back(' ');
+        sdp->append(param.id());
+        std::string fb_param = param.param();
+        if (!fb_param.empty()) {
+            sdp->push_back(' ');
+            sdp->append(fb_param);
+        }
+        sdp->append("\r\n");
+    }
+}
+
+static void build_rtp_map(const std::shared_ptr<MediaContentDescription>& content,
+        std::string* sdp)
+{
+    for (auto& codec : content->get_codecs()) {
+        sdp->append("a=rtpmap:");
+        append_int(sdp, codec->id);
+        sdp->push_back(' ');
+        sdp->append(codec->name);
+        sdp->push_back('/');
+        append_int(sdp, codec->samplerate);
+        if (MediaType::MEDIA_TYPE_AUDIO == content->type()) {
+            sdp->push_back('/');
+            append_int(sdp, codec->as_audio()->channels);
+        }
+        sdp->append("\r\n");
+
+        add_rtcp_fb_line(codec, sdp);
+        add_fmtp_line(codec, sdp);
+    }
+}
+
+static const char* rtp_direction_line(RtpDirection direction) {
+    switch (direction) {
+        case RtpDirection::k_send_recv:
+            return "a=sendrecv\r\n";
+        case RtpDirection::k_send_only:
+            return "a=sendonly\r\n";
+        case RtpDirection::k_recv_only:
+            return "a=recvonly\r\n";
+        default:
+            return "a=inactive\r\n";
+    }
+}
+
+// 一个m=段中只和编解码器、方向等有关的部分，同样配置的会话生成的内容完全一样，
+// 每个线程缓存一份，生成answer时直接拼接
+struct MediaSectionTemplate {
+    // m=和c=行
+    std::string head;
+    // 从a=mid到编解码器的rtpmap/rtcp-fb/fmtp行
+    std::string body;
+};
+
+static void build_media_section_template(const std::shared_ptr<MediaContentDescription>& content,
+        bool dtls_on, MediaSectionTemplate* tpl)
+{
+    // RFC 4566
+    // m=<media> <port> <proto> <fmt>
+    std::string& head = tpl->head;
+    head.clear();
+    head.append("m=");
+    head.append(content->mid());
+    head.append(" 9 ");
+    head.append(dtls_on ? k_media_protocol_dtls_savpf : k_meida_protocol_savpf);
+    for (auto& codec : content->get_codecs()) {
+        head.push_back(' ');
+        append_int(&head, codec->id);
+    }
+    head.append("\r\n");
+    head.append("c=IN IP4 0.0.0.0\r\n");
+
+    std::string& body = tpl->body;
+    body.clear();
+    if (MediaType::MEDIA_TYPE_AUDIO == content->type()) {
+        body.append("a=mid:0\r\n");
+    } else if (MediaType::MEDIA_TYPE_VIDEO == content->type()) {
+        body.append("a=mid:1\r\n");
+    }
+
+    body.append("a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n");
+    body.append(rtp_direction_line(content->direction()));
+    if (content->rtcp_mux()) {
+        body.append("a=rtcp-mux\r\n");
+    }
+    body.append("a=rtcp-rsize\r\n");
+
+    build_rtp_map(content, &body);
+}
+
+// 编解码器的参数只由构造函数决定，所以用媒体类型、方向和payload type组合成key
+static bool media_section_template_key(const std::shared_ptr<MediaContentDescription>& content,
+        bool dtls_on, uint64_t* key)
+{
+    const auto& codecs = content->get_codecs();
+    if (codecs.size() > k_max_template_codecs) {
+        return false;
+    }
+
+    uint64_t k = (uint64_t)content->type();
+    k = (k << 1) | (dtls_on ? 1 : 0);
+    k = (k << 1) | (content->rtcp_mux() ? 1 : 0);
+    k = (k << 2) | ((uint64_t)content->direction() & 0x3);
+    k = (k << 3) | codecs.size();
+    for (auto& codec : codecs) {
+        if (codec->id < 0 || codec->id > 127) {
+            return false;
+        }
+        k = (k << 7) | codec->id;
+    }
+
+    *key = k;
+    return true;
+}
+
+static const MediaSectionTemplate& get_media_section_template(
+        const std::shared_ptr<MediaContentDescription>& content, bool dtls_on)
+{
+    static thread_local std::unordered_map<uint64_t, MediaSectionTemplate> templates;
+    static thread_local MediaSectionTemplate uncached;
+
+    uint64_t key = 0;
+    if (!media_section_template_key(content, dtls_on, &key)) {
+        build_media_section_template(content, dtls_on, &uncached);
+        return uncached;
+    }
+
+    auto iter = templates.find(key);
+    if (iter == templates.end()) {
+        iter = templates.emplace(key, MediaSectionTemplate()).first;
+        build_media_section_template(content, dtls_on, &iter->second);
+    }
+
+    return iter->second;
+}
+
+static void build_candidates(const std::shared_ptr<MediaContentDescription>& content,
+        std::string* sdp)
 {
-    for (auto c : content->candidates()) {
-        ss << "a=candidate:" << c.foundation
-           << " " << c.component
-           << " " << c.protocol
-           << " " << c.priority
-           << " " << c.address.HostAsURIString()
-           << " " << c.port
-           << " typ " << c.type
-           << "\r\n";
+    for (auto& c : content->candidates()) {
+        sdp->append("a=candidate:");
+        sdp->append(c.foundation);
+        sdp->push_back(' ');
+        append_int(sdp, c.component);
+        sdp->push_back(' ');
+        sdp->append(c.protocol);
+        sdp->push_back(' ');
+        append_uint(sdp, c.priority);
+        sdp->push_back(' ');
+        sdp->append(c.address.HostAsURIString());
+        sdp->push_back(' ');
+        append_int(sdp, c.port);
+        sdp->append(" typ ");
+        sdp->append(c.type);
+        sdp->append("\r\n");
     }
 }
 
-static void add_ssrc_line(uint32_t ssrc, const std::string& attribute, 
-            const std::string& value, std::stringstream& ss) {
-    ss << "a=ssrc:" << ssrc << " " << attribute << ":" << value << "\r\n";
+static void add_ssrc_line(uint32_t ssrc, const char* attribute,
+        const std::string& value1, const std::string* value2, std::string* sdp)
+{
+    sdp->append("a=ssrc:");
+    append_uint(sdp, ssrc);
+    sdp->push_back(' ');
+    sdp->append(attribute);
+    sdp->push_back(':');
+    sdp->append(value1);
+    if (value2) {
+        sdp->push_back(' ');
+        sdp->append(*value2);
+    }
+    sdp->append("\r\n");
 }
 
-static void build_ssrc(std::shared_ptr<MediaContentDescription> content, std::stringstream& ss) {
-    for (auto track : content->streams()) {
-        for (auto ssrc_group : track.ssrc_groups) {
+static void build_ssrc(const std::shared_ptr<MediaContentDescription>& content, std::string* sdp) {
+    for (auto& track : content->streams()) {
+        for (auto& ssrc_group : track.ssrc_groups) {
             if (ssrc_group.ssrcs.empty()) {
                 continue;
             }
 
-            ss << "a=ssrc-group:" << ssrc_group.semantics;
+            sdp->append("a=ssrc-group:");
+            sdp->append(ssrc_group.semantics);
             for (auto ssrc : ssrc_group.ssrcs) {
-                ss << " " << ssrc;
+                sdp->push_back(' ');
+                append_uint(sdp, ssrc);
             }
-            ss << "\r\n";
+            sdp->append("\r\n");
         }
 
-        std::string msid = track.stream_id + " " + track.id;
         for (auto ssrc : track.ssrcs) {
-            add_ssrc_line(ssrc, "cname", track.cname, ss);
-            add_ssrc_line(ssrc, "msid", msid, ss);
-            add_ssrc_line(ssrc, "mslabel", track.stream_id, ss);
-            add_ssrc_line(ssrc, "lable", track.id, ss);
+            add_ssrc_line(ssrc, "cname", track.cname, nullptr, sdp);
+            add_ssrc_line(ssrc, "msid", track.stream_id, &track.id, sdp);
+            add_ssrc_line(ssrc, "mslabel", track.stream_id, nullptr, sdp);
+            add_ssrc_line(ssrc, "lable", track.id, nullptr, sdp);
         }
     }
 }
 
 // 当前sdp使用planB方式
 std::string SessionDescription::to_string(bool dtls_on) {
-    std::stringstream ss;
+    std::string sdp;
+    sdp.reserve(k_sdp_reserve_size);
+
     // version
-    ss << "v=0\r\n";
     // session origin
-	// RFC 4566
-	// o=<username> <sess-id> <sess-version> <nettype> <addrtype> <unicast-address>
-	ss << "o=XRTC/1.0 0 2 IN IP4 127.0.0.1\r\n";
-	// session name
-	ss << "s=XrtcPublishSession \r\n";
-	// time description
-	ss << "t=0 0\r\n";
+    // RFC 4566
+    // o=<username> <sess-id> <sess-version> <nettype> <addrtype> <unicast-address>
+    // session name
+    // time description
+    sdp.append("v=0\r\n"
+            "o=XRTC/1.0 0 2 IN IP4 127.0.0.1\r\n"
+            "s=XrtcPublishSession \r\n"
+            "t=0 0\r\n");
 
     //改为ice-lite方式，一起是ice-full方式
-   // ss << "a=ice-lite\r\n";
+    // sdp.append("a=ice-lite\r\n");
 
     // BUDDLE
     std::vector<const ContentGroup*> content_group = get_group_by_name("BUNDLE");
     if (!content_group.empty()) {
-        ss << "a=group:BUNDLE";
+        sdp.append("a=group:BUNDLE");
         for (auto group : content_group) {
-            for (auto content_name : group->content_names()) {
+            for (auto& content_name : group->content_names()) {
                 if (content_name == "audio") {
-                    ss << " " << 0;
+                    sdp.append(" 0");
                 } else if (content_name == "video") {
-                    ss << " " << 1;
-                }    
+                    sdp.append(" 1");
+                }
             }
         }
-        ss << "\r\n";
+        sdp.append("\r\n");
     }
 
-    ss << "a=msid-semantic: WMS  live/xrtc \r\n";
+    sdp.append("a=msid-semantic: WMS  live/xrtc \r\n");
 
-    for (auto content : contents_) {
-        // RFC 4566
-        // m=<media> <port> <proto> <fmt>
-        std::string fmt;
-        for (auto codec : content->get_codecs()) {
-            fmt.append(" ");
-            fmt.append(std::to_string(codec->id));
-        }
-
-        std::string meida_protocol;
-        if (dtls_on) {
-            meida_protocol = k_media_protocol_dtls_savpf;
-        } else {
-            meida_protocol = k_meida_protocol_savpf;
-        }
-        ss << "m=" << content->mid() << " 9 " << meida_protocol << fmt << "\r\n";
+    for (auto& content : contents_) {
+        const MediaSectionTemplate& tpl = get_media_section_template(content, dtls_on);
+        sdp.append(tpl.head);
+        //sdp.append("a=rtcp:9 IN IP4 0.0.0.0\r\n");
 
-        ss << "c=IN IP4 0.0.0.0\r\n";
-        //ss << "a=rtcp:9 IN IP4 0.0.0.0\r\n";
-  
         auto transport_info = get_transport_info(content->mid());
         if (transport_info) {
-            ss << "a=ice-ufrag:" << transport_info->ice_ufrag << "\r\n";
-            ss << "a=ice-pwd:" << transport_info->ice_pwd << "\r\n";
+            sdp.append("a=ice-ufrag:");
+            sdp.append(transport_info->ice_ufrag);
+            sdp.append("\r\na=ice-pwd:");
+            sdp.append(transport_info->ice_pwd);
+            sdp.append("\r\n");
 
             auto fp = transport_info->identity_fingerprint.get();
             if (fp) {
-                ss << "a=fingerprint:" << fp->algorithm << " " << fp->GetRfc4572Fingerprint()
-                    << "\r\n";
-                ss << "a=setup:" << connection_role_to_string(
-                    transport_info->connection_role) << "\r\n";
+                sdp.append("a=fingerprint:");
+                sdp.append(fp->algorithm);
+                sdp.push_back(' ');
+                sdp.append(fp->GetRfc4572Fingerprint());
+                sdp.append("\r\na=setup:");
+                sdp.append(connection_role_to_string(transport_info->connection_role));
+                sdp.append("\r\n");
             }
         }
 
-        if (content->mid() == "audio") {
-            ss << "a=mid:0" << "\r\n";
-        } else if (content->mid() == "video") {
-            ss << "a=mid:1" << "\r\n";
-        }
-
-        ss << "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01" << "\r\n";
-        
-        build_rtp_direction(content, ss);
-
-        if (content->rtcp_mux()) {
-            ss << "a=rtcp-mux\r\n";
-        }
-
-        ss << "a=rtcp-rsize\r\n";
-        
-        build_rtp_map(content, ss);
-        build_ssrc(content, ss);
-
-        build_candidates(content, ss);
+        sdp.append(tpl.body);
+        build_ssrc(content, &sdp);
+        build_candidates(content, &sdp);
     }
 
-    return ss.str();
+    return sdp;
 }
 
 } // end namespace xrtc
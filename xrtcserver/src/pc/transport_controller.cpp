@@ -45,6 +45,19 @@ void TransportController::_on_candidate_allocate_done(IceAgent* /*agent*/,
     signal_candidate_allocate_done(this, transport_name, component, candidates);
 }
 
+bool TransportController::can_migrate() {
+    return ice_agent_->can_migrate();
+}
+
+void TransportController::detach_event_loop() {
+    ice_agent_->detach_event_loop();
+}
+
+void TransportController::attach_event_loop(EventLoop* el, PortAllocator* allocator) {
+    el_ = el;
+    ice_agent_->attach_event_loop(el, allocator);
+}
+
 int TransportController::set_local_description(SessionDescription* desc) {
     if (!desc) {
         RTC_LOG(LS_WARNING) << "desc is null";
@@ -105,23 +118,27 @@ void TransportController::_on_read_packet(IceAgent*, const std::string& /*transp
         return;
     }
 
-    rtc::CopyOnWriteBuffer packet(data, len);
+    PacketBufferPtr packet = PacketBufferPool::current()->alloc(data, len);
+    if (!packet) {
+        return;
+    }
+
     if (packet_type == RtpPacketType::k_rtp) {
-        signal_rtp_packet_received(this, &packet, ts);
+        signal_rtp_packet_received(this, packet.get(), ts);
     } else {
-        signal_rtcp_packet_received(this, &packet, ts);
+        signal_rtcp_packet_received(this, packet.get(), ts);
     }
 
 }
 
 void TransportController::_on_rtp_packet_received(DtlsSrtpTransport*,
-        rtc::CopyOnWriteBuffer* packet, int64_t ts)
+        PacketBuffer* packet, int64_t ts)
 {
     signal_rtp_packet_received(this, packet, ts);
 }
 
 void TransportController::_on_rtcp_packet_received(DtlsSrtpTransport*,
-        rtc::CopyOnWriteBuffer* packet, int64_t ts)
+        PacketBuffer* packet, int64_t ts)
 {
     signal_rtcp_packet_received(this, packet, ts);
 }
@@ -14,6 +14,7 @@
 #include <rtc_base/third_party/sigslot/sigslot.h>
 #include <rtc_base/copy_on_write_buffer.h>
 
+#include "base/packet_buffer.h"
 #include "ice/ice_def.h"
 #include "pc/peer_connection_def.h"
 #include "ice/ice_transport_channel.h"
@@ -38,6 +39,11 @@ public:
     int set_remote_description(SessionDescription* desc);
     void set_local_certificate(rtc::RTCCertificate* cert);
 
+    // DTLS和SRTP的状态不依赖EventLoop，迁移时只需要处理ICE层的socket和定时器
+    bool can_migrate();
+    void detach_event_loop();
+    void attach_event_loop(EventLoop* el, PortAllocator* allocator);
+
     int send_rtp(const std::string& transport_name, const char* data, size_t len);
     int send_rtcp(const std::string& transport_name, const char* data, size_t len);
     int send_unencrypted_rtcp(const std::string& transport_name, const char* data, size_t len);
@@ -45,8 +51,8 @@ public:
     sigslot::signal4<TransportController*, const std::string&, IceCandidateComponent,
         const std::vector<Candidate>&> signal_candidate_allocate_done;
     sigslot::signal2<TransportController*, PeerConnectionState> signal_connection_state;
-    sigslot::signal3<TransportController*, rtc::CopyOnWriteBuffer*, int64_t> signal_rtp_packet_received;
-    sigslot::signal3<TransportController*, rtc::CopyOnWriteBuffer*, int64_t> signal_rtcp_packet_received;
+    sigslot::signal3<TransportController*, PacketBuffer*, int64_t> signal_rtp_packet_received;
+    sigslot::signal3<TransportController*, PacketBuffer*, int64_t> signal_rtcp_packet_received;
 
 private:
     void _on_candidate_allocate_done(IceAgent* agent,
@@ -57,8 +63,8 @@ private:
     void _on_dtls_writable_state(DtlsTransport*);
     void _on_dtls_state(DtlsTransport*, DtlsTransportState);
     void _on_ice_state(IceAgent*, IceTransportState);
-    void _on_rtp_packet_received(DtlsSrtpTransport*, rtc::CopyOnWriteBuffer* packet, int64_t ts);
-    void _on_rtcp_packet_received(DtlsSrtpTransport*, rtc::CopyOnWriteBuffer* packet, int64_t ts);
+    void _on_rtp_packet_received(DtlsSrtpTransport*, PacketBuffer* packet, int64_t ts);
+    void _on_rtcp_packet_received(DtlsSrtpTransport*, PacketBuffer* packet, int64_t ts);
 
     void _add_dtls_transport(DtlsTransport* dtls);
     DtlsTransport* _get_dtls_transport(const std::string& transport_name);
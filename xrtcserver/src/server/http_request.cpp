@@ -0,0 +1,194 @@
+#include <absl/strings/match.h>
+#include <absl/strings/string_view.h>
+
+#include "server/http_request.h"
+
+namespace xrtc {
+
+// 请求头最大长度，超过认为是非法请求
+const size_t k_max_http_head_len = 8 * 1024;
+
+static absl::string_view trim_space(absl::string_view str) {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+        str.remove_suffix(1);
+    }
+
+    return str;
+}
+
+static bool parse_content_length(absl::string_view str, size_t* value) {
+    if (str.empty() || str.size() > 10) {
+        return false;
+    }
+
+    size_t result = 0;
+    for (char c : str) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+
+    *value = result;
+    return true;
+}
+
+int parse_http_request_head(const char* data, size_t len, HttpRequest* req) {
+    absl::string_view buf(data, len);
+    size_t end = buf.find("\r\n\r\n");
+    if (end == absl::string_view::npos) {
+        return len > k_max_http_head_len ? -1 : 0;
+    }
+
+    if (end + 4 > k_max_http_head_len) {
+        return -1;
+    }
+
+    req->head_len = end + 4;
+    absl::string_view head = buf.substr(0, end + 2);
+
+    // 请求行: METHOD SP target SP HTTP/1.x
+    size_t line_end = head.find("\r\n");
+    absl::string_view line = head.substr(0, line_end);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.rfind(' ');
+    if (sp1 == absl::string_view::npos || sp1 == sp2) {
+        return -1;
+    }
+
+    absl::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    absl::string_view version = line.substr(sp2 + 1);
+    if (target.empty() || target[0] != '/' || !absl::StartsWith(version, "HTTP/1.")) {
+        return -1;
+    }
+
+    req->method.assign(line.data(), sp1);
+    size_t qpos = target.find('?');
+    if (qpos == absl::string_view::npos) {
+        req->path.assign(target.data(), target.size());
+        req->query.clear();
+    } else {
+        req->path.assign(target.data(), qpos);
+        req->query.assign(target.data() + qpos + 1, target.size() - qpos - 1);
+    }
+
+    // HTTP/1.0默认短连接
+    req->keep_alive = (version != "HTTP/1.0");
+    req->content_type.clear();
+    req->content_length = 0;
+
+    head.remove_prefix(line_end + 2);
+    while (!head.empty()) {
+        line_end = head.find("\r\n");
+        line = head.substr(0, line_end);
+        head.remove_prefix(line_end + 2);
+
+        size_t colon = line.find(':');
+        if (colon == absl::string_view::npos) {
+            return -1;
+        }
+
+        absl::string_view name = line.substr(0, colon);
+        absl::string_view value = trim_space(line.substr(colon + 1));
+        if (absl::EqualsIgnoreCase(name, "Content-Length")) {
+            if (!parse_content_length(value, &req->content_length)) {
+                return -1;
+            }
+        } else if (absl::EqualsIgnoreCase(name, "Content-Type")) {
+            // 去掉charset等参数
+            absl::string_view type = trim_space(value.substr(0, value.find(';')));
+            req->content_type.assign(type.data(), type.size());
+        } else if (absl::EqualsIgnoreCase(name, "Connection")) {
+            if (absl::EqualsIgnoreCase(value, "close")) {
+                req->keep_alive = false;
+            } else if (absl::EqualsIgnoreCase(value, "keep-alive")) {
+                req->keep_alive = true;
+            }
+        } else if (absl::EqualsIgnoreCase(name, "Transfer-Encoding")) {
+            // 不支持chunked请求体
+            return -1;
+        }
+    }
+
+    return 1;
+}
+
+bool get_http_query_param(const std::string& query, const char* name, std::string* value) {
+    absl::string_view rest(query);
+    absl::string_view key(name);
+    while (!rest.empty()) {
+        size_t amp = rest.find('&');
+        absl::string_view param = rest.substr(0, amp);
+        rest = (amp == absl::string_view::npos) ? absl::string_view() : rest.substr(amp + 1);
+
+        size_t eq = param.find('=');
+        if (param.substr(0, eq) != key) {
+            continue;
+        }
+
+        if (eq == absl::string_view::npos) {
+            value->clear();
+        } else {
+            value->assign(param.data() + eq + 1, param.size() - eq - 1);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+static const char* http_status_text(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 415: return "Unsupported Media Type";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+void append_http_response(int status, const char* content_type, const std::string& location,
+        const std::string& body, bool keep_alive, std::string* out)
+{
+    out->append("HTTP/1.1 ");
+    out->append(std::to_string(status));
+    out->push_back(' ');
+    out->append(http_status_text(status));
+    out->append("\r\n");
+
+    if (content_type && !body.empty()) {
+        out->append("Content-Type: ");
+        out->append(content_type);
+        out->append("\r\n");
+    }
+
+    if (!location.empty()) {
+        out->append("Location: ");
+        out->append(location);
+        out->append("\r\n");
+    }
+
+    // 浏览器页面直接访问时需要跨域
+    out->append("Access-Control-Allow-Origin: *\r\n"
+            "Access-Control-Allow-Methods: POST, DELETE, OPTIONS\r\n"
+            "Access-Control-Allow-Headers: Content-Type, Authorization\r\n"
+            "Access-Control-Expose-Headers: Location\r\n");
+
+    out->append("Content-Length: ");
+    out->append(std::to_string(body.size()));
+    out->append("\r\n");
+    out->append(keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
+    out->append(body);
+}
+
+} // namespace xrtc
@@ -0,0 +1,42 @@
+/**
+ * @file http_request.h
+ * @author charles
+ * @brief WHIP/WHEP使用的最简HTTP/1.1请求解析和应答构造，
+ *         只支持Content-Length的请求体，不支持chunked
+*/
+
+#ifndef __SERVER_HTTP_REQUEST_H_
+#define __SERVER_HTTP_REQUEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace xrtc {
+
+struct HttpRequest {
+    std::string method;
+    // 不包含query部分
+    std::string path;
+    std::string query;
+    std::string content_type;
+    size_t content_length = 0;
+    bool keep_alive = true;
+    // 请求行和所有请求头的长度，包括最后的空行
+    size_t head_len = 0;
+};
+
+// 解析请求头，返回1表示解析成功，0表示数据还不完整，-1表示格式错误
+int parse_http_request_head(const char* data, size_t len, HttpRequest* req);
+
+// 取query中的参数，不做url解码
+bool get_http_query_param(const std::string& query, const char* name, std::string* value);
+
+// 把完整的应答(状态行、应答头和包体)追加到out
+void append_http_response(int status, const char* content_type, const std::string& location,
+        const std::string& body, bool keep_alive, std::string* out);
+
+} // namespace xrtc
+
+#endif // __SERVER_HTTP_REQUEST_H_
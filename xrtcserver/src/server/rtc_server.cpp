@@ -1,4 +1,7 @@
-#include <unistd.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include <algorithm>
 
 #include <rtc_base/logging.h>
 #include <rtc_base/crc32.h>
@@ -7,12 +10,20 @@
 #include <yaml-cpp/yaml.h>
 
 #include "base/event_loop.h"
+#include "base/event_notifier.h"
 #include "server/rtc_server.h"
 #include "server/rtc_worker.h"
+#include "server/stream_relay.h"
 
 namespace xrtc {
 
 const uint64_t k_year_in_ms = 365 * 24 * 3600 * 1000L;
+// 证书在过期之前提前更换，避免新会话拿到即将过期的证书
+const uint64_t k_certificate_renew_ahead_ms = 24 * 3600 * 1000L;
+const unsigned int k_certificate_check_interval_usec = 600 * 1000 * 1000; // 10min
+const unsigned int k_rebalance_interval_usec = 10 * 1000 * 1000; // 10s
+// 选择worker时繁忙度按5%分档，同一档内比较会话数，避免采样误差导致新流集中到一个worker
+const uint32_t k_busy_bucket_permille = 50;
 
 RtcServer::RtcServer() : 
     el_(std::make_unique<xrtc::EventLoop>(this)) {
@@ -21,31 +32,52 @@ RtcServer::RtcServer() :
 RtcServer::~RtcServer() {
     workers_.clear();
     workers_.shrink_to_fit();
-}
+    relay_.reset();
 
-static void rtc_server_recv_notify(EventLoop * /*el*/, IOWatcher */*w*/, int fd, int /*event*/, void *data) {
-    int msg = -1;
-    if (read(fd, &msg, sizeof(int)) != sizeof(int)) {
-        RTC_LOG(LS_WARNING) << "read from pipe errror: " << strerror(errno) << ", errno: " << errno;
-        return;
+    if (certificate_timer_) {
+        el_->delete_timer(certificate_timer_);
+        certificate_timer_ = nullptr;
+    }
+
+    if (rebalance_timer_) {
+        el_->delete_timer(rebalance_timer_);
+        rebalance_timer_ = nullptr;
     }
+}
 
+static void rtc_server_recv_notify(EventLoop * /*el*/, int msg, void *data) {
     RtcServer *server = (RtcServer*)data;
     server->process_notify(msg);
 }
 
+static void certificate_timer_cb(EventLoop * /*el*/, TimerWatcher * /*w*/, void *data) {
+    RtcServer *server = (RtcServer*)data;
+    server->check_certificate();
+}
+
+static void rebalance_timer_cb(EventLoop * /*el*/, TimerWatcher * /*w*/, void *data) {
+    RtcServer *server = (RtcServer*)data;
+    server->check_rebalance();
+}
+
 int RtcServer::_generate_and_check_certificate() {
-    if (!certificate_ || certificate_->HasExpired(time(NULL) * 1000)) {
+    rtc::RTCCertificate *certificate = current_certificate_.load(std::memory_order_acquire);
+    if (!certificate || certificate->HasExpired(time(NULL) * 1000 + k_certificate_renew_ahead_ms)) {
         rtc::KeyParams key_params;
         RTC_LOG(LS_INFO) << "dtls enabled, key type: " << key_params.type();
-        certificate_ = rtc::RTCCertificateGenerator::GenerateCertificate(key_params, k_year_in_ms);
-        if (certificate_) {
-            rtc::RTCCertificatePEM pem = certificate_->ToPEM();
+        rtc::scoped_refptr<rtc::RTCCertificate> new_certificate =
+            rtc::RTCCertificateGenerator::GenerateCertificate(key_params, k_year_in_ms);
+        if (new_certificate) {
+            rtc::RTCCertificatePEM pem = new_certificate->ToPEM();
             RTC_LOG(LS_INFO) << "rtc certificate: \n" << pem.certificate();
+
+            certificates_.push_back(new_certificate);
+            certificate = new_certificate.get();
+            current_certificate_.store(certificate, std::memory_order_release);
         }
     }
     
-    if (!certificate_) {
+    if (!certificate) {
         RTC_LOG(LS_WARNING) << "get certificate error";
         return -1;
     }
@@ -53,6 +85,10 @@ int RtcServer::_generate_and_check_certificate() {
     return 0;
 }
 
+void RtcServer::check_certificate() {
+    _generate_and_check_certificate();
+}
+
 int RtcServer::init(const RtcServerOptions& options) {  
     options_ = options;
     
@@ -61,20 +97,32 @@ int RtcServer::init(const RtcServerOptions& options) {
         return -1;
     }
 
-    int fds[2];
-    if (pipe(fds) == -1) {
-        RTC_LOG(LS_ERROR) << "create pipe error: " << strerror(errno) << ", errno: " << errno;
+    notifier_ = std::make_unique<EventNotifier>(el_.get(), rtc_server_recv_notify, this);
+    if (notifier_->init() != 0) {
         return -1;
     }
 
-    notify_recv_fd_ = fds[0];
-    notify_send_fd_ = fds[1];
+    // 证书的检查和更换只在RtcServer线程中进行
+    certificate_timer_ = el_->create_timer(certificate_timer_cb, this, true);
+    el_->start_timer(certificate_timer_, k_certificate_check_interval_usec);
+
+    if (options_.cross_worker_fanout) {
+        if (options_.worker_num > k_relay_max_worker_num) {
+            RTC_LOG(LS_WARNING) << "cross worker fanout disabled, worker_num: " << options_.worker_num
+                << " exceeds " << k_relay_max_worker_num;
+            options_.cross_worker_fanout = false;
+        } else {
+            relay_ = std::make_unique<StreamRelay>(options_.worker_num);
+        }
+    }
 
-    // 将recv_fd添加到事件循环，进行管理
-    pipe_wather_ = el_->create_io_event(rtc_server_recv_notify, this);
-    el_->start_io_event(pipe_wather_, notify_recv_fd_, EventLoop::READ);
+    if (options_.rebalance_busy_diff > 0) {
+        rebalance_timer_ = el_->create_timer(rebalance_timer_cb, this, true);
+        el_->start_timer(rebalance_timer_, k_rebalance_interval_usec);
+    }
 
     // 创建worker
+    worker_sessions_.assign(options_.worker_num, 0);
     for (int i = 0; i < options_.worker_num; ++i) {
         if (_create_worker(i) != 0) {
             return -1;
@@ -104,8 +152,7 @@ void RtcServer::stop() {
 }
 
 int RtcServer::notify(int msg) {
-    int writen = write(notify_send_fd_, &msg, sizeof(int));
-    return writen == sizeof(int) ? 0 : -1;
+    return notifier_->notify(msg);
 }
 
 void RtcServer::process_notify(int msg) {
@@ -113,9 +160,6 @@ void RtcServer::process_notify(int msg) {
         case QUIT:
             _quit();
             break;
-        case RTC_MSG:
-            process_rtc_msg();
-            break;
         default:
             RTC_LOG(LS_WARNING) << "unknown msg:" << msg;
             break;
@@ -128,12 +172,9 @@ void RtcServer::_quit() {
         return;
     }
 
-    el_->delete_io_event(pipe_wather_);
+    // 其它线程可能还会通知，eventfd在析构时才关闭
     el_->stop();
 
-    close(notify_recv_fd_);
-    close(notify_send_fd_);
-
     for (auto worker : workers_) {
         if (worker) {
             worker->stop();
@@ -150,65 +191,311 @@ void RtcServer::join() {
     }
 }
 
-int RtcServer::send_rtc_msg(std::shared_ptr<RtcMsg> rtcMsg) {
-    push_msg(rtcMsg);
-    return notify(RtcServer::RTC_MSG);
-}
+int RtcServer::send_rtc_msg(std::shared_ptr<RtcMsg> msg) {
+    rtc::RTCCertificate *certificate = current_certificate_.load(std::memory_order_acquire);
+    if (!certificate) {
+        RTC_LOG(LS_WARNING) << "no rtc certificate, cmdno: " << msg->cmdno
+            << ", log_id: " << msg->log_id;
+        return -1;
+    }
 
-void RtcServer::push_msg(std::shared_ptr<RtcMsg> msg) {
-    std::unique_lock<std::mutex> lock(q_msg_mtx_);
-    q_msg_.push(msg);
-}
+    msg->certificate = certificate;
 
-std::shared_ptr<RtcMsg> RtcServer::pop_msg() {
-    std::unique_lock<std::mutex> lock(q_msg_mtx_);
+    std::shared_ptr<RtcWorker> worker = _get_worker(msg);
+    if (!worker) {
+        RTC_LOG(LS_WARNING) << "no rtc worker, cmdno: " << msg->cmdno
+            << ", log_id: " << msg->log_id;
+        return -1;
+    }
 
-    if (q_msg_.empty()) {
+    if (worker->send_rtc_msg(msg) != 0) {
+        placement_done(msg);
+        return -1;
+    }
+
+    return 0;
+}
+
+std::shared_ptr<RtcWorker> RtcServer::get_worker(int worker_id) {
+    if (worker_id < 0 || (size_t)worker_id >= workers_.size()) {
         return nullptr;
     }
+    return workers_[worker_id];
+}
+
+static bool is_stream_cmd(int cmdno) {
+    return CMDNO_PUSH == cmdno || CMDNO_PULL == cmdno
+        || CMDNO_STOPPUSH == cmdno || CMDNO_STOPPULL == cmdno;
+}
 
-    std::shared_ptr<RtcMsg> msg = q_msg_.front();
-    q_msg_.pop();
+static bool is_create_cmd(int cmdno) {
+    return CMDNO_PUSH == cmdno || CMDNO_PULL == cmdno;
+}
+
+static bool is_pull_cmd(int cmdno) {
+    return CMDNO_PULL == cmdno || CMDNO_STOPPULL == cmdno;
+}
 
-    return msg;
+std::string RtcServer::placement_key(bool pull, const std::string& stream_name, uint64_t uid) {
+    if (relay_ && pull) {
+        // 拉流者按uid分散，推流包由StreamRelay转发到拉流者所在的worker
+        return stream_name + "_" + std::to_string(uid);
+    }
+    return stream_name;
 }
 
-std::shared_ptr<RtcWorker> RtcServer::_get_worker(const std::string &stream_name) {
+std::shared_ptr<RtcWorker> RtcServer::_get_worker(std::shared_ptr<RtcMsg> msg) {
     if (workers_.size() == 0 || workers_.size() != (size_t)options_.worker_num) {
         return nullptr;
     }
 
-    uint32_t num = rtc::ComputeCrc32(stream_name);
-    size_t index = num % options_.worker_num;
-    return workers_[index];
+    std::string key = placement_key(is_pull_cmd(msg->cmdno), msg->stream_name, msg->uid);
+    bool create = is_create_cmd(msg->cmdno);
+
+    std::unique_lock<std::mutex> lock(placement_mtx_);
+    auto iter = placements_.find(key);
+    if (iter == placements_.end()) {
+        if (!create) {
+            // 流不在任何worker上，按流名计算，worker找不到流时直接返回
+            return workers_[rtc::ComputeCrc32(key) % options_.worker_num];
+        }
+
+        // 新的流放到负载最低的worker上，之后同一个流的消息都发到这个worker
+        StreamPlacement placement;
+        placement.worker_id = _least_loaded_worker();
+        iter = placements_.emplace(key, placement).first;
+    }
+
+    if (create) {
+        ++iter->second.pending;
+        ++worker_sessions_[iter->second.worker_id];
+    }
+
+    return workers_[iter->second.worker_id];
+}
+
+int RtcServer::_least_loaded_worker() {
+    int best = 0;
+    for (int i = 1; i < (int)workers_.size(); ++i) {
+        uint32_t busy = workers_[i]->busy_permille() / k_busy_bucket_permille;
+        uint32_t best_busy = workers_[best]->busy_permille() / k_busy_bucket_permille;
+        if (busy != best_busy) {
+            if (busy < best_busy) {
+                best = i;
+            }
+            continue;
+        }
+
+        if (worker_sessions_[i] != worker_sessions_[best]) {
+            if (worker_sessions_[i] < worker_sessions_[best]) {
+                best = i;
+            }
+            continue;
+        }
+
+        if (workers_[i]->forwarded_pps() < workers_[best]->forwarded_pps()) {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+bool RtcServer::forward_rtc_msg(int worker_id, std::shared_ptr<RtcMsg> msg) {
+    if (!is_stream_cmd(msg->cmdno)) {
+        return false;
+    }
+
+    std::string key = placement_key(is_pull_cmd(msg->cmdno), msg->stream_name, msg->uid);
+    int owner = -1;
+    {
+        std::unique_lock<std::mutex> lock(placement_mtx_);
+        auto iter = placements_.find(key);
+        if (iter == placements_.end() || iter->second.worker_id == worker_id) {
+            return false;
+        }
+        owner = iter->second.worker_id;
+    }
+
+    if (workers_[owner]->send_rtc_msg(msg) != 0) {
+        RTC_LOG(LS_WARNING) << "forward rtc msg failed, cmdno: " << msg->cmdno
+            << ", stream_name: " << msg->stream_name
+            << ", dst_worker: " << owner;
+        if (is_create_cmd(msg->cmdno)) {
+            placement_done(msg);
+        }
+    }
+
+    return true;
 }
 
-void RtcServer::process_rtc_msg() {
-    std::shared_ptr<RtcMsg> msg = pop_msg();
-    if (!msg) {
+void RtcServer::placement_done(std::shared_ptr<RtcMsg> msg) {
+    if (!is_create_cmd(msg->cmdno)) {
         return;
     }
 
-    if (_generate_and_check_certificate() != 0) {
+    std::string key = placement_key(is_pull_cmd(msg->cmdno), msg->stream_name, msg->uid);
+    std::unique_lock<std::mutex> lock(placement_mtx_);
+    auto iter = placements_.find(key);
+    if (iter == placements_.end()) {
         return;
     }
-    
-    msg->certificate = certificate_.get();
 
-    std::shared_ptr<RtcWorker> worker = _get_worker(msg->stream_name);
-    if (worker) {
-        worker->send_rtc_msg(msg);
+    --iter->second.pending;
+    --worker_sessions_[iter->second.worker_id];
+    _release_placement(iter);
+}
+
+void RtcServer::placement_add(const std::string& key, bool push) {
+    std::unique_lock<std::mutex> lock(placement_mtx_);
+    auto iter = placements_.find(key);
+    if (iter == placements_.end()) {
+        RTC_LOG(LS_WARNING) << "stream placement not found, key: " << key;
+        return;
+    }
+
+    ++iter->second.sessions;
+    if (push) {
+        ++iter->second.push_sessions;
     }
+    ++worker_sessions_[iter->second.worker_id];
+}
+
+void RtcServer::placement_remove(const std::string& key, bool push) {
+    std::unique_lock<std::mutex> lock(placement_mtx_);
+    auto iter = placements_.find(key);
+    if (iter == placements_.end()) {
+        return;
+    }
+
+    --iter->second.sessions;
+    if (push) {
+        --iter->second.push_sessions;
+    }
+    --worker_sessions_[iter->second.worker_id];
+    _release_placement(iter);
+}
+
+void RtcServer::_release_placement(std::unordered_map<std::string, StreamPlacement>::iterator iter) {
+    if (iter->second.pending <= 0 && iter->second.sessions <= 0) {
+        placements_.erase(iter);
+    }
+}
+
+void RtcServer::move_placement(const std::vector<std::string>& keys, int src_worker, int dst_worker) {
+    std::unique_lock<std::mutex> lock(placement_mtx_);
+    for (auto& key : keys) {
+        auto iter = placements_.find(key);
+        if (iter == placements_.end() || iter->second.worker_id != src_worker) {
+            continue;
+        }
+
+        int count = iter->second.pending + iter->second.sessions;
+        worker_sessions_[src_worker] -= count;
+        worker_sessions_[dst_worker] += count;
+        iter->second.worker_id = dst_worker;
+    }
+}
+
+int RtcServer::migrate_stream(const std::string& stream_name, int dst_worker) {
+    if (dst_worker < 0 || (size_t)dst_worker >= workers_.size()) {
+        return -1;
+    }
+
+    int src_worker = -1;
+    {
+        std::unique_lock<std::mutex> lock(placement_mtx_);
+        auto iter = placements_.find(placement_key(false, stream_name, 0));
+        if (iter == placements_.end() || iter->second.push_sessions <= 0) {
+            RTC_LOG(LS_WARNING) << "migrate stream not found, stream_name: " << stream_name;
+            return -1;
+        }
+        src_worker = iter->second.worker_id;
+    }
+
+    if (src_worker == dst_worker) {
+        return 0;
+    }
+
+    // 由源worker摘下会话后直接投递给目标worker
+    std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
+    msg->cmdno = CMDNO_MIGRATE_OUT;
+    msg->stream_name = stream_name;
+    msg->dst_worker = dst_worker;
+
+    RTC_LOG(LS_INFO) << "migrate stream, stream_name: " << stream_name
+        << ", src_worker: " << src_worker << ", dst_worker: " << dst_worker;
+
+    return workers_[src_worker]->send_rtc_msg(msg);
+}
+
+void RtcServer::check_rebalance() {
+    if (workers_.size() < 2) {
+        return;
+    }
+
+    int busiest = 0;
+    int idlest = 0;
+    for (int i = 1; i < (int)workers_.size(); ++i) {
+        if (workers_[i]->busy_permille() > workers_[busiest]->busy_permille()) {
+            busiest = i;
+        }
+        if (workers_[i]->busy_permille() < workers_[idlest]->busy_permille()) {
+            idlest = i;
+        }
+    }
+
+    uint32_t busy_diff = workers_[busiest]->busy_permille() - workers_[idlest]->busy_permille();
+    if (busy_diff <= (uint32_t)options_.rebalance_busy_diff) {
+        return;
+    }
+
+    // 选择会话数最接近两个worker会话差一半的推流，一次只迁移一路
+    std::string stream_name;
+    {
+        std::unique_lock<std::mutex> lock(placement_mtx_);
+        int target = std::max(1, (worker_sessions_[busiest] - worker_sessions_[idlest]) / 2);
+        int best_delta = INT_MAX;
+        for (auto& item : placements_) {
+            const StreamPlacement& placement = item.second;
+            if (placement.worker_id != busiest || placement.push_sessions <= 0
+                    || placement.pending > 0)
+            {
+                continue;
+            }
+
+            int delta = abs(placement.sessions - target);
+            if (delta < best_delta) {
+                best_delta = delta;
+                stream_name = item.first;
+            }
+        }
+    }
+
+    if (stream_name.empty()) {
+        return;
+    }
+
+    RTC_LOG(LS_INFO) << "rebalance, busiest worker: " << busiest
+        << ", busy: " << workers_[busiest]->busy_permille()
+        << ", idlest worker: " << idlest
+        << ", busy: " << workers_[idlest]->busy_permille();
+
+    migrate_stream(stream_name, idlest);
 }
 
 int RtcServer::_create_worker(int worker_id) {
     RTC_LOG(LS_INFO) << "rtc server create worker, worker_id:" << worker_id;
 
-    auto worker = std::make_shared<RtcWorker>(worker_id, options_);
+    auto worker = std::make_shared<RtcWorker>(worker_id, options_, this, relay_.get());
     if (worker->init() != 0) {
         return -1;
     }
 
+    if (relay_) {
+        relay_->register_worker(worker_id, worker.get());
+    }
+
     if (!worker->start()) {
         return -1;
     }
@@ -9,9 +9,11 @@
 
 #include <memory>
 #include <thread>
-#include <queue>
-#include <mutex>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 #include <rtc_base/rtc_certificate.h>
 
@@ -21,14 +23,15 @@
 namespace xrtc {
 
 class EventLoop;
-class IOWatcher;
+class EventNotifier;
+class TimerWatcher;
 class RtcWorker;
+class StreamRelay;
 
 class RtcServer {
 public:
     enum {
         QUIT = 0,
-        RTC_MSG = 1,
     };
 
     RtcServer();
@@ -41,32 +44,67 @@ public:
     int notify(int msg);
     void process_notify(int msg);
     void join();
+    // 在调用方(SignalingWorker)线程中选择RtcWorker并直接投递，不经过RtcServer线程
     int send_rtc_msg(std::shared_ptr<RtcMsg> msg);
-    void push_msg(std::shared_ptr<RtcMsg> msg);
-    std::shared_ptr<RtcMsg> pop_msg();
-    void process_rtc_msg();
+    void check_certificate();
+    void check_rebalance();
+
+    std::shared_ptr<RtcWorker> get_worker(int worker_id);
+
+    // 把推流和它的拉流迁移到dst_worker，不重新协商，可以在任意线程调用
+    int migrate_stream(const std::string& stream_name, int dst_worker);
+
+    // 以下由RtcWorker线程调用，维护流所在的worker
+    // 推流和拉流使用流名，开启cross_worker_fanout时拉流者使用流名+uid
+    std::string placement_key(bool pull, const std::string& stream_name, uint64_t uid);
+    // 消息属于其它worker时转发过去，返回true
+    bool forward_rtc_msg(int worker_id, std::shared_ptr<RtcMsg> msg);
+    // PUSH/PULL消息处理完成
+    void placement_done(std::shared_ptr<RtcMsg> msg);
+    void placement_add(const std::string& key, bool push);
+    void placement_remove(const std::string& key, bool push);
+    void move_placement(const std::vector<std::string>& keys, int src_worker, int dst_worker);
 
 private:
     void _quit();
     int _create_worker(int worker_id);
-    std::shared_ptr<RtcWorker> _get_worker(const std::string &stream_name);
+    std::shared_ptr<RtcWorker> _get_worker(std::shared_ptr<RtcMsg> msg);
+    int _least_loaded_worker();
     int _generate_and_check_certificate();
 
+    // 流所在的worker，第一次出现时选择负载最低的worker，之后固定不变，直到迁移或者所有会话结束
+    struct StreamPlacement {
+        int worker_id = -1;
+        // 已经路由但是还没有处理完的PUSH/PULL消息
+        int pending = 0;
+        int sessions = 0;
+        int push_sessions = 0;
+    };
+
+    void _release_placement(std::unordered_map<std::string, StreamPlacement>::iterator iter);
+
 private:
     RtcServerOptions options_;
     std::unique_ptr<EventLoop> el_;
+    std::unique_ptr<EventNotifier> notifier_;
+    TimerWatcher *certificate_timer_ = nullptr;
     std::unique_ptr<std::thread> thread_;
 
-    IOWatcher *pipe_wather_ = nullptr;
-    int notify_recv_fd_ = -1;
-    int notify_send_fd_ = -1;
+    // init之后只读，信令线程可以直接访问
+    std::unique_ptr<StreamRelay> relay_;
+    std::vector<std::shared_ptr<RtcWorker>> workers_;
 
-    std::queue<std::shared_ptr<RtcMsg>> q_msg_;
-    std::mutex q_msg_mtx_;
+    // 证书只在RtcServer线程中生成和更换，信令线程读取当前证书的快照。
+    // 已经创建的会话持有证书的裸指针，换下来的证书保留到RtcServer销毁
+    std::vector<rtc::scoped_refptr<rtc::RTCCertificate>> certificates_;
+    std::atomic<rtc::RTCCertificate*> current_certificate_{nullptr};
 
-    std::vector<std::shared_ptr<RtcWorker>> workers_;
-    rtc::scoped_refptr<rtc::RTCCertificate> certificate_;
+    TimerWatcher *rebalance_timer_ = nullptr;
 
+    std::mutex placement_mtx_;
+    std::unordered_map<std::string, StreamPlacement> placements_;
+    // 每个worker上的会话数，包括还没有处理完的PUSH/PULL
+    std::vector<int> worker_sessions_;
 };
 
 } // namespace xrtc
@@ -1,32 +1,57 @@
-#include <unistd.h>
+#include <algorithm>
 
 #include <rtc_base/logging.h>
 
+#include "base/cpu_affinity.h"
 #include "base/event_loop.h"
+#include "base/event_notifier.h"
+#include "base/packet_buffer.h"
+#include "modules/pacing/pacing_scheduler.h"
 #include "server/rtc_worker.h"
 #include "server/signaling_worker.h"
 #include "stream/rtc_stream_manager.h"
+#include "stream/pull_stream.h"
 
 namespace xrtc {
 
-static void rtc_worker_recv_notify(EventLoop * /*el*/, IOWatcher */*w*/, int fd, int /*event*/, void *data) {
-    int msg = -1;
-    if (read(fd, &msg, sizeof(int)) != sizeof(int)) {
-        RTC_LOG(LS_WARNING) << "read from pipe errror: " << strerror(errno) << ", errno: " << errno;
-        return;
-    }
+const unsigned int k_io_uring_entries = 4096;
+const size_t k_rtc_msg_queue_size = 4096;
+const unsigned int k_load_update_interval_usec = 1000 * 1000; // 1s
+const size_t k_prealloc_packet_buffers = 1024;
+// 每10次负载更新输出一次事件循环每轮耗时的分布
+const uint32_t k_loop_latency_log_updates = 10;
+
+static void rtc_worker_recv_notify(EventLoop * /*el*/, int msg, void *data) {
     RtcWorker *server = (RtcWorker*)data;
     server->process_notify(msg);
 }
 
-RtcWorker::RtcWorker(int worker_id, const RtcServerOptions& options) :
+static void load_timer_cb(EventLoop * /*el*/, TimerWatcher * /*w*/, void *data) {
+    RtcWorker *worker = (RtcWorker*)data;
+    worker->update_load();
+}
+
+RtcWorker::RtcWorker(int worker_id, const RtcServerOptions& options, RtcServer* server,
+        StreamRelay* relay) :
     worker_id_(worker_id),
     options_(options),
+    server_(server),
     el_(new EventLoop(this)),
-    rtc_stream_manager_(std::make_unique<xrtc::RtcStreamManager>(el_)) {
+    q_msg_(k_rtc_msg_queue_size),
+    relay_(relay)
+{
 }
 
 RtcWorker::~RtcWorker() {
+    // socket和定时器依赖EventLoop，先于EventLoop销毁
+    if (load_timer_) {
+        el_->delete_timer(load_timer_);
+        load_timer_ = nullptr;
+    }
+
+    // rtc_stream_manager_在worker线程退出之前销毁
+    notifier_.reset();
+
     if (el_) {
         delete el_;
         el_ = nullptr;
@@ -34,21 +59,71 @@ RtcWorker::~RtcWorker() {
 }
 
 int RtcWorker::init() {
-    int fds[2];
-    if (pipe(fds) == -1) {
-        RTC_LOG(LS_ERROR) << "create pipe error: " << strerror(errno) << ", errno: " << errno << ", worker_id:" << worker_id_;
+    notifier_ = std::make_unique<EventNotifier>(el_, rtc_worker_recv_notify, this);
+    if (notifier_->init() != 0) {
+        RTC_LOG(LS_ERROR) << "create notifier error, worker_id:" << worker_id_;
         return -1;
     }
 
-    notify_recv_fd_ = fds[0];
-    notify_send_fd_ = fds[1];
-
-    pipe_wather_ = el_->create_io_event(rtc_worker_recv_notify, this);
-    el_->start_io_event(pipe_wather_, notify_recv_fd_, EventLoop::READ);
+    load_timer_ = el_->create_timer(load_timer_cb, this, true);
+    el_->start_timer(load_timer_, k_load_update_interval_usec);
 
     return 0;
 }
 
+void RtcWorker::update_load() {
+    uint64_t now = el_->now();
+    uint64_t busy_usec = el_->busy_usec();
+    uint64_t forwarded_packets = rtc_stream_manager_->forwarded_packets();
+
+    if (last_load_time_ > 0 && now > last_load_time_) {
+        uint64_t elapsed = now - last_load_time_;
+        uint64_t busy = std::min<uint64_t>((busy_usec - last_busy_usec_) * 1000 / elapsed, 1000);
+        uint64_t pps = (forwarded_packets - last_forwarded_packets_) * 1000000 / elapsed;
+        busy_permille_.store((uint32_t)busy, std::memory_order_relaxed);
+        forwarded_pps_.store((uint32_t)pps, std::memory_order_relaxed);
+    }
+
+    last_load_time_ = now;
+    last_busy_usec_ = busy_usec;
+    last_forwarded_packets_ = forwarded_packets;
+
+    if (++load_updates_ % k_loop_latency_log_updates == 0) {
+        _log_loop_latency();
+    }
+}
+
+void RtcWorker::_log_loop_latency() {
+    // 只统计上一次输出之后的部分
+    std::string iterations = el_->iteration_histogram().report_since(&last_iteration_histogram_);
+    if (!iterations.empty()) {
+        RTC_LOG(LS_INFO) << "rtc worker loop iterations, worker_id: " << worker_id_
+            << ", " << iterations
+            << ", pacing pending senders: " << PacingScheduler::current()->PendingSenders();
+    }
+
+    std::string forward = rtc_stream_manager_->forward_latency().report_since(
+            &last_forward_latency_);
+    if (!forward.empty()) {
+        RTC_LOG(LS_INFO) << "rtc worker forward latency, worker_id: " << worker_id_
+            << ", cpu: " << select_worker_cpu(options_.worker_cpus, worker_id_)
+            << ", " << forward;
+    }
+
+    // 由订阅者触发的上行RTCP，开启RTCP终结时不应该随订阅者个数增长
+    uint64_t now = el_->now();
+    uint64_t upstream_rtcp_packets = rtc_stream_manager_->upstream_rtcp_packets();
+    if (last_log_time_ > 0 && now > last_log_time_) {
+        RTC_LOG(LS_INFO) << "rtc worker upstream rtcp, worker_id: " << worker_id_
+            << ", pps: " << (upstream_rtcp_packets - last_upstream_rtcp_packets_) * 1000000
+                / (now - last_log_time_)
+            << ", suppressed keyframe requests: "
+            << rtc_stream_manager_->suppressed_keyframe_requests();
+    }
+    last_log_time_ = now;
+    last_upstream_rtcp_packets_ = upstream_rtcp_packets;
+}
+
 bool RtcWorker::start() {
     if (thread_) {
         RTC_LOG(LS_WARNING) << "rtc worker already start, worker_id:" << worker_id_;
@@ -56,29 +131,81 @@ bool RtcWorker::start() {
     }
 
     thread_ = std::make_unique<std::thread>([=] {
+        _bind_cpu();
+        _create_stream_manager();
+        // pacing调度器是线程局部的，在worker线程中绑定本worker的EventLoop
+        PacingScheduler::current()->Init(el_,
+                (size_t)std::max(options_.pacing_packets_per_iteration, 1));
         RTC_LOG(LS_INFO) << "rtc worker event loop start, worker_id:" << worker_id_;
         el_->start();
         RTC_LOG(LS_INFO) << "rtc worker event loop stop, worker_id:" << worker_id_;
+        // 会话持有的包缓存要还给本线程的缓存池，pacer要从本线程的调度器中注销，
+        // 必须在线程局部对象析构之前、在worker线程中销毁
+        rtc_stream_manager_.reset();
     });
 
     return true;
 }
 
+void RtcWorker::_bind_cpu() {
+    int cpu = select_worker_cpu(options_.worker_cpus, worker_id_);
+    if (cpu < 0) {
+        return;
+    }
+
+    if (bind_thread_to_cpu(cpu) != 0) {
+        RTC_LOG(LS_WARNING) << "rtc worker bind cpu failed, worker_id:" << worker_id_
+            << ", cpu: " << cpu;
+        return;
+    }
+
+    int node = get_cpu_numa_node(cpu);
+    if (node >= 0) {
+        set_preferred_numa_node(node);
+    }
+
+    // 包缓存池是线程局部的，会话对象也都在worker线程中创建，
+    // 设置好内存策略之后再分配，保证落在本地NUMA节点上
+    PacketBufferPool::current()->prealloc(k_prealloc_packet_buffers);
+
+    RTC_LOG(LS_INFO) << "rtc worker bind cpu, worker_id:" << worker_id_
+        << ", cpu: " << cpu << ", numa node: " << node;
+}
+
+// io_uring的队列、端口分配器、socket和会话对象都在绑核和设置内存策略之后，
+// 在worker线程中创建，保证落在本地NUMA节点上；
+// 只在EventLoop线程中使用，事件循环开始之前到达的消息和通知会等到之后才处理
+void RtcWorker::_create_stream_manager() {
+    // 在创建任何socket之前选择IO方式
+    if ("io_uring" == options_.io_backend) {
+        if (el_->enable_io_uring(k_io_uring_entries) != 0) {
+            RTC_LOG(LS_WARNING) << "io_uring not available, fallback to libev, worker_id: "
+                << worker_id_;
+        }
+    }
+
+    rtc_stream_manager_ = std::make_unique<xrtc::RtcStreamManager>(el_, worker_id_, relay_);
+    rtc_stream_manager_->signal_stream_created.connect(this, &RtcWorker::_on_stream_created);
+    rtc_stream_manager_->signal_stream_removed.connect(this, &RtcWorker::_on_stream_removed);
+}
+
 void RtcWorker::stop() {
-    _notify(RtcWorker::QUIT);
+    notify(RtcWorker::QUIT);
 }
 
-int RtcWorker::_notify(int msg) {
-    int writen = write(notify_send_fd_, &msg, sizeof(int));
-    return writen == sizeof(int) ? 0 : -1;
+int RtcWorker::notify(int msg) {
+    return notifier_->notify(msg);
 }
 
 void RtcWorker::_process_rtc_msg() {
+    // 一次唤醒处理队列中所有的消息
     std::shared_ptr<RtcMsg> msg;
-    if (!_pop_msg(&msg)) {
-        return;
+    while (_pop_msg(&msg)) {
+        _process_one_rtc_msg(msg);
     }
+}
 
+void RtcWorker::_process_one_rtc_msg(std::shared_ptr<RtcMsg> msg) {
     RTC_LOG(LS_INFO) << "cmdno["<< msg->cmdno 
             << "] uid[" << msg->uid 
             << "] stream_name[" << msg->stream_name 
@@ -86,6 +213,11 @@ void RtcWorker::_process_rtc_msg() {
             << "] video[" << msg->video
             << "] rtc worker receive msg, worker id:" << worker_id_;
 
+    // 流已经迁移到其它worker，迁移之前路由到这里的消息转发过去
+    if (server_ && server_->forward_rtc_msg(worker_id_, msg)) {
+        return;
+    }
+
     switch (msg->cmdno) {
         case CMDNO_PUSH:
             _process_push(msg);
@@ -99,6 +231,12 @@ void RtcWorker::_process_rtc_msg() {
         case CMDNO_STOPPULL:
             _process_stop_pull(msg);
             break;
+        case CMDNO_MIGRATE_OUT:
+            _process_migrate_out(msg);
+            break;
+        case CMDNO_MIGRATE_IN:
+            _process_migrate_in(msg);
+            break;
         default:
             RTC_LOG(LS_WARNING) << "unknown cmdno: " << msg->cmdno << ", log_id: " << msg->log_id;
             break;
@@ -113,6 +251,9 @@ void RtcWorker::process_notify(int msg) {
         case RTC_MSG:
             _process_rtc_msg();
             break;
+        case RELAY_MSG:
+            rtc_stream_manager_->process_relay_packets();
+            break;
         default:
             RTC_LOG(LS_WARNING) << "unknown msg:" << msg << ", worker_id:" << worker_id_;
             break;
@@ -125,12 +266,9 @@ void RtcWorker::_quit() {
         return;
     }
 
-    el_->delete_io_event(pipe_wather_);
+    // 其它线程可能还会通知，eventfd在析构时才关闭
     el_->stop();
 
-    close(notify_recv_fd_);
-    close(notify_send_fd_);
-
     RTC_LOG(LS_INFO) << "rtc worker quit, worker_id:" << worker_id_;
 }
 
@@ -140,17 +278,22 @@ void RtcWorker::join() {
     }
 }
 
-void RtcWorker::_push_msg(std::shared_ptr<RtcMsg> msg) {
-    q_msg_.produce(msg);
+bool RtcWorker::_push_msg(std::shared_ptr<RtcMsg> msg) {
+    return q_msg_.push(msg);
 }
 
 bool RtcWorker::_pop_msg(std::shared_ptr<RtcMsg> *msg) {
-    return q_msg_.consume(msg);
+    return q_msg_.pop(msg);
 }
 
 int RtcWorker::send_rtc_msg(std::shared_ptr<RtcMsg> msg) {
-    _push_msg(msg);
-    return _notify(RtcWorker::RTC_MSG);
+    if (!_push_msg(msg)) {
+        RTC_LOG(LS_WARNING) << "rtc worker msg queue full, cmdno: " << msg->cmdno
+            << ", uid: " << msg->uid << ", worker_id:" << worker_id_;
+        return -1;
+    }
+
+    return notify(RtcWorker::RTC_MSG);
 }
 
 void RtcWorker::_process_push(std::shared_ptr<RtcMsg> msg) {
@@ -158,6 +301,9 @@ void RtcWorker::_process_push(std::shared_ptr<RtcMsg> msg) {
 
     std::string answer;
     int ret = rtc_stream_manager_->create_push_stream(msg, answer);
+    if (server_) {
+        server_->placement_done(msg);
+    }
     
     RTC_LOG(LS_INFO) << "push answer: " << answer;
 
@@ -176,6 +322,9 @@ void RtcWorker::_process_push(std::shared_ptr<RtcMsg> msg) {
 void RtcWorker::_process_pull(std::shared_ptr<RtcMsg> msg) {
     std::string answer;
     int ret = rtc_stream_manager_->create_pull_stream(msg, answer);
+    if (server_) {
+        server_->placement_done(msg);
+    }
     
     RTC_LOG(LS_INFO) << "pull answer: " << answer;
 
@@ -192,23 +341,106 @@ void RtcWorker::_process_pull(std::shared_ptr<RtcMsg> msg) {
 }
 
 void RtcWorker::_process_stop_push(std::shared_ptr<RtcMsg> msg) {
-    int ret = rtc_stream_manager_->stop_push(msg->uid, msg->stream_name);
+    int ret = rtc_stream_manager_->stop_push(msg->uid, msg->stream_name, msg->session_token);
     
     RTC_LOG(LS_INFO) << "rtc worker process stop push, uid: " << msg->uid
         << ", stream_name: " << msg->stream_name
         << ", worker_id: " << worker_id_
         << ", log_id: " << msg->log_id
         << ", ret: " << ret;
+
+    // 只有WHIP/WHEP的DELETE请求需要等待处理结果
+    if (ret != 0) {
+        msg->err_no = -1;
+    }
+
+    SignalingWorker *worker = (SignalingWorker*)(msg->worker);
+    if (worker) {
+        worker->send_rtc_msg(msg);
+    }
 }
 
 void RtcWorker::_process_stop_pull(std::shared_ptr<RtcMsg> msg) {
-    int ret = rtc_stream_manager_->stop_pull(msg->uid, msg->stream_name);
+    int ret = rtc_stream_manager_->stop_pull(msg->uid, msg->stream_name, msg->session_token);
     
     RTC_LOG(LS_INFO) << "rtc worker process stop pull, uid: " << msg->uid
         << ", stream_name: " << msg->stream_name
         << ", worker_id: " << worker_id_
         << ", log_id: " << msg->log_id
         << ", ret: " << ret;
+
+    // 只有WHIP/WHEP的DELETE请求需要等待处理结果
+    if (ret != 0) {
+        msg->err_no = -1;
+    }
+
+    SignalingWorker *worker = (SignalingWorker*)(msg->worker);
+    if (worker) {
+        worker->send_rtc_msg(msg);
+    }
+}
+
+void RtcWorker::_process_migrate_out(std::shared_ptr<RtcMsg> msg) {
+    std::shared_ptr<RtcWorker> dst_worker = server_ ? server_->get_worker(msg->dst_worker) : nullptr;
+    if (!dst_worker || dst_worker.get() == this) {
+        RTC_LOG(LS_WARNING) << "invalid migrate dst worker: " << msg->dst_worker
+            << ", stream_name: " << msg->stream_name << ", worker_id: " << worker_id_;
+        return;
+    }
+
+    StreamMigration* migration = new StreamMigration();
+    if (rtc_stream_manager_->detach_stream(msg->stream_name, migration) != 0) {
+        delete migration;
+        return;
+    }
+
+    // 投递之后会话归目标worker所有，路由信息需要在投递之前取出
+    std::vector<std::string> keys;
+    keys.push_back(server_->placement_key(false, msg->stream_name, 0));
+    for (auto pull_stream : migration->pull_streams) {
+        keys.push_back(server_->placement_key(true, msg->stream_name, pull_stream->get_uid()));
+    }
+
+    msg->cmdno = CMDNO_MIGRATE_IN;
+    msg->migration = migration;
+    if (dst_worker->send_rtc_msg(msg) != 0) {
+        RTC_LOG(LS_WARNING) << "migrate stream failed, stream_name: " << msg->stream_name
+            << ", dst_worker: " << msg->dst_worker << ", worker_id: " << worker_id_;
+        rtc_stream_manager_->attach_stream(migration);
+        delete migration;
+        return;
+    }
+
+    // 之后路由到本worker的消息会被转发到目标worker，排在迁移消息之后
+    server_->move_placement(keys, worker_id_, msg->dst_worker);
+
+    RTC_LOG(LS_INFO) << "migrate stream out, stream_name: " << msg->stream_name
+        << ", dst_worker: " << msg->dst_worker << ", worker_id: " << worker_id_;
+}
+
+void RtcWorker::_process_migrate_in(std::shared_ptr<RtcMsg> msg) {
+    StreamMigration* migration = (StreamMigration*)(msg->migration);
+    if (!migration) {
+        return;
+    }
+
+    rtc_stream_manager_->attach_stream(migration);
+    msg->migration = nullptr;
+    delete migration;
+}
+
+void RtcWorker::_on_stream_created(RtcStream* stream) {
+    if (server_) {
+        bool pull = stream->stream_type() == RtcStreamType::k_pull;
+        server_->placement_add(server_->placement_key(pull, stream->get_stream_name(), stream->get_uid()), !pull);
+    }
+}
+
+void RtcWorker::_on_stream_removed(RtcStream* stream) {
+    if (server_) {
+        bool pull = stream->stream_type() == RtcStreamType::k_pull;
+        server_->placement_remove(server_->placement_key(pull, stream->get_stream_name(), stream->get_uid()), !pull);
+    }
 }
 
 } // namespace xrtc
@@ -9,59 +9,96 @@
 
 #include <memory>
 #include <thread>
+#include <atomic>
+#include <vector>
+
+#include <rtc_base/third_party/sigslot/sigslot.h>
 
 #include "server/rtc_server.h"
 #include "xrtcserver_def.h"
-#include "base/lock_free_queue.h"
+#include "base/latency_histogram.h"
+#include "base/mpsc_ring.h"
 #include "server/settings.h"
 
 namespace xrtc {
 
 class EventLoop;
-class IOWatcher;
+class EventNotifier;
+class TimerWatcher;
+class RtcStream;
 class RtcStreamManager;
+class StreamRelay;
 
-class RtcWorker {
+class RtcWorker : public sigslot::has_slots<> {
 public:
     enum {
         QUIT = 0,
         RTC_MSG = 1,
+        RELAY_MSG = 2,
     };
 
-    explicit RtcWorker(int worker_id, const RtcServerOptions& options);
+    RtcWorker(int worker_id, const RtcServerOptions& options, RtcServer* server = nullptr,
+            StreamRelay* relay = nullptr);
     ~RtcWorker();
 
 public:
     int init();
     bool start();
     void stop();
+    int notify(int msg);
     void process_notify(int msg);
     void join();
     int send_rtc_msg(std::shared_ptr<RtcMsg> msg);
+    void update_load();
+
+    // 负载统计，worker线程每秒更新一次，其它线程可以读取
+    uint32_t busy_permille() { return busy_permille_.load(std::memory_order_relaxed); }
+    uint32_t forwarded_pps() { return forwarded_pps_.load(std::memory_order_relaxed); }
 
 private:
+    void _bind_cpu();
+    void _create_stream_manager();
+    void _log_loop_latency();
     void _quit();
-    int _notify(int msg);
-    void _push_msg(std::shared_ptr<RtcMsg> msg);
+    bool _push_msg(std::shared_ptr<RtcMsg> msg);
     bool _pop_msg(std::shared_ptr<RtcMsg> *msg);
     void _process_rtc_msg();
+    void _process_one_rtc_msg(std::shared_ptr<RtcMsg> msg);
     void _process_push(std::shared_ptr<RtcMsg> msg);
     void _process_pull(std::shared_ptr<RtcMsg> msg);
     void _process_stop_push(std::shared_ptr<RtcMsg> msg);
     void _process_stop_pull(std::shared_ptr<RtcMsg> msg);
+    void _process_migrate_out(std::shared_ptr<RtcMsg> msg);
+    void _process_migrate_in(std::shared_ptr<RtcMsg> msg);
+    void _on_stream_created(RtcStream* stream);
+    void _on_stream_removed(RtcStream* stream);
 
 private:
     int worker_id_;
     RtcServerOptions options_;
+    RtcServer *server_ = nullptr;
     EventLoop *el_ = nullptr;
-
-    IOWatcher *pipe_wather_ = nullptr;
-    int notify_recv_fd_ = -1;
-    int notify_send_fd_ = -1;
+    std::unique_ptr<EventNotifier> notifier_;
 
     std::unique_ptr<std::thread> thread_;
-    LockFreeQueue<std::shared_ptr<RtcMsg>> q_msg_;
+    // 所有SignalingWorker写入，worker线程读取
+    MpscRing<std::shared_ptr<RtcMsg>> q_msg_;
+    StreamRelay* relay_ = nullptr;
+    // 在worker线程中创建
     std::unique_ptr<RtcStreamManager> rtc_stream_manager_;
+
+    TimerWatcher *load_timer_ = nullptr;
+    uint64_t last_load_time_ = 0;
+    uint64_t last_busy_usec_ = 0;
+    uint64_t last_forwarded_packets_ = 0;
+    std::atomic<uint32_t> busy_permille_{0};
+    std::atomic<uint32_t> forwarded_pps_{0};
+    // 上一次输出事件循环和转发耗时分布时的累计值
+    LatencyHistogram last_iteration_histogram_;
+    LatencyHistogram last_forward_latency_;
+    uint64_t last_log_time_ = 0;
+    uint64_t last_upstream_rtcp_packets_ = 0;
+    uint32_t load_updates_ = 0;
 };
 
 } // end namespace xrtc
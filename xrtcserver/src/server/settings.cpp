@@ -22,14 +22,40 @@ bool Settings::Init(const char *confPath) {
 
         ice_conf_.ice_min_port = config["ice"]["min_port"].as<int>();
         ice_conf_.ice_max_port = config["ice"]["max_port"].as<int>();
+        ice_conf_.shared_port = config["ice"]["shared_port"].as<int>(0);
+        ice_conf_.socket_pool_size = config["ice"]["socket_pool_size"].as<int>(0);
 
         signaling_server_options_.host_ip = config["signaling"]["host_ip"].as<std::string>();
         signaling_server_options_.port = config["signaling"]["port"].as<int>();
         signaling_server_options_.worker_num = config["signaling"]["worker_num"].as<int>(); 
         signaling_server_options_.connection_timeout = config["signaling"]["connection_timeout"].as<int>();
+        signaling_server_options_.reuse_port = config["signaling"]["reuse_port"].as<bool>(false);
+        signaling_server_options_.worker_cpus = config["signaling"]["worker_cpus"].as<std::vector<int>>(
+                std::vector<int>());
+        signaling_server_options_.http_port = config["signaling"]["http_port"].as<int>(0);
 
         rtc_server_options_.worker_num = config["rtc"]["worker_num"].as<int>();
         rtc_server_options_.candidate_ip = config["rtc"]["candidate_ip"].as<std::string>();
+        rtc_server_options_.cross_worker_fanout = config["rtc"]["cross_worker_fanout"].as<bool>(false);
+        rtc_server_options_.udp_gro = config["rtc"]["udp_gro"].as<bool>(false);
+        rtc_server_options_.udp_send_batch = config["rtc"]["udp_send_batch"].as<bool>(false);
+        rtc_server_options_.udp_gso = config["rtc"]["udp_gso"].as<bool>(false);
+        rtc_server_options_.io_backend = config["rtc"]["io_backend"].as<std::string>("libev");
+        rtc_server_options_.rebalance_busy_diff = config["rtc"]["rebalance_busy_diff"].as<int>(0);
+        rtc_server_options_.worker_cpus = config["rtc"]["worker_cpus"].as<std::vector<int>>(
+                std::vector<int>());
+        rtc_server_options_.udp_incoming_cpu = config["rtc"]["udp_incoming_cpu"].as<bool>(false);
+        rtc_server_options_.nack_history_size = config["rtc"]["nack_history_size"].as<int>(1024);
+        rtc_server_options_.nack_rtx = config["rtc"]["nack_rtx"].as<bool>(false);
+        rtc_server_options_.keyframe_cache = config["rtc"]["keyframe_cache"].as<bool>(true);
+        rtc_server_options_.keyframe_request_interval =
+            config["rtc"]["keyframe_request_interval"].as<int>(500);
+        rtc_server_options_.rtcp_termination = config["rtc"]["rtcp_termination"].as<bool>(true);
+        rtc_server_options_.pacing = config["rtc"]["pacing"].as<bool>(false);
+        rtc_server_options_.pacing_start_bitrate = config["rtc"]["pacing_start_bitrate"].as<int>(1500);
+        rtc_server_options_.pacing_max_bitrate = config["rtc"]["pacing_max_bitrate"].as<int>(10000);
+        rtc_server_options_.pacing_packets_per_iteration =
+            config["rtc"]["pacing_packets_per_iteration"].as<int>(1024);
 
     } catch (YAML::Exception e) {
         fprintf(stderr, "catch a YAML::Exception, line: %d, column: %d"
@@ -8,6 +8,7 @@
 #define __SERVER_SETTINGS_H_
 
 #include <string>
+#include <vector>
 
 #include "base/utils.h"
 
@@ -23,11 +24,51 @@ typedef struct LogConf {
 struct IceConf {
     int ice_min_port = 0;
     int ice_max_port = 0;
+    // 大于0时每个worker只监听一个UDP端口: shared_port + worker_id
+    int shared_port = 0;
+    // 每个网络接口预先绑定的socket数量，0表示不使用
+    int socket_pool_size = 0;
 };
 
 struct RtcServerOptions {
     std::string candidate_ip; 
     int worker_num = 2;
+    // 拉流者按stream_name+uid分散到所有worker，推流包通过StreamRelay跨worker分发
+    bool cross_worker_fanout = false;
+    // UDP socket开启UDP_GRO
+    bool udp_gro = false;
+    // 发送的包在本轮事件循环结束前用sendmmsg批量发送
+    bool udp_send_batch = false;
+    // 批量发送时对发往同一地址的包使用UDP_SEGMENT
+    bool udp_gso = false;
+    // worker的UDP收发方式: libev或io_uring，io_uring不可用时回退到libev
+    std::string io_backend = "libev";
+    // 最忙和最闲的worker繁忙度(千分比)相差超过该值时，把一路流迁移到最闲的worker，0表示不自动迁移
+    int rebalance_busy_diff = 0;
+    // worker i绑定到worker_cpus[i % size]，并优先使用该核所在NUMA节点的内存，为空表示不绑核
+    std::vector<int> worker_cpus;
+    // 绑核时worker的UDP socket设置SO_INCOMING_CPU为绑定的核
+    bool udp_incoming_cpu = false;
+    // 每路推流缓存的最近视频包个数，订阅者的NACK由服务端直接重传，0表示把NACK转发给推流者
+    int nack_history_size = 1024;
+    // 重传时按订阅者协商的RTX封装，否则按原始ssrc和序号重传
+    bool nack_rtx = false;
+    // 新的拉流者连接后立即发送推流最近一个完整的H264关键帧
+    bool keyframe_cache = true;
+    // 订阅者的PLI/FIR在服务端合并，该时间(毫秒)内最多向推流者转发一次，
+    // 期间已经收到过关键帧时不再转发，0表示原样转发
+    int keyframe_request_interval = 500;
+    // RTCP在服务端分段终结：订阅者收到服务端生成的SR，推流者只收到服务端的RR/NACK
+    // 和合并后的反馈，false表示原样转发两个方向的RTCP
+    bool rtcp_termination = true;
+    // 发给每个拉流者的包经过pacer按带宽估计平滑发送，带宽估计从pacing_start_bitrate(kbps)开始，
+    // 按拉流者RR的丢包率调整，不超过pacing_max_bitrate(kbps)
+    bool pacing = false;
+    int pacing_start_bitrate = 1500;
+    int pacing_max_bitrate = 10000;
+    // 每个worker每轮事件循环最多发送的pacing包数，关键帧扇出给大量拉流者时剩下的包
+    // 按拉流者轮转分散到后面的tick发送，限制一次回调写入内核的包数和事件循环的卡顿时间
+    int pacing_packets_per_iteration = 1024;
 };
 
 struct SignalingServerOptions {
@@ -35,6 +76,12 @@ struct SignalingServerOptions {
     int port = 9000;
     int worker_num = 2;
     int connection_timeout = 5000; // 单位毫秒
+    // 每个worker创建自己的SO_REUSEPORT监听socket并直接accept，不再由SignalingServer分发
+    bool reuse_port = false;
+    // worker i绑定到worker_cpus[i % size]，为空表示不绑核
+    std::vector<int> worker_cpus;
+    // 大于0时每个worker在该端口(SO_REUSEPORT)直接处理WHIP/WHEP的HTTP请求
+    int http_port = 0;
 };
 
 class Settings {
@@ -60,6 +107,14 @@ public:
         return ice_conf_.ice_max_port;
     }
 
+    int IceSharedPort() const {
+        return ice_conf_.shared_port;
+    }
+
+    int IceSocketPoolSize() const {
+        return ice_conf_.socket_pool_size;
+    }
+
     SignalingServerOptions GetSignalingServerOptions() {
         return signaling_server_options_;
     }
@@ -68,10 +123,27 @@ public:
         return rtc_server_options_.candidate_ip;
     }
 
+    bool UdpGro() const {
+        return rtc_server_options_.udp_gro;
+    }
+
+    bool UdpSendBatch() const {
+        return rtc_server_options_.udp_send_batch;
+    }
+
+    bool UdpGso() const {
+        return rtc_server_options_.udp_gso;
+    }
+
     RtcServerOptions GetRtcServerOptions() {
         return rtc_server_options_;
     }
 
+    // 测试用例修改rtc选项，需要在创建RtcStreamManager之前调用
+    void SetRtcServerOptions(const RtcServerOptions& options) {
+        rtc_server_options_ = options;
+    }
+
 private:
     std::string conf_path_;
 
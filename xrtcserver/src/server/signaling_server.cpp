@@ -5,6 +5,7 @@
 
 #include "base/socket.h"
 #include "base/event_loop.h"
+#include "base/event_notifier.h"
 #include "server/signaling_server.h"
 #include "server/signaling_worker.h"
 
@@ -26,12 +27,7 @@ static void accept_new_conn(EventLoop * /*el*/, IOWatcher * /*w*/, int fd, int /
     server->dispatch_new_conn(cfd);
 }
 
-static void signaling_server_recv_notify(EventLoop * /*el*/, IOWatcher */*w*/, int fd, int /*event*/, void *data) {
-    int msg = -1;
-    if (read(fd, &msg, sizeof(int)) != sizeof(int)) {
-        RTC_LOG(LS_WARNING) << "read from pipe errror: " << strerror(errno) << ", errno: " << errno;
-        return;
-    }
+static void signaling_server_recv_notify(EventLoop * /*el*/, int msg, void *data) {
     SignalingServer *server = (SignalingServer*)data;
     server->process_notify(msg);
 }
@@ -48,31 +44,26 @@ SignalingServer::~SignalingServer() {
 int SignalingServer::init(const SignalingServerOptions& options) {
     options_ = options;
 
-    // 创建管道，用于线程间通信
-    int fds[2];
-    if (pipe(fds) == -1) {
-        RTC_LOG(LS_ERROR) << "create pipe error: " << strerror(errno) << ", errno: " << errno;
+    // 线程间通知
+    notifier_ = std::make_unique<EventNotifier>(el_.get(), signaling_server_recv_notify, this);
+    if (notifier_->init() != 0) {
         return -1;
     }
 
-    notify_recv_fd_ = fds[0];
-    notify_send_fd_ = fds[1];
-
-    // 将recv_fd添加到事件循环，进行管理
-    pipe_wather_ = el_->create_io_event(signaling_server_recv_notify, this);
-    el_->start_io_event(pipe_wather_, notify_recv_fd_, EventLoop::READ);
+    // reuse_port时每个worker自己监听和accept
+    if (!options_.reuse_port) {
+        // 创建tcp server
+        listen_fd_ = create_tcp_server(options_.host_ip.c_str(), options_.port);
+        if (listen_fd_ == -1) {
+            RTC_LOG(LS_ERROR) << "create tcp server failed";
+            return -1;
+        }
 
-    // 创建tcp server
-    listen_fd_ = create_tcp_server(options_.host_ip.c_str(), options_.port);
-    if (listen_fd_ == -1) {
-        RTC_LOG(LS_ERROR) << "create tcp server failed";
-        return -1;
+        // 创建并启动io事件监听
+        io_watcher_ = el_->create_io_event(accept_new_conn, this);
+        el_->start_io_event(io_watcher_, listen_fd_, xrtc::EventLoop::READ);
     }
 
-    // 创建并启动io事件监听
-    io_watcher_ = el_->create_io_event(accept_new_conn, this);
-    el_->start_io_event(io_watcher_, listen_fd_, xrtc::EventLoop::READ);
-
     // 创建worker
     for (int i = 0; i < options_.worker_num; ++i) {
         if (_create_worker(i) != 0) {
@@ -89,6 +80,11 @@ bool SignalingServer::start() {
         return false;
     }
 
+    // reuse_port和WHIP/WHEP的监听在worker中，RTC服务启动之后才开始accept
+    for (auto worker : workers_) {
+        worker->start_accept();
+    }
+
     thread_ = std::make_unique<std::thread>([=] {
         RTC_LOG(LS_INFO) << "signaling server event loop run";
         el_->start();
@@ -103,8 +99,7 @@ void SignalingServer::stop() {
 }
 
 int SignalingServer::notify(int msg) {
-    int writen = write(notify_send_fd_, &msg, sizeof(int));
-    return writen == sizeof(int) ? 0 : -1;
+    return notifier_->notify(msg);
 }
 
 void SignalingServer::process_notify(int msg) {
@@ -124,13 +119,16 @@ void SignalingServer::_quit() {
         return;
     }
 
-    el_->delete_io_event(pipe_wather_);
-    el_->delete_io_event(io_watcher_);
+    if (io_watcher_) {
+        el_->delete_io_event(io_watcher_);
+        io_watcher_ = nullptr;
+    }
     el_->stop();
 
-    close(notify_recv_fd_);
-    close(notify_send_fd_);
-    close(listen_fd_);
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
 
     for (auto worker : workers_) {
         if (worker) {
@@ -18,6 +18,7 @@ namespace xrtc {
 
 class EventLoop;
 class IOWatcher;
+class EventNotifier;
 class SignalingWorker;
 
 class SignalingServer {
@@ -47,10 +48,7 @@ private:
     SignalingServerOptions options_;
     std::unique_ptr<EventLoop> el_;
     IOWatcher *io_watcher_ = nullptr;
-
-    IOWatcher *pipe_wather_ = nullptr;
-    int notify_recv_fd_ = -1;
-    int notify_send_fd_ = -1;
+    std::unique_ptr<EventNotifier> notifier_;
 
     std::unique_ptr<std::thread> thread_;
 
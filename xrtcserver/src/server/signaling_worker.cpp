@@ -1,12 +1,22 @@
 #include <unistd.h>
+#include <string.h>
+#include <sys/uio.h>
 
+#include <ostream>
+#include <streambuf>
+
+#include <absl/strings/match.h>
+#include <absl/strings/string_view.h>
+#include <rtc_base/helpers.h>
 #include <rtc_base/logging.h>
-#include <rtc_base/zmalloc.h>
 
 #include "xrtcserver_def.h"
+#include "base/cpu_affinity.h"
 #include "base/event_loop.h"
+#include "base/event_notifier.h"
 #include "base/socket.h"
 #include "base/xhead.h"
+#include "server/http_request.h"
 #include "server/signaling_worker.h"
 #include "server/tcp_connection.h"
 #include "server/rtc_server.h"
@@ -15,20 +25,77 @@ extern xrtc::RtcServer *g_rtc_server;
 
 namespace xrtc {
 
-static void signaling_worker_recv_notify(EventLoop * /*el*/, IOWatcher */*w*/, int fd, int /*event*/, void *data) {
-    int msg = -1;
-    if (read(fd, &msg, sizeof(int)) != sizeof(int)) {
-        RTC_LOG(LS_WARNING) << "read from pipe errror: " << strerror(errno) << ", errno: " << errno;
-        return;
+const size_t k_conn_queue_size = 1024;
+const size_t k_rtc_msg_queue_size = 4096;
+const unsigned int k_conn_sweep_interval_usec = 100 * 1000; // 100ms
+const int k_max_accept_per_event = 64;
+const size_t k_min_read_len = 16 * 1024;
+const uint32_t k_max_request_body_len = 1024 * 1024;
+const size_t k_max_free_replies = 1024;
+const size_t k_max_pooled_body_len = 64 * 1024;
+const int k_max_reply_iov = 64;
+const char k_whip_prefix[] = "/whip/";
+const char k_whep_prefix[] = "/whep/";
+
+// 服务端分配的uid是随机的，并且大于客户端通过?uid=可以指定的范围，两者不会冲突
+const uint64_t k_http_uid_flag = 1ull << 62;
+const uint64_t k_http_uid_mask = k_http_uid_flag - 1;
+// Location中的会话令牌，128位随机数
+const size_t k_session_token_len = 32;
+const char k_session_token_chars[] = "0123456789abcdef";
+
+// 把jsoncpp的输出直接追加到std::string
+class StringAppendBuf : public std::streambuf {
+public:
+    explicit StringAppendBuf(std::string *str) : str_(str) {}
+
+protected:
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+        str_->append(s, n);
+        return n;
+    }
+
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            str_->push_back(traits_type::to_char_type(c));
+        }
+        return c;
     }
+
+private:
+    std::string *str_;
+};
+
+static void signaling_worker_recv_notify(EventLoop * /*el*/, int msg, void *data) {
     SignalingWorker *server = (SignalingWorker*)data;
     server->process_notify(msg);
 }
 
+static void worker_accept_cb(EventLoop * /*el*/, IOWatcher * /*w*/, int fd, int /*event*/, void *data) {
+    SignalingWorker *worker = (SignalingWorker*)data;
+    worker->accept_new_conn(fd, TcpConnection::TYPE_XHEAD);
+}
+
+static void worker_http_accept_cb(EventLoop * /*el*/, IOWatcher * /*w*/, int fd, int /*event*/, void *data) {
+    SignalingWorker *worker = (SignalingWorker*)data;
+    worker->accept_new_conn(fd, TcpConnection::TYPE_HTTP);
+}
+
+static void conn_sweep_cb(EventLoop * /*el*/, TimerWatcher * /*w*/, void *data) {
+    SignalingWorker *worker = (SignalingWorker*)data;
+    worker->sweep_idle_connections();
+}
+
 SignalingWorker::SignalingWorker(int worker_id, const SignalingServerOptions& options) :
     worker_id_(worker_id),
     options_(options),
-    el_(std::make_unique<xrtc::EventLoop>(this)) {
+    el_(std::make_unique<xrtc::EventLoop>(this)),
+    q_conn_(k_conn_queue_size),
+    q_msg_(k_rtc_msg_queue_size)
+{
+    Json::StreamWriterBuilder write_builder;
+    write_builder.settings_["indentation"] = ""; // 设置默认无格式化的输出
+    json_writer_.reset(write_builder.newStreamWriter());
 }
 
 SignalingWorker::~SignalingWorker() {
@@ -41,20 +108,81 @@ SignalingWorker::~SignalingWorker() {
 
     conns_.clear();
     conns_.shrink_to_fit();
+
+    for (auto reply : free_replies_) {
+        delete reply;
+    }
+    free_replies_.clear();
+
+    if (sweep_timer_) {
+        el_->delete_timer(sweep_timer_);
+        sweep_timer_ = nullptr;
+    }
+
+    if (accept_watcher_) {
+        el_->delete_io_event(accept_watcher_);
+        accept_watcher_ = nullptr;
+    }
+
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+
+    if (http_accept_watcher_) {
+        el_->delete_io_event(http_accept_watcher_);
+        http_accept_watcher_ = nullptr;
+    }
+
+    if (http_listen_fd_ >= 0) {
+        close(http_listen_fd_);
+        http_listen_fd_ = -1;
+    }
 }
 
 int SignalingWorker::init() {
-    int fds[2];
-    if (pipe(fds) == -1) {
-        RTC_LOG(LS_ERROR) << "create pipe error: " << strerror(errno) << ", errno: " << errno << ", worker_id:" << worker_id_;
+    notifier_ = std::make_unique<EventNotifier>(el_.get(), signaling_worker_recv_notify, this);
+    if (notifier_->init() != 0) {
+        RTC_LOG(LS_ERROR) << "create notifier error, worker_id:" << worker_id_;
         return -1;
     }
 
-    notify_recv_fd_ = fds[0];
-    notify_send_fd_ = fds[1];
+    if (options_.reuse_port) {
+        listen_fd_ = create_tcp_server(options_.host_ip.c_str(), options_.port, true);
+        if (-1 == listen_fd_) {
+            RTC_LOG(LS_ERROR) << "create tcp server failed, worker_id:" << worker_id_;
+            return -1;
+        }
+
+        sock_setnoblock(listen_fd_);
+
+        // 绑核时让内核把该核上收到的连接优先交给本worker
+        int cpu = select_worker_cpu(options_.worker_cpus, worker_id_);
+        if (cpu >= 0) {
+            sock_set_incoming_cpu(listen_fd_, cpu);
+        }
+
+        // 监听在这里创建，端口冲突时初始化失败；收到START_ACCEPT之后才开始accept，
+        // 在此之前到达的连接留在内核的accept队列中
+        accept_watcher_ = el_->create_io_event(worker_accept_cb, this);
+    }
+
+    // WHIP/WHEP总是由每个worker自己监听，不经过SignalingServer分发
+    if (options_.http_port > 0) {
+        http_listen_fd_ = create_tcp_server(options_.host_ip.c_str(), options_.http_port, true);
+        if (-1 == http_listen_fd_) {
+            RTC_LOG(LS_ERROR) << "create http server failed, worker_id:" << worker_id_;
+            return -1;
+        }
+
+        sock_setnoblock(http_listen_fd_);
 
-    pipe_wather_ = el_->create_io_event(signaling_worker_recv_notify, this);
-    el_->start_io_event(pipe_wather_, notify_recv_fd_, EventLoop::READ);
+        http_accept_watcher_ = el_->create_io_event(worker_http_accept_cb, this);
+    }
+
+    // 所有连接共用一个定时器检查超时
+    sweep_timer_ = el_->create_timer(conn_sweep_cb, this, true);
+    el_->start_timer(sweep_timer_, k_conn_sweep_interval_usec);
 
     return 0;
 }
@@ -66,6 +194,7 @@ bool SignalingWorker::start() {
     }
 
     thread_ = std::make_unique<std::thread>([=] {
+        _bind_cpu();
         RTC_LOG(LS_INFO) << "signaling worker event loop start, worker_id:" << worker_id_;
         el_->start();
         RTC_LOG(LS_INFO) << "signaling worker event loop stop, worker_id:" << worker_id_;
@@ -74,13 +203,49 @@ bool SignalingWorker::start() {
     return true;
 }
 
+void SignalingWorker::_bind_cpu() {
+    int cpu = select_worker_cpu(options_.worker_cpus, worker_id_);
+    if (cpu < 0) {
+        return;
+    }
+
+    if (bind_thread_to_cpu(cpu) != 0) {
+        RTC_LOG(LS_WARNING) << "signaling worker bind cpu failed, worker_id:" << worker_id_
+            << ", cpu: " << cpu;
+        return;
+    }
+
+    int node = get_cpu_numa_node(cpu);
+    if (node >= 0) {
+        set_preferred_numa_node(node);
+    }
+
+    RTC_LOG(LS_INFO) << "signaling worker bind cpu, worker_id:" << worker_id_
+        << ", cpu: " << cpu << ", numa node: " << node;
+}
+
 void SignalingWorker::stop() {
     _notify(SignalingWorker::QUIT);
 }
 
+int SignalingWorker::start_accept() {
+    return _notify(SignalingWorker::START_ACCEPT);
+}
+
+void SignalingWorker::_start_accept() {
+    if (accept_watcher_) {
+        el_->start_io_event(accept_watcher_, listen_fd_, EventLoop::READ);
+    }
+
+    if (http_accept_watcher_) {
+        el_->start_io_event(http_accept_watcher_, http_listen_fd_, EventLoop::READ);
+    }
+
+    RTC_LOG(LS_INFO) << "signaling worker start accept, worker_id:" << worker_id_;
+}
+
 int SignalingWorker::_notify(int msg) {
-    int writen = write(notify_send_fd_, &msg, sizeof(int));
-    return writen == sizeof(int) ? 0 : -1;
+    return notifier_->notify(msg);
 }
 
 void SignalingWorker::process_notify(int msg) {
@@ -90,13 +255,16 @@ void SignalingWorker::process_notify(int msg) {
             break;
         case NEW_CONN:
             int fd;
-            if (q_conn_.consume(&fd)) {
-                _handle_new_conn(fd);
+            while (q_conn_.pop(&fd)) {
+                _handle_new_conn(fd, TcpConnection::TYPE_XHEAD);
             }
             break;
         case RTC_MSG:
             _process_rtc_msg();
             break;
+        case START_ACCEPT:
+            _start_accept();
+            break;
         default:
             RTC_LOG(LS_WARNING) << "unknown msg:" << msg << ", worker_id:" << worker_id_;
             break;
@@ -109,11 +277,28 @@ void SignalingWorker::_quit() {
         return;
     }
 
-    el_->delete_io_event(pipe_wather_);
-    el_->stop();
+    if (accept_watcher_) {
+        el_->delete_io_event(accept_watcher_);
+        accept_watcher_ = nullptr;
+    }
 
-    close(notify_recv_fd_);
-    close(notify_send_fd_);
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+
+    if (http_accept_watcher_) {
+        el_->delete_io_event(http_accept_watcher_);
+        http_accept_watcher_ = nullptr;
+    }
+
+    if (http_listen_fd_ >= 0) {
+        close(http_listen_fd_);
+        http_listen_fd_ = -1;
+    }
+
+    // 其它线程可能还会通知，eventfd在析构时才关闭
+    el_->stop();
 
     RTC_LOG(LS_INFO) << "signaling worker quit, worker_id:" << worker_id_;
 }
@@ -126,7 +311,13 @@ void SignalingWorker::join() {
 
 void SignalingWorker::notify_new_conn(int fd) {
     RTC_LOG(LS_WARNING) << "notify_new_conn, worker_id:" << worker_id_;
-    q_conn_.produce(fd);
+    if (!q_conn_.push(fd)) {
+        RTC_LOG(LS_WARNING) << "signaling worker conn queue full, close fd: " << fd
+            << ", worker_id:" << worker_id_;
+        close(fd);
+        return;
+    }
+
     _notify(SignalingWorker::NEW_CONN);
 }
 
@@ -142,13 +333,23 @@ static void conn_io_cb(EventLoop * /*el*/, IOWatcher */*w*/, int fd, int event,
     }
 }
 
-static void conn_timer_cb(EventLoop *el, TimerWatcher * /*w*/, void *data) {
-    SignalingWorker *worker = (SignalingWorker*)el->owner();
-    TcpConnection *conn = (TcpConnection*)data;
-    worker->process_timeout(conn);
+void SignalingWorker::accept_new_conn(int listen_fd, int conn_type) {
+    // 监听socket是非阻塞的，一次事件尽量多accept一些连接
+    for (int i = 0; i < k_max_accept_per_event; ++i) {
+        char cip[128] = {0};
+        int cport = 0;
+        int cfd = tcp_accept(listen_fd, cip, &cport);
+        if (-1 == cfd) {
+            break;
+        }
+
+        RTC_LOG(LS_INFO) << "accept new conn, fd: " << cfd << ", ip: " << cip
+            << ", port: " << cport << ", type: " << conn_type << ", worker_id:" << worker_id_;
+        _handle_new_conn(cfd, conn_type);
+    }
 }
 
-void SignalingWorker::_handle_new_conn(int fd) {
+void SignalingWorker::_handle_new_conn(int fd, int conn_type) {
     RTC_LOG(LS_INFO) << "signaling worker: " << worker_id_ << ", receive new conn, fd: " << fd;
 
     if (fd < 0) {
@@ -159,17 +360,15 @@ void SignalingWorker::_handle_new_conn(int fd) {
     sock_setnoblock(fd);
     sock_setnodelay(fd);
 
-    TcpConnection *conn = new TcpConnection(fd);
+    TcpConnection *conn = new TcpConnection(fd, conn_type);
     sock_peer_to_str(fd, conn->ip, &(conn->port));
     conn->io_watcher = el_->create_io_event(conn_io_cb, this);
     el_->start_io_event(conn->io_watcher, fd, EventLoop::READ);
 
-    conn->timer_watcher = el_->create_timer(conn_timer_cb, conn, true);
-    el_->start_timer(conn->timer_watcher, 100000); // 100ms
-
     conn->last_interaction = el_->now();
+    conn->idle_it = idle_conns_.insert(idle_conns_.end(), conn);
 
-    if ((size_t)fd > conns_.size()) {
+    if ((size_t)fd >= conns_.size()) {
         conns_.resize(fd *2, nullptr);
     }
 
@@ -177,6 +376,12 @@ void SignalingWorker::_handle_new_conn(int fd) {
 
 }
 
+void SignalingWorker::_touch_connection(TcpConnection *conn) {
+    conn->last_interaction = el_->now();
+    // 移到链表尾部，链表始终按最后活跃时间有序
+    idle_conns_.splice(idle_conns_.end(), idle_conns_, conn->idle_it);
+}
+
 void SignalingWorker::read_query(int fd) {
     RTC_LOG(LS_INFO) << "signaling worker: " << worker_id_ << ", receive read event, fd: " << fd;
 
@@ -192,12 +397,16 @@ void SignalingWorker::read_query(int fd) {
     }
 
     int nread = 0;  // 实际读出来的数据大小
-    int read_len = conn->bytes_expected;  // 期待读取的数据大小
     int qb_len = sdslen(conn->querybuf);
+    // 至少读完当前请求，同时尽量把后面连续发送的请求一起读出来
+    size_t read_len = k_min_read_len;  // 期待读取的数据大小
+    if (conn->bytes_processed + conn->bytes_expected > (size_t)qb_len + read_len) {
+        read_len = conn->bytes_processed + conn->bytes_expected - qb_len;
+    }
     conn->querybuf = sdsMakeRoomFor(conn->querybuf, read_len);
     nread = sock_read_data(fd, conn->querybuf + qb_len, read_len);
 
-    conn->last_interaction = el_->now();
+    _touch_connection(conn);
 
     RTC_LOG(LS_INFO) << "sock read data, fd:" << fd << " , read len: " << nread;
 
@@ -208,7 +417,8 @@ void SignalingWorker::read_query(int fd) {
         sdsIncrLen(conn->querybuf, nread); // 调整sds字符串conn->querybuf中len和free的大小
     }
 
-    int ret = _process_query_buffer(conn);
+    int ret = (TcpConnection::TYPE_HTTP == conn->type) ?
+        _process_http_buffer(conn) : _process_query_buffer(conn);
     if (ret != 0) {
         _close_connection(conn);
         return;  
@@ -216,38 +426,52 @@ void SignalingWorker::read_query(int fd) {
 }
 
 int SignalingWorker::_process_query_buffer(TcpConnection *conn) {
+    // 一个连接上可以连续发送多个请求，bytes_processed是当前请求在querybuf中的起始位置，
+    // bytes_expected是当前状态下从起始位置开始需要的数据长度
     while (sdslen(conn->querybuf) >= conn->bytes_processed + conn->bytes_expected) {
-        xhead_t *head = (xhead_t*)(conn->querybuf);
+        xhead_t *head = (xhead_t*)(conn->querybuf + conn->bytes_processed);
         if (TcpConnection::STATE_HEAD == conn->current_state) {
             if (XHEAD_MAGIC_NUM != head->magic_num) {
                 RTC_LOG(LS_INFO) << "invalid data, fd:" << conn->fd;
                 return -1;
             }
 
+            if (head->body_len > k_max_request_body_len) {
+                RTC_LOG(LS_WARNING) << "request body too large, body_len: " << head->body_len
+                    << ", fd:" << conn->fd;
+                return -1;
+            }
+
             conn->current_state = TcpConnection::STATE_BODY;
-            conn->bytes_processed = XHEAD_SIZE;
-            conn->bytes_expected = head->body_len; // 下一个期待的接收大小就是包体大小了。
+            conn->bytes_expected = XHEAD_SIZE + head->body_len; // 包头加包体
         } else {
-            rtc::Slice header(conn->querybuf, XHEAD_SIZE);
-            rtc::Slice body(conn->querybuf + XHEAD_SIZE, head->body_len);
+            rtc::Slice header((char*)head, XHEAD_SIZE);
+            rtc::Slice body((char*)head + XHEAD_SIZE, head->body_len);
 
             int ret = _process_request(conn, header, body);
             if (ret != 0) {
                 return -1;
             }
 
-            // 后面的数据过来就不处理了，暂时是短连接处理
-            // 长连接的需要另外再处理。。
-            conn->bytes_processed = 65535;
-
+            // 重置状态机，继续解析下一个请求
+            conn->bytes_processed += conn->bytes_expected;
+            conn->current_state = TcpConnection::STATE_HEAD;
+            conn->bytes_expected = XHEAD_SIZE;
         }
     }
 
+    // 移除已经处理完的请求，不完整的请求移到缓冲区开头
+    if (conn->bytes_processed > 0) {
+        sdsrange(conn->querybuf, conn->bytes_processed, -1);
+        conn->bytes_processed = 0;
+    }
+
     return 0;
 }
 
 int SignalingWorker::_process_request(TcpConnection *conn, const rtc::Slice &header, const rtc::Slice &body) {
-    RTC_LOG(LS_INFO) << "receive body: " << body.data();
+    // body后面可能紧跟着下一个请求，不能当作字符串直接输出
+    RTC_LOG(LS_INFO) << "receive body: " << std::string(body.data(), body.size());
 
     xhead_t *xh = (xhead_t*)(header.data());
 
@@ -256,43 +480,45 @@ int SignalingWorker::_process_request(TcpConnection *conn, const rtc::Slice &hea
     Json::Value root;
     JSONCPP_STRING err;
     reader->parse(body.data(), body.data() + body.size(), &root, &err);
+
+    int ret = -1;
     if (!err.empty()) {
         RTC_LOG(LS_WARNING) << "parse json body error: " << err << ", fd:" << conn->fd << ", log id:" << xh->log_id;
-        return -1;
-    }
-
-    int cmdNo;
-    try {
-        cmdNo = root["cmdno"].asInt();
-    } catch (Json::Exception e) {
-        RTC_LOG(LS_WARNING) << "no cmdno field in body, log id:" << xh->log_id;
-        return -1;
-    }
-
-    int ret = 0;
-
-    switch (cmdNo) {
-        case CMDNO_PUSH:
-            return _process_push(cmdNo, conn, root, xh->log_id);
-        case CMDNO_PULL:
-            return _process_pull(cmdNo, conn, root, xh->log_id);
-        case CMDNO_STOPPUSH:
-            ret = _process_stop_push(cmdNo, conn, root, xh->log_id);
-            break;
-        case CMDNO_STOPPULL:
-            ret = _process_stop_pull(cmdNo, conn, root, xh->log_id);
-            break; 
-        default:
-            ret = -1;
-            RTC_LOG(LS_WARNING) << "unknown cmdno: " << cmdNo << ", log_id: " << xh->log_id;
-            break;
+    } else if (!root.isObject() || !root["cmdno"].isInt()) {
+        // 类型不对时jsoncpp会抛异常，先检查，只应答这个请求出错，不影响连接
+        RTC_LOG(LS_WARNING) << "no valid cmdno field in body, fd:" << conn->fd << ", log id:" << xh->log_id;
+    } else {
+        int cmdNo = root["cmdno"].asInt();
+        switch (cmdNo) {
+            case CMDNO_PUSH:
+                // 成功时由RtcWorker处理完之后再应答
+                ret = _process_push(cmdNo, conn, root, xh->id, xh->log_id);
+                if (0 == ret) {
+                    return 0;
+                }
+                break;
+            case CMDNO_PULL:
+                ret = _process_pull(cmdNo, conn, root, xh->id, xh->log_id);
+                if (0 == ret) {
+                    return 0;
+                }
+                break;
+            case CMDNO_STOPPUSH:
+                ret = _process_stop_push(cmdNo, conn, root, xh->log_id);
+                break;
+            case CMDNO_STOPPULL:
+                ret = _process_stop_pull(cmdNo, conn, root, xh->log_id);
+                break; 
+            case CMDNO_MIGRATE:
+                ret = _process_migrate(cmdNo, conn, root, xh->log_id);
+                break;
+            default:
+                RTC_LOG(LS_WARNING) << "unknown cmdno: " << cmdNo << ", log_id: " << xh->log_id;
+                break;
+        }
     }
 
-    // 返回处理结果
-    char* buf = (char*)zmalloc(XHEAD_SIZE + MAX_RES_BUF);
-    xhead_t* res_xh = (xhead_t*)buf;
-    memcpy(res_xh, header.data(), header.size());
-
+    // 返回处理结果，请求本身出错不影响连接上的其它请求
     Json::Value res_root;
     if (0 == ret) {
         res_root["err_no"] = 0;
@@ -302,18 +528,9 @@ int SignalingWorker::_process_request(TcpConnection *conn, const rtc::Slice &hea
         res_root["err_msg"] = "process error";
     }
 
-    Json::StreamWriterBuilder write_builder;
-    write_builder.settings_["indentation"] = "";
-    std::string json_data = Json::writeString(write_builder, res_root);
-    RTC_LOG(LS_INFO) << "response body: " << json_data;   
+    _send_reply(conn, xh->id, xh->log_id, res_root);
 
-    res_xh->body_len = json_data.size();
-    snprintf(buf + XHEAD_SIZE, MAX_RES_BUF, "%s", json_data.c_str());
-    
-    rtc::Slice reply(buf, XHEAD_SIZE + res_xh->body_len);
-    _add_reply(conn, reply);
-
-    return ret;
+    return 0;
 }
 
 int SignalingWorker::_process_stop_push(int cmdno, TcpConnection* /*conn*/, 
@@ -370,6 +587,273 @@ int SignalingWorker::_process_stop_pull(int cmdno, TcpConnection* /*c*/, const J
     return g_rtc_server->send_rtc_msg(msg);
 }
 
+// 应答只表示迁移命令已经投递给源worker，会话不满足迁移条件时由源worker放弃迁移
+int SignalingWorker::_process_migrate(int cmdno, TcpConnection* /*c*/, const Json::Value& root, uint32_t log_id) {
+    std::string stream_name;
+    int dst_worker;
+
+    try {
+        stream_name = root["stream_name"].asString();
+        dst_worker = root["dst_worker"].asInt();
+    } catch (Json::Exception e) {
+        RTC_LOG(LS_WARNING) << "parse json body error: " << e.what()
+            << "log_id: " << log_id;
+        return -1;
+    }
+
+    RTC_LOG(LS_INFO) << "cmdno[" << cmdno << "] stream_name[" << stream_name
+        << "] dst_worker[" << dst_worker
+        << "] signaling server send migrate request";
+
+    return g_rtc_server->migrate_stream(stream_name, dst_worker);
+}
+
+static bool parse_http_uid(absl::string_view str, uint64_t *uid) {
+    if (str.empty() || str.size() > 5) {
+        return false;
+    }
+
+    uint32_t value = 0;
+    for (char c : str) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+
+    if (value > 0xffff) {
+        return false;
+    }
+
+    *uid = value;
+    return true;
+}
+
+// 服务端分配的uid可能有20位，只在stop请求中解析
+static bool parse_session_uid(absl::string_view str, uint64_t *uid) {
+    if (str.empty() || str.size() > 20) {
+        return false;
+    }
+
+    uint64_t value = 0;
+    for (char c : str) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        uint64_t digit = c - '0';
+        if (value > (UINT64_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+
+    *uid = value;
+    return true;
+}
+
+int SignalingWorker::_process_http_buffer(TcpConnection *conn) {
+    // 等待应答期间客户端继续发送的数据先缓存，但不能无限增长
+    if ((conn->http_waiting || conn->close_after_reply)
+            && sdslen(conn->querybuf) > k_max_request_body_len)
+    {
+        RTC_LOG(LS_WARNING) << "too much pending http data, fd:" << conn->fd;
+        return -1;
+    }
+
+    // 一个连接上可以连续发送多个请求，应答必须按请求顺序返回，
+    // 推拉流请求需要等RtcWorker应答之后才能处理下一个请求
+    while (!conn->http_waiting && !conn->close_after_reply) {
+        size_t qb_len = sdslen(conn->querybuf);
+        if (qb_len <= conn->bytes_processed) {
+            break;
+        }
+
+        HttpRequest req;
+        int ret = parse_http_request_head(conn->querybuf + conn->bytes_processed,
+                qb_len - conn->bytes_processed, &req);
+        if (ret < 0) {
+            RTC_LOG(LS_WARNING) << "invalid http request, fd:" << conn->fd;
+            _send_http_reply(conn, 400, nullptr, "", "", false);
+            break;
+        } else if (0 == ret) {
+            break;
+        }
+
+        if (req.content_length > k_max_request_body_len) {
+            RTC_LOG(LS_WARNING) << "http body too large, content_length: " << req.content_length
+                << ", fd:" << conn->fd;
+            _send_http_reply(conn, 413, nullptr, "", "", false);
+            break;
+        }
+
+        size_t total = req.head_len + req.content_length;
+        if (qb_len - conn->bytes_processed < total) {
+            conn->bytes_expected = total;
+            break;
+        }
+
+        rtc::Slice body(conn->querybuf + conn->bytes_processed + req.head_len, req.content_length);
+        _process_http_request(conn, req, body);
+
+        conn->bytes_processed += total;
+        conn->bytes_expected = 0;
+    }
+
+    if (conn->bytes_processed > 0) {
+        sdsrange(conn->querybuf, conn->bytes_processed, -1);
+        conn->bytes_processed = 0;
+    }
+
+    return 0;
+}
+
+void SignalingWorker::_process_http_request(TcpConnection *conn, const HttpRequest &req,
+        const rtc::Slice &body)
+{
+    RTC_LOG(LS_INFO) << "receive http request: " << req.method << " " << req.path
+        << ", fd:" << conn->fd << ", worker_id:" << worker_id_;
+
+    // 浏览器跨域的预检请求
+    if (req.method == "OPTIONS") {
+        _send_http_reply(conn, 204, nullptr, "", "", req.keep_alive);
+        return;
+    }
+
+    // /whip/<stream_name>推流，/whep/<stream_name>拉流，
+    // 成功后的Location为/whip/<stream_name>/<uid>/<token>，DELETE该地址停止推拉流
+    absl::string_view path(req.path);
+    bool push = false;
+    if (absl::StartsWith(path, k_whip_prefix)) {
+        push = true;
+        path.remove_prefix(sizeof(k_whip_prefix) - 1);
+    } else if (absl::StartsWith(path, k_whep_prefix)) {
+        path.remove_prefix(sizeof(k_whep_prefix) - 1);
+    } else {
+        _send_http_reply(conn, 404, nullptr, "", "", req.keep_alive);
+        return;
+    }
+
+    size_t slash = path.find('/');
+    std::string stream_name(path.substr(0, slash));
+    if (stream_name.empty()) {
+        _send_http_reply(conn, 404, nullptr, "", "", req.keep_alive);
+        return;
+    }
+
+    int status = 405;
+    if (req.method == "POST" && slash == absl::string_view::npos) {
+        status = _process_http_offer(push ? CMDNO_PUSH : CMDNO_PULL, conn, stream_name, req, body);
+        if (0 == status) {
+            // 由RtcWorker处理完之后再应答
+            conn->http_waiting = true;
+            conn->http_keep_alive = req.keep_alive;
+            return;
+        }
+    } else if (req.method == "DELETE" && slash != absl::string_view::npos) {
+        status = _process_http_stop(push ? CMDNO_STOPPUSH : CMDNO_STOPPULL, conn, stream_name,
+                path.substr(slash + 1));
+        if (0 == status) {
+            // 由RtcWorker校验令牌之后再应答
+            conn->http_waiting = true;
+            conn->http_keep_alive = req.keep_alive;
+            return;
+        }
+    }
+
+    _send_http_reply(conn, status, nullptr, "", "", req.keep_alive);
+}
+
+int SignalingWorker::_process_http_offer(int cmdno, TcpConnection *conn,
+        const std::string &stream_name, const HttpRequest &req, const rtc::Slice &body)
+{
+    if (req.content_type != "application/sdp") {
+        return 415;
+    }
+
+    if (0 == body.size()) {
+        return 400;
+    }
+
+    // 客户端可以通过?uid=指定，否则由服务端分配
+    uint64_t uid = 0;
+    std::string uid_str;
+    if (get_http_query_param(req.query, "uid", &uid_str)) {
+        if (!parse_http_uid(uid_str, &uid)) {
+            return 400;
+        }
+    } else {
+        uid = (rtc::CreateRandomId64() & k_http_uid_mask) | k_http_uid_flag;
+    }
+
+    // uid是可以猜到的，停止推拉流只认Location中的令牌
+    std::string token;
+    if (!rtc::CreateRandomString(k_session_token_len, k_session_token_chars, &token)) {
+        return 500;
+    }
+
+    std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
+    msg->cmdno = cmdno;
+    msg->uid = uid;
+    msg->session_token = token;
+    msg->stream_name = stream_name;
+    msg->sdp.assign(body.data(), body.size());
+    msg->audio = absl::StrContains(msg->sdp, "m=audio") ? 1 : 0;
+    msg->video = absl::StrContains(msg->sdp, "m=video") ? 1 : 0;
+    msg->dtls_on = 1;
+    msg->worker = this;
+    msg->conn = conn;
+    msg->fd = conn->fd;
+
+    RTC_LOG(LS_INFO) << "cmdno["<< cmdno
+            << "] uid[" << uid
+            << "] stream_name[" << stream_name
+            << "] audio[" << msg->audio
+            << "] video[" << msg->video << "] signaling server http request";
+
+    if (g_rtc_server->send_rtc_msg(msg) != 0) {
+        return 503;
+    }
+
+    return 0;
+}
+
+int SignalingWorker::_process_http_stop(int cmdno, TcpConnection *conn,
+        const std::string &stream_name, absl::string_view session)
+{
+    // <uid>/<token>
+    size_t slash = session.find('/');
+    if (slash == absl::string_view::npos) {
+        return 404;
+    }
+
+    uint64_t uid = 0;
+    absl::string_view token = session.substr(slash + 1);
+    if (!parse_session_uid(session.substr(0, slash), &uid)
+            || token.size() != k_session_token_len)
+    {
+        return 404;
+    }
+
+    RTC_LOG(LS_INFO) << "cmdno[" << cmdno << "] uid[" << uid
+        << "] stream_name[" << stream_name
+        << "] signaling server http stop request";
+
+    std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
+    msg->cmdno = cmdno;
+    msg->uid = uid;
+    msg->stream_name = stream_name;
+    msg->session_token.assign(token.data(), token.size());
+    msg->worker = this;
+    msg->conn = conn;
+    msg->fd = conn->fd;
+
+    if (g_rtc_server->send_rtc_msg(msg) != 0) {
+        return 503;
+    }
+
+    return 0;
+}
+
 void SignalingWorker::_close_connection(TcpConnection *conn) {
     RTC_LOG(LS_INFO) << "close connection, fd: " << conn->fd;
     close(conn->fd);
@@ -377,21 +861,36 @@ void SignalingWorker::_close_connection(TcpConnection *conn) {
 }
 
 void SignalingWorker::_remove_connection(TcpConnection *conn) {
-    el_->delete_timer(conn->timer_watcher);
+    for (auto reply : conn->reply_list) {
+        _free_reply(reply);
+    }
+    conn->reply_list.clear();
+
+    idle_conns_.erase(conn->idle_it);
     el_->delete_io_event(conn->io_watcher);
     conns_[conn->fd] = nullptr;
     delete conn;
     conn = nullptr;
 }
 
-void SignalingWorker::process_timeout(TcpConnection *conn) {
-    if (el_->now() - conn->last_interaction >= (unsigned long)options_.connection_timeout) {
+void SignalingWorker::sweep_idle_connections() {
+    // connection_timeout的单位是毫秒，now()是微秒
+    unsigned long timeout = (unsigned long)options_.connection_timeout * 1000;
+    unsigned long now = el_->now();
+    while (!idle_conns_.empty()) {
+        TcpConnection *conn = idle_conns_.front();
+        if (now - conn->last_interaction < timeout) {
+            break;
+        }
+
         RTC_LOG(LS_INFO) << "connection timeout, fd: " << conn->fd;
         _close_connection(conn);
     }
 }
 
-int SignalingWorker::_process_push(int cmdno, TcpConnection *conn, const Json::Value &root, uint32_t log_id) {
+int SignalingWorker::_process_push(int cmdno, TcpConnection *conn, const Json::Value &root,
+        uint16_t req_id, uint32_t log_id)
+{
     uint64_t uid;
     std::string stream_name;
     int audio;
@@ -432,6 +931,7 @@ int SignalingWorker::_process_push(int cmdno, TcpConnection *conn, const Json::V
     msg->video = video;
     msg->dtls_on = dtls_on;
     msg->log_id = log_id;
+    msg->req_id = req_id;
     msg->worker = this;
     msg->conn = conn;
     msg->fd = conn->fd;
@@ -440,7 +940,9 @@ int SignalingWorker::_process_push(int cmdno, TcpConnection *conn, const Json::V
     return g_rtc_server->send_rtc_msg(msg);
 }
 
-int SignalingWorker::_process_pull(int cmdno, TcpConnection *conn, const Json::Value &root, uint32_t log_id) {
+int SignalingWorker::_process_pull(int cmdno, TcpConnection *conn, const Json::Value &root,
+        uint16_t req_id, uint32_t log_id)
+{
     uint64_t uid;
     std::string stream_name;
     int audio;
@@ -472,6 +974,7 @@ int SignalingWorker::_process_pull(int cmdno, TcpConnection *conn, const Json::V
     msg->audio = audio;
     msg->video = video;
     msg->log_id = log_id;
+    msg->req_id = req_id;
     msg->worker = this;
     msg->conn = conn;
     msg->fd = conn->fd;
@@ -480,42 +983,44 @@ int SignalingWorker::_process_pull(int cmdno, TcpConnection *conn, const Json::V
     return g_rtc_server->send_rtc_msg(msg);
 }
 
-void SignalingWorker::push_msg(std::shared_ptr<RtcMsg> msg) {
-    std::unique_lock<std::mutex> lock(q_msg_mtx_);
-    q_msg_.push(msg);
+bool SignalingWorker::push_msg(std::shared_ptr<RtcMsg> msg) {
+    return q_msg_.push(msg);
 }
 
 std::shared_ptr<RtcMsg> SignalingWorker::pop_msg() {
-    std::unique_lock<std::mutex> lock(q_msg_mtx_);
-
-    if (q_msg_.empty()) {
+    std::shared_ptr<RtcMsg> msg;
+    if (!q_msg_.pop(&msg)) {
         return nullptr;
     }
 
-    std::shared_ptr<RtcMsg> msg = q_msg_.front();
-    q_msg_.pop();
-
     return msg;
 }
 
 int SignalingWorker::send_rtc_msg(std::shared_ptr<RtcMsg> msg) {
-    push_msg(msg);
+    if (!push_msg(msg)) {
+        RTC_LOG(LS_WARNING) << "signaling worker msg queue full, cmdno: " << msg->cmdno
+            << ", uid: " << msg->uid << ", worker_id:" << worker_id_;
+        return -1;
+    }
+
     return _notify(SignalingWorker::RTC_MSG);
 }
 
 void SignalingWorker::_process_rtc_msg() {
-    std::shared_ptr<RtcMsg> msg = pop_msg();
-    if (!msg) {
-        return;
-    }
-
-    switch (msg->cmdno) {
-        case CMDNO_PUSH:
-        case CMDNO_PULL:
-            _response_server_offer(msg);
-            break;
-        default:
-        RTC_LOG(LS_WARNING) << "unknown cmdno["<< msg->cmdno << "], worker id:" << worker_id_;
+    // 一次唤醒处理队列中所有的应答
+    std::shared_ptr<RtcMsg> msg;
+    while ((msg = pop_msg()) != nullptr) {
+        switch (msg->cmdno) {
+            case CMDNO_PUSH:
+            case CMDNO_PULL:
+            case CMDNO_STOPPUSH:
+            case CMDNO_STOPPULL:
+                _response_server_offer(msg);
+                break;
+            default:
+                RTC_LOG(LS_WARNING) << "unknown cmdno["<< msg->cmdno << "], worker id:" << worker_id_;
+                break;
+        }
     }
 }
 
@@ -536,19 +1041,12 @@ void SignalingWorker::_response_server_offer(std::shared_ptr<RtcMsg> msg) {
         return;
     }
 
-    // 2、构建响应头和响应体，并处理
-    xhead_t *xh = (xhead_t*)(conn->querybuf);
-
-    rtc::Slice header(conn->querybuf, XHEAD_SIZE);
-    char *buf = (char*)zmalloc(XHEAD_SIZE + MAX_RES_BUF);
-    if (!buf) {
-        RTC_LOG(LS_WARNING) << "zmalloc error, log_id:" << xh->log_id <<  ", worker id:" << worker_id_;
+    if (TcpConnection::TYPE_HTTP == conn->type) {
+        _response_http(conn, msg);
         return;
     }
 
-    memcpy(buf, header.data(), header.size());
-    xhead_t *res_xh = (xhead_t*)buf;
-
+    // 2、构建响应体，响应头带回请求的id，客户端据此匹配乱序返回的响应
     Json::Value res_root;
     res_root["err_no"] = msg->err_no;
     if (msg->err_no != 0) {
@@ -559,19 +1057,96 @@ void SignalingWorker::_response_server_offer(std::shared_ptr<RtcMsg> msg) {
         res_root["offer"] = msg->sdp;
     }
 
-    Json::StreamWriterBuilder write_builder;
-    write_builder.settings_["indentation"] = ""; // 设置默认无格式化的输出
-    std::string json_data = Json::writeString(write_builder, res_root);
-    RTC_LOG(LS_INFO) << "signaling worker response body:" << json_data << ", worker id:" << worker_id_;
+    _send_reply(conn, msg->req_id, msg->log_id, res_root);
+}
 
-    res_xh->body_len = json_data.size();
-    snprintf(buf + XHEAD_SIZE, MAX_RES_BUF, "%s", json_data.c_str());
+void SignalingWorker::_response_http(TcpConnection *conn, std::shared_ptr<RtcMsg> msg) {
+    conn->http_waiting = false;
+
+    if (CMDNO_STOPPUSH == msg->cmdno || CMDNO_STOPPULL == msg->cmdno) {
+        // 会话不存在和令牌不对都返回404，不暴露会话是否存在
+        _send_http_reply(conn, msg->err_no != 0 ? 404 : 200, nullptr, "", "",
+                conn->http_keep_alive);
+    } else if (msg->err_no != 0) {
+        _send_http_reply(conn, 500, nullptr, "", "", conn->http_keep_alive);
+    } else {
+        std::string location = (CMDNO_PUSH == msg->cmdno) ? k_whip_prefix : k_whep_prefix;
+        location += msg->stream_name;
+        location += '/';
+        location += std::to_string(msg->uid);
+        location += '/';
+        location += msg->session_token;
+        _send_http_reply(conn, 201, "application/sdp", location, msg->sdp, conn->http_keep_alive);
+    }
+
+    // 继续处理等待期间收到的请求
+    if (_process_http_buffer(conn) != 0) {
+        _close_connection(conn);
+    }
+}
+
+void SignalingWorker::_send_http_reply(TcpConnection *conn, int status, const char *content_type,
+        const std::string &location, const std::string &body, bool keep_alive)
+{
+    TcpReply *reply = _alloc_reply();
+    reply->head_len = 0;
+    append_http_response(status, content_type, location, body, keep_alive, &reply->body);
+
+    RTC_LOG(LS_INFO) << "signaling worker http response status: " << status
+        << ", fd:" << conn->fd << ", worker id:" << worker_id_;
+
+    if (!keep_alive) {
+        conn->close_after_reply = true;
+    }
+
+    _add_reply(conn, reply);
+}
+
+void SignalingWorker::_send_reply(TcpConnection *conn, uint16_t req_id, uint32_t log_id,
+        const Json::Value& res_root)
+{
+    TcpReply *reply = _alloc_reply();
+
+    // json直接序列化到应答自己的body中，不再经过中间的字符串和固定大小的缓冲区
+    StringAppendBuf sbuf(&reply->body);
+    std::ostream os(&sbuf);
+    json_writer_->write(res_root, &os);
+    RTC_LOG(LS_INFO) << "signaling worker response body:" << reply->body << ", worker id:" << worker_id_;
+
+    memset(&reply->head, 0, sizeof(reply->head));
+    reply->head_len = XHEAD_SIZE;
+    reply->head.id = req_id;
+    reply->head.log_id = log_id;
+    reply->head.magic_num = XHEAD_MAGIC_NUM;
+    reply->head.body_len = reply->body.size();
 
-    rtc::Slice reply(buf, XHEAD_SIZE + res_xh->body_len);
     _add_reply(conn, reply);
 }
 
-void SignalingWorker::_add_reply(TcpConnection *conn, const rtc::Slice& reply) {
+TcpReply* SignalingWorker::_alloc_reply() {
+    if (free_replies_.empty()) {
+        return new TcpReply();
+    }
+
+    TcpReply *reply = free_replies_.back();
+    free_replies_.pop_back();
+    return reply;
+}
+
+void SignalingWorker::_free_reply(TcpReply *reply) {
+    // 保留body的容量，超大的body不保留，避免长期占用内存
+    if (free_replies_.size() >= k_max_free_replies
+            || reply->body.capacity() > k_max_pooled_body_len)
+    {
+        delete reply;
+        return;
+    }
+
+    reply->body.clear();
+    free_replies_.push_back(reply);
+}
+
+void SignalingWorker::_add_reply(TcpConnection *conn, TcpReply *reply) {
     conn->reply_list.push_back(reply);
     el_->start_io_event(conn->io_watcher, conn->fd, EventLoop::WRITE);
 }
@@ -586,30 +1161,68 @@ void SignalingWorker::write_reply(int fd) {
         return;
     }
 
-    while(!conn->reply_list.empty()) {
-        rtc::Slice reply = conn->reply_list.front();
-        // 可能一次没有写完，需要多次写入，因为需要保存一下偏移位置cur_resp_pos
-        int nwritten = sock_write_data(conn->fd, reply.data() + conn->cur_resp_pos, reply.size() - conn->cur_resp_pos);
+    while (!conn->reply_list.empty()) {
+        // 所有待发送应答的包头和包体一次writev写出，第一个应答可能已经写了一部分
+        struct iovec iov[k_max_reply_iov];
+        int iovcnt = 0;
+        size_t skip = conn->cur_resp_pos;
+        for (auto reply : conn->reply_list) {
+            if (iovcnt + 2 > k_max_reply_iov) {
+                break;
+            }
+
+            if (skip < reply->head_len) {
+                iov[iovcnt].iov_base = (char*)&reply->head + skip;
+                iov[iovcnt].iov_len = reply->head_len - skip;
+                ++iovcnt;
+                skip = 0;
+            } else {
+                skip -= reply->head_len;
+            }
+
+            if (skip < reply->body.size()) {
+                iov[iovcnt].iov_base = (char*)reply->body.data() + skip;
+                iov[iovcnt].iov_len = reply->body.size() - skip;
+                ++iovcnt;
+            }
+            skip = 0;
+        }
+
+        int nwritten = sock_writev_data(conn->fd, iov, iovcnt);
         if (-1 == nwritten) {
             _close_connection(conn);
             return;
         } else if (0 == nwritten) {
-            RTC_LOG(LS_WARNING) << "write zero bytes, fd:" << conn->fd << ", worker id:" << worker_id_;
-        } else if ((nwritten + conn->cur_resp_pos) >= reply.size()) {
+            // 发送缓冲区满了，等下一次可写事件
+            break;
+        }
+
+        // 可能一次没有写完，需要保存一下第一个应答的偏移位置cur_resp_pos
+        size_t left = nwritten;
+        while (left > 0) {
+            TcpReply *reply = conn->reply_list.front();
+            size_t remain = reply->size() - conn->cur_resp_pos;
+            if (left < remain) {
+                conn->cur_resp_pos += left;
+                break;
+            }
+
             // 写入完成
+            left -= remain;
             conn->reply_list.pop_front();
-            zfree((void*)reply.data());
             conn->cur_resp_pos = 0;
-            RTC_LOG(LS_INFO) << "write finish, fd:" << conn->fd << ", worker id:" << worker_id_;
-        } else {
-            //没有写完
-            conn->cur_resp_pos += nwritten;
+            _free_reply(reply);
         }
     }
 
-    conn->last_interaction = el_->now();
+    _touch_connection(conn);
 
     if (conn->reply_list.empty()) {
+        if (conn->close_after_reply) {
+            _close_connection(conn);
+            return;
+        }
+
         el_->stop_io_event(conn->io_watcher, conn->fd, EventLoop::WRITE);
         RTC_LOG(LS_INFO) << "stop write event, fd:" << conn->fd << ", worker id:" << worker_id_;
     }
@@ -7,16 +7,17 @@
 #ifndef __SERVER_SIGNALING_WORKER_H_
 #define __SERVER_SIGNALING_WORKER_H_
 
+#include <list>
 #include <memory>
 #include <thread>
 #include <vector>
-#include <queue>
-#include <mutex>
 
+#include <absl/strings/string_view.h>
 #include <rtc_base/slice.h>
 #include <json/json.h>
 
-#include "base/lock_free_queue.h"
+#include "base/spsc_ring.h"
+#include "base/mpsc_ring.h"
 #include "server/signaling_server.h"
 #include "xrtcserver_def.h"
 #include "server/settings.h"
@@ -24,8 +25,12 @@
 namespace xrtc {
 
 class EventLoop;
+class EventNotifier;
 class IOWatcher;
+class TimerWatcher;
 class TcpConnection;
+struct TcpReply;
+struct HttpRequest;
 
 class SignalingWorker {
 public:
@@ -33,6 +38,7 @@ public:
         QUIT = 0,
         NEW_CONN = 1,
         RTC_MSG = 2,
+        START_ACCEPT = 3,
     };
 
     SignalingWorker(int worker_id, const SignalingServerOptions& options);
@@ -45,45 +51,78 @@ public:
     void process_notify(int msg);
     void join();
     void notify_new_conn(int fd);
+    // RTC服务启动之后由SignalingServer::start()调用，worker线程开始accept自己监听的连接
+    int start_accept();
     void read_query(int fd);
-    void process_timeout(TcpConnection *conn);
+    void accept_new_conn(int listen_fd, int conn_type);
+    void sweep_idle_connections();
     int send_rtc_msg(std::shared_ptr<RtcMsg> msg);
-    void push_msg(std::shared_ptr<RtcMsg> msg);
+    bool push_msg(std::shared_ptr<RtcMsg> msg);
     std::shared_ptr<RtcMsg> pop_msg();
     void write_reply(int fd);
     
 private:
+    void _bind_cpu();
+    void _start_accept();
     void _quit();
     int _notify(int msg);
-    void _handle_new_conn(int fd);
+    void _handle_new_conn(int fd, int conn_type);
+    void _touch_connection(TcpConnection *conn);
     int _process_query_buffer(TcpConnection *conn);
     int _process_request(TcpConnection *conn, const rtc::Slice &header, const rtc::Slice &body);
+    int _process_http_buffer(TcpConnection *conn);
+    void _process_http_request(TcpConnection *conn, const HttpRequest &req, const rtc::Slice &body);
+    int _process_http_offer(int cmdno, TcpConnection *conn, const std::string &stream_name,
+            const HttpRequest &req, const rtc::Slice &body);
+    int _process_http_stop(int cmdno, TcpConnection *conn, const std::string &stream_name,
+            absl::string_view session);
+    void _response_http(TcpConnection *conn, std::shared_ptr<RtcMsg> msg);
+    void _send_http_reply(TcpConnection *conn, int status, const char *content_type,
+            const std::string &location, const std::string &body, bool keep_alive);
     void _close_connection(TcpConnection *conn);
     void _remove_connection(TcpConnection *conn);
     void _process_rtc_msg();
     void _response_server_offer(std::shared_ptr<RtcMsg> msg);
-    void _add_reply(TcpConnection *conn, const rtc::Slice& reply);
-
-    int _process_push(int cmdno, TcpConnection *conn, const Json::Value &root, uint32_t log_id);
-    int _process_pull(int cmdno, TcpConnection *conn, const Json::Value &root, uint32_t log_id);
+    void _add_reply(TcpConnection *conn, TcpReply *reply);
+    TcpReply* _alloc_reply();
+    void _free_reply(TcpReply *reply);
+    void _send_reply(TcpConnection *conn, uint16_t req_id, uint32_t log_id,
+            const Json::Value& res_root);
+
+    int _process_push(int cmdno, TcpConnection *conn, const Json::Value &root,
+            uint16_t req_id, uint32_t log_id);
+    int _process_pull(int cmdno, TcpConnection *conn, const Json::Value &root,
+            uint16_t req_id, uint32_t log_id);
     int _process_stop_push(int cmdno, TcpConnection *conn, const Json::Value& root, uint32_t log_id);
     int _process_stop_pull(int cmdno, TcpConnection *conn, const Json::Value& root, uint32_t log_id); 
+    int _process_migrate(int cmdno, TcpConnection *conn, const Json::Value& root, uint32_t log_id);
 
 private:
     int worker_id_;
     SignalingServerOptions options_;
     std::unique_ptr<EventLoop> el_;
-
-    IOWatcher *pipe_wather_ = nullptr;
-    int notify_recv_fd_ = -1;
-    int notify_send_fd_ = -1;
+    std::unique_ptr<EventNotifier> notifier_;
 
     std::unique_ptr<std::thread> thread_;
-    LockFreeQueue<int> q_conn_;
+    // SignalingServer线程写入
+    SpscRing<int> q_conn_;
     std::vector<TcpConnection*> conns_;
-
-    std::queue<std::shared_ptr<RtcMsg>> q_msg_;
-    std::mutex q_msg_mtx_;
+    // 应答对象池，只在worker线程中使用
+    std::vector<TcpReply*> free_replies_;
+    std::unique_ptr<Json::StreamWriter> json_writer_;
+    // 按最后活跃时间排序，超时检查只需要从表头开始看
+    std::list<TcpConnection*> idle_conns_;
+    TimerWatcher *sweep_timer_ = nullptr;
+
+    // reuse_port时worker自己的监听socket
+    int listen_fd_ = -1;
+    IOWatcher *accept_watcher_ = nullptr;
+    // WHIP/WHEP的HTTP监听socket
+    int http_listen_fd_ = -1;
+    IOWatcher *http_accept_watcher_ = nullptr;
+
+    // 所有RtcWorker写入
+    MpscRing<std::shared_ptr<RtcMsg>> q_msg_;
 };
 
 } // namespace xrtc
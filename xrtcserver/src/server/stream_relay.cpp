@@ -0,0 +1,306 @@
+#include <string.h>
+
+#include <rtc_base/logging.h>
+
+#include "server/stream_relay.h"
+#include "server/rtc_worker.h"
+
+namespace xrtc {
+
+const size_t k_relay_ring_size = 4096;
+
+StreamRelay::StreamRelay(int worker_num) :
+    worker_num_(worker_num),
+    workers_(worker_num, nullptr),
+    free_lists_(worker_num),
+    pending_(new std::atomic<bool>[worker_num]),
+    drop_count_(new std::atomic<uint64_t>[worker_num]),
+    oversize_count_(worker_num, 0)
+{
+    for (int i = 0; i < worker_num_ * worker_num_; ++i) {
+        rings_.push_back(std::make_unique<SpscRing<RelayPacket*>>(k_relay_ring_size));
+        free_rings_.push_back(std::make_unique<SpscRing<RelayPacket*>>(k_relay_ring_size));
+    }
+
+    for (int i = 0; i < worker_num_; ++i) {
+        pending_[i] = false;
+        drop_count_[i] = 0;
+    }
+}
+
+StreamRelay::~StreamRelay() {
+    // 同一个包可能在多个队列中，最后一个引用释放时delete
+    RelayPacket* packet = nullptr;
+    for (auto& ring : rings_) {
+        while (ring->pop(&packet)) {
+            if (packet->ref_count_.fetch_sub(1) == 1) {
+                delete packet;
+            }
+        }
+    }
+
+    for (auto& ring : free_rings_) {
+        while (ring->pop(&packet)) {
+            delete packet;
+        }
+    }
+
+    for (auto& free_list : free_lists_) {
+        for (auto free_packet : free_list) {
+            delete free_packet;
+        }
+    }
+}
+
+void StreamRelay::register_worker(int worker_id, RtcWorker* worker) {
+    if (worker_id < 0 || worker_id >= worker_num_) {
+        return;
+    }
+    workers_[worker_id] = worker;
+}
+
+std::shared_ptr<RelayChannel> StreamRelay::publish(const std::string& stream_name, int worker_id,
+        const std::vector<StreamParams>& audio_source,
+        const std::vector<StreamParams>& video_source)
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+
+    std::shared_ptr<RelayChannel> channel;
+    auto iter = channels_.find(stream_name);
+    if (iter != channels_.end()) {
+        channel = iter->second;
+    } else {
+        channel = std::make_shared<RelayChannel>(next_channel_id_++, stream_name);
+        channels_[stream_name] = channel;
+    }
+
+    channel->audio_source_ = audio_source;
+    channel->video_source_ = video_source;
+    channel->publisher_worker = worker_id;
+
+    return channel;
+}
+
+void StreamRelay::unpublish(std::shared_ptr<RelayChannel> channel, int worker_id) {
+    if (!channel) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (channel->publisher_worker != worker_id) {
+        return;
+    }
+
+    channel->publisher_worker = -1;
+    channel->audio_source_.clear();
+    channel->video_source_.clear();
+    _try_remove_channel(channel);
+}
+
+void StreamRelay::move_publisher(std::shared_ptr<RelayChannel> channel, int src_worker, int dst_worker) {
+    if (!channel || dst_worker < 0 || dst_worker >= worker_num_) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (channel->publisher_worker == src_worker) {
+        channel->publisher_worker = dst_worker;
+    }
+}
+
+std::shared_ptr<RelayChannel> StreamRelay::subscribe(const std::string& stream_name, int worker_id,
+        std::vector<StreamParams>& audio_source,
+        std::vector<StreamParams>& video_source)
+{
+    if (worker_id < 0 || worker_id >= worker_num_ || worker_id >= k_relay_max_worker_num) {
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto iter = channels_.find(stream_name);
+    if (iter == channels_.end() || iter->second->publisher_worker < 0) {
+        return nullptr;
+    }
+
+    std::shared_ptr<RelayChannel> channel = iter->second;
+    audio_source = channel->audio_source_;
+    video_source = channel->video_source_;
+
+    if (channel->subscriber_count_[worker_id]++ == 0) {
+        channel->worker_mask.fetch_or((uint64_t)1 << worker_id);
+    }
+    ++channel->total_subscriber_count_;
+
+    return channel;
+}
+
+void StreamRelay::unsubscribe(std::shared_ptr<RelayChannel> channel, int worker_id) {
+    if (!channel || worker_id < 0 || worker_id >= worker_num_) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (channel->subscriber_count_[worker_id] <= 0) {
+        return;
+    }
+
+    if (--channel->subscriber_count_[worker_id] == 0) {
+        channel->worker_mask.fetch_and(~((uint64_t)1 << worker_id));
+    }
+    --channel->total_subscriber_count_;
+    _try_remove_channel(channel);
+}
+
+void StreamRelay::_try_remove_channel(std::shared_ptr<RelayChannel> channel) {
+    if (channel->publisher_worker >= 0 || channel->total_subscriber_count_ > 0) {
+        return;
+    }
+
+    auto iter = channels_.find(channel->stream_name);
+    if (iter != channels_.end() && iter->second == channel) {
+        channels_.erase(iter);
+    }
+}
+
+RelayPacket* StreamRelay::_alloc_packet(int src_worker) {
+    std::vector<RelayPacket*>& free_list = free_lists_[src_worker];
+    if (free_list.empty()) {
+        // 本地没有空闲包时，收回其它worker释放的包
+        RelayPacket* packet = nullptr;
+        for (int dst = 0; dst < worker_num_; ++dst) {
+            auto& ring = free_rings_[src_worker * worker_num_ + dst];
+            while (ring->pop(&packet)) {
+                free_list.push_back(packet);
+            }
+        }
+    }
+
+    if (free_list.empty()) {
+        RelayPacket* packet = new RelayPacket();
+        packet->src_worker_ = src_worker;
+        return packet;
+    }
+
+    RelayPacket* packet = free_list.back();
+    free_list.pop_back();
+    return packet;
+}
+
+void StreamRelay::_release_packet(int worker_id, RelayPacket* packet, int count) {
+    if (packet->ref_count_.fetch_sub(count, std::memory_order_acq_rel) != count) {
+        return;
+    }
+
+    // 最后一个引用，还给源worker
+    if (worker_id == packet->src_worker_) {
+        free_lists_[worker_id].push_back(packet);
+        return;
+    }
+
+    if (!free_rings_[packet->src_worker_ * worker_num_ + worker_id]->push(packet)) {
+        delete packet;
+    }
+}
+
+int StreamRelay::send_packet(int src_worker, uint64_t worker_mask, uint32_t channel_id,
+        bool rtcp, bool upstream, const char* data, size_t len, bool repaired)
+{
+    if (worker_num_ < k_relay_max_worker_num) {
+        worker_mask &= ((uint64_t)1 << worker_num_) - 1;
+    }
+
+    if (src_worker < 0 || src_worker >= worker_num_ || 0 == worker_mask) {
+        return 0;
+    }
+
+    // 超过MTU的包(例如推流端没有按MTU分片)不能放进固定大小的RelayPacket，
+    // 远端worker上的拉流者收不到，计数并限频输出
+    if (len > k_relay_max_packet_size) {
+        uint64_t drops = ++oversize_count_[src_worker];
+        if (drops % 1000 == 1) {
+            RTC_LOG(LS_WARNING) << "relay packet too large, src_worker: " << src_worker
+                << ", len: " << len << ", max: " << k_relay_max_packet_size
+                << ", drops: " << drops;
+        }
+        return 0;
+    }
+
+    RelayPacket* packet = _alloc_packet(src_worker);
+    packet->channel_id = channel_id;
+    packet->rtcp = rtcp;
+    packet->upstream = upstream;
+    packet->repaired = repaired;
+    packet->len = len;
+    memcpy(packet->data, data, len);
+
+    // 写入第一个队列之后目标worker就可能释放，先按全部写入成功计数
+    int dst_count = __builtin_popcountll(worker_mask);
+    packet->ref_count_.store(dst_count, std::memory_order_relaxed);
+
+    int sent = 0;
+    while (worker_mask) {
+        int dst_worker = __builtin_ctzll(worker_mask);
+        worker_mask &= worker_mask - 1;
+
+        if (!rings_[dst_worker * worker_num_ + src_worker]->push(packet)) {
+            uint64_t drops = ++drop_count_[dst_worker];
+            if (drops % 1000 == 1) {
+                RTC_LOG(LS_WARNING) << "relay ring full, src_worker: " << src_worker
+                    << ", dst_worker: " << dst_worker << ", drops: " << drops;
+            }
+            continue;
+        }
+
+        ++sent;
+        // 目标worker还没有被唤醒时才通知，一批包只通知一次
+        if (!pending_[dst_worker].exchange(true) && workers_[dst_worker]) {
+            workers_[dst_worker]->notify(RtcWorker::RELAY_MSG);
+        }
+    }
+
+    // 丢弃的部分由源worker释放
+    if (sent < dst_count) {
+        _release_packet(src_worker, packet, dst_count - sent);
+    }
+
+    return sent;
+}
+
+bool StreamRelay::send_packet(int src_worker, int dst_worker, uint32_t channel_id,
+        bool rtcp, bool upstream, const char* data, size_t len)
+{
+    if (dst_worker < 0 || dst_worker >= worker_num_) {
+        return false;
+    }
+
+    return send_packet(src_worker, (uint64_t)1 << dst_worker, channel_id,
+            rtcp, upstream, data, len) == 1;
+}
+
+void StreamRelay::recv_packets(int dst_worker, std::vector<RelayPacket*>& packets) {
+    if (dst_worker < 0 || dst_worker >= worker_num_) {
+        return;
+    }
+
+    // 先清除标记再取包，保证取包之后写入的包一定会再次通知
+    pending_[dst_worker] = false;
+
+    RelayPacket* packet = nullptr;
+    for (int src = 0; src < worker_num_; ++src) {
+        auto& ring = rings_[dst_worker * worker_num_ + src];
+        size_t count = ring->size();
+        while (count-- > 0 && ring->pop(&packet)) {
+            packets.push_back(packet);
+        }
+    }
+}
+
+void StreamRelay::release_packet(int dst_worker, RelayPacket* packet) {
+    if (dst_worker < 0 || dst_worker >= worker_num_) {
+        return;
+    }
+
+    _release_packet(dst_worker, packet, 1);
+}
+
+} // namespace xrtc
@@ -0,0 +1,136 @@
+/**
+ * @file stream_relay.h
+ * @author charles
+ * @brief 跨worker的媒体分发
+ *         推流所在的worker把解密后的RTP/RTCP包写入目标worker的单生产者队列，
+ *         拉流者可以分布在任意worker上，由各自的worker完成SRTP加密和发送。
+ *         一个包只拷贝一次，所有目标worker共享，最后一个释放的worker把它
+ *         通过回收队列还给源worker重复使用
+*/
+
+#ifndef __SERVER_STREAM_RELAY_H_
+#define __SERVER_STREAM_RELAY_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+#include "base/spsc_ring.h"
+#include "pc/stream_params.h"
+
+namespace xrtc {
+
+class RtcWorker;
+
+const int k_relay_max_worker_num = 64;
+const size_t k_relay_max_packet_size = 1500;
+
+// 同一个流名在所有worker之间共享的分发通道
+class RelayChannel {
+public:
+    RelayChannel(uint32_t id, const std::string& stream_name) :
+        id(id), stream_name(stream_name) {}
+
+    const uint32_t id;
+    const std::string stream_name;
+
+    // 推流所在的worker，-1表示当前没有推流
+    std::atomic<int> publisher_worker{-1};
+    // 有远端拉流者的worker集合，推流worker每个包读取一次
+    std::atomic<uint64_t> worker_mask{0};
+
+private:
+    friend class StreamRelay;
+
+    // 以下成员由StreamRelay加锁访问
+    std::vector<StreamParams> audio_source_;
+    std::vector<StreamParams> video_source_;
+    int subscriber_count_[k_relay_max_worker_num] = {0};
+    int total_subscriber_count_ = 0;
+};
+
+struct RelayPacket {
+    uint32_t channel_id = 0;
+    bool rtcp = false;
+    // true表示拉流端发往推流端的反馈(RTCP)
+    bool upstream = false;
+    // 推流者RTX还原出来的旧包，不参与关键帧缓存和等待关键帧的判断
+    bool repaired = false;
+    size_t len = 0;
+    char data[k_relay_max_packet_size];
+
+private:
+    friend class StreamRelay;
+
+    // 分配这个包的worker，释放后回到它的空闲列表
+    int src_worker_ = -1;
+    // 还没有处理完这个包的目标worker数
+    std::atomic<int> ref_count_{0};
+};
+
+class StreamRelay {
+public:
+    StreamRelay(int worker_num);
+    ~StreamRelay();
+
+public:
+    void register_worker(int worker_id, RtcWorker* worker);
+    int worker_num() { return worker_num_; }
+
+    // 推流端
+    std::shared_ptr<RelayChannel> publish(const std::string& stream_name, int worker_id,
+            const std::vector<StreamParams>& audio_source,
+            const std::vector<StreamParams>& video_source);
+    void unpublish(std::shared_ptr<RelayChannel> channel, int worker_id);
+    // 推流迁移到其它worker，远端拉流者的订阅关系不变
+    void move_publisher(std::shared_ptr<RelayChannel> channel, int src_worker, int dst_worker);
+
+    // 拉流端，没有推流时返回nullptr
+    std::shared_ptr<RelayChannel> subscribe(const std::string& stream_name, int worker_id,
+            std::vector<StreamParams>& audio_source,
+            std::vector<StreamParams>& video_source);
+    void unsubscribe(std::shared_ptr<RelayChannel> channel, int worker_id);
+
+    // 只能在src_worker线程调用，数据拷贝一次后写入worker_mask中的每个worker，
+    // 队列满的worker丢弃，返回写入成功的worker数
+    int send_packet(int src_worker, uint64_t worker_mask, uint32_t channel_id,
+            bool rtcp, bool upstream, const char* data, size_t len, bool repaired = false);
+    bool send_packet(int src_worker, int dst_worker, uint32_t channel_id,
+            bool rtcp, bool upstream, const char* data, size_t len);
+
+    // 只能在dst_worker线程调用，取出当前所有待处理的包，处理完之后调用release_packet
+    void recv_packets(int dst_worker, std::vector<RelayPacket*>& packets);
+    void release_packet(int dst_worker, RelayPacket* packet);
+
+private:
+    void _try_remove_channel(std::shared_ptr<RelayChannel> channel);
+    RelayPacket* _alloc_packet(int src_worker);
+    void _release_packet(int worker_id, RelayPacket* packet, int count);
+
+private:
+    int worker_num_;
+    std::vector<RtcWorker*> workers_;
+
+    // rings_[dst * worker_num_ + src]
+    std::vector<std::unique_ptr<SpscRing<RelayPacket*>>> rings_;
+    // free_rings_[src * worker_num_ + dst]，dst释放的包还给src
+    std::vector<std::unique_ptr<SpscRing<RelayPacket*>>> free_rings_;
+    // 每个worker自己的空闲包，只在该worker线程访问
+    std::vector<std::vector<RelayPacket*>> free_lists_;
+    std::unique_ptr<std::atomic<bool>[]> pending_;
+    std::unique_ptr<std::atomic<uint64_t>[]> drop_count_;
+    // 每个源worker因为超长丢弃的包数，只在该worker线程访问
+    std::vector<uint64_t> oversize_count_;
+
+    std::mutex mtx_;
+    std::unordered_map<std::string, std::shared_ptr<RelayChannel>> channels_;
+    uint32_t next_channel_id_ = 1;
+};
+
+} // namespace xrtc
+
+#endif // __SERVER_STREAM_RELAY_H_
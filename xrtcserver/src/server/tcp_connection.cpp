@@ -1,11 +1,10 @@
-#include <rtc_base/zmalloc.h>
-
 #include "tcp_connection.h"
 
 namespace xrtc {
 
-TcpConnection::TcpConnection(int fd) : 
+TcpConnection::TcpConnection(int fd, int type) : 
     fd(fd),
+    type(type),
     querybuf(sdsempty()) {
 
 }
@@ -13,10 +12,8 @@ TcpConnection::TcpConnection(int fd) :
 TcpConnection::~TcpConnection() {
     sdsfree(querybuf);
     
-    while(!reply_list.empty()) {
-        rtc::Slice reply = reply_list.front();
-        zfree((void*)reply.data());
-        reply_list.pop_front();
+    for (auto reply : reply_list) {
+        delete reply;
     }
     reply_list.clear();
 }
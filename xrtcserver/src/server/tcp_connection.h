@@ -7,7 +7,9 @@
 #ifndef __SERVER_TCP_CONNECTION_H_
 #define __SERVER_TCP_CONNECTION_H_
 
+#include <deque>
 #include <list>
+#include <string>
 
 #include <rtc_base/sds.h>
 #include <rtc_base/slice.h>
@@ -17,7 +19,19 @@
 namespace xrtc {
 
 class IOWatcher;
-class TimerWatcher;
+
+// 一个应答，包头和包体分开存放，发送时用writev一起写出，
+// 由SignalingWorker回收复用，body的内存不需要每次重新分配
+struct TcpReply {
+    xhead_t head;
+    // HTTP应答没有xhead，状态行和应答头都放在body中，head_len为0
+    size_t head_len = XHEAD_SIZE;
+    std::string body;
+
+    size_t size() const {
+        return head_len + body.size();
+    }
+};
 
 class TcpConnection {
 public:
@@ -26,11 +40,17 @@ public:
         STATE_BODY = 1
     };
 
-    TcpConnection(int fd);
+    enum {
+        TYPE_XHEAD = 0,
+        TYPE_HTTP = 1
+    };
+
+    TcpConnection(int fd, int type = TYPE_XHEAD);
     ~TcpConnection();
 
 public:
     int fd;
+    int type;
     char ip[128] = {0};
     int port = 9000;
     sds querybuf;
@@ -39,9 +59,17 @@ public:
     int current_state = STATE_HEAD;
     unsigned long last_interaction = 0;
     IOWatcher *io_watcher = nullptr;
-    TimerWatcher *timer_watcher = nullptr;
-    std::list<rtc::Slice> reply_list;
+    // 在worker的空闲链表中的位置，链表按last_interaction从旧到新排列
+    std::list<TcpConnection*>::iterator idle_it;
+    std::deque<TcpReply*> reply_list;
+    // 第一个应答已经写出的字节数
     size_t cur_resp_pos = 0;
+    // HTTP应答必须按请求顺序返回，等待RtcWorker应答期间不处理后续请求
+    bool http_waiting = false;
+    // 当前等待应答的HTTP请求是否保持连接
+    bool http_keep_alive = true;
+    // 应答写完之后关闭连接
+    bool close_after_reply = false;
 };
 
 } // namespace xrtc
@@ -0,0 +1,150 @@
+#include "modules/rtp_rtcp/rtp_format_h264.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+#include "stream/keyframe_cache.h"
+
+namespace xrtc {
+
+// 一个关键帧最多缓存的包个数，超过时不缓存这一帧
+const size_t k_max_keyframe_packets = 1024;
+
+const uint8_t k_nalu_type_mask = 0x1f;
+const uint8_t k_fu_start_bit = 0x80;
+const size_t k_stap_a_length_size = 2;
+
+// 包中包含的参数集和IDR，关键帧必须三者都有
+const uint8_t k_has_sps = 0x01;
+const uint8_t k_has_pps = 0x02;
+const uint8_t k_has_idr = 0x04;
+const uint8_t k_has_keyframe = k_has_sps | k_has_pps | k_has_idr;
+
+static uint8_t h264_nalu_flag(uint8_t type) {
+    switch (type) {
+        case NaluType::kSps:
+            return k_has_sps;
+        case NaluType::kPps:
+            return k_has_pps;
+        case NaluType::kIdr:
+            return k_has_idr;
+        default:
+            return 0;
+    }
+}
+
+// 包中有哪些SPS/PPS/IDR，FU-A只看第一个分片
+static uint8_t h264_keyframe_nalus(const uint8_t* payload, size_t len) {
+    if (len < 1) {
+        return 0;
+    }
+
+    uint8_t nalu_type = payload[0] & k_nalu_type_mask;
+    if (NaluType::kStapA == nalu_type) {
+        uint8_t flags = 0;
+        size_t offset = 1;
+        while (offset + k_stap_a_length_size < len) {
+            size_t nalu_size = (payload[offset] << 8) | payload[offset + 1];
+            offset += k_stap_a_length_size;
+            if (0 == nalu_size || offset + nalu_size > len) {
+                return 0;
+            }
+
+            flags |= h264_nalu_flag(payload[offset] & k_nalu_type_mask);
+            offset += nalu_size;
+        }
+        return flags;
+    }
+
+    if (NaluType::kFuA == nalu_type) {
+        if (len >= 2 && (payload[1] & k_fu_start_bit)) {
+            return h264_nalu_flag(payload[1] & k_nalu_type_mask);
+        }
+        return 0;
+    }
+
+    return h264_nalu_flag(nalu_type);
+}
+
+KeyframeCache::KeyframeCache(uint32_t ssrc, uint32_t rtx_ssrc) :
+    ssrc_(ssrc), rtx_ssrc_(rtx_ssrc)
+{
+}
+
+KeyframeCache::~KeyframeCache() {
+}
+
+bool KeyframeCache::on_packet(PacketBuffer* packet, const RtpPacketView& rtp_packet) {
+    keyframe_start_ = false;
+    if (rtp_packet.ssrc() != ssrc_) {
+        return false;
+    }
+
+    uint16_t seq = rtp_packet.sequence_number();
+    if (has_last_seq_) {
+        // 推流者按原始ssrc重传的旧包不参与组帧
+        uint16_t diff = seq - last_seq_;
+        if (0 == diff || diff >= 0x8000) {
+            return false;
+        }
+    }
+
+    bool continuous = has_last_seq_ && seq == (uint16_t)(last_seq_ + 1);
+    bool frame_start = false;
+    if (!in_frame_ || rtp_packet.timestamp() != frame_ts_) {
+        // 新的一帧，上一帧没有收到marker时直接丢弃，
+        // 第一个包必须紧接着上一帧的marker，否则帧开头的包(例如SPS/PPS)可能丢了
+        frame_.clear();
+        in_frame_ = true;
+        frame_valid_ = continuous && last_marker_;
+        frame_nalus_ = 0;
+        frame_ts_ = rtp_packet.timestamp();
+        frame_start = true;
+    } else if (!continuous) {
+        // 帧内有丢包，这一帧不缓存
+        frame_valid_ = false;
+    }
+
+    has_last_seq_ = true;
+    last_seq_ = seq;
+    last_marker_ = rtp_packet.marker();
+
+    uint8_t nalus = 0;
+    if (frame_start || (frame_valid_ && frame_nalus_ != k_has_keyframe)) {
+        auto payload = rtp_packet.payload();
+        nalus = h264_keyframe_nalus(payload.data(), payload.size());
+    }
+    keyframe_start_ = frame_start && (nalus & k_has_sps);
+
+    if (frame_valid_) {
+        if (frame_.size() >= k_max_keyframe_packets) {
+            frame_valid_ = false;
+            frame_.clear();
+        } else {
+            frame_.push_back(packet);
+            frame_nalus_ |= nalus;
+        }
+    }
+
+    bool keyframe = false;
+    if (rtp_packet.marker()) {
+        if (frame_valid_ && k_has_keyframe == frame_nalus_) {
+            keyframe_.swap(frame_);
+            keyframe_ts_ = frame_ts_;
+            keyframe_last_seq_ = seq;
+            keyframe = true;
+        }
+        frame_.clear();
+        in_frame_ = false;
+    }
+
+    return keyframe;
+}
+
+void KeyframeCache::clear() {
+    keyframe_.clear();
+    frame_.clear();
+    in_frame_ = false;
+    has_last_seq_ = false;
+    last_marker_ = false;
+    keyframe_start_ = false;
+}
+
+} // namespace xrtc
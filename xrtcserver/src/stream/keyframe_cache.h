@@ -0,0 +1,69 @@
+/**
+ * @file keyframe_cache.h
+ * @author charles
+ * @brief 一路H264视频最近一个完整的关键帧(SPS/PPS + IDR)，
+ *         新的订阅者连接后先收到这个关键帧，不用等推流者的下一个IDR，
+ *         保存的是worker线程的PacketBuffer，只能在所属worker线程中使用
+*/
+
+#ifndef __STREAM_KEYFRAME_CACHE_H_
+#define __STREAM_KEYFRAME_CACHE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/packet_buffer.h"
+
+namespace xrtc {
+
+class RtpPacketView;
+
+class KeyframeCache {
+public:
+    KeyframeCache(uint32_t ssrc, uint32_t rtx_ssrc);
+    ~KeyframeCache();
+
+    uint32_t ssrc() const { return ssrc_; }
+    uint32_t rtx_ssrc() const { return rtx_ssrc_; }
+
+    // 按接收顺序输入视频包，只处理ssrc的包，收到marker时如果这一帧完整
+    // (第一个包紧接着上一帧的marker，帧内没有丢包)并且包含SPS、PPS和IDR，
+    // 替换缓存的关键帧并返回true
+    bool on_packet(PacketBuffer* packet, const RtpPacketView& rtp_packet);
+    // 最近一次输入的包是一帧的第一个包并且带有SPS，订阅者可以从这里开始解码
+    bool keyframe_start() const { return keyframe_start_; }
+
+    bool empty() const { return keyframe_.empty(); }
+    const std::vector<PacketBufferPtr>& packets() const { return keyframe_; }
+    // 缓存的关键帧的时间戳和最后一个包(marker)的序号
+    uint32_t keyframe_timestamp() const { return keyframe_ts_; }
+    uint16_t keyframe_last_seq() const { return keyframe_last_seq_; }
+
+    // 释放所有保存的包，迁移到其它worker之前必须调用
+    void clear();
+
+private:
+    uint32_t ssrc_;
+    uint32_t rtx_ssrc_;
+
+    std::vector<PacketBufferPtr> keyframe_;
+    uint32_t keyframe_ts_ = 0;
+    uint16_t keyframe_last_seq_ = 0;
+    // 正在接收的一帧
+    std::vector<PacketBufferPtr> frame_;
+    bool in_frame_ = false;
+    bool frame_valid_ = false;
+    // 这一帧中已经出现的SPS/PPS/IDR
+    uint8_t frame_nalus_ = 0;
+    uint32_t frame_ts_ = 0;
+    bool has_last_seq_ = false;
+    uint16_t last_seq_ = 0;
+    // 上一个包是否带有marker，新的一帧只有紧接着marker才是完整的
+    bool last_marker_ = false;
+    bool keyframe_start_ = false;
+};
+
+} // namespace xrtc
+
+#endif // __STREAM_KEYFRAME_CACHE_H_
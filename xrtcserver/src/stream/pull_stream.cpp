@@ -1,17 +1,24 @@
 #include <rtc_base/logging.h>
+#include <rtc_base/helpers.h>
 
 #include "stream/pull_stream.h"
+#include "stream/push_stream.h"
 
 namespace xrtc {
 
 PullStream::PullStream(EventLoop *el, PortAllocator *allocator, uint64_t uid, const std::string& stream_name,
     bool audio, bool video, bool dtls_on, uint32_t log_id) :
-    RtcStream(el, allocator, uid, stream_name, audio, video, dtls_on, log_id) 
+    RtcStream(el, allocator, uid, stream_name, audio, video, dtls_on, log_id),
+    rtx_seq_((uint16_t)rtc::CreateRandomId())
 {
 
 }
 
 PullStream::~PullStream() {
+    if (publisher_) {
+        publisher_->remove_subscriber(this);
+    }
+
     RTC_LOG(LS_INFO) << to_string() << ": Pull stream destroy.";
 }
 
@@ -21,10 +28,43 @@ std::string PullStream::create_answer() {
     options.send_video = video;
     options.recv_audio = false;
     options.recv_video = false;
+    options.send_rtcp_report = send_rtcp_report_;
 
     return pc->create_answer(options);
 }
 
+void PullStream::enable_pacing(int start_bitrate_kbps, int max_bitrate_kbps) {
+    if (pc) {
+        pc->enable_pacing(start_bitrate_kbps, max_bitrate_kbps);
+    }
+}
+
+void PullStream::on_publisher_sender_report(uint32_t ssrc, uint32_t rtp_timestamp) {
+    if (pc) {
+        pc->on_remote_sender_report(ssrc, rtp_timestamp);
+    }
+}
+
+uint8_t PullStream::video_rtx_payload_type() {
+    return pc ? (uint8_t)pc->video_rtx_codec_id() : 0;
+}
+
+void PullStream::set_keyframe_seq_range(uint16_t first_seq, uint16_t count) {
+    keyframe_first_seq_ = first_seq;
+    keyframe_seq_count_ = count;
+}
+
+void PullStream::extend_keyframe_seq_range(uint16_t seq) {
+    uint16_t count = seq - keyframe_first_seq_ + 1;
+    if (count > keyframe_seq_count_ && count < 0x8000) {
+        keyframe_seq_count_ = count;
+    }
+}
+
+bool PullStream::is_keyframe_seq(uint16_t seq) {
+    return (uint16_t)(seq - keyframe_first_seq_) < keyframe_seq_count_;
+}
+
 void PullStream::add_audio_source(const std::vector<StreamParams>& source) {
     if (pc) {
         pc->add_audio_source(source);
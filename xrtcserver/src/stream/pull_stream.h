@@ -9,12 +9,16 @@
 
 #include <stdint.h>
 #include <string>
+#include <memory>
 
 #include "stream/rtc_stream.h"
 #include "pc/stream_params.h"
 
 namespace xrtc {
 
+class PushStream;
+class RelayChannel;
+
 class PullStream: public RtcStream {
 public:
     PullStream(EventLoop *el, PortAllocator *allocator, uint64_t uid, const std::string& stream_name,
@@ -27,6 +31,51 @@ public:
 
     void add_audio_source(const std::vector<StreamParams>& source);
     void add_video_source(const std::vector<StreamParams>& source);
+
+    // 服务端生成发给订阅者的SR，在create_answer之前设置
+    void set_send_rtcp_report(bool send_rtcp_report) { send_rtcp_report_ = send_rtcp_report; }
+    // 推流者的SR，SR中的RTP时间戳对应收到SR的本地时间，之后的SR按这个对应关系生成
+    void on_publisher_sender_report(uint32_t ssrc, uint32_t rtp_timestamp);
+
+    // 发给订阅者的包经过pacer平滑发送，在add_audio_source/add_video_source之后调用
+    void enable_pacing(int start_bitrate_kbps, int max_bitrate_kbps);
+
+    // 重传时封装RTX使用订阅者自己协商的payload type，0表示不支持RTX
+    uint8_t video_rtx_payload_type();
+    // 发给这个订阅者的RTX包的序号，每个订阅者各自连续
+    uint16_t next_rtx_seq() { return rtx_seq_++; }
+
+    // 连接建立时推流已经有缓存的关键帧，在下一个帧边界发送给订阅者，
+    // 发送之前不转发视频包
+    bool waiting_keyframe() { return waiting_keyframe_; }
+    void set_waiting_keyframe(bool waiting) { waiting_keyframe_ = waiting; }
+
+    // 发送缓存的关键帧之后，之后的实时P帧参考的是推流者的前一帧而不是缓存的关键帧，
+    // 丢弃实时视频包直到下一个实时关键帧
+    bool waiting_live_keyframe() { return waiting_live_keyframe_; }
+    void set_waiting_live_keyframe(bool waiting) { waiting_live_keyframe_ = waiting; }
+
+    // 发送缓存的关键帧和之后丢弃的实时包占用的序号，这些序号的NACK不能用实时包响应
+    void set_keyframe_seq_range(uint16_t first_seq, uint16_t count);
+    void extend_keyframe_seq_range(uint16_t seq);
+    bool is_keyframe_seq(uint16_t seq);
+
+    PushStream* publisher() { return publisher_; }
+    void set_publisher(PushStream* publisher) { publisher_ = publisher; }
+
+    // 推流在其他worker上时，通过该通道接收媒体包
+    const std::shared_ptr<RelayChannel>& relay_channel() { return relay_channel_; }
+    void set_relay_channel(std::shared_ptr<RelayChannel> channel) { relay_channel_ = channel; }
+
+private:
+    PushStream* publisher_ = nullptr;
+    bool send_rtcp_report_ = false;
+    bool waiting_keyframe_ = false;
+    bool waiting_live_keyframe_ = false;
+    uint16_t keyframe_first_seq_ = 0;
+    uint16_t keyframe_seq_count_ = 0;
+    uint16_t rtx_seq_;
+    std::shared_ptr<RelayChannel> relay_channel_;
 };
 
 } // end namespace xrtc
@@ -1,6 +1,11 @@
 #include <rtc_base/logging.h>
 
+#include <algorithm>
+
 #include "stream/push_stream.h"
+#include "stream/pull_stream.h"
+#include "stream/keyframe_cache.h"
+#include "stream/rtp_packet_history.h"
 #include "pc/session_description.h"
 
 namespace xrtc {
@@ -11,6 +16,11 @@ PushStream::PushStream(EventLoop *el, PortAllocator *allocator, uint64_t uid, co
 }
 
 PushStream::~PushStream() {
+    for (auto subscriber : subscribers_) {
+        subscriber->set_publisher(nullptr);
+    }
+    subscribers_.clear();
+
     RTC_LOG(LS_INFO) << to_string() << ": Push stream destroy.";
 }
 
@@ -36,6 +46,40 @@ bool PushStream::get_video_source(std::vector<StreamParams>& source) {
     return _get_source("video", source);
 }
 
+void PushStream::add_subscriber(PullStream* stream) {
+    if (!stream) {
+        return;
+    }
+
+    auto iter = std::find(subscribers_.begin(), subscribers_.end(), stream);
+    if (iter == subscribers_.end()) {
+        subscribers_.push_back(stream);
+    }
+    stream->set_publisher(this);
+}
+
+void PushStream::remove_subscriber(PullStream* stream) {
+    auto iter = std::find(subscribers_.begin(), subscribers_.end(), stream);
+    if (iter == subscribers_.end()) {
+        return;
+    }
+
+    // 订阅者的顺序无关紧要，用末尾元素覆盖，避免整体搬移
+    *iter = subscribers_.back();
+    subscribers_.pop_back();
+    if (stream->publisher() == this) {
+        stream->set_publisher(nullptr);
+    }
+}
+
+void PushStream::set_packet_history(std::unique_ptr<RtpPacketHistory> history) {
+    packet_history_ = std::move(history);
+}
+
+void PushStream::set_keyframe_cache(std::unique_ptr<KeyframeCache> cache) {
+    keyframe_cache_ = std::move(cache);
+}
+
 bool PushStream::_get_source(const std::string& mid, std::vector<StreamParams>& source) {
     if (!pc) {
         return false;
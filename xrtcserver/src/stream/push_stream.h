@@ -9,12 +9,19 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
+#include <memory>
 
 #include "stream/rtc_stream.h"
 #include "pc/stream_params.h"
 
 namespace xrtc {
 
+class PullStream;
+class RelayChannel;
+class RtpPacketHistory;
+class KeyframeCache;
+
 class PushStream: public RtcStream {
 public:
     PushStream(EventLoop *el, PortAllocator *allocator, uint64_t uid, const std::string& stream_name,
@@ -28,11 +35,40 @@ public:
     bool get_audio_source(std::vector<StreamParams>& source);
     bool get_video_source(std::vector<StreamParams>& source);
 
+    // 订阅者列表，转发时直接遍历，不需要按流名查找
+    void add_subscriber(PullStream* stream);
+    void remove_subscriber(PullStream* stream);
+    const std::vector<PullStream*>& subscribers() { return subscribers_; }
+
+    // 跨worker分发通道，未开启cross_worker_fanout时为空
+    const std::shared_ptr<RelayChannel>& relay_channel() { return relay_channel_; }
+    void set_relay_channel(std::shared_ptr<RelayChannel> channel) { relay_channel_ = channel; }
+
+    // 最近收到的视频包，用来响应订阅者的NACK，未开启时为nullptr
+    RtpPacketHistory* packet_history() { return packet_history_.get(); }
+    void set_packet_history(std::unique_ptr<RtpPacketHistory> history);
+
+    // 最近一个完整的关键帧，新的订阅者连接后立即发送，没有视频时为nullptr
+    KeyframeCache* keyframe_cache() { return keyframe_cache_.get(); }
+    void set_keyframe_cache(std::unique_ptr<KeyframeCache> cache);
+
+    // 最近一次收到完整关键帧和向推流者转发关键帧请求的时间(微秒)，用来合并订阅者的PLI/FIR
+    unsigned long last_keyframe_time() { return last_keyframe_time_; }
+    void set_last_keyframe_time(unsigned long time) { last_keyframe_time_ = time; }
+    unsigned long last_keyframe_request_time() { return last_keyframe_request_time_; }
+    void set_last_keyframe_request_time(unsigned long time) { last_keyframe_request_time_ = time; }
+
 private:
     bool _get_source(const std::string& mid, std::vector<StreamParams>& source);
 
 private:
     bool dtls_on_ = true;
+    std::vector<PullStream*> subscribers_;
+    std::shared_ptr<RelayChannel> relay_channel_;
+    std::unique_ptr<RtpPacketHistory> packet_history_;
+    std::unique_ptr<KeyframeCache> keyframe_cache_;
+    unsigned long last_keyframe_time_ = 0;
+    unsigned long last_keyframe_request_time_ = 0;
 };
 
 } // end namespace xrtc
@@ -54,18 +54,18 @@ void RtcStream::_on_connection_state(PeerConnection* /*pc*/, PeerConnectionState
 }
 
 void RtcStream::_on_rtp_packet_received(PeerConnection*, 
-        rtc::CopyOnWriteBuffer* packet, int64_t /*ts*/)
+        PacketBuffer* packet, const RtpPacketView& rtp_packet, int64_t ts)
 {
     if (listener_) {
-        listener_->on_rtp_packet_received(this, (const char*)packet->data(), packet->size());
+        listener_->on_rtp_packet_received(this, packet, rtp_packet, ts);
     }
 }
 
 void RtcStream::_on_rtcp_packet_received(PeerConnection*, 
-        rtc::CopyOnWriteBuffer* packet, int64_t /*ts*/)
+        PacketBuffer* packet, int64_t /*ts*/)
 {
     if (listener_) {
-        listener_->on_rtcp_packet_received(this, (const char*)packet->data(), packet->size());
+        listener_->on_rtcp_packet_received(this, packet);
     }
 }
 
@@ -79,7 +79,7 @@ void ice_timeout_cb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
 }
 
 int RtcStream::start(rtc::RTCCertificate* certificate) {
-    ice_timeout_watcher_ = el->create_timer(ice_timeout_cb, this, false);
+    ice_timeout_watcher_ = el->create_wheel_timer(ice_timeout_cb, this, false);
     el->start_timer(ice_timeout_watcher_, k_ice_timeout * 1000);
 
     return pc->init(certificate);
@@ -89,9 +89,25 @@ int RtcStream::set_remote_sdp(const std::string& sdp) {
     return pc->set_remote_sdp(sdp);
 }
 
-int RtcStream::send_rtp(const char* data, size_t len) {
+int RtcStream::send_rtp(const char* data, size_t len, bool retransmission) {
     if (pc) {
-        return pc->send_rtp(data, len);
+        return pc->send_rtp(data, len, retransmission);
+    }
+    return -1;
+}
+
+int RtcStream::send_rtp(PacketBuffer* packet, bool retransmission) {
+    if (pc) {
+        return pc->send_rtp(packet, retransmission);
+    }
+    return -1;
+}
+
+int RtcStream::send_rtp(PacketBuffer* packet, const RtpPacketView& rtp_packet,
+        bool retransmission)
+{
+    if (pc) {
+        return pc->send_rtp(packet, rtp_packet, retransmission);
     }
     return -1;
 }
@@ -103,6 +119,27 @@ int RtcStream::send_rtcp(const char* data, size_t len) {
     return -1;
 }
 
+bool RtcStream::can_migrate() {
+    return state_ == PeerConnectionState::k_connected && pc->can_migrate();
+}
+
+void RtcStream::detach_event_loop() {
+    if (ice_timeout_watcher_) {
+        el->detach_timer(ice_timeout_watcher_);
+    }
+
+    pc->detach_event_loop();
+}
+
+void RtcStream::attach_event_loop(EventLoop* el, PortAllocator* allocator) {
+    this->el = el;
+    if (ice_timeout_watcher_) {
+        el->attach_timer(ice_timeout_watcher_);
+    }
+
+    pc->attach_event_loop(el, allocator);
+}
+
 std::string RtcStream::to_string() {
     std::stringstream ss;
     ss << "Stream[" << this << "|" << uid << "|" << stream_name << "]";
@@ -30,8 +30,11 @@ enum class RtcStreamType {
 class RtcStreamListener {
 public:
     virtual void on_connection_state(RtcStream* stream, PeerConnectionState state) = 0;
-    virtual void on_rtp_packet_received(RtcStream* stream, const char* data, size_t len) = 0;
-    virtual void on_rtcp_packet_received(RtcStream* stream, const char* data, size_t len) = 0;
+    // packet在回调期间有效，需要保留时持有PacketBufferPtr引用，
+    // ts是内核收到包的时间(UTC微秒)，拿不到时是-1
+    virtual void on_rtp_packet_received(RtcStream* stream, PacketBuffer* packet,
+            const RtpPacketView& rtp_packet, int64_t ts) = 0;
+    virtual void on_rtcp_packet_received(RtcStream* stream, PacketBuffer* packet) = 0;
     virtual void on_stream_exception(RtcStream* stream) = 0;
 };
 
@@ -52,16 +55,32 @@ public:
 
     uint64_t get_uid() { return uid; }
     const std::string& get_stream_name() { return stream_name; }
-
-    int send_rtp(const char* data, size_t len);
+    // 非空时停止推拉流的请求必须带上相同的令牌
+    void set_session_token(const std::string& token) { session_token_ = token; }
+    const std::string& session_token() { return session_token_; }
+
+    // retransmission为true时开启pacing的情况下优先于视频发送
+    int send_rtp(const char* data, size_t len, bool retransmission = false);
+    // 缓冲池中的包，开启pacing时多个订阅者的队列共享同一份数据
+    int send_rtp(PacketBuffer* packet, bool retransmission = false);
+    // 转发路径上已经解析过的包，每个订阅者不再重复解析
+    int send_rtp(PacketBuffer* packet, const RtpPacketView& rtp_packet,
+            bool retransmission = false);
     int send_rtcp(const char* data, size_t len);
 
+    // 迁移到另一个worker，只有连接建立之后才可以迁移，
+    // detach在当前worker线程调用，attach在目标worker线程调用
+    bool can_migrate();
+    void detach_event_loop();
+    void attach_event_loop(EventLoop* el, PortAllocator* allocator);
+
     std::string to_string();
 
 private:
     void _on_connection_state(PeerConnection* pc, PeerConnectionState state);
-    void _on_rtp_packet_received(PeerConnection*, rtc::CopyOnWriteBuffer* packet, int64_t ts);
-    void _on_rtcp_packet_received(PeerConnection*, rtc::CopyOnWriteBuffer* packet, int64_t ts);
+    void _on_rtp_packet_received(PeerConnection*, PacketBuffer* packet,
+            const RtpPacketView& rtp_packet, int64_t ts);
+    void _on_rtcp_packet_received(PeerConnection*, PacketBuffer* packet, int64_t ts);
 
 protected:
     EventLoop *el;
@@ -71,6 +90,7 @@ protected:
     bool video;
     bool dtls_on;
     uint32_t log_id; 
+    std::string session_token_;
 
     PeerConnection *pc;
     PeerConnectionState state_ = PeerConnectionState::k_new;
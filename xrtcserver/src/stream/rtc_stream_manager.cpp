@@ -1,19 +1,68 @@
+#include <algorithm>
+
 #include <rtc_base/logging.h>
+#include <rtc_base/time_utils.h>
+#include <modules/rtp_rtcp/source/byte_io.h>
 
+#include "base/cpu_affinity.h"
 #include "base/event_loop.h"
 #include "ice/port_allocator.h"
 #include "stream/rtc_stream_manager.h"
 #include "stream/push_stream.h"
 #include "stream/pull_stream.h"
+#include "stream/keyframe_cache.h"
+#include "stream/rtp_packet_history.h"
+#include "modules/rtp_rtcp/rtcp_packet/common_header.h"
+#include "modules/rtp_rtcp/rtcp_packet/nack.h"
 #include "server/settings.h"
+#include "server/stream_relay.h"
 
 namespace xrtc {
+
+const uint8_t k_rtcp_sr = 200;
+const size_t k_rtcp_sr_info_size = 24;
+// RFC 4585/5104 负载相关的反馈，PLI和FIR都是向推流者请求关键帧
+const uint8_t k_rtcp_rtpfb = 205;
+const uint8_t k_rtcp_psfb = 206;
+const uint8_t k_psfb_pli = 1;
+const uint8_t k_psfb_fir = 4;
+const size_t k_rtcp_pli_size = 12;
   
-RtcStreamManager::RtcStreamManager(EventLoop *el) : 
+RtcStreamManager::RtcStreamManager(EventLoop *el, int worker_id, StreamRelay* relay) : 
     el_(el), 
-    port_allocator_(new PortAllocator) 
+    port_allocator_(new PortAllocator),
+    worker_id_(worker_id),
+    relay_(relay)
 {
     port_allocator_->set_port_range(Singleton<Settings>::Instance()->IceMinPort(), Singleton<Settings>::Instance()->IceMaxPort());
+    // 每个worker使用端口范围中互不重叠的一部分，避免worker之间bind冲突
+    port_allocator_->set_port_shard(worker_id_, Singleton<Settings>::Instance()->GetRtcServerOptions().worker_num);
+
+    RtcServerOptions options = Singleton<Settings>::Instance()->GetRtcServerOptions();
+    nack_history_size_ = options.nack_history_size;
+    nack_rtx_ = options.nack_rtx;
+    keyframe_cache_ = options.keyframe_cache;
+    keyframe_request_interval_ = options.keyframe_request_interval;
+    rtcp_termination_ = options.rtcp_termination;
+    pacing_ = options.pacing;
+    pacing_start_bitrate_ = options.pacing_start_bitrate;
+    pacing_max_bitrate_ = options.pacing_max_bitrate;
+    if (options.udp_incoming_cpu) {
+        port_allocator_->set_incoming_cpu(select_worker_cpu(options.worker_cpus, worker_id_));
+    }
+
+    int shared_port = Singleton<Settings>::Instance()->IceSharedPort();
+    if (shared_port > 0) {
+        if (port_allocator_->enable_shared_port(el_, shared_port + worker_id_) != 0) {
+            RTC_LOG(LS_WARNING) << "enable shared port failed, fallback to per session port"
+                << ", port: " << shared_port + worker_id_;
+        }
+    }
+
+    int pool_size = Singleton<Settings>::Instance()->IceSocketPoolSize();
+    if (pool_size > 0 && !port_allocator_->shared_port_mux()) {
+        port_allocator_->enable_socket_pool(el_, pool_size);
+    }
 }
 
 RtcStreamManager::~RtcStreamManager() {
@@ -23,12 +72,13 @@ int RtcStreamManager::create_push_stream(const std::shared_ptr<RtcMsg>& msg, std
     PushStream* stream = _find_push_stream(msg->stream_name);
     if (stream) {
         push_streams_.erase(msg->stream_name);
-        delete stream;
+        _delete_push_stream(stream);
         stream = nullptr;
     }
 
     stream = new PushStream(el_, port_allocator_.get(), msg->uid, msg->stream_name,
             msg->audio, msg->video, msg->dtls_on, msg->log_id);
+    stream->set_session_token(msg->session_token);
     stream->register_listener(this);
     stream->start((rtc::RTCCertificate*)msg->certificate);
 
@@ -36,32 +86,67 @@ int RtcStreamManager::create_push_stream(const std::shared_ptr<RtcMsg>& msg, std
 
     answer = stream->create_answer();
 
+    std::vector<StreamParams> audio_source;
+    std::vector<StreamParams> video_source;
+    stream->get_audio_source(audio_source);
+    stream->get_video_source(video_source);
+    stream->set_packet_history(_create_packet_history(video_source));
+    stream->set_keyframe_cache(_create_keyframe_cache(video_source));
+
     RTC_LOG(LS_INFO) << "add push stream, uid: " << msg->uid
                 << ", stream_name: " << msg->stream_name
                 << ", log_id: " << msg->log_id;
 
     push_streams_[msg->stream_name] = stream;
+    signal_stream_created(stream);
+
+    // 重新推流时，已有的拉流者挂到新的推流上
+    auto iter = pull_streams_.find(msg->stream_name);
+    if (iter != pull_streams_.end()) {
+        for (auto& item : iter->second) {
+            if (!item.second->relay_channel()) {
+                stream->add_subscriber(item.second);
+            }
+        }
+    }
+
+    if (relay_) {
+        std::shared_ptr<RelayChannel> channel = relay_->publish(msg->stream_name, worker_id_,
+                audio_source, video_source);
+        stream->set_relay_channel(channel);
+        relay_publishers_[channel->id] = stream;
+    }
 
     return 0;
 }
 
 int RtcStreamManager::create_pull_stream(const std::shared_ptr<RtcMsg>& msg, std::string& answer) {
+    _remove_pull_stream(msg->uid, msg->stream_name);
+
+    std::vector<StreamParams> audio_source;
+    std::vector<StreamParams> video_source;
+    std::shared_ptr<RelayChannel> channel;
+
     PushStream* push_stream = _find_push_stream(msg->stream_name);
-    if (!push_stream) {
+    if (push_stream) {
+        push_stream->get_audio_source(audio_source);
+        push_stream->get_video_source(video_source);
+    } else if (relay_) {
+        // 推流在其他worker上，订阅它的分发通道
+        channel = relay_->subscribe(msg->stream_name, worker_id_, audio_source, video_source);
+    }
+
+    if (!push_stream && !channel) {
         RTC_LOG(LS_WARNING) << "Stream not found, uid: " << msg->uid << ", stream_name: "
             << msg->stream_name << ", log_id: " << msg->log_id;
         return -1;
     }
 
-    _remove_pull_stream(msg->uid, msg->stream_name);
-    std::vector<StreamParams> audio_source;
-    std::vector<StreamParams> video_source;
-    push_stream->get_audio_source(audio_source);
-    push_stream->get_video_source(video_source);
-
     PullStream *stream = new PullStream(el_, port_allocator_.get(), msg->uid, msg->stream_name,
             msg->audio, msg->video, msg->dtls_on, msg->log_id);
+    stream->set_session_token(msg->session_token);
     stream->register_listener(this);
+    stream->set_send_rtcp_report(rtcp_termination_);
     stream->add_audio_source(audio_source);
     stream->add_video_source(video_source);
     stream->start((rtc::RTCCertificate*)msg->certificate);
@@ -69,12 +154,38 @@ int RtcStreamManager::create_pull_stream(const std::shared_ptr<RtcMsg>& msg, std
     stream->set_remote_sdp(msg->sdp);
     
     answer = stream->create_answer();
+    if (pacing_) {
+        stream->enable_pacing(pacing_start_bitrate_, pacing_max_bitrate_);
+    }
 
-    RTC_LOG(LS_WARNING) << "add push stream, uid: " << msg->uid
-                << ", stream_name: " << msg->stream_name
-                << ", log_id: " << msg->log_id;
+    pull_streams_[msg->stream_name][msg->uid] = stream;
+    signal_stream_created(stream);
+
+    size_t subscriber_num = 0;
+    if (push_stream) {
+        push_stream->add_subscriber(stream);
+        subscriber_num = push_stream->subscribers().size();
+    } else {
+        stream->set_relay_channel(channel);
+        auto& subscribers = relay_subscribers_[channel->id];
+        subscribers.push_back(stream);
+        subscriber_num = subscribers.size();
 
-    pull_streams_[msg->stream_name] = stream;
+        // 同一个通道在本worker上的拉流者共用一份缓存
+        if (relay_video_caches_.find(channel->id) == relay_video_caches_.end()) {
+            RelayVideoCache& cache = relay_video_caches_[channel->id];
+            cache.history = _create_packet_history(video_source);
+            if (keyframe_cache_) {
+                cache.keyframe_cache = _create_keyframe_cache(video_source);
+            }
+        }
+    }
+
+    RTC_LOG(LS_INFO) << "add pull stream, uid: " << msg->uid
+                << ", stream_name: " << msg->stream_name
+                << ", log_id: " << msg->log_id
+                << ", relay: " << (channel ? 1 : 0)
+                << ", subscribers: " << subscriber_num;
 
     return 0;
 }
@@ -99,24 +210,69 @@ void RtcStreamManager::_remove_push_stream(uint64_t uid, const std::string& stre
     PushStream* push_stream = _find_push_stream(stream_name);
     if (push_stream && uid == push_stream->get_uid()) {
         push_streams_.erase(stream_name);
-        delete push_stream;
+        _delete_push_stream(push_stream);
     }
 }
 
-int RtcStreamManager::stop_push(uint64_t uid, const std::string& stream_name) {
+void RtcStreamManager::_delete_push_stream(PushStream* stream) {
+    const std::shared_ptr<RelayChannel>& channel = stream->relay_channel();
+    if (channel && relay_) {
+        auto iter = relay_publishers_.find(channel->id);
+        if (iter != relay_publishers_.end() && iter->second == stream) {
+            relay_publishers_.erase(iter);
+        }
+        relay_->unpublish(channel, worker_id_);
+    }
+
+    signal_stream_removed(stream);
+    delete stream;
+}
+
+int RtcStreamManager::stop_push(uint64_t uid, const std::string& stream_name,
+        const std::string& session_token)
+{
+    PushStream* push_stream = _find_push_stream(stream_name);
+    if (!push_stream || uid != push_stream->get_uid()) {
+        return -1;
+    }
+
+    if (push_stream->session_token() != session_token) {
+        RTC_LOG(LS_WARNING) << "stop push with invalid session token, uid: " << uid
+            << ", stream_name: " << stream_name;
+        return -1;
+    }
+
     _remove_push_stream(uid, stream_name);
     return 0;
 }
 
-int RtcStreamManager::stop_pull(uint64_t uid, const std::string& stream_name) {
+int RtcStreamManager::stop_pull(uint64_t uid, const std::string& stream_name,
+        const std::string& session_token)
+{
+    PullStream* pull_stream = _find_pull_stream(uid, stream_name);
+    if (!pull_stream) {
+        return -1;
+    }
+
+    if (pull_stream->session_token() != session_token) {
+        RTC_LOG(LS_WARNING) << "stop pull with invalid session token, uid: " << uid
+            << ", stream_name: " << stream_name;
+        return -1;
+    }
+
     _remove_pull_stream(uid, stream_name);
     return 0;
 }
 
-PullStream *RtcStreamManager::_find_pull_stream(const std::string& stram_name) {
+PullStream *RtcStreamManager::_find_pull_stream(uint64_t uid, const std::string& stram_name) {
     auto iter = pull_streams_.find(stram_name);
-    if (iter != pull_streams_.end()) {
-        return iter->second;
+    if (iter == pull_streams_.end()) {
+        return nullptr;
+    }
+
+    auto uid_iter = iter->second.find(uid);
+    if (uid_iter != iter->second.end()) {
+        return uid_iter->second;
     }
     return nullptr;
 }
@@ -130,11 +286,48 @@ void RtcStreamManager::_remove_pull_stream(RtcStream* stream) {
 }
 
 void RtcStreamManager::_remove_pull_stream(uint64_t uid, const std::string& stream_name) {
-    PullStream* pull_stream = _find_pull_stream(stream_name);
-    if (pull_stream && uid == pull_stream->get_uid()) {
-        pull_streams_.erase(stream_name);
-        delete pull_stream;
+    auto iter = pull_streams_.find(stream_name);
+    if (iter == pull_streams_.end()) {
+        return;
+    }
+
+    auto uid_iter = iter->second.find(uid);
+    if (uid_iter == iter->second.end()) {
+        return;
     }
+
+    PullStream* pull_stream = uid_iter->second;
+    iter->second.erase(uid_iter);
+    if (iter->second.empty()) {
+        pull_streams_.erase(iter);
+    }
+
+    _delete_pull_stream(pull_stream);
+}
+
+void RtcStreamManager::_delete_pull_stream(PullStream* stream) {
+    const std::shared_ptr<RelayChannel>& channel = stream->relay_channel();
+    if (channel && relay_) {
+        auto iter = relay_subscribers_.find(channel->id);
+        if (iter != relay_subscribers_.end()) {
+            auto& subscribers = iter->second;
+            auto pos = std::find(subscribers.begin(), subscribers.end(), stream);
+            if (pos != subscribers.end()) {
+                *pos = subscribers.back();
+                subscribers.pop_back();
+            }
+
+            if (subscribers.empty()) {
+                relay_subscribers_.erase(iter);
+                relay_video_caches_.erase(channel->id);
+            }
+        }
+        relay_->unsubscribe(channel, worker_id_);
+    }
+
+    signal_stream_removed(stream);
+    // 析构时会从推流的订阅者列表中摘除
+    delete stream;
 }
 
 void RtcStreamManager::on_connection_state(RtcStream* stream, PeerConnectionState state) {
@@ -144,32 +337,690 @@ void RtcStreamManager::on_connection_state(RtcStream* stream, PeerConnectionStat
         } else if (stream->stream_type() == RtcStreamType::k_pull) {
             _remove_pull_stream(stream);
         }
-    } 
+    } else if (keyframe_cache_ && state == PeerConnectionState::k_connected
+            && stream->stream_type() == RtcStreamType::k_pull)
+    {
+        // 有缓存的关键帧时，在下一个帧边界先发送关键帧
+        PullStream* pull_stream = static_cast<PullStream*>(stream);
+        KeyframeCache* keyframe_cache = _find_keyframe_cache(pull_stream);
+        if (keyframe_cache && !keyframe_cache->empty()) {
+            pull_stream->set_waiting_keyframe(true);
+        }
+    }
 }
 
-void RtcStreamManager::on_rtp_packet_received(RtcStream* stream, const char* data, size_t len) {
+void RtcStreamManager::on_rtp_packet_received(RtcStream* stream, PacketBuffer* packet,
+        const RtpPacketView& rtp_packet, int64_t ts)
+{
+    // 所有订阅者共享同一份解密后的数据，只在各自加密时拷贝
+    const char* data = (const char*)packet->data();
+    size_t len = packet->size();
     if (RtcStreamType::k_push == stream->stream_type()) {
-        PullStream* pull_stream = _find_pull_stream(stream->get_stream_name());
-        if (pull_stream) {
-            pull_stream->send_rtp(data, len);
+        PushStream* push_stream = static_cast<PushStream*>(stream);
+        RtpPacketHistory* history = push_stream->packet_history();
+        if (nack_rtx_ && history && history->rtx_ssrc() && rtp_packet.ssrc() == history->rtx_ssrc()) {
+            // 服务端用推流者的RTX ssrc给订阅者发送自己封装的RTX包，推流者的RTX包不能原样转发，
+            // 还原成原始的媒体包，和订阅者的其它视频包使用同一个序号空间
+            PacketBufferPtr repaired = history->restore_rtx_packet(rtp_packet);
+            RtpPacketView repaired_packet;
+            if (repaired && repaired_packet.Parse(repaired->data(), repaired->size())
+                    && _forward_repaired_rtp(push_stream->subscribers(), history,
+                        repaired.get(), repaired_packet))
+            {
+                _relay_to_workers(push_stream, false, (const char*)repaired->data(),
+                        repaired->size(), true);
+            }
+            return;
+        }
+
+        if (history && rtp_packet.ssrc() == history->ssrc()) {
+            history->put(packet, rtp_packet.sequence_number());
         }
+
+        KeyframeCache* keyframe_cache = push_stream->keyframe_cache();
+        if (keyframe_cache && keyframe_cache->on_packet(packet, rtp_packet)) {
+            push_stream->set_last_keyframe_time(el_->now());
+        }
+
+        _forward_rtp(push_stream->subscribers(), keyframe_cache, rtp_packet, packet);
+        // 内核时间戳是系统时间，和EventLoop的单调时间不能比较
+        if (ts > 0 && !push_stream->subscribers().empty()) {
+            int64_t now = rtc::TimeUTCMicros();
+            forward_latency_.add(now > ts ? now - ts : 0);
+        }
+        _relay_to_workers(push_stream, false, data, len);
     }
 }
 
-void RtcStreamManager::on_rtcp_packet_received(RtcStream* stream,  const char* data, size_t len) {
+bool RtcStreamManager::_forward_repaired_rtp(const std::vector<PullStream*>& subscribers,
+        RtpPacketHistory* history, PacketBuffer* packet, const RtpPacketView& rtp_packet)
+{
+    // 服务端已经收到过的包，订阅者的NACK已经从缓存中响应
+    uint16_t seq = rtp_packet.sequence_number();
+    if (history) {
+        if (history->get(seq)) {
+            return false;
+        }
+        history->put(packet, seq);
+    }
+
+    // 等待关键帧的订阅者还没有开始接收视频，注入关键帧占用的序号对订阅者是其它包
+    for (auto subscriber : subscribers) {
+        if (subscriber->waiting_keyframe() || subscriber->waiting_live_keyframe()
+                || subscriber->is_keyframe_seq(seq))
+        {
+            continue;
+        }
+
+        subscriber->send_rtp(packet, rtp_packet, true);
+        ++forwarded_packets_;
+    }
+
+    return true;
+}
+
+void RtcStreamManager::on_rtcp_packet_received(RtcStream* stream, PacketBuffer* packet) {
+    const char* data = (const char*)packet->data();
+    size_t len = packet->size();
     if (RtcStreamType::k_push == stream->stream_type()) {
-        PullStream* pull_stream = _find_pull_stream(stream->get_stream_name());
-        if (pull_stream) {
-            pull_stream->send_rtcp(data, len);
+        PushStream* push_stream = static_cast<PushStream*>(stream);
+        // 推流者的RTCP由服务端的接收模块处理，订阅者收到的是服务端生成的SR，
+        // 只把推流者SR中的时间戳对应关系交给订阅者的发送模块，其它worker也需要
+        if (rtcp_termination_) {
+            _process_publisher_rtcp(push_stream->subscribers(), data, len);
+            _relay_to_workers(push_stream, true, data, len);
+            return;
         }
+
+        for (auto subscriber : push_stream->subscribers()) {
+            subscriber->send_rtcp(data, len);
+        }
+        _relay_to_workers(push_stream, true, data, len);
     } else if (RtcStreamType::k_pull == stream->stream_type()) {
-        PushStream* push_stream = _find_push_stream(stream->get_stream_name());
+        PullStream* pull_stream = static_cast<PullStream*>(stream);
+        PushStream* push_stream = pull_stream->publisher();
+
+        // 能从缓存中重传的NACK在本地处理，推流在本worker上时合并PLI/FIR，
+        // 剩下的部分再转发给推流者，远端推流的PLI/FIR由推流所在的worker合并
+        RtpPacketHistory* history = _find_packet_history(pull_stream);
+        len = _process_subscriber_rtcp(pull_stream, history, push_stream, data, len);
+        if (0 == len) {
+            return;
+        }
+        data = upstream_rtcp_.data();
+
         if (push_stream) {
-            push_stream->send_rtcp(data, len);
+            _send_upstream_rtcp(push_stream, data, len);
+            return;
+        }
+
+        const std::shared_ptr<RelayChannel>& channel = pull_stream->relay_channel();
+        if (channel && relay_) {
+            int publisher_worker = channel->publisher_worker.load(std::memory_order_relaxed);
+            if (publisher_worker >= 0 && publisher_worker != worker_id_) {
+                relay_->send_packet(worker_id_, publisher_worker, channel->id, true, true, data, len);
+            }
+        }
+    }
+}
+
+void RtcStreamManager::_relay_to_workers(PushStream* stream, bool rtcp, const char* data, size_t len,
+        bool repaired)
+{
+    const std::shared_ptr<RelayChannel>& channel = stream->relay_channel();
+    if (!channel || !relay_) {
+        return;
+    }
+
+    // 本worker的拉流者已经直接转发过，其它worker共享同一份拷贝
+    uint64_t mask = channel->worker_mask.load(std::memory_order_relaxed);
+    if (worker_id_ < k_relay_max_worker_num) {
+        mask &= ~((uint64_t)1 << worker_id_);
+    }
+    if (mask) {
+        relay_->send_packet(worker_id_, mask, channel->id, rtcp, false, data, len, repaired);
+    }
+}
+
+void RtcStreamManager::process_relay_packets() {
+    if (!relay_) {
+        return;
+    }
+
+    relay_packets_.clear();
+    relay_->recv_packets(worker_id_, relay_packets_);
+
+    for (auto packet : relay_packets_) {
+        if (packet->upstream) {
+            auto iter = relay_publishers_.find(packet->channel_id);
+            if (iter != relay_publishers_.end()) {
+                size_t len = _process_subscriber_rtcp(nullptr, nullptr, iter->second,
+                        packet->data, packet->len);
+                if (len > 0) {
+                    _send_upstream_rtcp(iter->second, upstream_rtcp_.data(), len);
+                }
+            }
+        } else if (!packet->rtcp) {
+            _process_relay_rtp(packet);
+        } else {
+            auto iter = relay_subscribers_.find(packet->channel_id);
+            if (iter != relay_subscribers_.end()) {
+                if (rtcp_termination_) {
+                    _process_publisher_rtcp(iter->second, packet->data, packet->len);
+                } else {
+                    for (auto subscriber : iter->second) {
+                        subscriber->send_rtcp(packet->data, packet->len);
+                    }
+                }
+            }
+        }
+
+        relay_->release_packet(worker_id_, packet);
+    }
+
+    relay_packets_.clear();
+}
+
+void RtcStreamManager::_process_relay_rtp(RelayPacket* packet) {
+    auto iter = relay_subscribers_.find(packet->channel_id);
+    if (iter == relay_subscribers_.end()) {
+        return;
+    }
+
+    // 远端推流的包在本worker上拷贝一份，转发给所有拉流者、响应NACK和发送给新的拉流者共用
+    PacketBufferPtr buffer = PacketBufferPool::current()->alloc(packet->data, packet->len);
+    if (!buffer) {
+        return;
+    }
+
+    RtpPacketView rtp_packet;
+    if (!rtp_packet.Parse(buffer->data(), buffer->size())) {
+        return;
+    }
+
+    KeyframeCache* keyframe_cache = nullptr;
+    auto cache_iter = relay_video_caches_.find(packet->channel_id);
+    if (packet->repaired) {
+        RtpPacketHistory* history = cache_iter != relay_video_caches_.end() ?
+            cache_iter->second.history.get() : nullptr;
+        _forward_repaired_rtp(iter->second, history, buffer.get(), rtp_packet);
+        return;
+    }
+
+    if (cache_iter != relay_video_caches_.end()) {
+        RelayVideoCache& cache = cache_iter->second;
+        keyframe_cache = cache.keyframe_cache.get();
+
+        uint32_t ssrc = cache.history ? cache.history->ssrc() :
+            (keyframe_cache ? keyframe_cache->ssrc() : 0);
+        if (ssrc && ssrc == rtp_packet.ssrc()) {
+            if (cache.history) {
+                cache.history->put(buffer.get(), rtp_packet.sequence_number());
+            }
+            if (keyframe_cache) {
+                keyframe_cache->on_packet(buffer.get(), rtp_packet);
+            }
+        }
+    }
+
+    _forward_rtp(iter->second, keyframe_cache, rtp_packet, buffer.get());
+}
+
+void RtcStreamManager::_forward_rtp(const std::vector<PullStream*>& subscribers,
+        KeyframeCache* keyframe_cache, const RtpPacketView& rtp_packet, PacketBuffer* packet)
+{
+    bool video = keyframe_cache && (rtp_packet.ssrc() == keyframe_cache->ssrc()
+            || (keyframe_cache->rtx_ssrc() && rtp_packet.ssrc() == keyframe_cache->rtx_ssrc()));
+
+    // 实时关键帧的第一个包，等待实时关键帧的订阅者从这里开始接收
+    bool keyframe_start = video && rtp_packet.ssrc() == keyframe_cache->ssrc()
+        && keyframe_cache->keyframe_start();
+
+    bool waiting = false;
+    for (auto subscriber : subscribers) {
+        if (video && subscriber->waiting_keyframe()) {
+            // 实时关键帧正好开始，不需要缓存的关键帧
+            if (!keyframe_start) {
+                waiting = true;
+                continue;
+            }
+            subscriber->set_waiting_keyframe(false);
+        }
+
+        if (video && subscriber->waiting_live_keyframe()) {
+            if (!keyframe_start) {
+                _drop_until_live_keyframe(subscriber, keyframe_cache, rtp_packet);
+                continue;
+            }
+            subscriber->set_waiting_live_keyframe(false);
+        }
+
+        subscriber->send_rtp(packet, rtp_packet);
+        ++forwarded_packets_;
+    }
+
+    // 帧边界，等待的订阅者先收到缓存的关键帧，占用的序号正好接上前面已经转发过的包
+    if (waiting && rtp_packet.marker() && rtp_packet.ssrc() == keyframe_cache->ssrc()) {
+        for (auto subscriber : subscribers) {
+            if (subscriber->waiting_keyframe()) {
+                _send_cached_keyframe(subscriber, keyframe_cache, rtp_packet);
+            }
         }
     }
 }
 
+void RtcStreamManager::_send_cached_keyframe(PullStream* stream, KeyframeCache* keyframe_cache,
+        const RtpPacketView& rtp_packet)
+{
+    stream->set_waiting_keyframe(false);
+
+    const std::vector<PacketBufferPtr>& packets = keyframe_cache->packets();
+    if (packets.empty()) {
+        return;
+    }
+
+    // 缓存的就是刚结束的这一帧时，原样发送，之后的实时包可以直接解码
+    uint16_t count = packets.size();
+    bool live = keyframe_cache->keyframe_last_seq() == rtp_packet.sequence_number()
+        && keyframe_cache->keyframe_timestamp() == rtp_packet.timestamp();
+    if (live) {
+        for (const PacketBufferPtr& packet : packets) {
+            stream->send_rtp(packet.get());
+        }
+        RTC_LOG(LS_INFO) << stream->to_string() << ": send live keyframe, packets: " << count;
+        return;
+    }
+
+    // 关键帧占用当前包及之前的序号，时间戳使用当前帧的，订阅者没有收到过这些序号和这一帧
+    uint16_t seq = rtp_packet.sequence_number() - count + 1;
+    uint32_t timestamp = rtp_packet.timestamp();
+    stream->set_keyframe_seq_range(seq, count);
+
+    for (const PacketBufferPtr& packet : packets) {
+        PacketBufferPtr copy = PacketBufferPool::current()->alloc(packet->data(), packet->size());
+        uint8_t* data = copy->data();
+        webrtc::ByteWriter<uint16_t>::WriteBigEndian(data + 2, seq++);
+        webrtc::ByteWriter<uint32_t>::WriteBigEndian(data + 4, timestamp);
+        stream->send_rtp(copy.get());
+    }
+
+    // 后面的实时P帧参考的不是缓存的关键帧，向推流者请求新的关键帧，收到之前不再转发视频
+    stream->set_waiting_live_keyframe(true);
+    _request_keyframe(stream, keyframe_cache->ssrc());
+
+    RTC_LOG(LS_INFO) << stream->to_string() << ": send cached keyframe, packets: " << count;
+}
+
+void RtcStreamManager::_drop_until_live_keyframe(PullStream* stream, KeyframeCache* keyframe_cache,
+        const RtpPacketView& rtp_packet)
+{
+    if (rtp_packet.ssrc() != keyframe_cache->ssrc()) {
+        return;
+    }
+
+    // 丢弃的序号在订阅者看来是丢包，NACK不能用这些P帧响应
+    stream->extend_keyframe_seq_range(rtp_packet.sequence_number());
+
+    // 每一帧结束时再请求一次，请求本身由_allow_keyframe_request合并，
+    // 上一次请求被合并掉或者关键帧的第一个包丢了时不会一直等到下一个GOP
+    if (rtp_packet.marker()) {
+        _request_keyframe(stream, keyframe_cache->ssrc());
+    }
+}
+
+void RtcStreamManager::_request_keyframe(PullStream* stream, uint32_t media_ssrc) {
+    // RFC 4585 PLI
+    uint8_t pli[k_rtcp_pli_size];
+    pli[0] = 0x80 | k_psfb_pli;
+    pli[1] = k_rtcp_psfb;
+    webrtc::ByteWriter<uint16_t>::WriteBigEndian(pli + 2, k_rtcp_pli_size / 4 - 1);
+    webrtc::ByteWriter<uint32_t>::WriteBigEndian(pli + 4, 0);
+    webrtc::ByteWriter<uint32_t>::WriteBigEndian(pli + 8, media_ssrc);
+
+    PushStream* push_stream = stream->publisher();
+    if (push_stream) {
+        if (_allow_keyframe_request(push_stream)) {
+            _send_upstream_rtcp(push_stream, (const char*)pli, sizeof(pli));
+        }
+        return;
+    }
+
+    // 远端推流由推流所在的worker合并
+    const std::shared_ptr<RelayChannel>& channel = stream->relay_channel();
+    if (channel && relay_) {
+        int publisher_worker = channel->publisher_worker.load(std::memory_order_relaxed);
+        if (publisher_worker >= 0 && publisher_worker != worker_id_) {
+            relay_->send_packet(worker_id_, publisher_worker, channel->id, true, true,
+                    (const char*)pli, sizeof(pli));
+        }
+    }
+}
+
+int RtcStreamManager::detach_stream(const std::string& stream_name, StreamMigration* migration) {
+    PushStream* push_stream = _find_push_stream(stream_name);
+    if (!push_stream) {
+        RTC_LOG(LS_WARNING) << "migrate stream not found, stream_name: " << stream_name
+            << ", worker_id: " << worker_id_;
+        return -1;
+    }
+
+    // 所有会话都可以迁移时才迁移，避免推流和拉流分散在不同的worker上
+    bool can_migrate = push_stream->can_migrate();
+    for (auto subscriber : push_stream->subscribers()) {
+        can_migrate = can_migrate && subscriber->can_migrate();
+    }
+
+    if (!can_migrate) {
+        RTC_LOG(LS_WARNING) << "stream can not migrate, stream_name: " << stream_name
+            << ", worker_id: " << worker_id_;
+        return -1;
+    }
+
+    migration->src_worker = worker_id_;
+    migration->stream_name = stream_name;
+    migration->push_stream = push_stream;
+    migration->pull_streams = push_stream->subscribers();
+
+    push_streams_.erase(stream_name);
+    const std::shared_ptr<RelayChannel>& channel = push_stream->relay_channel();
+    if (channel) {
+        relay_publishers_.erase(channel->id);
+    }
+
+    auto iter = pull_streams_.find(stream_name);
+    for (auto pull_stream : migration->pull_streams) {
+        if (iter != pull_streams_.end()) {
+            iter->second.erase(pull_stream->get_uid());
+        }
+    }
+    if (iter != pull_streams_.end() && iter->second.empty()) {
+        pull_streams_.erase(iter);
+    }
+
+    // 缓存的包属于当前worker的缓冲池，不能带到其它worker上释放
+    if (push_stream->packet_history()) {
+        push_stream->packet_history()->clear();
+    }
+    if (push_stream->keyframe_cache()) {
+        push_stream->keyframe_cache()->clear();
+    }
+
+    push_stream->register_listener(nullptr);
+    push_stream->detach_event_loop();
+    for (auto pull_stream : migration->pull_streams) {
+        pull_stream->register_listener(nullptr);
+        pull_stream->detach_event_loop();
+    }
+
+    RTC_LOG(LS_INFO) << "detach stream, stream_name: " << stream_name
+        << ", subscribers: " << migration->pull_streams.size()
+        << ", worker_id: " << worker_id_;
+
+    return 0;
+}
+
+void RtcStreamManager::attach_stream(StreamMigration* migration) {
+    PushStream* push_stream = migration->push_stream;
+    const std::string& stream_name = migration->stream_name;
+
+    // 路由已经指向本worker，正常情况下不会有同名的会话，有的话以迁移过来的为准
+    PushStream* old_push_stream = _find_push_stream(stream_name);
+    if (old_push_stream) {
+        push_streams_.erase(stream_name);
+        _delete_push_stream(old_push_stream);
+    }
+
+    push_stream->attach_event_loop(el_, port_allocator_.get());
+    push_stream->register_listener(this);
+    push_streams_[stream_name] = push_stream;
+
+    for (auto pull_stream : migration->pull_streams) {
+        _remove_pull_stream(pull_stream->get_uid(), stream_name);
+        pull_stream->attach_event_loop(el_, port_allocator_.get());
+        pull_stream->register_listener(this);
+        pull_streams_[stream_name][pull_stream->get_uid()] = pull_stream;
+    }
+
+    const std::shared_ptr<RelayChannel>& channel = push_stream->relay_channel();
+    if (channel && relay_) {
+        relay_->move_publisher(channel, migration->src_worker, worker_id_);
+        relay_publishers_[channel->id] = push_stream;
+
+        // 本worker上原来通过StreamRelay接收的拉流者，改为直接订阅
+        auto iter = relay_subscribers_.find(channel->id);
+        if (iter != relay_subscribers_.end()) {
+            for (auto pull_stream : iter->second) {
+                relay_->unsubscribe(channel, worker_id_);
+                pull_stream->set_relay_channel(nullptr);
+                push_stream->add_subscriber(pull_stream);
+            }
+            relay_subscribers_.erase(iter);
+            relay_video_caches_.erase(channel->id);
+        }
+    }
+
+    RTC_LOG(LS_INFO) << "attach stream, stream_name: " << stream_name
+        << ", subscribers: " << push_stream->subscribers().size()
+        << ", src_worker: " << migration->src_worker
+        << ", worker_id: " << worker_id_;
+}
+
+// 只缓存第一路视频，RTX的ssrc来自FID分组
+static bool get_video_ssrc(const std::vector<StreamParams>& video_source,
+        uint32_t* ssrc, uint32_t* rtx_ssrc)
+{
+    for (const StreamParams& stream : video_source) {
+        if (stream.ssrcs.empty()) {
+            continue;
+        }
+
+        *ssrc = stream.ssrcs[0];
+        *rtx_ssrc = 0;
+        for (const SsrcGroup& group : stream.ssrc_groups) {
+            if (group.semantics == "FID" && group.ssrcs.size() >= 2 && group.ssrcs[0] == *ssrc) {
+                *rtx_ssrc = group.ssrcs[1];
+                break;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+std::unique_ptr<RtpPacketHistory> RtcStreamManager::_create_packet_history(
+        const std::vector<StreamParams>& video_source)
+{
+    uint32_t ssrc = 0;
+    uint32_t rtx_ssrc = 0;
+    if (nack_history_size_ <= 0 || !get_video_ssrc(video_source, &ssrc, &rtx_ssrc)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<RtpPacketHistory> history =
+        std::make_unique<RtpPacketHistory>(nack_history_size_);
+    history->set_ssrc(ssrc, rtx_ssrc);
+    return history;
+}
+
+std::unique_ptr<KeyframeCache> RtcStreamManager::_create_keyframe_cache(
+        const std::vector<StreamParams>& video_source)
+{
+    uint32_t ssrc = 0;
+    uint32_t rtx_ssrc = 0;
+    if (!get_video_ssrc(video_source, &ssrc, &rtx_ssrc)) {
+        return nullptr;
+    }
+
+    return std::make_unique<KeyframeCache>(ssrc, rtx_ssrc);
+}
+
+RtpPacketHistory* RtcStreamManager::_find_packet_history(PullStream* stream) {
+    PushStream* push_stream = stream->publisher();
+    if (push_stream) {
+        return push_stream->packet_history();
+    }
+
+    const std::shared_ptr<RelayChannel>& channel = stream->relay_channel();
+    if (channel) {
+        auto iter = relay_video_caches_.find(channel->id);
+        if (iter != relay_video_caches_.end()) {
+            return iter->second.history.get();
+        }
+    }
+
+    return nullptr;
+}
+
+KeyframeCache* RtcStreamManager::_find_keyframe_cache(PullStream* stream) {
+    PushStream* push_stream = stream->publisher();
+    if (push_stream) {
+        return push_stream->keyframe_cache();
+    }
+
+    const std::shared_ptr<RelayChannel>& channel = stream->relay_channel();
+    if (channel) {
+        auto iter = relay_video_caches_.find(channel->id);
+        if (iter != relay_video_caches_.end()) {
+            return iter->second.keyframe_cache.get();
+        }
+    }
+
+    return nullptr;
+}
+
+size_t RtcStreamManager::_process_subscriber_rtcp(PullStream* stream, RtpPacketHistory* history,
+        PushStream* publisher, const char* data, size_t len)
+{
+    upstream_rtcp_.clear();
+
+    const uint8_t* packet = (const uint8_t*)data;
+    const uint8_t* packet_end = packet + len;
+    rtcp::CommonHeader header;
+    for (; packet < packet_end; packet = header.NextPacket()) {
+        if (!header.Parse(packet, packet_end - packet)) {
+            // 解析不了的包原样转发
+            upstream_rtcp_.assign(data, len);
+            return len;
+        }
+
+        // 订阅者的SR/RR/SDES等报告在服务端终结，推流者只收到服务端自己的RR，
+        // 只有反馈消息继续处理
+        if (rtcp_termination_ && k_rtcp_rtpfb != header.packet_type()
+                && k_rtcp_psfb != header.packet_type())
+        {
+            continue;
+        }
+
+        if (history && rtcp::Nack::kPacketType == header.packet_type()
+                && rtcp::Nack::kFeedbackMessageType == header.fmt())
+        {
+            rtcp::Nack nack;
+            if (nack.Parse(header) && nack.media_ssrc() == history->ssrc()) {
+                // 转发的视频ssrc的NACK全部在这里终结，历史中没有的包也不转发：
+                // 服务端自己没有收到的包由推流端的NackRequester向推流者请求，
+                // 所有订阅者的丢包只会在上行请求一次
+                _retransmit_packets(stream, history, nack.packet_ids());
+                continue;
+            }
+        }
+
+        if (publisher && k_rtcp_psfb == header.packet_type()
+                && (k_psfb_pli == header.fmt() || k_psfb_fir == header.fmt())
+                && !_allow_keyframe_request(publisher))
+        {
+            continue;
+        }
+
+        upstream_rtcp_.append((const char*)packet, header.NextPacket() - packet);
+    }
+
+    return upstream_rtcp_.size();
+}
+
+void RtcStreamManager::_process_publisher_rtcp(const std::vector<PullStream*>& subscribers,
+        const char* data, size_t len)
+{
+    if (subscribers.empty()) {
+        return;
+    }
+
+    const uint8_t* packet = (const uint8_t*)data;
+    const uint8_t* packet_end = packet + len;
+    rtcp::CommonHeader header;
+    for (; packet < packet_end; packet = header.NextPacket()) {
+        if (!header.Parse(packet, packet_end - packet)) {
+            return;
+        }
+
+        // SR: sender ssrc(4) NTP(8) RTP timestamp(4) packet count(4) octet count(4)
+        if (k_rtcp_sr != header.packet_type() || header.payload_size() < k_rtcp_sr_info_size) {
+            continue;
+        }
+
+        uint32_t ssrc = webrtc::ByteReader<uint32_t>::ReadBigEndian(header.payload());
+        uint32_t rtp_timestamp = webrtc::ByteReader<uint32_t>::ReadBigEndian(header.payload() + 12);
+        for (auto subscriber : subscribers) {
+            subscriber->on_publisher_sender_report(ssrc, rtp_timestamp);
+        }
+    }
+}
+
+void RtcStreamManager::_send_upstream_rtcp(PushStream* stream, const char* data, size_t len) {
+    ++upstream_rtcp_packets_;
+    stream->send_rtcp(data, len);
+}
+
+bool RtcStreamManager::_allow_keyframe_request(PushStream* stream) {
+    if (keyframe_request_interval_ <= 0) {
+        return true;
+    }
+
+    // 间隔内已经收到过关键帧，订阅者很快就能收到，或者已经转发过一次请求
+    unsigned long now = el_->now();
+    unsigned long interval = (unsigned long)keyframe_request_interval_ * 1000;
+    if ((stream->last_keyframe_time() && now - stream->last_keyframe_time() < interval)
+            || (stream->last_keyframe_request_time()
+                && now - stream->last_keyframe_request_time() < interval))
+    {
+        ++suppressed_keyframe_requests_;
+        return false;
+    }
+
+    stream->set_last_keyframe_request_time(now);
+    return true;
+}
+
+void RtcStreamManager::_retransmit_packets(PullStream* stream, RtpPacketHistory* history,
+        const std::vector<uint16_t>& seqs)
+{
+    uint8_t rtx_payload_type = nack_rtx_ ? stream->video_rtx_payload_type() : 0;
+    for (uint16_t seq : seqs) {
+        // 注入关键帧占用的序号在缓存中对应的是其它包
+        if (stream->is_keyframe_seq(seq)) {
+            continue;
+        }
+
+        PacketBuffer* packet = history->get(seq);
+        if (!packet) {
+            continue;
+        }
+
+        if (rtx_payload_type && history->rtx_ssrc()) {
+            PacketBufferPtr rtx_packet = history->build_rtx_packet(packet, rtx_payload_type,
+                    stream->next_rtx_seq());
+            if (rtx_packet) {
+                stream->send_rtp(rtx_packet.get(), true);
+                ++retransmitted_packets_;
+                continue;
+            }
+        }
+
+        stream->send_rtp(packet, true);
+        ++retransmitted_packets_;
+    }
+}
+
 void RtcStreamManager::on_stream_exception(RtcStream* stream) {
     if (RtcStreamType::k_push == stream->stream_type()) {
         _remove_push_stream(stream);
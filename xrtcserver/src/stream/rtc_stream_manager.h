@@ -11,9 +11,11 @@
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 #include <rtc_base/rtc_certificate.h>
 
+#include "base/latency_histogram.h"
 #include "stream/rtc_stream.h"
 #include "xrtcserver_def.h"
 
@@ -23,37 +25,137 @@ class EventLoop;
 class PushStream;
 class PortAllocator;
 class PullStream;
+class StreamRelay;
+class RtpPacketHistory;
+class KeyframeCache;
+struct RelayPacket;
+
+// 迁移中的推流和它在本worker上的拉流，从源worker摘下之后交给目标worker
+struct StreamMigration {
+    int src_worker = -1;
+    std::string stream_name;
+    PushStream* push_stream = nullptr;
+    std::vector<PullStream*> pull_streams;
+};
+
+// 远端推流的视频在本worker上的缓存，本worker上订阅同一个通道的拉流者共享
+struct RelayVideoCache {
+    std::unique_ptr<RtpPacketHistory> history;
+    std::unique_ptr<KeyframeCache> keyframe_cache;
+};
 
 class RtcStreamManager : public RtcStreamListener {
 public:
-    RtcStreamManager(EventLoop *el);
+    RtcStreamManager(EventLoop *el, int worker_id = 0, StreamRelay* relay = nullptr);
     ~RtcStreamManager();
 
 public:
     int create_push_stream(const std::shared_ptr<RtcMsg>& msg, std::string& answer);
     int create_pull_stream(const std::shared_ptr<RtcMsg>& msg, std::string& answer);
 
-    int stop_push(uint64_t uid, const std::string& stream_name);
-    int stop_pull(uint64_t uid, const std::string& stream_name);
+    // WHIP/WHEP创建的会话需要带上创建时的令牌，会话不存在或者令牌不一致时返回-1
+    int stop_push(uint64_t uid, const std::string& stream_name, const std::string& session_token);
+    int stop_pull(uint64_t uid, const std::string& stream_name, const std::string& session_token);
 
     void on_connection_state(RtcStream* stream, PeerConnectionState state) override;
-    void on_rtp_packet_received(RtcStream* stream, const char* data, size_t len) override;
-    void on_rtcp_packet_received(RtcStream* stream, const char* data, size_t len) override;
+    void on_rtp_packet_received(RtcStream* stream, PacketBuffer* packet,
+            const RtpPacketView& rtp_packet, int64_t ts) override;
+    void on_rtcp_packet_received(RtcStream* stream, PacketBuffer* packet) override;
     void on_stream_exception(RtcStream* stream);
+
+    // 处理其他worker通过StreamRelay转发过来的包
+    void process_relay_packets();
+
+    // 把推流和订阅它的拉流从当前EventLoop摘下，交给其它worker，
+    // 共享端口或者还没有建立连接的会话不能迁移，失败时返回-1，不做任何修改
+    int detach_stream(const std::string& stream_name, StreamMigration* migration);
+    // 在目标worker线程调用，接管迁移过来的会话
+    void attach_stream(StreamMigration* migration);
+
+    // 转发给拉流者的RTP包的累计个数
+    uint64_t forwarded_packets() { return forwarded_packets_; }
+    // 从缓存中重传给拉流者的RTP包的累计个数
+    uint64_t retransmitted_packets() { return retransmitted_packets_; }
+    // 合并之后没有转发给推流者的PLI/FIR的累计个数
+    uint64_t suppressed_keyframe_requests() { return suppressed_keyframe_requests_; }
+    // 由订阅者触发发给推流者的RTCP包(转发的反馈和关键帧请求)的累计个数，
+    // 不包括推流端接收模块自己的RR/NACK，RTCP终结时不随订阅者个数增长
+    uint64_t upstream_rtcp_packets() { return upstream_rtcp_packets_; }
+    // 推流的RTP包从内核收到到交给本worker上所有拉流者发送的耗时分布，
+    // 不包括之后批量发送的等待时间和转给其它worker的部分
+    const LatencyHistogram& forward_latency() { return forward_latency_; }
+
+    // 会话创建和销毁，迁移不会触发
+    sigslot::signal1<RtcStream*> signal_stream_created;
+    sigslot::signal1<RtcStream*> signal_stream_removed;
     
 private:
     PushStream *_find_push_stream(const std::string& stram_name);
     void _remove_push_stream(RtcStream* stream);
     void _remove_push_stream(uint64_t uid, const std::string& stream_name);
-    PullStream *_find_pull_stream(const std::string& stram_name);
+    PullStream *_find_pull_stream(uint64_t uid, const std::string& stram_name);
     void _remove_pull_stream(RtcStream* stream);
     void _remove_pull_stream(uint64_t uid, const std::string& stream_name);
+    void _delete_push_stream(PushStream* stream);
+    void _delete_pull_stream(PullStream* stream);
+    void _relay_to_workers(PushStream* stream, bool rtcp, const char* data, size_t len,
+            bool repaired = false);
+    std::unique_ptr<RtpPacketHistory> _create_packet_history(
+            const std::vector<StreamParams>& video_source);
+    std::unique_ptr<KeyframeCache> _create_keyframe_cache(
+            const std::vector<StreamParams>& video_source);
+    RtpPacketHistory* _find_packet_history(PullStream* stream);
+    KeyframeCache* _find_keyframe_cache(PullStream* stream);
+    void _forward_rtp(const std::vector<PullStream*>& subscribers, KeyframeCache* keyframe_cache,
+            const RtpPacketView& rtp_packet, PacketBuffer* packet);
+    void _send_cached_keyframe(PullStream* stream, KeyframeCache* keyframe_cache,
+            const RtpPacketView& rtp_packet);
+    void _drop_until_live_keyframe(PullStream* stream, KeyframeCache* keyframe_cache,
+            const RtpPacketView& rtp_packet);
+    void _request_keyframe(PullStream* stream, uint32_t media_ssrc);
+    void _process_relay_rtp(RelayPacket* packet);
+    bool _forward_repaired_rtp(const std::vector<PullStream*>& subscribers,
+            RtpPacketHistory* history, PacketBuffer* packet, const RtpPacketView& rtp_packet);
+    size_t _process_subscriber_rtcp(PullStream* stream, RtpPacketHistory* history,
+            PushStream* publisher, const char* data, size_t len);
+    void _process_publisher_rtcp(const std::vector<PullStream*>& subscribers,
+            const char* data, size_t len);
+    void _send_upstream_rtcp(PushStream* stream, const char* data, size_t len);
+    bool _allow_keyframe_request(PushStream* stream);
+    void _retransmit_packets(PullStream* stream, RtpPacketHistory* history,
+            const std::vector<uint16_t>& seqs);
 
 private:
     EventLoop *el_;
     std::unordered_map<std::string, PushStream*> push_streams_;
-    std::unordered_map<std::string, PullStream*> pull_streams_;
+    // stream_name -> (uid -> PullStream)，同一路推流可以有多个拉流者
+    std::unordered_map<std::string, std::unordered_map<uint64_t, PullStream*>> pull_streams_;
     std::unique_ptr<PortAllocator> port_allocator_;
+
+    int worker_id_;
+    StreamRelay* relay_;
+    // channel_id -> 本worker上的远端拉流者/推流者
+    std::unordered_map<uint32_t, std::vector<PullStream*>> relay_subscribers_;
+    std::unordered_map<uint32_t, PushStream*> relay_publishers_;
+    std::vector<RelayPacket*> relay_packets_;
+    // channel_id -> 本worker上远端拉流者共享的视频缓存
+    std::unordered_map<uint32_t, RelayVideoCache> relay_video_caches_;
+    uint64_t forwarded_packets_ = 0;
+    uint64_t retransmitted_packets_ = 0;
+    uint64_t suppressed_keyframe_requests_ = 0;
+    uint64_t upstream_rtcp_packets_ = 0;
+    LatencyHistogram forward_latency_;
+
+    int nack_history_size_;
+    bool nack_rtx_;
+    bool keyframe_cache_;
+    int keyframe_request_interval_;
+    bool rtcp_termination_;
+    bool pacing_;
+    int pacing_start_bitrate_;
+    int pacing_max_bitrate_;
+    // 订阅者的RTCP去掉本地处理的NACK和合并掉的PLI/FIR之后，需要继续转发给推流者的部分
+    std::string upstream_rtcp_;
 };
 
 } // end namespace xrtc
@@ -0,0 +1,119 @@
+#include <string.h>
+
+#include <modules/rtp_rtcp/source/byte_io.h>
+
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+#include "stream/rtp_packet_history.h"
+
+namespace xrtc {
+
+const size_t k_rtx_header_size = 2;
+
+static size_t round_up_pow2(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+RtpPacketHistory::RtpPacketHistory(size_t capacity) :
+    entries_(round_up_pow2(capacity > 0 ? capacity : 1)),
+    mask_(entries_.size() - 1)
+{
+}
+
+RtpPacketHistory::~RtpPacketHistory() {
+}
+
+void RtpPacketHistory::set_ssrc(uint32_t ssrc, uint32_t rtx_ssrc) {
+    if (ssrc != ssrc_) {
+        clear();
+    }
+
+    ssrc_ = ssrc;
+    rtx_ssrc_ = rtx_ssrc;
+}
+
+void RtpPacketHistory::put(PacketBuffer* packet, uint16_t seq) {
+    Entry& entry = entries_[seq & mask_];
+    entry.packet = packet;
+    entry.seq = seq;
+    payload_type_ = packet->data()[1] & 0x7f;
+}
+
+PacketBuffer* RtpPacketHistory::get(uint16_t seq) const {
+    const Entry& entry = entries_[seq & mask_];
+    if (!entry.packet || entry.seq != seq) {
+        return nullptr;
+    }
+
+    return entry.packet.get();
+}
+
+PacketBufferPtr RtpPacketHistory::build_rtx_packet(const PacketBuffer* packet,
+        uint8_t rtx_payload_type, uint16_t rtx_seq)
+{
+    RtpPacketView view;
+    if (0 == rtx_ssrc_ || !view.Parse(packet->data(), packet->size())) {
+        return nullptr;
+    }
+
+    size_t header_size = view.header_size();
+    size_t payload_size = view.payload_size();
+
+    PacketBufferPtr rtx = PacketBufferPool::current()->alloc();
+    if (header_size + k_rtx_header_size + payload_size > rtx->capacity()) {
+        return nullptr;
+    }
+
+    uint8_t* data = rtx->data();
+    memcpy(data, packet->data(), header_size);
+    // 去掉padding标志，保留marker
+    data[0] &= ~0x20;
+    data[1] = (data[1] & 0x80) | (rtx_payload_type & 0x7f);
+    webrtc::ByteWriter<uint16_t>::WriteBigEndian(data + 2, rtx_seq);
+    webrtc::ByteWriter<uint32_t>::WriteBigEndian(data + 8, rtx_ssrc_);
+    // 原始序号
+    webrtc::ByteWriter<uint16_t>::WriteBigEndian(data + header_size, view.sequence_number());
+    memcpy(data + header_size + k_rtx_header_size, view.payload().data(), payload_size);
+    rtx->set_size(header_size + k_rtx_header_size + payload_size);
+
+    return rtx;
+}
+
+PacketBufferPtr RtpPacketHistory::restore_rtx_packet(const RtpPacketView& rtx_packet) {
+    if (payload_type_ < 0 || rtx_packet.payload_size() <= k_rtx_header_size) {
+        return nullptr;
+    }
+
+    size_t header_size = rtx_packet.header_size();
+    size_t payload_size = rtx_packet.payload_size() - k_rtx_header_size;
+    const uint8_t* payload = rtx_packet.payload().data();
+
+    PacketBufferPtr packet = PacketBufferPool::current()->alloc();
+    if (header_size + payload_size > packet->capacity()) {
+        return nullptr;
+    }
+
+    // RTX包头之后是原始序号，去掉padding标志，保留marker
+    uint8_t* data = packet->data();
+    memcpy(data, rtx_packet.data(), header_size);
+    data[0] &= ~0x20;
+    data[1] = (data[1] & 0x80) | (uint8_t)payload_type_;
+    webrtc::ByteWriter<uint16_t>::WriteBigEndian(data + 2,
+            webrtc::ByteReader<uint16_t>::ReadBigEndian(payload));
+    webrtc::ByteWriter<uint32_t>::WriteBigEndian(data + 8, ssrc_);
+    memcpy(data + header_size, payload + k_rtx_header_size, payload_size);
+    packet->set_size(header_size + payload_size);
+
+    return packet;
+}
+
+void RtpPacketHistory::clear() {
+    for (auto& entry : entries_) {
+        entry.packet = nullptr;
+    }
+}
+
+} // namespace xrtc
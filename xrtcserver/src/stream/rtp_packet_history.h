@@ -0,0 +1,69 @@
+/**
+ * @file rtp_packet_history.h
+ * @author charles
+ * @brief 一路视频最近收到的RTP包，按序号下标存放在环形数组中，
+ *         同一路流的所有订阅者共享，收到订阅者的NACK时直接从这里重传，
+ *         保存的是worker线程的PacketBuffer，只能在所属worker线程中使用
+*/
+
+#ifndef __STREAM_RTP_PACKET_HISTORY_H_
+#define __STREAM_RTP_PACKET_HISTORY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "base/packet_buffer.h"
+
+namespace xrtc {
+
+class RtpPacketView;
+
+class RtpPacketHistory {
+public:
+    // capacity向上取整为2的幂
+    explicit RtpPacketHistory(size_t capacity);
+    ~RtpPacketHistory();
+
+    // 只保存ssrc的包，rtx_ssrc为0时不能封装RTX
+    void set_ssrc(uint32_t ssrc, uint32_t rtx_ssrc);
+    uint32_t ssrc() const { return ssrc_; }
+    uint32_t rtx_ssrc() const { return rtx_ssrc_; }
+
+    // 增加一次引用，不拷贝数据，被更新的包覆盖之后释放
+    void put(PacketBuffer* packet, uint16_t seq);
+    // 没有收到或者已经被覆盖时返回nullptr
+    PacketBuffer* get(uint16_t seq) const;
+
+    // 按RFC4588封装成RTX包: ssrc和payload type替换为RTX的，序号使用rtx_seq，
+    // 包头之后插入原始序号，去掉padding，失败时返回nullptr。
+    // 每个订阅者的RTX序号各自连续，由调用方维护
+    PacketBufferPtr build_rtx_packet(const PacketBuffer* packet, uint8_t rtx_payload_type,
+            uint16_t rtx_seq);
+    // 把推流者的RTX包还原成原始的媒体包，payload type使用最近保存的媒体包的，
+    // 只有padding的RTX包或者还没有保存过媒体包时返回nullptr
+    PacketBufferPtr restore_rtx_packet(const RtpPacketView& rtx_packet);
+
+    // 释放所有保存的包，迁移到其它worker之前必须调用
+    void clear();
+
+    size_t capacity() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        PacketBufferPtr packet;
+        uint16_t seq = 0;
+    };
+
+    std::vector<Entry> entries_;
+    size_t mask_;
+    uint32_t ssrc_ = 0;
+    uint32_t rtx_ssrc_ = 0;
+    // 最近保存的媒体包的payload type，还原RTX包时使用
+    int payload_type_ = -1;
+};
+
+} // namespace xrtc
+
+#endif // __STREAM_RTP_PACKET_HISTORY_H_
@@ -33,6 +33,7 @@ std::unique_ptr<ModuleRtpRtcpImpl> CreateRtpRtcpModule(EventLoop* el, webrtc::Cl
 
 VideoReceiveStream::VideoReceiveStream(EventLoop* el, webrtc::Clock* clock, 
 	const VideoReceiveStreamConfig& config) :
+    el_(el),
 	config_(config),
     rtp_receive_statistics_(ReceiveStatistics::Create(clock)),
     rtp_rtcp_(CreateRtpRtcpModule(el, clock, config, rtp_receive_statistics_.get())),
@@ -68,14 +69,22 @@ void VideoReceiveStream::OnSendingRtpFrame(uint32_t rtp_timestamp,
     rtp_rtcp_->OnSendingRtpFrame(rtp_timestamp, capture_time_ms, forced_report);
 }
 
+void VideoReceiveStream::DetachEventLoop() {
+    rtp_rtcp_->DetachEventLoop();
+    nack_module_->DetachEventLoop();
+}
+
+void VideoReceiveStream::AttachEventLoop(EventLoop* el) {
+    el_ = el;
+    rtp_rtcp_->AttachEventLoop(el);
+    nack_module_->AttachEventLoop(el);
+}
+
 void VideoReceiveStream::DeliverRtcp(const uint8_t* packet, size_t length) {
     rtp_rtcp_->IncomingRtcpPacket(packet, length);
 }
 
-void VideoReceiveStream::DeliverRtp(const uint8_t* packet, size_t length) {
-    RtpPacketReceived rtp_packet;
-    rtp_packet.Parse(packet, length);
-
+void VideoReceiveStream::DeliverRtp(const RtpPacketView& rtp_packet) {
     rtp_receive_statistics_->OnRtpPacket(rtp_packet);
 
     // NACK检查
@@ -96,7 +105,7 @@ void VideoReceiveStream::DeliverRtp(const uint8_t* packet, size_t length) {
 
 VideoReceiveStream::ParseGenericDependenciesResult
 VideoReceiveStream::ParseGenericDependenciesExtension(
-    const RtpPacketReceived& rtp_packet, webrtc::RTPVideoHeader* video_header) 
+    const RtpPacketView& rtp_packet, webrtc::RTPVideoHeader* video_header) 
 {
     if (rtp_packet.HasExtension<RtpDependencyDescriptorExtension>()) {
         webrtc::DependencyDescriptor dependency_descriptor;
@@ -12,6 +12,7 @@
 #include "video/video_stream_config.h"
 #include "modules/rtp_rtcp/rtp_rtcp_impl.h"
 #include "modules/rtp_rtcp/rtp_packet_to_send.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
 #include "modules/rtp_rtcp/include/receive_statistics.h"
 #include "modules/video_coding/nack_requester.h"
 
@@ -26,7 +27,13 @@ public:
     void UpdateRtpStats(std::shared_ptr<RtpPacketToSend> packet,bool is_rtx, bool is_retransmit);
     void OnSendingRtpFrame(uint32_t rtp_timestamp, int64_t capture_time_ms, bool forced_report);
     void DeliverRtcp(const uint8_t* packet, size_t length);
-    void DeliverRtp(const uint8_t* packet, size_t length);
+    void DeliverRtp(const RtpPacketView& rtp_packet);
+
+    // 收到的包按这个映射查找扩展
+    const RtpHeaderExtensionMap& extensions() const { return config_.rtp.extensions; }
+
+    void DetachEventLoop();
+    void AttachEventLoop(EventLoop* el);
 
     sigslot::signal1<const std::vector<uint16_t>&> SignalSendNack;
 
@@ -39,7 +46,7 @@ enum ParseGenericDependenciesResult {
 
     void OnNackSend(const std::vector<uint16_t>& seq_nums);
     ParseGenericDependenciesResult ParseGenericDependenciesExtension(
-      const RtpPacketReceived& rtp_packet,
+      const RtpPacketView& rtp_packet,
       webrtc::RTPVideoHeader* video_header);
 
 private:
@@ -54,6 +54,31 @@ namespace xrtc {
         rtp_rtcp_->IncomingRtcpPacket(packet, length);
     }
 
+    void VideoSendStream::OnSendingRtpPacket(uint32_t ssrc, const RtpPacketCounter& counter) {
+        bool is_rtx = config_.rtp.rtx.ssrc && ssrc == config_.rtp.rtx.ssrc;
+        if (!is_rtx && ssrc != config_.rtp.ssrc) {
+            return;
+        }
+
+        rtp_rtcp_->UpdateRtpStats(counter, is_rtx, is_rtx);
+    }
+
+    void VideoSendStream::OnRemoteSenderReport(uint32_t ssrc, uint32_t rtp_timestamp) {
+        if (ssrc != config_.rtp.ssrc) {
+            return;
+        }
+
+        rtp_rtcp_->OnSendingRtpFrame(rtp_timestamp, -1, false);
+    }
+
+    void VideoSendStream::DetachEventLoop() {
+        rtp_rtcp_->DetachEventLoop();
+    }
+
+    void VideoSendStream::AttachEventLoop(EventLoop* el) {
+        rtp_rtcp_->AttachEventLoop(el);
+    }
+
     std::unique_ptr<RtpPacketToSend> VideoSendStream::BuildRtxPacket(
         std::shared_ptr<RtpPacketToSend> packet)
     {
@@ -7,6 +7,7 @@
 #include "video/video_stream_config.h"
 #include "modules/rtp_rtcp/rtp_rtcp_impl.h"
 #include "modules/rtp_rtcp/rtp_packet_to_send.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
 
 namespace xrtc {
 
@@ -20,6 +21,18 @@ public:
     void DeliverRtcp(const uint8_t* packet, size_t length);
     std::unique_ptr<RtpPacketToSend> BuildRtxPacket(std::shared_ptr<RtpPacketToSend> packet);
 
+    // 转发给订阅者的包，更新SR中的发送统计，大小由转发路径解析一次之后传入
+    void OnSendingRtpPacket(uint32_t ssrc, const RtpPacketCounter& counter);
+    // 订阅者按这个映射解析转发给它的包中的扩展
+    const RtpHeaderExtensionMap& extensions() const { return config_.rtp.extensions; }
+    // 推流者的SR，转发不改变RTP时间戳，SR中的RTP时间戳对应收到SR的本地时间，
+    // 之后的SR都按这个对应关系生成，音视频都使用推流者自己的对应关系，保持同步
+    void OnRemoteSenderReport(uint32_t ssrc, uint32_t rtp_timestamp);
+
+    // 会话迁移到其它worker时，RTCP定时器跟随转移
+    void DetachEventLoop();
+    void AttachEventLoop(EventLoop* el);
+
 private:
     VideoSendStreamConfig config_;
     std::unique_ptr<ModuleRtpRtcpImpl> rtp_rtcp_;
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
+
 namespace xrtc {
 
 class RtpRtcpModuleObserver;
@@ -18,6 +20,8 @@ struct VideoSendStreamConfig {
             int payload_type = -1;
         } rtx;
 
+        // 对端offer中协商的RTP头扩展id
+        RtpHeaderExtensionMap extensions;
     } rtp;
 
     // 视频的rtcp包发送间隔
@@ -39,6 +43,8 @@ struct VideoReceiveStreamConfig {
             int payload_type = -1;
         } rtx;
 
+        // 对端offer中协商的RTP头扩展id
+        RtpHeaderExtensionMap extensions;
     } rtp;
 
     // 视频的rtcp包发送间隔
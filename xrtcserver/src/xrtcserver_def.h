@@ -12,22 +12,27 @@
 
 namespace xrtc {
 
-#define MAX_RES_BUF 4096
-
 #define CMDNO_PUSH     1
 #define CMDNO_PULL     2
 #define CMDNO_OFFER   3
 #define CMDNO_STOPPUSH 4
 #define CMDNO_STOPPULL 5
+// 运维命令，把一路推流和它的拉流迁移到指定的worker
+#define CMDNO_MIGRATE  6
+// worker之间迁移会话，只在内部使用
+#define CMDNO_MIGRATE_OUT 100
+#define CMDNO_MIGRATE_IN  101
 
 struct RtcMsg {
     int cmdno = -1;
-    uint16_t uid = 0;
+    uint64_t uid = 0;
     std::string stream_name;
     std::string stream_type;
     int audio = 0;
     int video = 0;
     uint32_t log_id = 0;
+    // 信令请求头中的id，应答时原样带回，同一个连接上的应答可以乱序
+    uint16_t req_id = 0;
     void *worker = nullptr;
     void *conn = nullptr;
     int fd = 0;
@@ -35,6 +40,11 @@ struct RtcMsg {
     int err_no = 0;
     void* certificate = nullptr;
     int dtls_on = 1;
+    // WHIP/WHEP会话Location中的随机令牌，停止推拉流时必须一致
+    std::string session_token;
+    // 迁移的目标worker和迁移中的会话(StreamMigration)
+    int dst_worker = -1;
+    void* migration = nullptr;
 };
 
 } // end namespace xrtc
@@ -0,0 +1,55 @@
+/**
+ * @file bench.h
+ * @author charles
+ * @brief xrtc_bench的用例注册，每个用例是一个返回0/-1的函数，
+ *        既用于ctest检查结果，也输出耗时和计数供优化前后对比
+*/
+
+#ifndef __TEST_BENCH_H_
+#define __TEST_BENCH_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace xrtc {
+namespace test {
+
+typedef int(*bench_func_t)();
+
+struct BenchCase {
+    const char* name;
+    bench_func_t func;
+};
+
+std::vector<BenchCase>& bench_cases();
+
+struct BenchRegister {
+    BenchRegister(const char* name, bench_func_t func) {
+        bench_cases().push_back({name, func});
+    }
+};
+
+// 单调时钟，微秒
+int64_t now_usec();
+
+} // namespace test
+} // namespace xrtc
+
+#define XRTC_BENCH(name) \
+    static int bench_##name(); \
+    static xrtc::test::BenchRegister bench_register_##name(#name, bench_##name); \
+    static int bench_##name()
+
+// 条件不满足时输出位置并让用例失败
+#define BENCH_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return -1; \
+        } \
+    } while (0)
+
+#endif // __TEST_BENCH_H_
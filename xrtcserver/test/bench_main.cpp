@@ -0,0 +1,77 @@
+#include <time.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <rtc_base/logging.h>
+
+#include "server/rtc_server.h"
+#include "server/settings.h"
+#include "test/bench.h"
+
+// RtcStreamManager经过StreamRelay和RtcWorker依赖SignalingWorker，后者引用main.cpp中的
+// 全局RtcServer，xrtc_bench不链接main.cpp，在这里提供一个空的定义
+xrtc::RtcServer *g_rtc_server = nullptr;
+
+namespace xrtc {
+namespace test {
+
+std::vector<BenchCase>& bench_cases() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+int64_t now_usec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+} // namespace test
+} // namespace xrtc
+
+// 用法: xrtc_bench [case ...]，不带参数时运行全部用例，在xrtcserver目录下运行
+int main(int argc, char** argv) {
+    if (!xrtc::Singleton<xrtc::Settings>::Instance()->Init("./conf/general.yaml")) {
+        fprintf(stderr, "init settings failed \n");
+        return -1;
+    }
+
+    // 每个拉流者每个网络接口占用一个socket，上千个拉流者的用例会超过默认的1024
+    struct rlimit limit;
+    if (0 == getrlimit(RLIMIT_NOFILE, &limit) && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    // 会话创建的日志会淹没测试结果
+    rtc::LogMessage::LogToDebug(rtc::LS_WARNING);
+
+    int failed = 0;
+    int ran = 0;
+    for (const xrtc::test::BenchCase& bench_case : xrtc::test::bench_cases()) {
+        bool selected = argc <= 1;
+        for (int i = 1; i < argc && !selected; ++i) {
+            selected = strcmp(argv[i], bench_case.name) == 0;
+        }
+
+        if (!selected) {
+            continue;
+        }
+
+        ++ran;
+        printf("[ RUN  ] %s\n", bench_case.name);
+        fflush(stdout);
+        int ret = bench_case.func();
+        printf("[ %s ] %s\n", ret == 0 ? " OK " : "FAIL", bench_case.name);
+        if (ret != 0) {
+            ++failed;
+        }
+    }
+
+    if (0 == ran) {
+        fprintf(stderr, "no bench case matched\n");
+        return -1;
+    }
+
+    return failed == 0 ? 0 : -1;
+}
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <rtc_base/rtc_certificate_generator.h>
+
+#include "server/rtc_worker.h"
+#include "server/settings.h"
+#include "server/signaling_worker.h"
+#include "test/bench.h"
+#include "test/sdp_offers.h"
+#include "xrtcserver_def.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_storm_joins = 1000;
+const int64_t k_storm_timeout_usec = 60000000;
+const uint64_t k_storm_certificate_expires_ms = 24 * 3600 * 1000;
+
+struct StormResult {
+    int64_t total_usec = 0;
+    int64_t p50_usec = 0;
+    int64_t p99_usec = 0;
+    int64_t max_usec = 0;
+};
+
+// 当前线程扮演信令worker：把msgs一次全部投递给RtcWorker(MPSC队列 + eventfd唤醒)，
+// 再从SignalingWorker的应答队列中取回，统计每个请求从投递到取回应答的时间
+static int run_storm(RtcWorker* rtc_worker, SignalingWorker* signaling_worker,
+        std::vector<std::shared_ptr<RtcMsg>>& msgs, StormResult* result)
+{
+    std::vector<int64_t> send_time(msgs.size());
+    std::vector<int64_t> latency;
+    latency.reserve(msgs.size());
+
+    int64_t start = now_usec();
+    for (size_t i = 0; i < msgs.size(); ++i) {
+        // 用log_id带回请求的序号
+        msgs[i]->log_id = i;
+        msgs[i]->worker = signaling_worker;
+        send_time[i] = now_usec();
+        BENCH_CHECK(rtc_worker->send_rtc_msg(msgs[i]) == 0);
+    }
+
+    while (latency.size() < msgs.size()) {
+        BENCH_CHECK(now_usec() - start < k_storm_timeout_usec);
+        std::shared_ptr<RtcMsg> reply = signaling_worker->pop_msg();
+        if (!reply) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        BENCH_CHECK(reply->log_id < msgs.size() && 0 == reply->err_no);
+        latency.push_back(now_usec() - send_time[reply->log_id]);
+    }
+    result->total_usec = now_usec() - start;
+
+    std::sort(latency.begin(), latency.end());
+    result->p50_usec = latency[latency.size() / 2];
+    result->p99_usec = latency[std::min(latency.size() - 1, latency.size() * 99 / 100)];
+    result->max_usec = latency.back();
+    return 0;
+}
+
+static std::shared_ptr<RtcMsg> make_msg(int cmdno, uint64_t uid, const char* offer,
+        rtc::RTCCertificate* certificate)
+{
+    std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
+    msg->cmdno = cmdno;
+    msg->uid = uid;
+    msg->stream_name = "storm";
+    msg->audio = 1;
+    msg->video = 1;
+    if (offer) {
+        msg->sdp = offer;
+    }
+    msg->certificate = certificate;
+    return msg;
+}
+
+static void print_storm(const char* name, size_t count, const StormResult& result) {
+    printf("%s: %zu pipelined requests in %ld usec, round trip p50: %ld usec, "
+            "p99: %ld usec, max: %ld usec\n", name, count, (long)result.total_usec,
+            (long)result.p50_usec, (long)result.p99_usec, (long)result.max_usec);
+}
+
+// 信令到RTC worker的控制通道在加入风暴下的往返时延：一个推流之后1000个拉流请求
+// 连续投递，再连续投递1000个停止拉流，包括worker创建和销毁会话的时间
+XRTC_BENCH(join_storm) {
+    rtc::KeyParams key_params;
+    rtc::scoped_refptr<rtc::RTCCertificate> certificate =
+        rtc::RTCCertificateGenerator::GenerateCertificate(key_params,
+                k_storm_certificate_expires_ms);
+    BENCH_CHECK(certificate);
+
+    // 不监听端口，也不启动线程，只使用它的应答队列
+    SignalingServerOptions signaling_options =
+        Singleton<Settings>::Instance()->GetSignalingServerOptions();
+    signaling_options.reuse_port = false;
+    signaling_options.http_port = 0;
+    SignalingWorker signaling_worker(0, signaling_options);
+    BENCH_CHECK(signaling_worker.init() == 0);
+
+    RtcServerOptions options = Singleton<Settings>::Instance()->GetRtcServerOptions();
+    std::unique_ptr<RtcWorker> rtc_worker = std::make_unique<RtcWorker>(0, options);
+    BENCH_CHECK(rtc_worker->init() == 0);
+    BENCH_CHECK(rtc_worker->start());
+
+    int ret = 0;
+    StormResult result;
+    std::vector<std::shared_ptr<RtcMsg>> msgs;
+    msgs.push_back(make_msg(CMDNO_PUSH, 1, k_chrome_publish_offer, certificate.get()));
+    ret = run_storm(rtc_worker.get(), &signaling_worker, msgs, &result);
+
+    if (0 == ret) {
+        msgs.clear();
+        for (size_t i = 0; i < k_storm_joins; ++i) {
+            msgs.push_back(make_msg(CMDNO_PULL, i + 2, k_chrome_play_offer, certificate.get()));
+        }
+        ret = run_storm(rtc_worker.get(), &signaling_worker, msgs, &result);
+        if (0 == ret) {
+            print_storm("join", msgs.size(), result);
+        }
+    }
+
+    if (0 == ret) {
+        msgs.clear();
+        for (size_t i = 0; i < k_storm_joins; ++i) {
+            msgs.push_back(make_msg(CMDNO_STOPPULL, i + 2, nullptr, nullptr));
+        }
+        ret = run_storm(rtc_worker.get(), &signaling_worker, msgs, &result);
+        if (0 == ret) {
+            print_storm("leave", msgs.size(), result);
+        }
+    }
+
+    // 会话在worker线程退出之前销毁，之后不会再有应答写入signaling_worker
+    rtc_worker->stop();
+    rtc_worker->join();
+    rtc_worker.reset();
+    return ret;
+}
+
+} // namespace test
+} // namespace xrtc
@@ -0,0 +1,151 @@
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <rtc_base/ssl_stream_adapter.h>
+
+#include "base/packet_buffer.h"
+#include "base/socket.h"
+#include "pc/srtp_transport.h"
+#include "stream/rtc_stream_manager.h"
+#include "test/bench.h"
+#include "test/stream_fixture.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_fanout_max_frames = 300;
+const size_t k_fanout_min_frames = 10;
+const size_t k_fanout_frame_packets = 10;
+// 拉流者多时减少帧数，每种配置转发的包总数不超过这个值
+const size_t k_fanout_max_forwards = 1000000;
+const size_t k_send_path_packets = 100000;
+const size_t k_send_path_payload = 1100;
+
+// 一路推流扇出给n个拉流者，返回每秒转发的包数(每个拉流者的每个包算一次)，
+// 并检查每个拉流者都收到了关键帧之后的全部视频包。
+// fixture的拉流者没有完成DTLS，包在SRTP加密之前就返回了，不包含加密和sendto
+static int run_fanout(size_t subscriber_num, bool pacing, double* pps) {
+    RtcServerOptions options = StreamFixture::default_options();
+    options.pacing = pacing;
+    StreamFixture fixture(options);
+    BENCH_CHECK(fixture.init() == 0);
+    // 开启DTLS时未激活的SRTP传输每个包都会输出一条警告
+    fixture.set_dtls_on(false);
+    BENCH_CHECK(fixture.publish("fanout") == 0);
+    for (size_t i = 0; i < subscriber_num; ++i) {
+        BENCH_CHECK(fixture.subscribe("fanout", i + 1) == 0);
+    }
+
+    // 等待关键帧的拉流者从实时关键帧开始接收
+    fixture.send_video_frame(true, k_fanout_frame_packets);
+
+    size_t frames = k_fanout_max_forwards / (subscriber_num * k_fanout_frame_packets);
+    frames = std::max(k_fanout_min_frames, std::min(k_fanout_max_frames, frames));
+
+    RtcStreamManager* manager = fixture.manager();
+    uint64_t forwarded = manager->forwarded_packets();
+    int64_t start = now_usec();
+    for (size_t i = 0; i < frames; ++i) {
+        fixture.send_video_frame(false, k_fanout_frame_packets);
+    }
+    int64_t elapsed = std::max<int64_t>(now_usec() - start, 1);
+
+    size_t packets = frames * k_fanout_frame_packets * subscriber_num;
+    BENCH_CHECK(manager->forwarded_packets() - forwarded == packets);
+    *pps = packets * 1000000.0 / elapsed;
+    return 0;
+}
+
+// 单独测量fanout中跳过的发送路径：和DtlsSrtpTransport::send_rtp一样拷贝到缓冲区、
+// SRTP加密，然后sendto到本机的UDP端口，返回每个包的耗时(纳秒)
+static int run_send_path(double* ns_per_packet) {
+    int key_len = 0;
+    int salt_len = 0;
+    BENCH_CHECK(rtc::GetSrtpKeyAndSaltLengths(rtc::SRTP_AES128_CM_SHA1_80,
+                &key_len, &salt_len));
+    uint8_t key[64];
+    BENCH_CHECK((size_t)(key_len + salt_len) <= sizeof(key));
+    for (size_t i = 0; i < sizeof(key); ++i) {
+        key[i] = (uint8_t)i;
+    }
+
+    SrtpTransport srtp(true);
+    BENCH_CHECK(srtp.set_rtp_params(rtc::SRTP_AES128_CM_SHA1_80, key, key_len + salt_len,
+                std::vector<int>(), rtc::SRTP_AES128_CM_SHA1_80, key, key_len + salt_len,
+                std::vector<int>()));
+
+    // 接收端不读数据，缓冲区满之后由内核丢弃，不影响发送的开销
+    int recv_sock = create_udp_socket(AF_INET);
+    int send_sock = create_udp_socket(AF_INET);
+    BENCH_CHECK(recv_sock >= 0 && send_sock >= 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    BENCH_CHECK(sock_bind(recv_sock, (struct sockaddr*)&addr, sizeof(addr), 0, 0) == 0);
+    int port = 0;
+    BENCH_CHECK(sock_get_address(recv_sock, nullptr, &port) == 0);
+    addr.sin_port = htons(port);
+    BENCH_CHECK(sock_setnoblock(send_sock) == 0);
+
+    uint8_t rtp[12 + k_send_path_payload];
+    memset(rtp, 0xab, sizeof(rtp));
+    rtp[0] = 0x80;
+    rtp[1] = 96;
+    rtp[8] = 0x12;
+    rtp[9] = 0x34;
+    rtp[10] = 0x56;
+    rtp[11] = 0x78;
+
+    int64_t start = now_usec();
+    for (size_t i = 0; i < k_send_path_packets; ++i) {
+        // 序号递增，否则SRTP的重放检查会拒绝
+        uint16_t seq = (uint16_t)(i + 1);
+        rtp[2] = seq >> 8;
+        rtp[3] = seq & 0xff;
+
+        PacketBufferPtr packet = PacketBufferPool::current()->alloc((const char*)rtp,
+                sizeof(rtp));
+        BENCH_CHECK(packet);
+        int len = packet->size();
+        BENCH_CHECK(srtp.protect_rtp(packet->data(), len, packet->capacity(), &len));
+        sock_send_to(send_sock, (const char*)packet->data(), len, 0,
+                (struct sockaddr*)&addr, sizeof(addr));
+    }
+    int64_t elapsed = std::max<int64_t>(now_usec() - start, 1);
+
+    close(send_sock);
+    close(recv_sock);
+    *ns_per_packet = elapsed * 1000.0 / k_send_path_packets;
+    return 0;
+}
+
+XRTC_BENCH(fanout) {
+    printf("note: fixture subscribers never complete DTLS, the fanout loop stops before "
+            "SRTP protect and sendto; that path is measured separately\n");
+
+    double send_ns = 0;
+    BENCH_CHECK(run_send_path(&send_ns) == 0);
+    printf("send path (copy + srtp protect + sendto): %.1f ns per packet\n", send_ns);
+
+    const size_t subscriber_nums[] = {1, 10, 100, 1000};
+    for (size_t subscriber_num : subscriber_nums) {
+        double direct = 0;
+        double paced = 0;
+        BENCH_CHECK(run_fanout(subscriber_num, false, &direct) == 0);
+        BENCH_CHECK(run_fanout(subscriber_num, true, &paced) == 0);
+        // 单核上加上发送路径之后的估算值
+        double estimated = 1e9 / (1e9 / direct + send_ns);
+        printf("subscribers: %zu, forwarded pps (srtp/send skipped): %.0f, with pacing: %.0f, "
+                "estimated with send path: %.0f\n",
+                subscriber_num, direct, paced, estimated);
+    }
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
@@ -0,0 +1,204 @@
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <rtc_base/helpers.h>
+#include <rtc_base/string_encode.h>
+
+#include "base/network.h"
+#include "base/socket.h"
+#include "ice/stun.h"
+#include "test/ice_peer.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_recv_buffer_size = 2048;
+const uint32_t k_peer_priority = 0x6e001eff;
+
+// 返回sdp中第一个指定属性的值，例如a=ice-ufrag:
+static std::string get_sdp_attribute(const std::string& sdp, const std::string& attr) {
+    size_t pos = sdp.find(attr);
+    if (pos == std::string::npos) {
+        return "";
+    }
+
+    pos += attr.size();
+    size_t end = sdp.find("\r\n", pos);
+    return sdp.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+// 应答中candidate的地址是配置的candidate_ip，实际绑定的是本机网卡的地址，
+// 所以取所有候选的端口，和本机每个网卡的地址组合
+static void get_candidate_ports(const std::string& sdp, std::vector<int>* ports) {
+    const std::string attr = "a=candidate:";
+    size_t pos = 0;
+    while ((pos = sdp.find(attr, pos)) != std::string::npos) {
+        size_t end = sdp.find("\r\n", pos);
+        std::vector<std::string> fields;
+        rtc::split(sdp.substr(pos + attr.size(), end - pos - attr.size()), ' ', &fields);
+        pos = end;
+
+        // foundation component protocol priority ip port typ host
+        int port = 0;
+        if (fields.size() < 6 || !rtc::FromString(fields[5], &port)) {
+            continue;
+        }
+
+        bool exist = false;
+        for (int p : *ports) {
+            exist = exist || p == port;
+        }
+        if (!exist) {
+            ports->push_back(port);
+        }
+    }
+}
+
+IcePeer::~IcePeer() {
+    if (sock_ >= 0) {
+        close(sock_);
+        sock_ = -1;
+    }
+}
+
+int IcePeer::init(const std::string& offer, const std::string& answer) {
+    local_ufrag_ = get_sdp_attribute(offer, "a=ice-ufrag:");
+    local_pwd_ = get_sdp_attribute(offer, "a=ice-pwd:");
+    remote_ufrag_ = get_sdp_attribute(answer, "a=ice-ufrag:");
+    remote_pwd_ = get_sdp_attribute(answer, "a=ice-pwd:");
+    if (local_ufrag_.empty() || local_pwd_.empty() || remote_ufrag_.empty()
+            || remote_pwd_.empty())
+    {
+        fprintf(stderr, "ice params not found in offer or answer\n");
+        return -1;
+    }
+
+    std::vector<int> ports;
+    get_candidate_ports(answer, &ports);
+
+    NetworkManager network_manager;
+    if (network_manager.create_networks() != 0) {
+        return -1;
+    }
+
+    for (auto network : network_manager.get_networks()) {
+        for (int port : ports) {
+            remote_addrs_.push_back(rtc::SocketAddress(network->ip(), port));
+        }
+    }
+
+    if (remote_addrs_.empty()) {
+        fprintf(stderr, "no candidate address in answer\n");
+        return -1;
+    }
+
+    sock_ = create_udp_socket(AF_INET);
+    if (sock_ < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in addr_in;
+    memset(&addr_in, 0, sizeof(addr_in));
+    addr_in.sin_family = AF_INET;
+    addr_in.sin_addr.s_addr = INADDR_ANY;
+    if (sock_bind(sock_, (struct sockaddr*)&addr_in, sizeof(addr_in), 0, 0) != 0
+            || sock_setnoblock(sock_) != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+void IcePeer::send_binding_request() {
+    StunMessage request;
+    request.set_type(STUN_BINDING_REQUEST);
+    request.set_transaction_id(rtc::CreateRandomString(k_stun_transaction_id_length));
+    request.add_attribute(std::make_unique<StunByteStringAttribute>(STUN_ATTR_USERNAME,
+                remote_ufrag_ + ":" + local_ufrag_));
+    request.add_attribute(std::make_unique<StunUInt32Attribute>(STUN_ATTR_PRIORITY,
+                k_peer_priority));
+    request.add_message_integrity(remote_pwd_);
+    request.add_fingerprint();
+
+    rtc::ByteBufferWriter buf;
+    if (!request.write(&buf)) {
+        return;
+    }
+
+    for (const rtc::SocketAddress& addr : remote_addrs_) {
+        _send_to(buf.Data(), buf.Length(), addr);
+    }
+}
+
+int IcePeer::process() {
+    int received = 0;
+    char buf[k_recv_buffer_size];
+    while (true) {
+        struct sockaddr_storage addr_storage;
+        int len = sock_recv_from(sock_, buf, sizeof(buf), (struct sockaddr*)&addr_storage,
+                sizeof(addr_storage));
+        if (len <= 0) {
+            break;
+        }
+
+        rtc::SocketAddress addr;
+        rtc::SocketAddressFromSockAddrStorage(addr_storage, &addr);
+        if (StunMessage::validate_fingerprint(buf, len)) {
+            _on_stun_packet(buf, len, addr);
+        } else {
+            ++received;
+            ++received_packets_;
+        }
+    }
+
+    return received;
+}
+
+void IcePeer::_on_stun_packet(const char* data, size_t len, const rtc::SocketAddress& addr) {
+    StunMessage msg;
+    rtc::ByteBufferReader reader(data, len);
+    if (!msg.read(&reader) || msg.type() != STUN_BINDING_REQUEST) {
+        return;
+    }
+
+    if (msg.validate_message_integrity(local_pwd_) != StunMessage::IntegrityStatus::k_integrity_ok) {
+        fprintf(stderr, "bad binding request integrity from %s\n", addr.ToString().c_str());
+        return;
+    }
+
+    // 服务端的ping走的是它选中的连接，媒体也发往这个地址
+    selected_addr_ = addr;
+
+    StunMessage response;
+    response.set_type(STUN_BINDING_RESPONSE);
+    response.set_transaction_id(msg.transaction_id());
+    response.add_attribute(std::make_unique<StunXorAddressAttribute>(
+                STUN_ATTR_XOR_MAPPED_ADDRESS, addr));
+    response.add_message_integrity(local_pwd_);
+    response.add_fingerprint();
+
+    rtc::ByteBufferWriter buf;
+    if (response.write(&buf)) {
+        _send_to(buf.Data(), buf.Length(), addr);
+    }
+}
+
+int IcePeer::send_packet(const char* data, size_t len) {
+    if (selected_addr_.IsNil()) {
+        return -1;
+    }
+
+    return _send_to(data, len, selected_addr_);
+}
+
+int IcePeer::_send_to(const char* data, size_t len, const rtc::SocketAddress& addr) {
+    struct sockaddr_storage addr_storage;
+    size_t addr_len = addr.ToSockAddrStorage(&addr_storage);
+    return sock_send_to(sock_, data, len, 0, (struct sockaddr*)&addr_storage, addr_len);
+}
+
+} // namespace test
+} // namespace xrtc
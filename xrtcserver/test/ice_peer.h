@@ -0,0 +1,56 @@
+/**
+ * @file ice_peer.h
+ * @author charles
+ * @brief 测试用的最小ICE客户端：用offer中的ufrag/pwd向服务端的host candidate
+ *        发送binding request，并应答服务端的ping，让dtls_on=0的会话真正进入连接状态
+*/
+
+#ifndef __TEST_ICE_PEER_H_
+#define __TEST_ICE_PEER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <rtc_base/socket_address.h>
+
+namespace xrtc {
+namespace test {
+
+class IcePeer {
+public:
+    IcePeer() = default;
+    ~IcePeer();
+
+    // offer是客户端发出的offer，answer是服务端的应答
+    int init(const std::string& offer, const std::string& answer);
+
+    // 向服务端的每个候选地址发送binding request，服务端据此创建peer反射的连接
+    void send_binding_request();
+    // 读出socket上的全部包，应答服务端的binding request，返回收到的非STUN包个数
+    int process();
+    // 发给最近一次收到服务端ping的地址，还没有收到ping时返回-1
+    int send_packet(const char* data, size_t len);
+
+    uint64_t received_packets() const { return received_packets_; }
+
+private:
+    int _send_to(const char* data, size_t len, const rtc::SocketAddress& addr);
+    void _on_stun_packet(const char* data, size_t len, const rtc::SocketAddress& addr);
+
+private:
+    int sock_ = -1;
+    std::string local_ufrag_;
+    std::string local_pwd_;
+    std::string remote_ufrag_;
+    std::string remote_pwd_;
+    std::vector<rtc::SocketAddress> remote_addrs_;
+    rtc::SocketAddress selected_addr_;
+    uint64_t received_packets_ = 0;
+};
+
+} // namespace test
+} // namespace xrtc
+
+#endif // __TEST_ICE_PEER_H_
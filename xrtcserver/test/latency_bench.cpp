@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/cpu_affinity.h"
+#include "base/latency_histogram.h"
+#include "stream/rtc_stream_manager.h"
+#include "stream/push_stream.h"
+#include "stream/pull_stream.h"
+#include "test/bench.h"
+#include "test/ice_peer.h"
+#include "test/stream_fixture.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_latency_subscribers = 20;
+const size_t k_latency_frames = 500;
+const size_t k_latency_frame_packets = 5;
+// 每2ms一帧，约2500pps，总共1秒，在拉流者的ICE接收超时(2.5秒)之前结束
+const int64_t k_latency_frame_interval_usec = 2000;
+const int64_t k_latency_timeout_usec = 5000000;
+const unsigned int k_latency_poll_usec = 2000;
+
+typedef std::vector<std::unique_ptr<IcePeer>> IcePeerList;
+
+struct LatencyResult {
+    int ret = -1;
+    uint64_t forwarded = 0;
+    std::string report;
+};
+
+static bool all_connected(StreamFixture* fixture) {
+    if (!fixture->push_stream() || !fixture->push_stream()->can_migrate()) {
+        return false;
+    }
+
+    for (PullStream* stream : fixture->pull_streams()) {
+        if (!stream->can_migrate()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int wait_connected(StreamFixture* fixture, IcePeerList& peers) {
+    int64_t start = now_usec();
+    while (!all_connected(fixture)) {
+        BENCH_CHECK(now_usec() - start < k_latency_timeout_usec);
+        for (auto& peer : peers) {
+            peer->send_binding_request();
+        }
+        fixture->run_loop(k_latency_poll_usec);
+        for (auto& peer : peers) {
+            peer->process();
+        }
+    }
+    return 0;
+}
+
+// 在当前线程上运行worker的会话层，建立连接之后通知发送线程，
+// 然后只运行事件循环，直到发送线程发完并且全部包都已转发
+static int run_worker(StreamFixture* fixture, IcePeerList& peers,
+        std::atomic<StreamFixture*>* ready, std::atomic<bool>* sent, LatencyResult* result)
+{
+    BENCH_CHECK(fixture->init() == 0);
+    fixture->set_dtls_on(false);
+
+    std::string answer;
+    BENCH_CHECK(fixture->publish("latency", k_chrome_publish_offer, &answer) == 0);
+    peers.push_back(std::make_unique<IcePeer>());
+    BENCH_CHECK(peers.back()->init(k_chrome_publish_offer, answer) == 0);
+    IcePeer* publisher = peers.back().get();
+
+    for (size_t i = 0; i < k_latency_subscribers; ++i) {
+        BENCH_CHECK(fixture->subscribe("latency", i + 1, k_chrome_play_offer, false,
+                    &answer) == 0);
+        peers.push_back(std::make_unique<IcePeer>());
+        BENCH_CHECK(peers.back()->init(k_chrome_play_offer, answer) == 0);
+    }
+    BENCH_CHECK(wait_connected(fixture, peers) == 0);
+
+    // 关键帧在通知发送线程之前发出并转发完，之后的包都直接转发
+    fixture->set_publisher(publisher);
+    fixture->send_video_frame(true, k_latency_frame_packets);
+    uint64_t expected = k_latency_frame_packets * k_latency_subscribers;
+    int64_t start = now_usec();
+    while (fixture->manager()->forwarded_packets() < expected) {
+        BENCH_CHECK(now_usec() - start < k_latency_timeout_usec);
+        fixture->run_loop(k_latency_poll_usec);
+    }
+
+    // 只统计发送线程发出的包
+    LatencyHistogram last = fixture->manager()->forward_latency();
+    expected += k_latency_frames * k_latency_frame_packets * k_latency_subscribers;
+    ready->store(fixture);
+
+    start = now_usec();
+    while (!sent->load() || fixture->manager()->forwarded_packets() < expected) {
+        BENCH_CHECK(now_usec() - start < k_latency_timeout_usec);
+        fixture->run_loop(k_latency_poll_usec);
+    }
+
+    result->forwarded = fixture->manager()->forwarded_packets();
+    result->report = fixture->manager()->forward_latency().report_since(&last);
+    BENCH_CHECK(!result->report.empty());
+    return 0;
+}
+
+// cpu小于0时不绑核。worker线程只收包和转发，推流者的包由当前线程按固定间隔发送，
+// 时延包括内核收到包之后唤醒worker线程的调度时间
+static int run_latency(int cpu, LatencyResult* result) {
+    std::atomic<StreamFixture*> ready_fixture(nullptr);
+    std::atomic<bool> sent(false);
+    std::atomic<bool> failed(false);
+
+    // fixture和会话在worker线程上创建，也在worker线程上销毁
+    std::thread worker([&]() {
+        if (cpu >= 0) {
+            if (bind_thread_to_cpu(cpu) != 0) {
+                failed.store(true);
+                return;
+            }
+            int node = get_cpu_numa_node(cpu);
+            if (node >= 0) {
+                set_preferred_numa_node(node);
+            }
+        }
+
+        StreamFixture fixture(StreamFixture::default_options());
+        IcePeerList peers;
+        result->ret = run_worker(&fixture, peers, &ready_fixture, &sent, result);
+        if (result->ret != 0) {
+            failed.store(true);
+        }
+        // 发送线程可能还在使用fixture
+        while (ready_fixture.load() && !sent.load()) {
+            std::this_thread::yield();
+        }
+    });
+
+    while (!ready_fixture.load() && !failed.load()) {
+        std::this_thread::yield();
+    }
+
+    // 发送只使用fixture中推流者的序号和IcePeer的socket，worker线程在ready之后不再访问它们
+    StreamFixture* fixture = ready_fixture.load();
+    auto next = std::chrono::steady_clock::now();
+    for (size_t i = 0; fixture && i < k_latency_frames && !failed.load(); ++i) {
+        fixture->send_video_frame(false, k_latency_frame_packets);
+        next += std::chrono::microseconds(k_latency_frame_interval_usec);
+        std::this_thread::sleep_until(next);
+    }
+    sent.store(true);
+    worker.join();
+    return result->ret;
+}
+
+// 推流的包从UDP收到(内核时间戳)到转发给全部拉流者之后的时延分布，
+// 比较worker线程绑核和不绑核时的p50/p99/p999
+XRTC_BENCH(forward_latency) {
+    RtcServerOptions options = StreamFixture::default_options();
+    int cpu = select_worker_cpu(options.worker_cpus, 0);
+    if (cpu < 0) {
+        cpu = std::max<int>(std::thread::hardware_concurrency(), 1) - 1;
+    }
+
+    for (int pin_cpu : {-1, cpu}) {
+        LatencyResult result;
+        BENCH_CHECK(run_latency(pin_cpu, &result) == 0);
+        std::string mode = pin_cpu < 0 ? "unpinned" : "pinned to cpu " + std::to_string(pin_cpu);
+        printf("%s, subscribers: %zu, forwarded: %lu, forward latency: %s\n",
+                mode.c_str(), k_latency_subscribers, (unsigned long)result.forwarded,
+                result.report.c_str());
+    }
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
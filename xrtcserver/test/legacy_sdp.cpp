@@ -0,0 +1,629 @@
+#include <stdlib.h>
+
+#include <sstream>
+#include <vector>
+
+#include <absl/algorithm/container.h>
+#include <rtc_base/logging.h>
+#include <rtc_base/string_encode.h>
+#include <rtc_base/ssl_fingerprint.h>
+
+#include "pc/stream_params.h"
+#include "test/legacy_sdp.h"
+
+namespace xrtc {
+namespace test {
+
+const char k_media_protocol_dtls_savpf[] = "UDP/TLS/RTP/SAVPF";
+const char k_meida_protocol_savpf[] = "RTP/SAVPF";
+
+namespace {
+
+struct SsrcInfo {
+    uint32_t ssrc_id;
+    std::string cname;
+    std::string stream_id;
+    std::string track_id;
+};
+
+} // namespace
+
+static std::string get_attribute(const std::string& line)
+{
+    std::vector<std::string> fields;
+    size_t size = rtc::tokenize(line, ':', &fields);
+    if (size != 2) {
+        RTC_LOG(LS_WARNING) << "get attribute error: " << line;
+        return "";
+    }
+
+    return fields[1];
+}
+
+static int parse_transport_info(TransportDescription* td, const std::string& line) 
+{
+    // a=ice-ufrag:w/W3\r\n
+    if (line.find("a=ice-ufrag") != std::string::npos) {
+        td->ice_ufrag = get_attribute(line);
+        if (td->ice_ufrag.empty()) {
+            return -1;
+        }
+
+    // a=ice-pwd:l8PkVNNDw9depfNOxAzZHUzT\r\n     
+    } else if (line.find("a=ice-pwd") != std::string::npos) {
+        td->ice_pwd = get_attribute(line);
+        if (td->ice_pwd.empty()) {
+            return -1;
+        }
+
+    // a=fingerprint:sha-256 A0:C5:56:20:92:76:F7:3E:5D:E7:80:CA:F3:69:51:53:24:3A:CA:16:89:7E:2D:E0:EA:D3:1B:92:7C:D0:EF:B6\r\n
+    } else if (line.find("a=fingerprint") != std::string::npos) {
+        std::vector<std::string> items;
+        rtc::tokenize(line, ' ', &items);
+        if (items.size() != 2) {
+            RTC_LOG(LS_WARNING) << "parse a=fingerprint error: " << line;
+            return -1;
+        }
+
+         // 字符串a=fingerprint: 是14字节，还需注意大小写转换
+        std::string alg = items[0].substr(14);
+        absl::c_transform(alg, alg.begin(), ::tolower);
+        std::string content = items[1];
+
+        td->identity_fingerprint = rtc::SSLFingerprint::CreateUniqueFromRfc4572(
+                alg, content);
+        if (!(td->identity_fingerprint.get())) {
+            RTC_LOG(LS_WARNING) << "create fingerprint error: " << line;
+            return -1;
+        }            
+
+    }
+    return 0;
+}
+
+static int parse_ssrc_info(std::vector<SsrcInfo>& ssrc_info, const std::string& line) {
+    if (line.find("a=ssrc:") == std::string::npos) {
+        return 0;
+    }
+
+    // rfc5576
+    // a=ssrc:<ssrc-id> <attribute>
+    // a=ssrc:<ssrc-id> <attribute>:<value>
+    std::string field1, field2;
+    if (!rtc::tokenize_first(line.substr(2), ' ', &field1, &field2)) {
+        RTC_LOG(LS_WARNING) << "parse a=ssrc failed, line: " << line;
+        return -1;
+    }
+
+    // ssrc:<ssrc-id>
+    std::string ssrc_id_s = field1.substr(5);
+    uint32_t ssrc_id = 0;
+    if (!rtc::FromString(ssrc_id_s, &ssrc_id)) {
+        RTC_LOG(LS_WARNING) << "invalid ssrc_id, line: " << line;
+        return -1;
+    }
+
+    // <attribute>
+    std::string attribute;
+    std::string value;
+    if (!rtc::tokenize_first(field2, ':', &attribute, &value)) {
+        RTC_LOG(LS_WARNING) << "get ssrc attribute failed, line: " << line;
+        return -1;
+    }
+
+    // ssrc_info里面找是否存在ssrc_id的一行
+    auto iter = ssrc_info.begin();
+    for (; iter != ssrc_info.end(); ++iter) {
+        if (iter->ssrc_id == ssrc_id) {
+            break;
+        }
+    }
+
+    // 如果ssrc_info里没有找到ssrc_id的一行，则插入一条ssrc信息
+    if (iter == ssrc_info.end()) {
+        SsrcInfo info;
+        info.ssrc_id = ssrc_id;
+        ssrc_info.push_back(info);
+        iter = ssrc_info.end() - 1;
+    }
+
+    // a=ssrc:3038623782 cname:9UkMttm/AKBk/3gN
+    if ("cname" == attribute) {
+        iter->cname = value;
+
+    // a=ssrc:3038623782 msid:Z0HUtsuZwWwocPvLkt8PANm3axsdHekKKIXA 19a75650-d2ad-45d8-b7f4-53398701f7de
+    } else if ("msid" == attribute) {
+        std::vector<std::string> fields;
+        rtc::split(value, ' ', &fields);
+        if (fields.size() < 1 || fields.size() > 2) {
+            RTC_LOG(LS_WARNING) << "msid format error, line: " << line;
+            return -1;
+        }
+
+        iter->stream_id = fields[0];
+        if (fields.size() == 2) {
+            iter->track_id = fields[1];
+        }
+    }
+
+    return 0;
+}
+
+// 解析 a=ssrc-group:FID 3038623782 2405544162
+static int parse_ssrc_group_info(std::vector<SsrcGroup>& ssrc_groups, const std::string& line) {
+    if (line.find("a=ssrc-group:") == std::string::npos) {
+        return 0;
+    }  
+
+    // rfc5576
+    // a=ssrc-group:<semantics> <ssrc-id> ...
+    std::vector<std::string> fields;
+    rtc::split(line.substr(2), ' ', &fields);
+    if (fields.size() < 2) {
+        RTC_LOG(LS_WARNING) << "ssrc-group field size < 2, line: " << line;
+        return -1;
+    }
+
+    std::string semantics = get_attribute(fields[0]);
+    if (semantics.empty()) {
+        return -1;
+    }
+
+    std::vector<uint32_t> ssrcs;
+    for (size_t i = 1; i < fields.size(); ++i) {
+        uint32_t ssrc_id = 0;
+        if (!rtc::FromString(fields[i], &ssrc_id)) {
+            return -1;
+        }
+        ssrcs.push_back(ssrc_id);
+    }
+
+    ssrc_groups.push_back(SsrcGroup(semantics, ssrcs));
+
+    return 0;    
+}
+
+// 暂时采用比较粗暴的做法
+// a=fmtp:100 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f
+static int parse_fmtp_info(int &h264_codec_id, const std::string& line) {
+    if (h264_codec_id != 0) {
+        return 0;
+    }
+
+    if (line.find("42e01f") == std::string::npos) {
+        return 0;
+    }
+
+    if (line.find("level-asymmetry-allowed=1") == std::string::npos) {
+        return 0;
+    }  
+
+    if (line.find("packetization-mode=1") == std::string::npos) {
+        return 0;
+    }    
+
+    std::vector<std::string> fields;
+    rtc::split(line.substr(2), ' ', &fields);
+    if (fields.size() < 2) {
+        RTC_LOG(LS_WARNING) << "rtpmap field size < 2, line: " << line;
+        return -1;
+    }
+
+    std::string code_id = get_attribute(fields[0]);
+    if (code_id.empty()) {
+        return -1;
+    }
+
+    h264_codec_id = atoi(code_id.c_str());
+    RTC_LOG(LS_INFO) << "fmtp h264 code id: " << h264_codec_id;
+
+    return 0;
+}
+
+// a=rtpmap:101 rtx/90000
+static int parse_rtpmap_info(int &rtx_codec_id, const std::string& line) {
+    if (rtx_codec_id != 0) {
+        return 0;
+    }
+
+    if (line.find("rtx/90000") == std::string::npos) {
+        return 0;
+    }  
+
+    std::vector<std::string> fields;
+    rtc::split(line.substr(2), ' ', &fields);
+    if (fields.size() < 2) {
+        RTC_LOG(LS_WARNING) << "rtpmap field size < 2, line: " << line;
+        return -1;
+    }
+
+    std::string code_id = get_attribute(fields[0]);
+    if (code_id.empty()) {
+        return -1;
+    }
+
+    rtx_codec_id = atoi(code_id.c_str());
+    RTC_LOG(LS_INFO) << "rtpmap rtx code id: " << rtx_codec_id;
+
+    return 0;
+}
+
+static void create_track_from_ssrc_info(const std::vector<SsrcInfo>& ssrc_infos,
+        std::vector<StreamParams>& tracks) 
+{
+    for (auto ssrc_info : ssrc_infos) {
+        std::string track_id = ssrc_info.track_id;
+
+        auto iter = tracks.begin();
+        for (; iter != tracks.end(); ++iter) {
+            if (iter->id == track_id) {
+                break;
+            }
+        }
+
+        if (iter == tracks.end()) {
+            StreamParams track;
+            track.id = track_id;
+            tracks.push_back(track);
+            iter = tracks.end() - 1;
+        }
+
+        iter->cname = ssrc_info.cname;
+        iter->stream_id = ssrc_info.stream_id;
+        iter->ssrcs.push_back(ssrc_info.ssrc_id);
+    }
+}
+
+int legacy_parse_offer(const std::string& sdp, LegacyOffer* offer) {
+    std::vector<std::string> fields;
+    size_t size = rtc::tokenize(sdp, '\n', &fields);
+    if (size <= 0) {
+        RTC_LOG(LS_WARNING) << "remote sdp invalid";
+        return -1;
+    }
+
+    bool is_rn = false;
+    if (sdp.find("\r\n") != std::string::npos) {
+        is_rn = true;
+    }
+
+    offer->desc = std::make_unique<SessionDescription>(SdpType::k_offer);
+
+    std::string media_type;
+    std::shared_ptr<AudioContentDescription> audio_content;
+    std::shared_ptr<VideoContentDescription> video_content;
+    auto audio_td = std::make_shared<TransportDescription>();
+    auto video_td = std::make_shared<TransportDescription>();
+
+    std::vector<SsrcInfo> audio_ssrc_info;
+    std::vector<SsrcInfo> video_ssrc_info;
+    std::vector<SsrcGroup> video_ssrc_groups;
+    std::vector<StreamParams> audio_tracks;
+    std::vector<StreamParams> video_tracks;
+
+    for (auto field : fields) {
+        if (is_rn) {
+            field = field.substr(0, field.length() - 1);
+        }
+
+        if (field.find("m=group:BUNDLE") != std::string::npos) {
+            std::vector<std::string> items;
+            rtc::split(field, ' ', &items);
+            if (items.size() > 1) {
+                ContentGroup answer_bundle("BUNDLE");
+                for (size_t i = 1; i < items.size(); ++i) {
+                    answer_bundle.add_content_name(items[i]);
+                }
+                offer->desc->add_group(answer_bundle);
+            }
+        } else if (field.find("m=") != std::string::npos) {
+            std::vector<std::string> items;
+            rtc::split(field, ' ', &items);
+            if (items.size() <= 2) {
+                RTC_LOG(LS_WARNING) << "parse m= error: " << field;
+                return -1;
+            }
+
+            // m=audio/video
+            media_type = items[0].substr(2);
+            if ("audio" == media_type) {
+                audio_td->mid = "audio";
+                offer->exist_audio = true;
+            } else if ("video" == media_type){    
+                video_td->mid = "video";
+                offer->exist_video = true;
+            }    
+        }
+
+        if ("audio" == media_type) {
+            if (parse_transport_info(audio_td.get(), field) != 0) {
+                return -1;
+            }
+
+            if (parse_ssrc_info(audio_ssrc_info, field) != 0) {
+                return -1;
+            }
+
+        } else if ("video" == media_type) {
+            if (parse_transport_info(video_td.get(), field) != 0) {
+                return -1;
+            }
+
+            if (parse_ssrc_info(video_ssrc_info, field) != 0) {
+                return -1;
+            }      
+
+            if (parse_ssrc_group_info(video_ssrc_groups, field) != 0) {
+                return -1;
+            }
+
+            if (parse_fmtp_info(offer->h264_codec_id, field) != 0) {
+                return -1;
+            }
+            if (offer->h264_codec_id != 0) {
+                if (parse_rtpmap_info(offer->rtx_codec_id, field) != 0) {
+                    return -1;
+                }      
+            }        
+        }
+    } 
+
+    if (offer->exist_audio) {
+        audio_content = std::make_shared<AudioContentDescription>();
+        offer->desc->add_content(audio_content);
+    }
+
+    if (offer->exist_video) {
+        video_content = std::make_shared<VideoContentDescription>(offer->h264_codec_id, offer->rtx_codec_id);
+        offer->desc->add_content(video_content);
+    }
+
+    if (!audio_ssrc_info.empty()) {
+        create_track_from_ssrc_info(audio_ssrc_info, audio_tracks);
+
+        for (auto track : audio_tracks) {
+            audio_content->add_stream(track);
+        }
+    }
+
+    if (!video_ssrc_info.empty()) {
+        create_track_from_ssrc_info(video_ssrc_info, video_tracks);
+
+        for (auto ssrc_group : video_ssrc_groups) {
+            if (ssrc_group.ssrcs.empty()) {
+                continue;
+            }
+            
+            uint32_t ssrc = ssrc_group.ssrcs.front();
+            for (StreamParams& track : video_tracks) {
+                if (track.has_ssrc(ssrc)) {
+                    track.ssrc_groups.push_back(ssrc_group);
+                }
+            }
+        }
+
+        for (auto track : video_tracks) {
+            video_content->add_stream(track);
+        }
+    }
+
+    offer->desc->add_transport_info(audio_td);
+    offer->desc->add_transport_info(video_td);
+
+    return 0;
+}
+
+static void add_fmtp_line(std::shared_ptr<CodecInfo> codec,
+        std::stringstream& ss)
+{
+    if (!codec->codec_param.empty()) {
+        ss << "a=fmtp:" << codec->id << " ";
+        std::string data;
+        for (auto param : codec->codec_param) {
+            data += (";" + param.first + "=" + param.second);
+        }
+        // data = ";key1=value1;key2=value2"
+        data = data.substr(1);
+        ss << data << "\r\n";
+    }
+}
+
+static void add_rtcp_fb_line(std::shared_ptr<CodecInfo> codec,
+        std::stringstream& ss)
+{
+    for (auto param : codec->feedback_param) {
+        ss << "a=rtcp-fb:" << codec->id << " " << param.id();
+        if (!param.param().empty()) {
+            ss << " " << param.param();
+        }
+        ss << "\r\n";
+    }
+}
+
+static void build_rtp_map(std::shared_ptr<MediaContentDescription> content, 
+        std::stringstream& ss) {          
+    for (auto codec : content->get_codecs()) {
+        ss << "a=rtpmap:" << codec->id << " " << codec->name << "/" << codec->samplerate;
+        if (MediaType::MEDIA_TYPE_AUDIO == content->type()) {
+            auto audio_codec = codec->as_audio();
+            ss << "/" << audio_codec->channels;
+        }
+        ss << "\r\n";
+
+        add_rtcp_fb_line(codec, ss);
+        add_fmtp_line(codec, ss);
+    }
+}
+
+static void build_rtp_direction(std::shared_ptr<MediaContentDescription> content, std::stringstream& ss) {
+    switch (content->direction()) {
+        case RtpDirection::k_send_recv:
+            ss << "a=sendrecv\r\n";
+            break;
+        case RtpDirection::k_send_only:
+            ss << "a=sendonly\r\n";
+            break;
+        case RtpDirection::k_recv_only:
+            ss << "a=recvonly\r\n";
+            break;
+        default:
+            ss << "a=inactive\r\n";
+            break;
+    }
+}
+
+static std::string connection_role_to_string(ConnectionRole role) {
+    switch (role) {
+        case ConnectionRole::ACTIVE:
+            return "active";
+        case ConnectionRole::PASSIVE:
+            return "passive";
+        case ConnectionRole::ACTPASS:
+            return "actpass";
+        case ConnectionRole::HOLDCONN:
+            return "holdconn";
+        default:
+            return "none";
+    }
+}
+
+static void build_candidates(std::shared_ptr<MediaContentDescription> content,
+        std::stringstream& ss)
+{
+    for (auto c : content->candidates()) {
+        ss << "a=candidate:" << c.foundation
+           << " " << c.component
+           << " " << c.protocol
+           << " " << c.priority
+           << " " << c.address.HostAsURIString()
+           << " " << c.port
+           << " typ " << c.type
+           << "\r\n";
+    }
+}
+
+static void add_ssrc_line(uint32_t ssrc, const std::string& attribute, 
+            const std::string& value, std::stringstream& ss) {
+    ss << "a=ssrc:" << ssrc << " " << attribute << ":" << value << "\r\n";
+}
+
+static void build_ssrc(std::shared_ptr<MediaContentDescription> content, std::stringstream& ss) {
+    for (auto track : content->streams()) {
+        for (auto ssrc_group : track.ssrc_groups) {
+            if (ssrc_group.ssrcs.empty()) {
+                continue;
+            }
+
+            ss << "a=ssrc-group:" << ssrc_group.semantics;
+            for (auto ssrc : ssrc_group.ssrcs) {
+                ss << " " << ssrc;
+            }
+            ss << "\r\n";
+        }
+
+        std::string msid = track.stream_id + " " + track.id;
+        for (auto ssrc : track.ssrcs) {
+            add_ssrc_line(ssrc, "cname", track.cname, ss);
+            add_ssrc_line(ssrc, "msid", msid, ss);
+            add_ssrc_line(ssrc, "mslabel", track.stream_id, ss);
+            add_ssrc_line(ssrc, "lable", track.id, ss);
+        }
+    }
+}
+
+
+std::string legacy_to_string(SessionDescription* desc, bool dtls_on) {
+    std::stringstream ss;
+    // version
+    ss << "v=0\r\n";
+    // session origin
+	// RFC 4566
+	// o=<username> <sess-id> <sess-version> <nettype> <addrtype> <unicast-address>
+	ss << "o=XRTC/1.0 0 2 IN IP4 127.0.0.1\r\n";
+	// session name
+	ss << "s=XrtcPublishSession \r\n";
+	// time description
+	ss << "t=0 0\r\n";
+
+    //改为ice-lite方式，一起是ice-full方式
+   // ss << "a=ice-lite\r\n";
+
+    // BUDDLE
+    std::vector<const ContentGroup*> content_group = desc->get_group_by_name("BUNDLE");
+    if (!content_group.empty()) {
+        ss << "a=group:BUNDLE";
+        for (auto group : content_group) {
+            for (auto content_name : group->content_names()) {
+                if (content_name == "audio") {
+                    ss << " " << 0;
+                } else if (content_name == "video") {
+                    ss << " " << 1;
+                }    
+            }
+        }
+        ss << "\r\n";
+    }
+
+    ss << "a=msid-semantic: WMS  live/xrtc \r\n";
+
+    for (auto content : desc->contents()) {
+        // RFC 4566
+        // m=<media> <port> <proto> <fmt>
+        std::string fmt;
+        for (auto codec : content->get_codecs()) {
+            fmt.append(" ");
+            fmt.append(std::to_string(codec->id));
+        }
+
+        std::string meida_protocol;
+        if (dtls_on) {
+            meida_protocol = k_media_protocol_dtls_savpf;
+        } else {
+            meida_protocol = k_meida_protocol_savpf;
+        }
+        ss << "m=" << content->mid() << " 9 " << meida_protocol << fmt << "\r\n";
+
+        ss << "c=IN IP4 0.0.0.0\r\n";
+        //ss << "a=rtcp:9 IN IP4 0.0.0.0\r\n";
+  
+        auto transport_info = desc->get_transport_info(content->mid());
+        if (transport_info) {
+            ss << "a=ice-ufrag:" << transport_info->ice_ufrag << "\r\n";
+            ss << "a=ice-pwd:" << transport_info->ice_pwd << "\r\n";
+
+            auto fp = transport_info->identity_fingerprint.get();
+            if (fp) {
+                ss << "a=fingerprint:" << fp->algorithm << " " << fp->GetRfc4572Fingerprint()
+                    << "\r\n";
+                ss << "a=setup:" << connection_role_to_string(
+                    transport_info->connection_role) << "\r\n";
+            }
+        }
+
+        if (content->mid() == "audio") {
+            ss << "a=mid:0" << "\r\n";
+        } else if (content->mid() == "video") {
+            ss << "a=mid:1" << "\r\n";
+        }
+
+        ss << "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01" << "\r\n";
+        
+        build_rtp_direction(content, ss);
+
+        if (content->rtcp_mux()) {
+            ss << "a=rtcp-mux\r\n";
+        }
+
+        ss << "a=rtcp-rsize\r\n";
+        
+        build_rtp_map(content, ss);
+        build_ssrc(content, ss);
+
+        build_candidates(content, ss);
+    }
+
+    return ss.str();
+}
+
+} // namespace test
+} // namespace xrtc
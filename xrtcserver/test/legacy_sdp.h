@@ -0,0 +1,36 @@
+/**
+ * @file legacy_sdp.h
+ * @author charles
+ * @brief 改为单遍解析和answer模板之前的offer解析和answer生成，原样保留，
+ *        只在sdp用例中对比新实现的输出是否一致以及两者的耗时
+*/
+
+#ifndef __TEST_LEGACY_SDP_H_
+#define __TEST_LEGACY_SDP_H_
+
+#include <string>
+#include <memory>
+
+#include "pc/session_description.h"
+
+namespace xrtc {
+namespace test {
+
+struct LegacyOffer {
+    std::unique_ptr<SessionDescription> desc;
+    bool exist_audio = false;
+    bool exist_video = false;
+    int h264_codec_id = 0;
+    int rtx_codec_id = 0;
+};
+
+// 对应原来的PeerConnection::set_remote_sdp，只保留解析部分
+int legacy_parse_offer(const std::string& sdp, LegacyOffer* offer);
+
+// 对应原来的SessionDescription::to_string
+std::string legacy_to_string(SessionDescription* desc, bool dtls_on);
+
+} // namespace test
+} // namespace xrtc
+
+#endif // __TEST_LEGACY_SDP_H_
@@ -0,0 +1,130 @@
+#include <memory>
+#include <vector>
+
+#include "stream/rtc_stream_manager.h"
+#include "stream/push_stream.h"
+#include "stream/pull_stream.h"
+#include "test/bench.h"
+#include "test/ice_peer.h"
+#include "test/stream_fixture.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_migrate_subscribers = 3;
+const size_t k_migrate_frames = 20;
+const size_t k_migrate_frame_packets = 5;
+const int64_t k_migrate_timeout_usec = 5000000;
+const unsigned int k_migrate_poll_usec = 5000;
+// 迁移之后ICE的ping由目标worker的定时器发送，保持一段时间检查连接没有断开
+const int64_t k_migrate_keepalive_usec = 1000000;
+
+typedef std::vector<std::unique_ptr<IcePeer>> IcePeerList;
+
+static void poll_peers(StreamFixture* fixture, IcePeerList& peers) {
+    fixture->run_loop(k_migrate_poll_usec);
+    for (auto& peer : peers) {
+        peer->process();
+    }
+}
+
+static bool all_connected(StreamFixture* fixture) {
+    if (!fixture->push_stream() || !fixture->push_stream()->can_migrate()) {
+        return false;
+    }
+
+    for (PullStream* stream : fixture->pull_streams()) {
+        if (!stream->can_migrate()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 客户端持续发送binding request，直到服务端的ping得到应答，所有会话进入连接状态
+static int wait_connected(StreamFixture* fixture, IcePeerList& peers) {
+    int64_t start = now_usec();
+    while (!all_connected(fixture)) {
+        BENCH_CHECK(now_usec() - start < k_migrate_timeout_usec);
+        for (auto& peer : peers) {
+            peer->send_binding_request();
+        }
+        poll_peers(fixture, peers);
+    }
+    return 0;
+}
+
+// 运行事件循环直到fixture的manager转发了expected个包
+static int wait_forwarded(StreamFixture* fixture, IcePeerList& peers, uint64_t expected) {
+    int64_t start = now_usec();
+    while (fixture->manager()->forwarded_packets() < expected) {
+        BENCH_CHECK(now_usec() - start < k_migrate_timeout_usec);
+        poll_peers(fixture, peers);
+    }
+    return 0;
+}
+
+// 推流和拉流都经过真实的ICE连接建立(不开DTLS)，推流者从UDP发送RTP，
+// 迁移到另一个EventLoop上的manager之后，推流的包继续转发给全部拉流者
+XRTC_BENCH(migrate) {
+    StreamFixture src(StreamFixture::default_options());
+    StreamFixture dst(StreamFixture::default_options());
+    BENCH_CHECK(src.init() == 0);
+    BENCH_CHECK(dst.init() == 0);
+    src.set_dtls_on(false);
+
+    IcePeerList peers;
+    std::string answer;
+    BENCH_CHECK(src.publish("migrate", k_chrome_publish_offer, &answer) == 0);
+    peers.push_back(std::make_unique<IcePeer>());
+    BENCH_CHECK(peers.back()->init(k_chrome_publish_offer, answer) == 0);
+    IcePeer* publisher = peers.back().get();
+
+    for (size_t i = 0; i < k_migrate_subscribers; ++i) {
+        BENCH_CHECK(src.subscribe("migrate", i + 1, k_chrome_play_offer, false, &answer) == 0);
+        peers.push_back(std::make_unique<IcePeer>());
+        BENCH_CHECK(peers.back()->init(k_chrome_play_offer, answer) == 0);
+    }
+
+    int64_t start = now_usec();
+    BENCH_CHECK(wait_connected(&src, peers) == 0);
+    int64_t connect_usec = now_usec() - start;
+
+    // 迁移之前先在源worker上转发，拉流者从关键帧开始接收
+    src.set_publisher(publisher);
+    src.send_video_frame(true, k_migrate_frame_packets);
+    for (size_t i = 0; i < k_migrate_frames; ++i) {
+        src.send_video_frame(false, k_migrate_frame_packets);
+    }
+    uint64_t packets = (k_migrate_frames + 1) * k_migrate_frame_packets;
+    BENCH_CHECK(wait_forwarded(&src, peers, packets * k_migrate_subscribers) == 0);
+
+    start = now_usec();
+    BENCH_CHECK(src.migrate_to(&dst) == 0);
+    int64_t migrate_usec = now_usec() - start;
+    BENCH_CHECK(src.push_stream() == nullptr);
+    BENCH_CHECK(dst.push_stream() != nullptr);
+    BENCH_CHECK(dst.pull_streams().size() == k_migrate_subscribers);
+
+    // 同一个socket上的包由目标worker接收和转发，源worker不再处理
+    uint64_t src_forwarded = src.manager()->forwarded_packets();
+    for (size_t i = 0; i < k_migrate_frames; ++i) {
+        src.send_video_frame(false, k_migrate_frame_packets);
+    }
+    packets = k_migrate_frames * k_migrate_frame_packets;
+    BENCH_CHECK(wait_forwarded(&dst, peers, packets * k_migrate_subscribers) == 0);
+    BENCH_CHECK(src.manager()->forwarded_packets() == src_forwarded);
+
+    start = now_usec();
+    while (now_usec() - start < k_migrate_keepalive_usec) {
+        poll_peers(&dst, peers);
+    }
+    BENCH_CHECK(all_connected(&dst));
+
+    printf("subscribers: %zu, ice connect: %.1fms, detach and attach: %ldus\n",
+            k_migrate_subscribers, connect_usec / 1000.0, (long)migrate_usec);
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "server/stream_relay.h"
+#include "stream/rtc_stream_manager.h"
+#include "test/bench.h"
+#include "test/stream_fixture.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_relay_subscribers = 1000;
+const size_t k_relay_frames = 100;
+const size_t k_relay_frame_packets = 10;
+// 推流worker领先最慢的远端worker不超过这么多包，小于relay的队列长度，不会丢包
+const uint64_t k_relay_window_packets = 1024;
+const int64_t k_relay_timeout_usec = 30000000;
+
+// 一个远端worker：在自己的线程上创建fixture和拉流者，轮询relay的队列直到结束
+struct RelayBenchWorker {
+    int id = 0;
+    size_t subscriber_num = 0;
+    uint64_t first_uid = 0;
+    std::atomic<uint64_t> forwarded{0};
+    std::atomic<bool> ready{false};
+    std::atomic<bool> stop{false};
+    std::atomic<int> result{0};
+    std::unique_ptr<std::thread> thread;
+};
+
+static void relay_worker_loop(RelayBenchWorker* worker, StreamRelay* relay,
+        const RtcServerOptions& options)
+{
+    StreamFixture fixture(options);
+    fixture.set_dtls_on(false);
+    int ret = fixture.init(worker->id, relay);
+    for (size_t i = 0; i < worker->subscriber_num && 0 == ret; ++i) {
+        ret = fixture.subscribe("relay", worker->first_uid + i);
+    }
+    worker->result = ret;
+    worker->ready = true;
+
+    RtcStreamManager* manager = fixture.manager();
+    while (0 == ret && !worker->stop) {
+        uint64_t forwarded = manager->forwarded_packets();
+        manager->process_relay_packets();
+        if (manager->forwarded_packets() == forwarded) {
+            std::this_thread::yield();
+            continue;
+        }
+        worker->forwarded.store(manager->forwarded_packets(), std::memory_order_release);
+    }
+}
+
+template <typename Pred>
+static bool wait_until(Pred pred) {
+    int64_t start = now_usec();
+    while (!pred()) {
+        if (now_usec() - start > k_relay_timeout_usec) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// 推流在worker 0(当前线程)，k_relay_subscribers个拉流者平均分布在worker_num个worker上，
+// 返回所有worker合计每秒转发的包数。拉流者没有DTLS，不包含SRTP加密和sendto
+static int run_relay(int worker_num, double* pps) {
+    RtcServerOptions options = StreamFixture::default_options();
+    options.worker_num = worker_num;
+    options.cross_worker_fanout = true;
+    options.pacing = false;
+
+    // relay最后销毁，fixture按创建的逆序销毁，最后恢复全局配置
+    StreamRelay relay(worker_num);
+    StreamFixture fixture(options);
+    fixture.set_dtls_on(false);
+    BENCH_CHECK(fixture.init(0, worker_num > 1 ? &relay : nullptr) == 0);
+    BENCH_CHECK(fixture.publish("relay") == 0);
+
+    std::vector<size_t> subscriber_nums(worker_num, k_relay_subscribers / worker_num);
+    for (size_t i = 0; i < k_relay_subscribers % worker_num; ++i) {
+        ++subscriber_nums[i];
+    }
+
+    for (size_t i = 0; i < subscriber_nums[0]; ++i) {
+        BENCH_CHECK(fixture.subscribe("relay", i + 1) == 0);
+    }
+
+    // 全局配置不是线程安全的，worker依次创建
+    std::vector<std::unique_ptr<RelayBenchWorker>> workers;
+    uint64_t uid = subscriber_nums[0] + 1;
+    for (int i = 1; i < worker_num; ++i) {
+        auto worker = std::make_unique<RelayBenchWorker>();
+        worker->id = i;
+        worker->subscriber_num = subscriber_nums[i];
+        worker->first_uid = uid;
+        uid += subscriber_nums[i];
+        RelayBenchWorker* w = worker.get();
+        worker->thread = std::make_unique<std::thread>(relay_worker_loop, w, &relay, options);
+        workers.push_back(std::move(worker));
+        while (!w->ready) {
+            std::this_thread::yield();
+        }
+        if (w->result != 0) {
+            break;
+        }
+    }
+
+    auto stop_workers = [&workers]() {
+        for (auto iter = workers.rbegin(); iter != workers.rend(); ++iter) {
+            (*iter)->stop = true;
+            (*iter)->thread->join();
+        }
+        workers.clear();
+    };
+
+    for (auto& worker : workers) {
+        if (worker->result != 0) {
+            stop_workers();
+            BENCH_CHECK(false);
+        }
+    }
+
+    // 远端worker至少已经处理到(已发送 - 窗口)个包
+    auto remote_caught_up = [&workers](uint64_t sent, uint64_t window) {
+        for (auto& worker : workers) {
+            uint64_t expected = sent > window ? (sent - window) * worker->subscriber_num : 0;
+            if (worker->forwarded.load(std::memory_order_acquire) < expected) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // 拉流者从实时关键帧开始接收
+    fixture.send_video_frame(true, k_relay_frame_packets);
+    uint64_t sent = k_relay_frame_packets;
+    if (!wait_until([&]() { return remote_caught_up(sent, 0); })) {
+        stop_workers();
+        BENCH_CHECK(false);
+    }
+
+    RtcStreamManager* manager = fixture.manager();
+    uint64_t local_forwarded = manager->forwarded_packets();
+    bool ok = true;
+    int64_t start = now_usec();
+    for (size_t i = 0; i < k_relay_frames && ok; ++i) {
+        fixture.send_video_frame(false, k_relay_frame_packets);
+        sent += k_relay_frame_packets;
+        ok = wait_until([&]() { return remote_caught_up(sent, k_relay_window_packets); });
+    }
+    ok = ok && wait_until([&]() { return remote_caught_up(sent, 0); });
+    int64_t elapsed = std::max<int64_t>(now_usec() - start, 1);
+    stop_workers();
+
+    size_t packets = k_relay_frames * k_relay_frame_packets;
+    BENCH_CHECK(ok);
+    BENCH_CHECK(manager->forwarded_packets() - local_forwarded == packets * subscriber_nums[0]);
+    *pps = packets * k_relay_subscribers * 1000000.0 / elapsed;
+    return 0;
+}
+
+// 一路流的拉流者容量随worker数的变化，worker数超过CPU核数时不会再增长
+XRTC_BENCH(relay) {
+    int cpu_num = std::max(1, (int)std::thread::hardware_concurrency());
+    int max_worker_num = std::min(cpu_num, k_relay_max_worker_num);
+    std::vector<int> worker_nums = {1, 2, 4, max_worker_num};
+    std::sort(worker_nums.begin(), worker_nums.end());
+    worker_nums.erase(std::unique(worker_nums.begin(), worker_nums.end()), worker_nums.end());
+
+    printf("note: subscribers never complete DTLS, srtp protect and sendto are not included\n");
+    double base = 0;
+    for (int worker_num : worker_nums) {
+        double pps = 0;
+        BENCH_CHECK(run_relay(worker_num, &pps) == 0);
+        if (0 == base) {
+            base = pps;
+        }
+        printf("workers: %d (cpus: %d), subscribers: %zu, forwarded pps: %.0f, "
+                "speedup: %.2fx\n", worker_num, cpu_num, k_relay_subscribers, pps, pps / base);
+    }
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
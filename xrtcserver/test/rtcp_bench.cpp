@@ -0,0 +1,68 @@
+#include "stream/rtc_stream_manager.h"
+#include "stream/pull_stream.h"
+#include "test/bench.h"
+#include "test/stream_fixture.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_rtcp_rounds = 10;
+// 每一轮的间隔，等于合并关键帧请求的间隔，每一轮最多向推流者请求一次关键帧
+const int k_rtcp_round_ms = 10;
+
+// 每个订阅者每一轮发送一个RR+PLI的复合包，返回发给推流者的RTCP包数
+static int run_upstream_rtcp(size_t subscriber_num, bool rtcp_termination, uint64_t* upstream) {
+    RtcServerOptions options = StreamFixture::default_options();
+    options.rtcp_termination = rtcp_termination;
+    options.keyframe_request_interval = k_rtcp_round_ms;
+    StreamFixture fixture(options);
+    BENCH_CHECK(fixture.init() == 0);
+    BENCH_CHECK(fixture.publish("rtcp") == 0);
+    for (size_t i = 0; i < subscriber_num; ++i) {
+        BENCH_CHECK(fixture.subscribe("rtcp", i + 1) == 0);
+    }
+
+    for (size_t round = 0; round < k_rtcp_rounds; ++round) {
+        for (PullStream* stream : fixture.pull_streams()) {
+            uint32_t sender_ssrc = (uint32_t)stream->get_uid();
+            uint8_t rtcp[] = {
+                // RR，没有报告块
+                0x80, 201, 0x00, 0x01,
+                (uint8_t)(sender_ssrc >> 24), (uint8_t)(sender_ssrc >> 16),
+                (uint8_t)(sender_ssrc >> 8), (uint8_t)sender_ssrc,
+                // PLI
+                0x81, 206, 0x00, 0x02,
+                (uint8_t)(sender_ssrc >> 24), (uint8_t)(sender_ssrc >> 16),
+                (uint8_t)(sender_ssrc >> 8), (uint8_t)sender_ssrc,
+                (uint8_t)(k_publisher_video_ssrc >> 24), (uint8_t)(k_publisher_video_ssrc >> 16),
+                (uint8_t)(k_publisher_video_ssrc >> 8), (uint8_t)k_publisher_video_ssrc
+            };
+            fixture.send_rtcp(stream, rtcp, sizeof(rtcp));
+        }
+        fixture.run_loop(k_rtcp_round_ms * 1000);
+    }
+
+    *upstream = fixture.manager()->upstream_rtcp_packets();
+    return 0;
+}
+
+// RTCP终结时发给推流者的RTCP不随订阅者个数增长，原样转发时和订阅者个数成正比
+XRTC_BENCH(rtcp_upstream) {
+    const size_t subscriber_nums[] = {1, 10, 50, 200};
+    for (size_t subscriber_num : subscriber_nums) {
+        uint64_t terminated = 0;
+        uint64_t forwarded = 0;
+        BENCH_CHECK(run_upstream_rtcp(subscriber_num, true, &terminated) == 0);
+        BENCH_CHECK(run_upstream_rtcp(subscriber_num, false, &forwarded) == 0);
+        printf("subscribers: %zu, upstream rtcp per round: %.1f, without termination: %.1f\n",
+                subscriber_num, (double)terminated / k_rtcp_rounds,
+                (double)forwarded / k_rtcp_rounds);
+
+        BENCH_CHECK(terminated <= k_rtcp_rounds);
+        BENCH_CHECK(forwarded == subscriber_num * k_rtcp_rounds);
+    }
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
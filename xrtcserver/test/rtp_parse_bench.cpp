@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <vector>
+
+#include "modules/rtp_rtcp/include/rtp_header_extension_map.h"
+#include "modules/rtp_rtcp/include/rtp_header_extensions.h"
+#include "modules/rtp_rtcp/include/rtp_packet_received.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+#include "test/bench.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_parse_packets = 64;
+const size_t k_parse_rounds = 20000;
+const size_t k_parse_payload_size = 1100;
+const int k_abs_send_time_id = 2;
+const int k_transport_seq_id = 3;
+
+// 带abs-send-time和transport-cc两个one-byte扩展的视频包，和浏览器推流的包结构一致
+static std::vector<uint8_t> build_packet(uint16_t seq) {
+    std::vector<uint8_t> packet(12 + 4 + 8 + k_parse_payload_size, 0xab);
+    uint8_t* p = packet.data();
+    p[0] = 0x90;
+    p[1] = 96;
+    p[2] = seq >> 8;
+    p[3] = seq & 0xff;
+    uint32_t ts = seq * 3000;
+    p[4] = ts >> 24;
+    p[5] = (ts >> 16) & 0xff;
+    p[6] = (ts >> 8) & 0xff;
+    p[7] = ts & 0xff;
+    p[8] = 0x12;
+    p[9] = 0x34;
+    p[10] = 0x56;
+    p[11] = 0x78;
+
+    // 0xBEDE，长度2个字(8字节)
+    uint8_t* ext = p + 12;
+    ext[0] = 0xbe;
+    ext[1] = 0xde;
+    ext[2] = 0;
+    ext[3] = 2;
+    uint8_t* data = ext + 4;
+    data[0] = (k_abs_send_time_id << 4) | 2;
+    data[1] = 0x01;
+    data[2] = 0x02;
+    data[3] = 0x03;
+    data[4] = (k_transport_seq_id << 4) | 1;
+    data[5] = seq >> 8;
+    data[6] = seq & 0xff;
+    data[7] = 0;
+    return packet;
+}
+
+// 接收路径对每个包做的事情：解析header和扩展，读取ssrc/序号/transport-cc序号
+template <typename Packet>
+static bool parse_packet(Packet& rtp_packet, const std::vector<uint8_t>& packet, uint64_t* sink) {
+    if (!rtp_packet.Parse(packet.data(), packet.size())) {
+        return false;
+    }
+
+    uint16_t transport_seq = 0;
+    rtp_packet.template GetExtension<TransportSequenceNumber>(&transport_seq);
+    *sink += rtp_packet.ssrc() + rtp_packet.sequence_number() + rtp_packet.payload_size();
+    return true;
+}
+
+// RtpPacketView只记录偏移，不拷贝也不分配内存；
+// 优化之前每个接收流为每个包构造一个RtpPacketReceived，拷贝到它自己的缓冲区再解析。
+// RtpPacketReceived没有扩展映射，查不到transport-cc序号，它少做的这部分工作使结果偏保守
+XRTC_BENCH(rtp_parse) {
+    RtpHeaderExtensionMap extensions;
+    extensions.Register<AbsoluteSendTime>(k_abs_send_time_id);
+    extensions.Register<TransportSequenceNumber>(k_transport_seq_id);
+
+    std::vector<std::vector<uint8_t>> packets;
+    for (size_t i = 0; i < k_parse_packets; ++i) {
+        packets.push_back(build_packet((uint16_t)(i + 1)));
+    }
+    size_t total = k_parse_rounds * packets.size();
+
+    RtpPacketView check_packet;
+    check_packet.set_extension_map(&extensions);
+    uint16_t transport_seq = 0;
+    BENCH_CHECK(check_packet.Parse(packets[0].data(), packets[0].size()));
+    BENCH_CHECK(check_packet.GetExtension<TransportSequenceNumber>(&transport_seq)
+            && 1 == transport_seq);
+
+    uint64_t view_sink = 0;
+    int64_t start = now_usec();
+    for (size_t round = 0; round < k_parse_rounds; ++round) {
+        for (const auto& packet : packets) {
+            RtpPacketView rtp_packet;
+            rtp_packet.set_extension_map(&extensions);
+            BENCH_CHECK(parse_packet(rtp_packet, packet, &view_sink));
+        }
+    }
+    double view_ns = std::max<int64_t>(now_usec() - start, 1) * 1000.0 / total;
+
+    uint64_t received_sink = 0;
+    start = now_usec();
+    for (size_t round = 0; round < k_parse_rounds; ++round) {
+        for (const auto& packet : packets) {
+            RtpPacketReceived rtp_packet;
+            BENCH_CHECK(parse_packet(rtp_packet, packet, &received_sink));
+        }
+    }
+    double received_ns = std::max<int64_t>(now_usec() - start, 1) * 1000.0 / total;
+
+    BENCH_CHECK(view_sink == received_sink);
+    printf("ns per packet, RtpPacketView: %.1f, RtpPacketReceived: %.1f, speedup: %.2fx\n",
+            view_ns, received_ns, received_ns / view_ns);
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
@@ -0,0 +1,185 @@
+#include <string>
+#include <memory>
+#include <vector>
+
+#include "ice/candidate.h"
+#include "ice/ice_credentials.h"
+#include "pc/peer_connection.h"
+#include "test/bench.h"
+#include "test/legacy_sdp.h"
+#include "test/stream_fixture.h"
+
+namespace xrtc {
+namespace test {
+
+const int k_sdp_iterations = 2000;
+const unsigned int k_sdp_destroy_wait_usec = 50000;
+
+struct SdpCase {
+    const char* name;
+    const char* publish_offer;
+    const char* play_offer;
+};
+
+// 和PeerConnection::create_answer相同的方式生成answer，ice参数、证书和candidate固定，
+// 新旧两种输出可以逐字节比较
+static std::unique_ptr<SessionDescription> build_answer(SessionDescription* offer, bool send,
+        SessionDescription* publisher, rtc::RTCCertificate* certificate)
+{
+    std::unique_ptr<SessionDescription> answer =
+        std::make_unique<SessionDescription>(SdpType::k_answer);
+    IceParameters ice_param("bnch", "0123456789abcdefghijklmn");
+    RtpDirection direction = send ? RtpDirection::k_send_only : RtpDirection::k_recv_only;
+
+    std::vector<Candidate> candidates(1);
+    candidates[0].component = IceCandidateComponent::RTP;
+    candidates[0].protocol = "udp";
+    candidates[0].address = rtc::SocketAddress("192.168.1.10", 8000);
+    candidates[0].port = 8000;
+    candidates[0].priority = 2130706431;
+    candidates[0].type = "host";
+    candidates[0].foundation = "1";
+
+    ContentGroup bundle("BUNDLE");
+    for (auto content : offer->contents()) {
+        std::shared_ptr<MediaContentDescription> media;
+        if (MediaType::MEDIA_TYPE_AUDIO == content->type()) {
+            media = std::make_shared<AudioContentDescription>();
+        } else {
+            auto codecs = content->get_codecs();
+            int h264_codec_id = codecs.empty() ? 0 : codecs[0]->id;
+            int rtx_codec_id = codecs.size() > 1 ? codecs[1]->id : 0;
+            media = std::make_shared<VideoContentDescription>(h264_codec_id, rtx_codec_id);
+        }
+
+        media->set_direction(direction);
+        media->set_rtcp_mux(true);
+        media->add_candidates(candidates);
+        if (send && publisher) {
+            auto source = publisher->get_content(media->mid());
+            if (source) {
+                for (auto stream : source->streams()) {
+                    media->add_stream(stream);
+                }
+            }
+        }
+
+        answer->add_content(media);
+        answer->add_transport_info(media->mid(), ice_param, certificate);
+        bundle.add_content_name(media->mid());
+    }
+
+    if (!bundle.content_names().empty()) {
+        answer->add_group(bundle);
+    }
+
+    return answer;
+}
+
+// 新旧解析的结果用同一个writer输出后比较，新旧writer对同一个answer的输出比较
+static int check_offer(StreamFixture& fixture, const char* offer, bool send,
+        SessionDescription* publisher, LegacyOffer* legacy)
+{
+    PeerConnection* pc = new PeerConnection(fixture.el(), nullptr, true);
+    int ret = pc->set_remote_sdp(offer);
+    int legacy_ret = legacy_parse_offer(offer, legacy);
+    bool parse_same = 0 == ret && 0 == legacy_ret
+        && legacy_to_string(pc->remote_desc(), true) == legacy_to_string(legacy->desc.get(), true)
+        && pc->video_rtx_codec_id() == legacy->rtx_codec_id;
+    pc->destroy();
+    fixture.run_loop(k_sdp_destroy_wait_usec);
+    BENCH_CHECK(parse_same);
+
+    std::unique_ptr<SessionDescription> answer = build_answer(legacy->desc.get(), send,
+            publisher, fixture.certificate());
+    BENCH_CHECK(answer->to_string(true) == legacy_to_string(answer.get(), true));
+    return 0;
+}
+
+// 返回每次操作的平均耗时(微秒)
+static int time_offer(StreamFixture& fixture, const char* offer, bool send,
+        SessionDescription* publisher, double* parse_us, double* legacy_parse_us,
+        double* answer_us, double* legacy_answer_us)
+{
+    std::string sdp(offer);
+    PeerConnection* pc = new PeerConnection(fixture.el(), nullptr, true);
+    int64_t start = now_usec();
+    for (int i = 0; i < k_sdp_iterations; ++i) {
+        pc->set_remote_sdp(sdp);
+    }
+    *parse_us = (double)(now_usec() - start) / k_sdp_iterations;
+    pc->destroy();
+    fixture.run_loop(k_sdp_destroy_wait_usec);
+
+    start = now_usec();
+    for (int i = 0; i < k_sdp_iterations; ++i) {
+        LegacyOffer legacy;
+        legacy_parse_offer(sdp, &legacy);
+    }
+    *legacy_parse_us = (double)(now_usec() - start) / k_sdp_iterations;
+
+    LegacyOffer legacy;
+    BENCH_CHECK(legacy_parse_offer(sdp, &legacy) == 0);
+    std::unique_ptr<SessionDescription> answer = build_answer(legacy.desc.get(), send,
+            publisher, fixture.certificate());
+
+    size_t total = 0;
+    start = now_usec();
+    for (int i = 0; i < k_sdp_iterations; ++i) {
+        total += answer->to_string(true).size();
+    }
+    *answer_us = (double)(now_usec() - start) / k_sdp_iterations;
+
+    start = now_usec();
+    for (int i = 0; i < k_sdp_iterations; ++i) {
+        total -= legacy_to_string(answer.get(), true).size();
+    }
+    *legacy_answer_us = (double)(now_usec() - start) / k_sdp_iterations;
+
+    BENCH_CHECK(0 == total);
+    return 0;
+}
+
+// 浏览器的推拉流offer：新旧解析结果一致，新旧answer逐字节一致，输出每个会话的解析和生成耗时
+XRTC_BENCH(sdp) {
+    const SdpCase sdp_cases[] = {
+        { "chrome", k_chrome_publish_offer, k_chrome_play_offer },
+        { "firefox", k_firefox_publish_offer, k_firefox_play_offer },
+    };
+
+    StreamFixture fixture(StreamFixture::default_options());
+    BENCH_CHECK(fixture.init() == 0);
+
+    for (const SdpCase& sdp_case : sdp_cases) {
+        LegacyOffer publish;
+        LegacyOffer play;
+        BENCH_CHECK(check_offer(fixture, sdp_case.publish_offer, false, nullptr, &publish) == 0);
+        BENCH_CHECK(check_offer(fixture, sdp_case.play_offer, true, publish.desc.get(), &play) == 0);
+
+        struct {
+            const char* name;
+            const char* offer;
+            bool send;
+        } offers[] = {
+            { "publish", sdp_case.publish_offer, false },
+            { "play", sdp_case.play_offer, true },
+        };
+
+        for (auto& item : offers) {
+            double parse_us = 0;
+            double legacy_parse_us = 0;
+            double answer_us = 0;
+            double legacy_answer_us = 0;
+            BENCH_CHECK(time_offer(fixture, item.offer, item.send, publish.desc.get(),
+                        &parse_us, &legacy_parse_us, &answer_us, &legacy_answer_us) == 0);
+            printf("%s %s: parse %.2f us (legacy %.2f us), answer %.2f us (legacy %.2f us)\n",
+                    sdp_case.name, item.name, parse_us, legacy_parse_us,
+                    answer_us, legacy_answer_us);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
@@ -0,0 +1,321 @@
+/**
+ * @file sdp_offers.h
+ * @author charles
+ * @brief 测试用的浏览器offer，按Chrome/Firefox实际生成的格式裁剪，
+ *        推流offer的ssrc固定，测试直接按这些ssrc构造RTP/RTCP包
+*/
+
+#ifndef __TEST_SDP_OFFERS_H_
+#define __TEST_SDP_OFFERS_H_
+
+#include <stdint.h>
+
+namespace xrtc {
+namespace test {
+
+const uint32_t k_publisher_audio_ssrc = 1001;
+const uint32_t k_publisher_video_ssrc = 2001;
+const uint32_t k_publisher_rtx_ssrc = 2002;
+const uint8_t k_publisher_audio_pt = 111;
+const uint8_t k_publisher_video_pt = 102;
+
+const char k_chrome_publish_offer[] =
+    "v=0\r\n"
+    "o=- 4611731400430051336 2 IN IP4 127.0.0.1\r\n"
+    "s=-\r\n"
+    "t=0 0\r\n"
+    "a=group:BUNDLE 0 1\r\n"
+    "a=extmap-allow-mixed\r\n"
+    "a=msid-semantic: WMS bench\r\n"
+    "m=audio 9 UDP/TLS/RTP/SAVPF 111 63 9 0 8 13 110 126\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+    "a=ice-ufrag:Xk3c\r\n"
+    "a=ice-pwd:3cCx1cLQzqL0dZ7cYgRUb0yz\r\n"
+    "a=ice-options:trickle\r\n"
+    "a=fingerprint:sha-256 25:6D:9D:69:61:67:0B:F7:02:E6:A0:4D:AA:8A:19:E3:"
+        "28:B5:51:D7:F6:80:83:16:C7:F4:33:C5:3B:54:58:0C\r\n"
+    "a=setup:actpass\r\n"
+    "a=mid:0\r\n"
+    "a=extmap:1 urn:ietf:params:rtp-hdrext:ssrc-audio-level\r\n"
+    "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+    "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+    "a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=sendonly\r\n"
+    "a=msid:bench audio0\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtpmap:111 opus/48000/2\r\n"
+    "a=rtcp-fb:111 transport-cc\r\n"
+    "a=fmtp:111 minptime=10;useinbandfec=1\r\n"
+    "a=rtpmap:63 red/48000/2\r\n"
+    "a=fmtp:63 111/111\r\n"
+    "a=rtpmap:9 G722/8000\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:8 PCMA/8000\r\n"
+    "a=rtpmap:13 CN/8000\r\n"
+    "a=rtpmap:110 telephone-event/48000\r\n"
+    "a=rtpmap:126 telephone-event/8000\r\n"
+    "a=ssrc:1001 cname:benchcname\r\n"
+    "a=ssrc:1001 msid:bench audio0\r\n"
+    "m=video 9 UDP/TLS/RTP/SAVPF 96 97 102 103\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+    "a=ice-ufrag:Xk3c\r\n"
+    "a=ice-pwd:3cCx1cLQzqL0dZ7cYgRUb0yz\r\n"
+    "a=ice-options:trickle\r\n"
+    "a=fingerprint:sha-256 25:6D:9D:69:61:67:0B:F7:02:E6:A0:4D:AA:8A:19:E3:"
+        "28:B5:51:D7:F6:80:83:16:C7:F4:33:C5:3B:54:58:0C\r\n"
+    "a=setup:actpass\r\n"
+    "a=mid:1\r\n"
+    "a=extmap:14 urn:ietf:params:rtp-hdrext:toffset\r\n"
+    "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+    "a=extmap:13 urn:3gpp:video-orientation\r\n"
+    "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+    "a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=sendonly\r\n"
+    "a=msid:bench video0\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtcp-rsize\r\n"
+    "a=rtpmap:96 VP8/90000\r\n"
+    "a=rtcp-fb:96 goog-remb\r\n"
+    "a=rtcp-fb:96 transport-cc\r\n"
+    "a=rtcp-fb:96 ccm fir\r\n"
+    "a=rtcp-fb:96 nack\r\n"
+    "a=rtcp-fb:96 nack pli\r\n"
+    "a=rtpmap:97 rtx/90000\r\n"
+    "a=fmtp:97 apt=96\r\n"
+    "a=rtpmap:102 H264/90000\r\n"
+    "a=rtcp-fb:102 goog-remb\r\n"
+    "a=rtcp-fb:102 transport-cc\r\n"
+    "a=rtcp-fb:102 ccm fir\r\n"
+    "a=rtcp-fb:102 nack\r\n"
+    "a=rtcp-fb:102 nack pli\r\n"
+    "a=fmtp:102 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f\r\n"
+    "a=rtpmap:103 rtx/90000\r\n"
+    "a=fmtp:103 apt=102\r\n"
+    "a=ssrc-group:FID 2001 2002\r\n"
+    "a=ssrc:2001 cname:benchcname\r\n"
+    "a=ssrc:2001 msid:bench video0\r\n"
+    "a=ssrc:2002 cname:benchcname\r\n"
+    "a=ssrc:2002 msid:bench video0\r\n";
+
+const char k_chrome_play_offer[] =
+    "v=0\r\n"
+    "o=- 8147382201561823715 2 IN IP4 127.0.0.1\r\n"
+    "s=-\r\n"
+    "t=0 0\r\n"
+    "a=group:BUNDLE 0 1\r\n"
+    "a=extmap-allow-mixed\r\n"
+    "a=msid-semantic: WMS\r\n"
+    "m=audio 9 UDP/TLS/RTP/SAVPF 111 63 9 0 8 13 110 126\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+    "a=ice-ufrag:pQ7d\r\n"
+    "a=ice-pwd:Vb2RdXkT0n4yHq8sLw1eZc5m\r\n"
+    "a=ice-options:trickle\r\n"
+    "a=fingerprint:sha-256 DB:CA:A9:CD:8A:74:40:2A:31:25:4F:70:1A:2B:9A:E7:"
+        "31:84:F2:F2:F4:8A:12:92:D9:18:F2:BD:D0:07:E1:A3\r\n"
+    "a=setup:actpass\r\n"
+    "a=mid:0\r\n"
+    "a=extmap:1 urn:ietf:params:rtp-hdrext:ssrc-audio-level\r\n"
+    "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+    "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+    "a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=recvonly\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtpmap:111 opus/48000/2\r\n"
+    "a=rtcp-fb:111 transport-cc\r\n"
+    "a=fmtp:111 minptime=10;useinbandfec=1\r\n"
+    "a=rtpmap:63 red/48000/2\r\n"
+    "a=fmtp:63 111/111\r\n"
+    "a=rtpmap:9 G722/8000\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:8 PCMA/8000\r\n"
+    "a=rtpmap:13 CN/8000\r\n"
+    "a=rtpmap:110 telephone-event/48000\r\n"
+    "a=rtpmap:126 telephone-event/8000\r\n"
+    "m=video 9 UDP/TLS/RTP/SAVPF 96 97 102 103\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+    "a=ice-ufrag:pQ7d\r\n"
+    "a=ice-pwd:Vb2RdXkT0n4yHq8sLw1eZc5m\r\n"
+    "a=ice-options:trickle\r\n"
+    "a=fingerprint:sha-256 DB:CA:A9:CD:8A:74:40:2A:31:25:4F:70:1A:2B:9A:E7:"
+        "31:84:F2:F2:F4:8A:12:92:D9:18:F2:BD:D0:07:E1:A3\r\n"
+    "a=setup:actpass\r\n"
+    "a=mid:1\r\n"
+    "a=extmap:14 urn:ietf:params:rtp-hdrext:toffset\r\n"
+    "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+    "a=extmap:13 urn:3gpp:video-orientation\r\n"
+    "a=extmap:3 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+    "a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=recvonly\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtcp-rsize\r\n"
+    "a=rtpmap:96 VP8/90000\r\n"
+    "a=rtcp-fb:96 goog-remb\r\n"
+    "a=rtcp-fb:96 transport-cc\r\n"
+    "a=rtcp-fb:96 ccm fir\r\n"
+    "a=rtcp-fb:96 nack\r\n"
+    "a=rtcp-fb:96 nack pli\r\n"
+    "a=rtpmap:97 rtx/90000\r\n"
+    "a=fmtp:97 apt=96\r\n"
+    "a=rtpmap:102 H264/90000\r\n"
+    "a=rtcp-fb:102 goog-remb\r\n"
+    "a=rtcp-fb:102 transport-cc\r\n"
+    "a=rtcp-fb:102 ccm fir\r\n"
+    "a=rtcp-fb:102 nack\r\n"
+    "a=rtcp-fb:102 nack pli\r\n"
+    "a=fmtp:102 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f\r\n"
+    "a=rtpmap:103 rtx/90000\r\n"
+    "a=fmtp:103 apt=102\r\n";
+
+// Firefox的属性按字母序输出，fmtp在rtpmap之前
+const char k_firefox_publish_offer[] =
+    "v=0\r\n"
+    "o=mozilla...THIS_IS_SDPARTA-99.0 5381218036417328398 0 IN IP4 0.0.0.0\r\n"
+    "s=-\r\n"
+    "t=0 0\r\n"
+    "a=fingerprint:sha-256 25:6D:9D:69:61:67:0B:F7:02:E6:A0:4D:AA:8A:19:E3:"
+        "28:B5:51:D7:F6:80:83:16:C7:F4:33:C5:3B:54:58:0C\r\n"
+    "a=group:BUNDLE 0 1\r\n"
+    "a=ice-options:trickle\r\n"
+    "a=msid-semantic:WMS *\r\n"
+    "m=audio 9 UDP/TLS/RTP/SAVPF 109 9 0 8 101\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=sendonly\r\n"
+    "a=extmap:1 urn:ietf:params:rtp-hdrext:ssrc-audio-level\r\n"
+    "a=extmap:2/recvonly urn:ietf:params:rtp-hdrext:csrc-audio-level\r\n"
+    "a=extmap:3 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=fmtp:109 maxplaybackrate=48000;stereo=1;useinbandfec=1\r\n"
+    "a=fmtp:101 0-15\r\n"
+    "a=ice-pwd:e2d1c0a7f3b84c4d9e6a5b7c8d9e0f1a\r\n"
+    "a=ice-ufrag:8f3a2b1c\r\n"
+    "a=mid:0\r\n"
+    "a=msid:{5e1c7d1a-2f0b-4c6e-9a3d-1b2c3d4e5f60} {0a1b2c3d-4e5f-6071-8293-a4b5c6d7e8f9}\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtpmap:109 opus/48000/2\r\n"
+    "a=rtpmap:9 G722/8000/1\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:8 PCMA/8000\r\n"
+    "a=rtpmap:101 telephone-event/8000\r\n"
+    "a=setup:actpass\r\n"
+    "a=ssrc:3001 cname:{7c9e6f5d-4b3a-2918-0706-f5e4d3c2b1a0}\r\n"
+    "m=video 9 UDP/TLS/RTP/SAVPF 120 124 121 125 126 127 97 98\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=sendonly\r\n"
+    "a=extmap:3 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=extmap:4 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+    "a=extmap:5 urn:ietf:params:rtp-hdrext:toffset\r\n"
+    "a=extmap:6/recvonly http://www.webrtc.org/experiments/rtp-hdrext/playout-delay\r\n"
+    "a=extmap:7 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+    "a=fmtp:126 profile-level-id=42e01f;level-asymmetry-allowed=1;packetization-mode=1\r\n"
+    "a=fmtp:97 profile-level-id=42e01f;level-asymmetry-allowed=1\r\n"
+    "a=fmtp:120 max-fs=12288;max-fr=60\r\n"
+    "a=fmtp:124 apt=120\r\n"
+    "a=fmtp:121 max-fs=12288;max-fr=60\r\n"
+    "a=fmtp:125 apt=121\r\n"
+    "a=fmtp:127 apt=126\r\n"
+    "a=fmtp:98 apt=97\r\n"
+    "a=ice-pwd:e2d1c0a7f3b84c4d9e6a5b7c8d9e0f1a\r\n"
+    "a=ice-ufrag:8f3a2b1c\r\n"
+    "a=mid:1\r\n"
+    "a=msid:{5e1c7d1a-2f0b-4c6e-9a3d-1b2c3d4e5f60} {1b2c3d4e-5f60-7182-93a4-b5c6d7e8f9a0}\r\n"
+    "a=rtcp-fb:120 nack\r\n"
+    "a=rtcp-fb:120 nack pli\r\n"
+    "a=rtcp-fb:120 ccm fir\r\n"
+    "a=rtcp-fb:120 goog-remb\r\n"
+    "a=rtcp-fb:120 transport-cc\r\n"
+    "a=rtcp-fb:126 nack\r\n"
+    "a=rtcp-fb:126 nack pli\r\n"
+    "a=rtcp-fb:126 ccm fir\r\n"
+    "a=rtcp-fb:126 goog-remb\r\n"
+    "a=rtcp-fb:126 transport-cc\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtcp-rsize\r\n"
+    "a=rtpmap:120 VP8/90000\r\n"
+    "a=rtpmap:124 rtx/90000\r\n"
+    "a=rtpmap:121 VP9/90000\r\n"
+    "a=rtpmap:125 rtx/90000\r\n"
+    "a=rtpmap:126 H264/90000\r\n"
+    "a=rtpmap:127 rtx/90000\r\n"
+    "a=rtpmap:97 H264/90000\r\n"
+    "a=rtpmap:98 rtx/90000\r\n"
+    "a=setup:actpass\r\n"
+    "a=ssrc:4001 cname:{7c9e6f5d-4b3a-2918-0706-f5e4d3c2b1a0}\r\n"
+    "a=ssrc:4002 cname:{7c9e6f5d-4b3a-2918-0706-f5e4d3c2b1a0}\r\n"
+    "a=ssrc-group:FID 4001 4002\r\n";
+
+const char k_firefox_play_offer[] =
+    "v=0\r\n"
+    "o=mozilla...THIS_IS_SDPARTA-99.0 7725126410203915722 0 IN IP4 0.0.0.0\r\n"
+    "s=-\r\n"
+    "t=0 0\r\n"
+    "a=fingerprint:sha-256 DB:CA:A9:CD:8A:74:40:2A:31:25:4F:70:1A:2B:9A:E7:"
+        "31:84:F2:F2:F4:8A:12:92:D9:18:F2:BD:D0:07:E1:A3\r\n"
+    "a=group:BUNDLE 0 1\r\n"
+    "a=ice-options:trickle\r\n"
+    "a=msid-semantic:WMS *\r\n"
+    "m=audio 9 UDP/TLS/RTP/SAVPF 109 9 0 8 101\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=recvonly\r\n"
+    "a=extmap:1 urn:ietf:params:rtp-hdrext:ssrc-audio-level\r\n"
+    "a=extmap:2/recvonly urn:ietf:params:rtp-hdrext:csrc-audio-level\r\n"
+    "a=extmap:3 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=fmtp:109 maxplaybackrate=48000;stereo=1;useinbandfec=1\r\n"
+    "a=fmtp:101 0-15\r\n"
+    "a=ice-pwd:4b5c6d7e8f9a0b1c2d3e4f5a6b7c8d9e\r\n"
+    "a=ice-ufrag:1d2e3f4a\r\n"
+    "a=mid:0\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtpmap:109 opus/48000/2\r\n"
+    "a=rtpmap:9 G722/8000/1\r\n"
+    "a=rtpmap:0 PCMU/8000\r\n"
+    "a=rtpmap:8 PCMA/8000\r\n"
+    "a=rtpmap:101 telephone-event/8000\r\n"
+    "a=setup:actpass\r\n"
+    "m=video 9 UDP/TLS/RTP/SAVPF 120 124 121 125 126 127 97 98\r\n"
+    "c=IN IP4 0.0.0.0\r\n"
+    "a=recvonly\r\n"
+    "a=extmap:3 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+    "a=extmap:4 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+    "a=extmap:5 urn:ietf:params:rtp-hdrext:toffset\r\n"
+    "a=extmap:6/recvonly http://www.webrtc.org/experiments/rtp-hdrext/playout-delay\r\n"
+    "a=extmap:7 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+    "a=fmtp:126 profile-level-id=42e01f;level-asymmetry-allowed=1;packetization-mode=1\r\n"
+    "a=fmtp:97 profile-level-id=42e01f;level-asymmetry-allowed=1\r\n"
+    "a=fmtp:120 max-fs=12288;max-fr=60\r\n"
+    "a=fmtp:124 apt=120\r\n"
+    "a=fmtp:121 max-fs=12288;max-fr=60\r\n"
+    "a=fmtp:125 apt=121\r\n"
+    "a=fmtp:127 apt=126\r\n"
+    "a=fmtp:98 apt=97\r\n"
+    "a=ice-pwd:4b5c6d7e8f9a0b1c2d3e4f5a6b7c8d9e\r\n"
+    "a=ice-ufrag:1d2e3f4a\r\n"
+    "a=mid:1\r\n"
+    "a=rtcp-fb:120 nack\r\n"
+    "a=rtcp-fb:120 nack pli\r\n"
+    "a=rtcp-fb:120 ccm fir\r\n"
+    "a=rtcp-fb:120 goog-remb\r\n"
+    "a=rtcp-fb:120 transport-cc\r\n"
+    "a=rtcp-fb:126 nack\r\n"
+    "a=rtcp-fb:126 nack pli\r\n"
+    "a=rtcp-fb:126 ccm fir\r\n"
+    "a=rtcp-fb:126 goog-remb\r\n"
+    "a=rtcp-fb:126 transport-cc\r\n"
+    "a=rtcp-mux\r\n"
+    "a=rtcp-rsize\r\n"
+    "a=rtpmap:120 VP8/90000\r\n"
+    "a=rtpmap:124 rtx/90000\r\n"
+    "a=rtpmap:121 VP9/90000\r\n"
+    "a=rtpmap:125 rtx/90000\r\n"
+    "a=rtpmap:126 H264/90000\r\n"
+    "a=rtpmap:127 rtx/90000\r\n"
+    "a=rtpmap:97 H264/90000\r\n"
+    "a=rtpmap:98 rtx/90000\r\n"
+    "a=setup:actpass\r\n";
+
+} // namespace test
+} // namespace xrtc
+
+#endif // __TEST_SDP_OFFERS_H_
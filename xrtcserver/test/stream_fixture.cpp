@@ -0,0 +1,256 @@
+#include <string.h>
+
+#include <algorithm>
+
+#include <rtc_base/rtc_certificate_generator.h>
+
+#include "base/event_loop.h"
+#include "modules/rtp_rtcp/rtp_packet_view.h"
+#include "stream/push_stream.h"
+#include "stream/pull_stream.h"
+#include "test/ice_peer.h"
+#include "test/stream_fixture.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_rtp_header_size = 12;
+const uint8_t k_rtp_version = 0x80;
+const uint8_t k_rtp_marker = 0x80;
+const uint32_t k_video_frame_ts_step = 3000;
+const uint32_t k_audio_ts_step = 960;
+// 会话销毁由10ms的定时器完成
+const unsigned int k_destroy_wait_usec = 50000;
+const uint64_t k_certificate_expires_ms = 24 * 3600 * 1000;
+
+// SPS/PPS的STAP-A，长度字段之后是NALU头和填充的参数集
+const uint8_t k_stap_a_sps_pps[] = {
+    0x78,
+    0x00, 0x0a, 0x67, 0x42, 0xe0, 0x1f, 0xdb, 0x02, 0x80, 0xbf, 0xe5, 0x80,
+    0x00, 0x04, 0x68, 0xce, 0x3c, 0x80
+};
+// FU-A指示字节和分片头，IDR是5，P帧是1
+const uint8_t k_fu_a_indicator = 0x7c;
+const uint8_t k_fu_start = 0x80;
+const uint8_t k_fu_end = 0x40;
+const uint8_t k_nalu_idr = 0x05;
+const uint8_t k_nalu_slice = 0x01;
+
+static void stop_loop_cb(EventLoop* el, TimerWatcher* /*w*/, void* /*data*/) {
+    el->stop();
+}
+
+static rtc::scoped_refptr<rtc::RTCCertificate> bench_certificate() {
+    static rtc::scoped_refptr<rtc::RTCCertificate> certificate;
+    if (!certificate) {
+        rtc::KeyParams key_params;
+        certificate = rtc::RTCCertificateGenerator::GenerateCertificate(key_params,
+                k_certificate_expires_ms);
+    }
+    return certificate;
+}
+
+StreamFixture::StreamFixture(const RtcServerOptions& options) :
+    saved_options_(Singleton<Settings>::Instance()->GetRtcServerOptions()),
+    options_(options)
+{
+}
+
+StreamFixture::~StreamFixture() {
+    if (manager_) {
+        for (PullStream* stream : pull_streams_) {
+            manager_->stop_pull(stream->get_uid(), stream_name_, "");
+        }
+
+        if (push_stream_) {
+            manager_->stop_push(push_stream_->get_uid(), stream_name_, "");
+        }
+
+        run_loop(k_destroy_wait_usec);
+        manager_.reset();
+    }
+
+    el_.reset();
+    Singleton<Settings>::Instance()->SetRtcServerOptions(saved_options_);
+}
+
+RtcServerOptions StreamFixture::default_options() {
+    return Singleton<Settings>::Instance()->GetRtcServerOptions();
+}
+
+int StreamFixture::init(int worker_id, StreamRelay* relay) {
+    certificate_ = bench_certificate();
+    if (!certificate_) {
+        fprintf(stderr, "generate certificate failed\n");
+        return -1;
+    }
+
+    Singleton<Settings>::Instance()->SetRtcServerOptions(options_);
+    el_ = std::make_unique<EventLoop>(this);
+    manager_ = std::make_unique<RtcStreamManager>(el_.get(), worker_id, relay);
+    manager_->signal_stream_created.connect(this, &StreamFixture::_on_stream_created);
+    return 0;
+}
+
+void StreamFixture::_on_stream_created(RtcStream* stream) {
+    if (RtcStreamType::k_push == stream->stream_type()) {
+        push_stream_ = static_cast<PushStream*>(stream);
+    } else {
+        pull_streams_.push_back(static_cast<PullStream*>(stream));
+    }
+}
+
+int StreamFixture::publish(const std::string& stream_name, const char* offer,
+        std::string* answer)
+{
+    std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
+    msg->uid = 1;
+    msg->stream_name = stream_name;
+    msg->audio = 1;
+    msg->video = 1;
+    msg->sdp = offer;
+    msg->certificate = certificate_.get();
+    msg->dtls_on = dtls_on_ ? 1 : 0;
+
+    stream_name_ = stream_name;
+    std::string local_answer;
+    if (manager_->create_push_stream(msg, local_answer) != 0 || local_answer.empty()
+            || !push_stream_)
+    {
+        fprintf(stderr, "create push stream failed\n");
+        return -1;
+    }
+
+    if (answer) {
+        *answer = local_answer;
+    }
+    return 0;
+}
+
+int StreamFixture::subscribe(const std::string& stream_name, uint64_t uid,
+        const char* offer, bool connected, std::string* answer)
+{
+    std::shared_ptr<RtcMsg> msg = std::make_shared<RtcMsg>();
+    msg->uid = uid;
+    msg->stream_name = stream_name;
+    msg->audio = 1;
+    msg->video = 1;
+    msg->sdp = offer;
+    msg->certificate = certificate_.get();
+    msg->dtls_on = dtls_on_ ? 1 : 0;
+
+    size_t count = pull_streams_.size();
+    std::string local_answer;
+    if (manager_->create_pull_stream(msg, local_answer) != 0 || local_answer.empty()
+            || pull_streams_.size() != count + 1)
+    {
+        fprintf(stderr, "create pull stream failed, uid: %lu\n", (unsigned long)uid);
+        return -1;
+    }
+
+    if (answer) {
+        *answer = local_answer;
+    }
+
+    if (connected) {
+        manager_->on_connection_state(pull_streams_.back(), PeerConnectionState::k_connected);
+    }
+    return 0;
+}
+
+void StreamFixture::_send_rtp(uint32_t ssrc, uint8_t pt, bool marker, uint32_t timestamp,
+        uint16_t seq, const uint8_t* payload_header, size_t header_size, size_t payload_size)
+{
+    PacketBufferPtr packet = PacketBufferPool::current()->alloc();
+    uint8_t* data = packet->data();
+    data[0] = k_rtp_version;
+    data[1] = (marker ? k_rtp_marker : 0) | pt;
+    data[2] = seq >> 8;
+    data[3] = seq & 0xff;
+    data[4] = timestamp >> 24;
+    data[5] = (timestamp >> 16) & 0xff;
+    data[6] = (timestamp >> 8) & 0xff;
+    data[7] = timestamp & 0xff;
+    data[8] = ssrc >> 24;
+    data[9] = (ssrc >> 16) & 0xff;
+    data[10] = (ssrc >> 8) & 0xff;
+    data[11] = ssrc & 0xff;
+    memcpy(data + k_rtp_header_size, payload_header, header_size);
+    memset(data + k_rtp_header_size + header_size, 0xab,
+            payload_size > header_size ? payload_size - header_size : 0);
+    packet->set_size(k_rtp_header_size + std::max(payload_size, header_size));
+
+    if (publisher_) {
+        publisher_->send_packet((const char*)packet->data(), packet->size());
+        return;
+    }
+
+    RtpPacketView rtp_packet;
+    rtp_packet.Parse(packet->data(), packet->size());
+    manager_->on_rtp_packet_received(push_stream_, packet.get(), rtp_packet, -1);
+}
+
+void StreamFixture::send_video_frame(bool keyframe, size_t packets, size_t payload_size) {
+    size_t index = 0;
+    if (keyframe) {
+        _send_rtp(k_publisher_video_ssrc, k_publisher_video_pt, false, video_ts_, video_seq_++,
+                k_stap_a_sps_pps, sizeof(k_stap_a_sps_pps), sizeof(k_stap_a_sps_pps));
+        ++index;
+    }
+
+    uint8_t nalu_type = keyframe ? k_nalu_idr : k_nalu_slice;
+    for (size_t i = 0; index < packets; ++i, ++index) {
+        uint8_t fu_header = nalu_type;
+        if (0 == i) {
+            fu_header |= k_fu_start;
+        }
+
+        bool marker = index + 1 == packets;
+        if (marker) {
+            fu_header |= k_fu_end;
+        }
+
+        uint8_t header[] = { k_fu_a_indicator, fu_header };
+        _send_rtp(k_publisher_video_ssrc, k_publisher_video_pt, marker, video_ts_, video_seq_++,
+                header, sizeof(header), payload_size);
+    }
+
+    video_ts_ += k_video_frame_ts_step;
+}
+
+void StreamFixture::send_audio_packet(size_t payload_size) {
+    uint8_t header[] = { 0xfc };
+    _send_rtp(k_publisher_audio_ssrc, k_publisher_audio_pt, true, audio_ts_, audio_seq_++,
+            header, sizeof(header), payload_size);
+    audio_ts_ += k_audio_ts_step;
+}
+
+void StreamFixture::send_rtcp(RtcStream* stream, const uint8_t* data, size_t len) {
+    PacketBufferPtr packet = PacketBufferPool::current()->alloc(data, len);
+    manager_->on_rtcp_packet_received(stream, packet.get());
+}
+
+int StreamFixture::migrate_to(StreamFixture* dst) {
+    StreamMigration migration;
+    if (manager_->detach_stream(stream_name_, &migration) != 0) {
+        return -1;
+    }
+
+    dst->manager_->attach_stream(&migration);
+    dst->stream_name_ = stream_name_;
+    dst->push_stream_ = push_stream_;
+    dst->pull_streams_ = pull_streams_;
+    push_stream_ = nullptr;
+    pull_streams_.clear();
+    return 0;
+}
+
+void StreamFixture::run_loop(unsigned int usec) {
+    TimerWatcher* timer = el_->create_timer(stop_loop_cb, this, false);
+    el_->start_timer(timer, usec);
+    el_->start();
+    el_->delete_timer(timer);
+}
+
+} // namespace test
+} // namespace xrtc
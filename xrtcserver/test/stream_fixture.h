@@ -0,0 +1,107 @@
+/**
+ * @file stream_fixture.h
+ * @author charles
+ * @brief 在当前线程上搭一个worker的会话层：EventLoop + RtcStreamManager，
+ *        用浏览器offer创建推拉流，不经过ICE/DTLS直接把构造的RTP/RTCP交给manager，
+ *        拉流者的发送停在未建立的DTLS传输之前，测量的是服务端分发和发送模块的开销；
+ *        关闭DTLS时也可以配合IcePeer经过真实的ICE连接收发
+*/
+
+#ifndef __TEST_STREAM_FIXTURE_H_
+#define __TEST_STREAM_FIXTURE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <rtc_base/rtc_certificate.h>
+#include <rtc_base/third_party/sigslot/sigslot.h>
+
+#include "base/packet_buffer.h"
+#include "server/settings.h"
+#include "stream/rtc_stream_manager.h"
+#include "test/sdp_offers.h"
+
+namespace xrtc {
+
+class EventLoop;
+class PushStream;
+class PullStream;
+class StreamRelay;
+
+namespace test {
+
+class IcePeer;
+
+class StreamFixture : public sigslot::has_slots<> {
+public:
+    // options在fixture存在期间替换全局配置，析构时恢复
+    explicit StreamFixture(const RtcServerOptions& options);
+    ~StreamFixture();
+
+    // 配置文件中的rtc选项，用例在此基础上修改
+    static RtcServerOptions default_options();
+
+    // relay不为空时manager作为跨worker分发中的worker_id，远端的包由用例调用
+    // manager()->process_relay_packets()处理
+    int init(int worker_id = 0, StreamRelay* relay = nullptr);
+
+    EventLoop* el() { return el_.get(); }
+    RtcStreamManager* manager() { return manager_.get(); }
+    rtc::RTCCertificate* certificate() { return certificate_.get(); }
+    PushStream* push_stream() { return push_stream_; }
+    const std::vector<PullStream*>& pull_streams() { return pull_streams_; }
+
+    // 之后创建的会话是否使用DTLS，关闭时ICE连通即进入连接状态，可以用IcePeer真正建立连接
+    void set_dtls_on(bool dtls_on) { dtls_on_ = dtls_on; }
+    // 设置之后推流者的RTP经过IcePeer从UDP发送，而不是直接交给manager
+    void set_publisher(IcePeer* peer) { publisher_ = peer; }
+
+    int publish(const std::string& stream_name, const char* offer = k_chrome_publish_offer,
+            std::string* answer = nullptr);
+    // connected为true时模拟拉流者的连接建立，之后等待关键帧
+    int subscribe(const std::string& stream_name, uint64_t uid,
+            const char* offer = k_chrome_play_offer, bool connected = true,
+            std::string* answer = nullptr);
+
+    // 把推流和它的拉流从本fixture的worker迁移到dst，之后由dst负责销毁会话
+    int migrate_to(StreamFixture* dst);
+
+    // 推流者发送一帧视频，关键帧第一个包是SPS+PPS的STAP-A，其余是FU-A分片，
+    // 最后一个包带marker
+    void send_video_frame(bool keyframe, size_t packets, size_t payload_size = 1100);
+    void send_audio_packet(size_t payload_size = 120);
+    void send_rtcp(RtcStream* stream, const uint8_t* data, size_t len);
+
+    // 运行事件循环usec微秒，处理到期的定时器(例如会话销毁)
+    void run_loop(unsigned int usec);
+
+private:
+    void _on_stream_created(RtcStream* stream);
+    void _send_rtp(uint32_t ssrc, uint8_t pt, bool marker, uint32_t timestamp, uint16_t seq,
+            const uint8_t* payload_header, size_t header_size, size_t payload_size);
+
+private:
+    RtcServerOptions saved_options_;
+    RtcServerOptions options_;
+    rtc::scoped_refptr<rtc::RTCCertificate> certificate_;
+    std::unique_ptr<EventLoop> el_;
+    std::unique_ptr<RtcStreamManager> manager_;
+    std::string stream_name_;
+    bool dtls_on_ = true;
+    IcePeer* publisher_ = nullptr;
+    PushStream* push_stream_ = nullptr;
+    std::vector<PullStream*> pull_streams_;
+
+    uint16_t video_seq_ = 1;
+    uint32_t video_ts_ = 90000;
+    uint16_t audio_seq_ = 1;
+    uint32_t audio_ts_ = 48000;
+};
+
+} // namespace test
+} // namespace xrtc
+
+#endif // __TEST_STREAM_FIXTURE_H_
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <vector>
+
+#include "base/event_loop.h"
+#include "test/bench.h"
+
+namespace xrtc {
+namespace test {
+
+const unsigned int k_timer_base_usec = 20000;
+const unsigned int k_timer_step_usec = 5000;
+const size_t k_timer_intervals = 8;
+const size_t k_timer_restarts = 10;
+const unsigned int k_timer_run_usec = 500000;
+
+struct TimerResult {
+    double start_ns = 0;
+    double restart_ns = 0;
+    uint64_t fired = 0;
+    uint64_t busy_usec = 0;
+};
+
+static void count_cb(EventLoop* /*el*/, TimerWatcher* /*w*/, void* data) {
+    ++*(uint64_t*)data;
+}
+
+static void stop_loop_cb(EventLoop* el, TimerWatcher* /*w*/, void* /*data*/) {
+    el->stop();
+}
+
+// 每个会话一个20~55ms的重复定时器(类似ICE ping和RTCP报告)，测量创建并启动、
+// 重新启动(收到包之后推迟超时)的单次耗时，以及运行期间事件循环处理定时器的CPU时间
+static int run_timers(bool wheel, size_t timer_num, TimerResult* result) {
+    EventLoop el(nullptr);
+    std::vector<TimerWatcher*> timers;
+    timers.reserve(timer_num);
+    uint64_t fired = 0;
+
+    int64_t start = now_usec();
+    for (size_t i = 0; i < timer_num; ++i) {
+        TimerWatcher* w = wheel ? el.create_wheel_timer(count_cb, &fired)
+            : el.create_timer(count_cb, &fired);
+        el.start_timer(w, k_timer_base_usec + (i % k_timer_intervals) * k_timer_step_usec);
+        timers.push_back(w);
+    }
+    result->start_ns = std::max<int64_t>(now_usec() - start, 1) * 1000.0 / timer_num;
+
+    start = now_usec();
+    for (size_t round = 0; round < k_timer_restarts; ++round) {
+        for (size_t i = 0; i < timer_num; ++i) {
+            el.start_timer(timers[i],
+                    k_timer_base_usec + ((i + round) % k_timer_intervals) * k_timer_step_usec);
+        }
+    }
+    result->restart_ns = std::max<int64_t>(now_usec() - start, 1) * 1000.0
+        / (timer_num * k_timer_restarts);
+
+    TimerWatcher* stop_timer = el.create_timer(stop_loop_cb, nullptr, false);
+    el.start_timer(stop_timer, k_timer_run_usec);
+    uint64_t busy = el.busy_usec();
+    el.start();
+    result->busy_usec = el.busy_usec() - busy;
+    result->fired = fired;
+    el.delete_timer(stop_timer);
+
+    for (TimerWatcher* w : timers) {
+        el.delete_timer(w);
+    }
+
+    BENCH_CHECK(fired > 0);
+    if (wheel) {
+        BENCH_CHECK(el.wheel_timer_count() == 0);
+    }
+    return 0;
+}
+
+// 会话级别定时器：时间轮和每个会话一个ev_timer在1万个以上会话时的开销
+XRTC_BENCH(timer) {
+    const size_t timer_nums[] = {1000, 10000, 50000};
+    for (size_t timer_num : timer_nums) {
+        for (bool wheel : {false, true}) {
+            TimerResult result;
+            BENCH_CHECK(run_timers(wheel, timer_num, &result) == 0);
+            printf("%s, timers: %zu, start: %.1f ns, restart: %.1f ns, fired: %lu, "
+                    "loop busy: %lu usec in %u ms, ns per fire: %.1f\n",
+                    wheel ? "wheel" : "ev_timer", timer_num, result.start_ns,
+                    result.restart_ns, (unsigned long)result.fired,
+                    (unsigned long)result.busy_usec, k_timer_run_usec / 1000,
+                    result.busy_usec * 1000.0 / result.fired);
+        }
+    }
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
@@ -0,0 +1,231 @@
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <rtc_base/socket_address.h>
+#include <rtc_base/third_party/sigslot/sigslot.h>
+
+#include "base/async_udp_socket.h"
+#include "base/event_loop.h"
+#include "base/socket.h"
+#include "test/bench.h"
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+namespace xrtc {
+namespace test {
+
+const size_t k_recv_bursts = 2000;
+// 一次突发的包数，GSO时合并为一个消息，总长度不能超过64KB，
+// 也不超过默认的socket接收缓冲区，避免丢包
+const size_t k_recv_burst_packets = 48;
+const size_t k_recv_packet_size = 1200;
+const int k_recv_buf_size = 4 * 1024 * 1024;
+
+enum class RecvMode {
+    k_recvfrom,
+    k_recvmmsg,
+    k_gro,
+};
+
+struct RecvResult {
+    uint64_t packets = 0;
+    uint64_t syscalls = 0;
+    int64_t usec = 0;
+};
+
+class RecvCounter : public sigslot::has_slots<> {
+public:
+    void on_read_packet(AsyncUdpSocket* /*socket*/, char* buf, size_t len,
+            const rtc::SocketAddress& /*addr*/, int64_t /*ts*/)
+    {
+        ++packets;
+        bytes += len + (uint8_t)buf[0];
+    }
+
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+};
+
+static int create_loopback_socket(struct sockaddr_in* addr) {
+    int sock = create_udp_socket(AF_INET);
+    if (sock < 0) {
+        return -1;
+    }
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int port = 0;
+    if (sock_bind(sock, (struct sockaddr*)addr, sizeof(*addr), 0, 0) != 0
+            || sock_get_address(sock, nullptr, &port) != 0
+            || sock_setnoblock(sock) != 0)
+    {
+        close(sock);
+        return -1;
+    }
+
+    addr->sin_port = htons(port);
+    return sock;
+}
+
+// 一次突发，gso为true时用一个UDP_SEGMENT消息发送，内核按k_recv_packet_size分段
+static int send_burst(int sock, const struct sockaddr_in& addr, char* buf, bool gso) {
+    if (!gso) {
+        for (size_t i = 0; i < k_recv_burst_packets; ++i) {
+            if (sock_send_to(sock, buf + i * k_recv_packet_size, k_recv_packet_size, 0,
+                        (struct sockaddr*)&addr, sizeof(addr)) <= 0)
+            {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = k_recv_packet_size * k_recv_burst_packets;
+    char ctrl[CMSG_SPACE(sizeof(uint16_t))];
+    memset(ctrl, 0, sizeof(ctrl));
+
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_name = (void*)&addr;
+    hdr.msg_namelen = sizeof(addr);
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = ctrl;
+    hdr.msg_controllen = sizeof(ctrl);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    uint16_t gso_size = k_recv_packet_size;
+    memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+
+    return sendmsg(sock, &hdr, 0) < 0 ? -1 : 0;
+}
+
+// 优化之前的接收路径：每个包一次recvfrom，再用一次ioctl(SIOCGSTAMP)取到达时间，
+// 地址转成字符串构造SocketAddress
+static void recv_per_packet(int sock, char* buf, RecvResult* result, uint64_t* sink) {
+    while (true) {
+        struct sockaddr_in addr;
+        int len = sock_recv_from(sock, buf, k_recv_packet_size * 2,
+                (struct sockaddr*)&addr, sizeof(addr));
+        ++result->syscalls;
+        if (len <= 0) {
+            return;
+        }
+
+        int64_t timestamp = sock_get_recv_timestamp(sock);
+        ++result->syscalls;
+
+        char ip[64] = {0};
+        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        rtc::SocketAddress remote_addr(ip, ntohs(addr.sin_port));
+
+        ++result->packets;
+        *sink += len + timestamp + remote_addr.port();
+    }
+}
+
+// 只计接收一侧的耗时，发送在计时之外完成
+static int run_recv(RecvMode mode, RecvResult* result) {
+    struct sockaddr_in recv_addr;
+    struct sockaddr_in send_addr;
+    int recv_sock = create_loopback_socket(&recv_addr);
+    int send_sock = create_loopback_socket(&send_addr);
+    BENCH_CHECK(recv_sock >= 0 && send_sock >= 0);
+    setsockopt(recv_sock, SOL_SOCKET, SO_RCVBUF, &k_recv_buf_size, sizeof(k_recv_buf_size));
+
+    EventLoop el(nullptr);
+    RecvCounter counter;
+    AsyncUdpSocket* socket = nullptr;
+    bool gso = false;
+    if (mode != RecvMode::k_recvfrom) {
+        socket = new AsyncUdpSocket(&el, recv_sock);
+        socket->signal_read_packet.connect(&counter, &RecvCounter::on_read_packet);
+        if (RecvMode::k_gro == mode) {
+            if (socket->enable_gro() != 0) {
+                delete socket;
+                close(recv_sock);
+                close(send_sock);
+                return 1;
+            }
+            gso = true;
+        }
+    }
+
+    std::vector<char> send_buf(k_recv_packet_size * k_recv_burst_packets, 0x5a);
+    std::vector<char> recv_buf(k_recv_packet_size * 2);
+    uint64_t sink = 0;
+    int ret = 0;
+    for (size_t i = 0; i < k_recv_bursts && 0 == ret; ++i) {
+        ret = send_burst(send_sock, recv_addr, send_buf.data(), gso);
+
+        int64_t start = now_usec();
+        if (socket) {
+            socket->recv_data();
+        } else {
+            recv_per_packet(recv_sock, recv_buf.data(), result, &sink);
+        }
+        result->usec += now_usec() - start;
+    }
+
+    if (socket) {
+        result->packets = socket->recv_packets();
+        result->syscalls = socket->recv_syscalls();
+        delete socket;
+    }
+    close(recv_sock);
+    close(send_sock);
+
+    BENCH_CHECK(0 == ret);
+    BENCH_CHECK(result->packets > 0 && sink + counter.bytes > 0);
+    return 0;
+}
+
+// 接收路径每个包的系统调用数和吞吐：逐包recvfrom(优化之前) / recvmmsg / recvmmsg + UDP_GRO
+XRTC_BENCH(udp_recv) {
+    printf("note: loopback, the sender uses UDP_SEGMENT in gro mode so packets stay "
+            "coalesced up to the receiving socket, as NIC GRO would do\n");
+
+    const struct {
+        RecvMode mode;
+        const char* name;
+    } modes[] = {
+        {RecvMode::k_recvfrom, "recvfrom"},
+        {RecvMode::k_recvmmsg, "recvmmsg"},
+        {RecvMode::k_gro, "recvmmsg+gro"},
+    };
+
+    size_t sent = k_recv_bursts * k_recv_burst_packets;
+    for (auto& item : modes) {
+        RecvResult result;
+        int ret = run_recv(item.mode, &result);
+        BENCH_CHECK(ret >= 0);
+        if (ret > 0) {
+            printf("%s: skipped, UDP_GRO not supported by the kernel\n", item.name);
+            continue;
+        }
+
+        int64_t usec = std::max<int64_t>(result.usec, 1);
+        printf("%s: received %lu/%zu, syscalls per packet: %.3f, pps: %.0f\n",
+                item.name, (unsigned long)result.packets, sent,
+                (double)result.syscalls / result.packets,
+                result.packets * 1000000.0 / usec);
+    }
+    return 0;
+}
+
+} // namespace test
+} // namespace xrtc
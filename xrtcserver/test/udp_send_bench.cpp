@@ -0,0 +1,180 @@
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <rtc_base/socket_address.h>
+
+#include "base/async_udp_socket.h"
+#include "base/event_loop.h"
+#include "base/socket.h"
+#include "test/bench.h"
+
+namespace xrtc {
+namespace test {
+
+const size_t k_send_sessions = 100;
+const size_t k_send_frames = 200;
+const size_t k_send_frame_packets = 10;
+const size_t k_send_packet_size = 1200;
+const size_t k_send_drain_loops = 1000;
+
+enum class SendMode {
+    k_sendto,
+    k_sendmmsg,
+    k_gso,
+};
+
+struct SendResult {
+    uint64_t packets = 0;
+    uint64_t syscalls = 0;
+    int64_t usec = 0;
+};
+
+static void stop_loop_cb(EventLoop* el, TimerWatcher* /*w*/, void* /*data*/) {
+    el->stop();
+}
+
+// 运行一轮事件循环，发送缓存在阻塞之前的ev_prepare中flush
+static void run_once(EventLoop* el) {
+    TimerWatcher* timer = el->create_timer(stop_loop_cb, nullptr, false);
+    el->start_timer(timer, 0);
+    el->start();
+    el->delete_timer(timer);
+}
+
+static int create_loopback_socket(rtc::SocketAddress* addr) {
+    int sock = create_udp_socket(AF_INET);
+    if (sock < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in saddr;
+    memset(&saddr, 0, sizeof(saddr));
+    saddr.sin_family = AF_INET;
+    saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int port = 0;
+    if (sock_bind(sock, (struct sockaddr*)&saddr, sizeof(saddr), 0, 0) != 0
+            || sock_get_address(sock, nullptr, &port) != 0
+            || sock_setnoblock(sock) != 0)
+    {
+        close(sock);
+        return -1;
+    }
+
+    addr->SetIP("127.0.0.1");
+    addr->SetPort(port);
+    return sock;
+}
+
+// 一路流转发给k_send_sessions个会话，每帧之后运行一轮事件循环(相当于一次recvmmsg收到一帧)。
+// shared_port为true时所有会话共用一个发送socket(共享端口)，否则每个会话一个socket；
+// burst为false时按包扇出(直接转发的顺序)，为true时一个会话的整帧连续发送(pacer和关键帧缓存的顺序)。
+// 接收端不读数据，缓冲区满之后由内核丢弃，不影响发送的开销
+static int run_send(EventLoop* el, SendMode mode, bool shared_port, bool burst,
+        SendResult* result)
+{
+    std::vector<int> fds;
+    std::vector<rtc::SocketAddress> remote_addrs(k_send_sessions);
+    for (size_t i = 0; i < k_send_sessions; ++i) {
+        int sock = create_loopback_socket(&remote_addrs[i]);
+        BENCH_CHECK(sock >= 0);
+        fds.push_back(sock);
+    }
+
+    std::vector<std::unique_ptr<AsyncUdpSocket>> sockets;
+    size_t socket_num = shared_port ? 1 : k_send_sessions;
+    for (size_t i = 0; i < socket_num; ++i) {
+        rtc::SocketAddress local_addr;
+        int sock = create_loopback_socket(&local_addr);
+        BENCH_CHECK(sock >= 0);
+        fds.push_back(sock);
+        sockets.push_back(std::make_unique<AsyncUdpSocket>(el, sock));
+        if (mode != SendMode::k_sendto) {
+            sockets.back()->enable_send_batch(SendMode::k_gso == mode);
+        }
+    }
+
+    std::vector<char> payload(k_send_packet_size, 0x5a);
+    int64_t start = now_usec();
+    for (size_t frame = 0; frame < k_send_frames; ++frame) {
+        for (size_t i = 0; i < k_send_frame_packets * k_send_sessions; ++i) {
+            size_t session = burst ? i / k_send_frame_packets : i % k_send_sessions;
+            AsyncUdpSocket* socket = sockets[shared_port ? 0 : session].get();
+            socket->send_to(payload.data(), payload.size(), remote_addrs[session]);
+        }
+        run_once(el);
+    }
+
+    // 发送缓冲区满时剩余的包在socket可写之后发送
+    size_t expected = k_send_frames * k_send_frame_packets * k_send_sessions;
+    for (size_t i = 0; i < k_send_drain_loops; ++i) {
+        result->packets = 0;
+        result->syscalls = 0;
+        for (auto& socket : sockets) {
+            result->packets += socket->send_packets();
+            result->syscalls += socket->send_syscalls();
+        }
+        if (result->packets >= expected) {
+            break;
+        }
+        run_once(el);
+    }
+    result->usec = now_usec() - start;
+    sockets.clear();
+    for (int fd : fds) {
+        close(fd);
+    }
+
+    BENCH_CHECK(result->packets == expected);
+    return 0;
+}
+
+static int run_all(EventLoop* el) {
+    const struct {
+        SendMode mode;
+        const char* name;
+    } modes[] = {
+        {SendMode::k_sendto, "sendto"},
+        {SendMode::k_sendmmsg, "sendmmsg"},
+        {SendMode::k_gso, "sendmmsg+gso"},
+    };
+
+    for (bool shared_port : {true, false}) {
+        for (bool burst : {false, true}) {
+            for (auto& item : modes) {
+                SendResult result;
+                BENCH_CHECK(run_send(el, item.mode, shared_port, burst, &result) == 0);
+                int64_t usec = std::max<int64_t>(result.usec, 1);
+                printf("%s, %s order, %s: syscalls per packet: %.3f, pps: %.0f\n",
+                        shared_port ? "shared port" : "per-session port",
+                        burst ? "burst" : "fanout", item.name,
+                        (double)result.syscalls / result.packets,
+                        result.packets * 1000000.0 / usec);
+            }
+        }
+    }
+    return 0;
+}
+
+// 发送路径每个包的系统调用数和吞吐：逐包sendto / sendmmsg / sendmmsg + UDP_SEGMENT，
+// 分别在共享端口和每会话一个端口两种模式下测量
+XRTC_BENCH(udp_send) {
+    // 线程的发送缓存绑定到第一次使用它的EventLoop，线程退出时才销毁，
+    // 在独立的线程上使用一个线程结束之后才销毁的EventLoop，不受其它用例的影响
+    int ret = -1;
+    std::thread thread([&ret]() {
+        static thread_local EventLoop el(nullptr);
+        ret = run_all(&el);
+    });
+    thread.join();
+    return ret;
+}
+
+} // namespace test
+} // namespace xrtc